@@ -0,0 +1,196 @@
+/** @file   main.cpp
+    @author Philip Abbet
+
+    Benchmark of the ingestion of a large mesh by 'Athena::Graphics::MeshBuilder', with
+    the bulk methods (positions(), indices(), ...) and with the per-vertex ones
+    (position(), index(), ...)
+*/
+
+#include <Athena-Graphics/MeshBuilder.h>
+#include <Ogre/OgreTimer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace Athena;
+using namespace Athena::Graphics;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Number of quads on each side of the grid
+static const unsigned int DEFAULT_GRID_SIZE = 1024;
+
+/// Number of runs of each method (the fastest one is kept)
+static const unsigned int NB_RUNS = 5;
+
+
+/*************************************** TYPES *****************************************/
+
+struct tGrid
+{
+    std::vector<float>          positions;
+    std::vector<float>          normals;
+    std::vector<float>          texCoords;
+    std::vector<unsigned int>   indices;
+};
+
+struct tTimings
+{
+    unsigned long   ingestion;      ///< Time spent giving the data to the builder
+    unsigned long   end;            ///< Time spent in end()
+};
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+static void buildGrid(unsigned int size, tGrid& grid)
+{
+    const unsigned int nbVerticesPerRow = size + 1;
+
+    grid.positions.reserve(nbVerticesPerRow * nbVerticesPerRow * 3);
+    grid.normals.reserve(nbVerticesPerRow * nbVerticesPerRow * 3);
+    grid.texCoords.reserve(nbVerticesPerRow * nbVerticesPerRow * 2);
+    grid.indices.reserve(size * size * 6);
+
+    for (unsigned int y = 0; y < nbVerticesPerRow; ++y)
+    {
+        for (unsigned int x = 0; x < nbVerticesPerRow; ++x)
+        {
+            grid.positions.push_back((float) x);
+            grid.positions.push_back((float) y);
+            grid.positions.push_back(0.0f);
+
+            grid.normals.push_back(0.0f);
+            grid.normals.push_back(0.0f);
+            grid.normals.push_back(1.0f);
+
+            grid.texCoords.push_back((float) x / size);
+            grid.texCoords.push_back((float) y / size);
+        }
+    }
+
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            const unsigned int v = y * nbVerticesPerRow + x;
+
+            grid.indices.push_back(v);
+            grid.indices.push_back(v + 1);
+            grid.indices.push_back(v + nbVerticesPerRow);
+
+            grid.indices.push_back(v + 1);
+            grid.indices.push_back(v + nbVerticesPerRow + 1);
+            grid.indices.push_back(v + nbVerticesPerRow);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static tTimings runBulk(const tGrid& grid)
+{
+    tTimings timings;
+    Ogre::Timer timer;
+
+    // Deferred: the mesh is never committed, so no Ogre manager is needed
+    MeshBuilder builder("Bulk", "General", true);
+
+    timer.reset();
+
+    builder.begin("grid", "BaseWhite");
+    builder.positions(&grid.positions[0], grid.positions.size() / 3);
+    builder.normals(&grid.normals[0]);
+    builder.textureCoords(&grid.texCoords[0]);
+    builder.indices(&grid.indices[0], grid.indices.size());
+
+    timings.ingestion = timer.getMicroseconds();
+
+    timer.reset();
+    builder.end();
+    timings.end = timer.getMicroseconds();
+
+    return timings;
+}
+
+//-----------------------------------------------------------------------
+
+static tTimings runPerVertex(const tGrid& grid)
+{
+    tTimings timings;
+    Ogre::Timer timer;
+
+    MeshBuilder builder("PerVertex", "General", true);
+
+    timer.reset();
+
+    builder.begin("grid", "BaseWhite");
+
+    const unsigned int nbVertices = grid.positions.size() / 3;
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        builder.position(grid.positions[i * 3], grid.positions[i * 3 + 1], grid.positions[i * 3 + 2]);
+        builder.normal(grid.normals[i * 3], grid.normals[i * 3 + 1], grid.normals[i * 3 + 2]);
+        builder.textureCoord(grid.texCoords[i * 2], grid.texCoords[i * 2 + 1]);
+    }
+
+    for (unsigned int i = 0; i < grid.indices.size(); ++i)
+        builder.index(grid.indices[i]);
+
+    timings.ingestion = timer.getMicroseconds();
+
+    timer.reset();
+    builder.end();
+    timings.end = timer.getMicroseconds();
+
+    return timings;
+}
+
+//-----------------------------------------------------------------------
+
+static void keepFastest(tTimings& best, const tTimings& timings, bool bFirst)
+{
+    if (bFirst || (timings.ingestion < best.ingestion))
+        best.ingestion = timings.ingestion;
+
+    if (bFirst || (timings.end < best.end))
+        best.end = timings.end;
+}
+
+
+/************************************* ENTRY POINT *************************************/
+
+int main(int argc, char** argv)
+{
+    const unsigned int size = (argc > 1 ? (unsigned int) atoi(argv[1]) : DEFAULT_GRID_SIZE);
+    if (size == 0)
+    {
+        printf("Usage: %s [grid size]\n", argv[0]);
+        return 1;
+    }
+
+    tGrid grid;
+    buildGrid(size, grid);
+
+    printf("Grid of %u x %u quads: %u vertices, %u indices\n", size, size,
+           (unsigned int) grid.positions.size() / 3, (unsigned int) grid.indices.size());
+
+    tTimings bulk;
+    tTimings perVertex;
+
+    for (unsigned int i = 0; i < NB_RUNS; ++i)
+    {
+        keepFastest(bulk, runBulk(grid), i == 0);
+        keepFastest(perVertex, runPerVertex(grid), i == 0);
+    }
+
+    printf("                          ingestion (us)    end() (us)\n");
+    printf("positions() / indices()   %14lu    %10lu\n", bulk.ingestion, bulk.end);
+    printf("position() / index()      %14lu    %10lu\n", perVertex.ingestion, perVertex.end);
+
+    if (bulk.ingestion > 0)
+        printf("Speedup of the ingestion: %.2fx\n", (double) perVertex.ingestion / bulk.ingestion);
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/** @file   DynamicMesh.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::DynamicMesh'
+*/
+
+#ifndef _ATHENA_GRAPHICS_DYNAMICMESH_H_
+#define _ATHENA_GRAPHICS_DYNAMICMESH_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreHardwareVertexBuffer.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to modify the vertices of an existing mesh in place,
+///         frame after frame (cloth, water, procedural animations, ...)
+///
+/// A vertex buffer is converted the first time it is modified: a copy is kept in system
+/// memory, and the buffer is replaced by dynamic ones (in all the vertex data using it).
+/// The modifications are done on the copy, and the modified ranges of vertices are
+/// tracked until update() uploads them. The buffers never modified are left untouched.
+///
+/// Two update modes are available:
+///   - UPDATE_DISCARD: each modified buffer is entirely rewritten with HBL_DISCARD (the
+///     driver provides a new memory area, so there is no stall)
+///   - UPDATE_MULTI_BUFFERED: each vertex buffer is replaced by a ring of dynamic
+///     buffers (3 by default), used in turn. Only the modified ranges are written, with
+///     HBL_NO_OVERWRITE, in the oldest buffer of the ring, which is then bound to the
+///     mesh. The GPU can still be reading the buffers of the frames in flight, so the
+///     ring must contain more buffers than the number of frames queued by the driver
+///     (usually 2 or 3).
+///
+/// @remark The modified vertex buffers must be readable (see GraphicTools::isReadable())
+/// @remark Since the buffers are converted when first modified, the methods modifying
+///         the vertices must be called from the rendering thread
+/// @remark The bounds of the mesh aren't updated, see Ogre::Mesh::_setBounds()
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL DynamicMesh
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The ways the modified vertices are uploaded
+    //-----------------------------------------------------------------------------------
+    enum tUpdateMode
+    {
+        UPDATE_DISCARD,         ///< The modified buffers are rewritten with HBL_DISCARD
+        UPDATE_MULTI_BUFFERED,  ///< The modified ranges are written with HBL_NO_OVERWRITE
+                                ///  in the oldest buffer of a ring
+    };
+
+
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @param  mesh        The mesh
+    /// @param  mode        The way the modified vertices are uploaded
+    /// @param  nbBuffers   Number of buffers in the ring of each vertex buffer (at least
+    ///                     3, only used by UPDATE_MULTI_BUFFERED)
+    //-----------------------------------------------------------------------------------
+    DynamicMesh(const Ogre::MeshPtr& mesh, tUpdateMode mode = UPDATE_DISCARD,
+                unsigned int nbBuffers = 3);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    ~DynamicMesh();
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the mesh
+    //-----------------------------------------------------------------------------------
+    inline const Ogre::MeshPtr& getMesh() const
+    {
+        return m_mesh;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the update mode
+    //-----------------------------------------------------------------------------------
+    inline tUpdateMode getUpdateMode() const
+    {
+        return m_mode;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the number of hardware buffers used for each vertex buffer
+    //-----------------------------------------------------------------------------------
+    inline unsigned int getNbBuffers() const
+    {
+        return m_nbBuffers;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Modify the values of an attribute of a range of vertices
+    /// @remark Only the attributes made of floats are supported (see getVertices() for
+    ///         the other ones)
+    /// @param  usSubMesh   Index of the submesh, SHARED_VERTICES for the shared vertices
+    /// @param  semantic    Semantic of the attribute
+    /// @param  start       Index of the first vertex
+    /// @param  nbVertices  Number of vertices
+    /// @param  pValues     The values (as many components per vertex as the attribute)
+    /// @param  usIndex     Index of the attribute (for the texture coordinates)
+    //-----------------------------------------------------------------------------------
+    void setValues(unsigned short usSubMesh, Ogre::VertexElementSemantic semantic,
+                   unsigned int start, unsigned int nbVertices, const float* pValues,
+                   unsigned short usIndex = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the copy in system memory of the vertices of a vertex buffer, to
+    ///         modify them directly
+    /// @remark The modified vertices must be reported with markDirty()
+    /// @param  usSubMesh   Index of the submesh, SHARED_VERTICES for the shared vertices
+    /// @param  usSource    Source of the vertex buffer
+    //-----------------------------------------------------------------------------------
+    unsigned char* getVertices(unsigned short usSubMesh, unsigned short usSource);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates that a range of vertices of a vertex buffer was modified
+    /// @param  usSubMesh   Index of the submesh, SHARED_VERTICES for the shared vertices
+    /// @param  usSource    Source of the vertex buffer
+    /// @param  start       Index of the first vertex
+    /// @param  nbVertices  Number of vertices
+    //-----------------------------------------------------------------------------------
+    void markDirty(unsigned short usSubMesh, unsigned short usSource, unsigned int start,
+                   unsigned int nbVertices);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Upload the modified vertices into the hardware buffers
+    /// @remark Must be called from the rendering thread, at most once per frame
+    /// @return The number of bytes uploaded
+    //-----------------------------------------------------------------------------------
+    size_t update();
+
+
+    //_____ Internal types __________
+private:
+    /// A range of vertices: [start, end[
+    typedef std::pair<unsigned int, unsigned int> tRange;
+    typedef std::vector<tRange>                   tRangesList;
+
+    /// A vertex data using a converted vertex buffer
+    typedef std::pair<Ogre::VertexData*, unsigned short>  tBinding;
+
+    struct tStream
+    {
+        std::vector<tBinding>                               bindings;
+        size_t                                              vertexSize;
+        std::vector<unsigned char>                          data;
+        std::vector<Ogre::HardwareVertexBufferSharedPtr>    buffers;
+        unsigned int                                        current;
+        std::vector<tRangesList>                            dirtyRanges;    ///< Per buffer
+    };
+
+
+private:
+    tStream& getStream(Ogre::VertexData* pVertexData, unsigned short usSource);
+
+    tStream& convertBuffer(const Ogre::HardwareVertexBufferSharedPtr& source);
+
+    void bindBuffer(const tStream& stream, const Ogre::HardwareVertexBufferSharedPtr& buffer);
+
+    Ogre::VertexData* getVertexData(unsigned short usSubMesh) const;
+
+    static void mergeRanges(tRangesList& ranges);
+
+
+    //_____ Constants __________
+public:
+    static const unsigned short SHARED_VERTICES;    ///< Index used for the shared vertices
+
+
+    //_____ Attributes __________
+private:
+    Ogre::MeshPtr           m_mesh;
+    tUpdateMode             m_mode;
+    unsigned int            m_nbBuffers;    ///< Number of buffers per vertex buffer
+    std::list<tStream>      m_streams;
+
+    /// The converted streams, by hardware buffer (each buffer of their rings)
+    std::map<Ogre::HardwareVertexBuffer*, tStream*> m_buffers;
+};
+
+}
+}
+
+#endif
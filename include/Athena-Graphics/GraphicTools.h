@@ -9,6 +9,7 @@
 
 #include <Athena-Graphics/Prerequisites.h>
 #include <Ogre/OgreSkeleton.h>
+#include <Ogre/OgreHardwareBuffer.h>
 #include <Ogre/OgreResourceGroupManager.h>
 
 
@@ -59,6 +60,31 @@ public:
     static void resetMaterials(Ogre::Entity* pOgreEntity);
     static void resetMaterials(Visual::Object* pVisualPart);
     static void resetMaterials(Entities::Entity* pEntity);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the content of a hardware buffer can be read back (either
+    ///         from its shadow buffer, or because it wasn't created with the
+    ///         HBU_WRITE_ONLY flag)
+    /// @remark The tools reading the vertices or the indices of a mesh (MeshClusters,
+    ///         MeshConverter, MeshSimplifier, MeshTransformer, DynamicMesh, ...) need
+    ///         readable buffers: a mesh loaded by its name through loadReadableMesh()
+    ///         always has them.
+    //-----------------------------------------------------------------------------------
+    static bool isReadable(const Ogre::HardwareBuffer* pBuffer);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Load a mesh with readable buffers (static ones, with a shadow buffer)
+    /// @remark A mesh already loaded without shadow buffers is reloaded (except the
+    ///         manual ones, which can't be)
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr loadReadableMesh(const std::string& strMeshName,
+                                          const std::string& strResourceGroup);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Read the indices of an index data (16 or 32 bits) into a list
+    /// @remark The index buffer must be readable (see isReadable())
+    //-----------------------------------------------------------------------------------
+    static void readIndices(const Ogre::IndexData* pIndexData, std::vector<unsigned int>& indices);
 };
 
 }
@@ -0,0 +1,204 @@
+/** @file   InstancedMesh.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::InstancedMesh'
+*/
+
+#ifndef _ATHENA_GRAPHICS_INSTANCEDMESH_H_
+#define _ATHENA_GRAPHICS_INSTANCEDMESH_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Math/AxisAlignedBox.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreMovableObject.h>
+#include <Ogre/OgreRenderable.h>
+#include <Ogre/OgreHardwareVertexBuffer.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Movable object drawing many copies of a mesh with hardware instancing, in one
+///         draw per submesh
+///
+/// The mesh must contain some instance buffers (see
+/// MeshBuilder::declareInstanceBuffer()), read by the vertex programs of its materials
+/// to place each copy (transforms, colours, animation offsets, ...).
+///
+/// Each InstancedMesh has its own instance buffers (the vertex and index buffers are
+/// shared with the mesh), so several of them can draw the same mesh with different
+/// instances. The instance buffers of the mesh are only used for their declaration
+/// and initial content (only copied if they are readable, see
+/// GraphicTools::isReadable(); the instances start zeroed otherwise).
+///
+/// @remark The submeshes must use the same instance buffers (same sources and sizes)
+/// @remark The skeleton of the mesh (if any) isn't used
+/// @remark The instances aren't known to Ogre: the bounding box of the object must
+///         enclose all of them (see setBoundingBox())
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL InstancedMesh: public Ogre::MovableObject
+{
+    //_____ Internal types __________
+private:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Renderable drawing all the instances of a submesh
+    //-----------------------------------------------------------------------------------
+    class InstancedSubMesh: public Ogre::Renderable
+    {
+    public:
+        InstancedSubMesh(InstancedMesh* pParent, Ogre::SubMesh* pSubMesh,
+                         Ogre::VertexData* pVertexData);
+
+        void setMaterialName(const std::string& strMaterial);
+
+        inline Ogre::SubMesh* getSubMesh() const
+        {
+            return m_pSubMesh;
+        }
+
+        virtual const Ogre::MaterialPtr& getMaterial() const
+        {
+            return m_material;
+        }
+
+        virtual void getRenderOperation(Ogre::RenderOperation& op);
+
+        virtual void getWorldTransforms(Ogre::Matrix4* xform) const;
+
+        virtual Ogre::Real getSquaredViewDepth(const Ogre::Camera* pCamera) const;
+
+        virtual const Ogre::LightList& getLights() const;
+
+    private:
+        InstancedMesh*      m_pParent;
+        Ogre::SubMesh*      m_pSubMesh;
+        Ogre::VertexData*   m_pVertexData;
+        Ogre::MaterialPtr   m_material;
+    };
+
+
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @param  strName     Name of the object
+    /// @param  mesh        The mesh (must be loaded)
+    //-----------------------------------------------------------------------------------
+    InstancedMesh(const std::string& strName, const Ogre::MeshPtr& mesh);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    virtual ~InstancedMesh();
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the mesh
+    //-----------------------------------------------------------------------------------
+    inline const Ogre::MeshPtr& getMesh() const
+    {
+        return m_mesh;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the number of instances to draw
+    /// @param  nbInstances     The number of instances (at most getMaxNbInstances())
+    //-----------------------------------------------------------------------------------
+    void setNbInstances(unsigned int nbInstances);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the number of instances to draw
+    //-----------------------------------------------------------------------------------
+    inline unsigned int getNbInstances() const
+    {
+        return m_nbInstances;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the maximum number of instances that the instance buffers can hold
+    //-----------------------------------------------------------------------------------
+    inline unsigned int getMaxNbInstances() const
+    {
+        return m_nbMaxInstances;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Modify the data of a range of instances of an instance buffer
+    /// @remark The data is written with one lock of the buffer (discarding its content
+    ///         if the whole buffer is written)
+    /// @param  usSource        Source of the instance buffer
+    /// @param  start           Index of the first element of the buffer to modify
+    /// @param  nbElements      Number of elements to modify
+    /// @param  pData           The data, in the layout of the buffer
+    //-----------------------------------------------------------------------------------
+    void setInstanceData(unsigned short usSource, unsigned int start, unsigned int nbElements,
+                         const void* pData);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns an instance buffer
+    /// @param  usSource        Source of the instance buffer
+    //-----------------------------------------------------------------------------------
+    Ogre::HardwareVertexBufferSharedPtr getInstanceBuffer(unsigned short usSource) const;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the bounding box enclosing all the instances, in the space of the
+    ///         object (by default, the bounds of the mesh)
+    //-----------------------------------------------------------------------------------
+    void setBoundingBox(const Math::AxisAlignedBox& box);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the material of all the submeshes
+    //-----------------------------------------------------------------------------------
+    void setMaterialName(const std::string& strMaterial);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the material of a submesh
+    //-----------------------------------------------------------------------------------
+    void setMaterialName(unsigned int subMesh, const std::string& strMaterial);
+
+
+    //_____ Implementation of Ogre::MovableObject __________
+public:
+    virtual const Ogre::String& getMovableType() const;
+
+    virtual const Ogre::AxisAlignedBox& getBoundingBox() const
+    {
+        return m_box;
+    }
+
+    virtual Ogre::Real getBoundingRadius() const
+    {
+        return m_radius;
+    }
+
+    virtual void _updateRenderQueue(Ogre::RenderQueue* pQueue);
+
+    virtual void visitRenderables(Ogre::Renderable::Visitor* pVisitor, bool debugRenderables = false);
+
+
+    //_____ Constants __________
+public:
+    static const std::string TYPE;  ///< Movable type of the objects
+
+
+    //_____ Attributes __________
+private:
+    Ogre::MeshPtr                                   m_mesh;
+    std::vector<InstancedSubMesh*>                  m_subMeshes;
+    std::vector<Ogre::VertexData*>                  m_vertexDatas;  ///< Copies of the
+                                                                    ///  vertex data of
+                                                                    ///  the mesh
+    std::map<unsigned short, Ogre::HardwareVertexBufferSharedPtr> m_instanceBuffers;
+    unsigned int                                    m_nbInstances;
+    unsigned int                                    m_nbMaxInstances;
+    Ogre::AxisAlignedBox                            m_box;
+    Ogre::Real                                      m_radius;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,90 @@
+/** @file   MeshBounds.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshBounds'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHBOUNDS_H_
+#define _ATHENA_GRAPHICS_MESHBOUNDS_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Math/AxisAlignedBox.h>
+#include <Athena-Math/Sphere.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class containing algorithms used to compute the bounding volumes of
+///         a set of vertices
+///
+/// The positions are given as 3 floats per vertex, with an optional stride (in bytes)
+/// between two consecutive positions.
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshBounds
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The bounding volumes of a set of vertices
+    //-----------------------------------------------------------------------------------
+    struct tBounds
+    {
+        Math::AxisAlignedBox    aabb;       ///< Bounding box
+        Math::Sphere            sphere;     ///< Bounding sphere (not centered on the
+                                            ///  origin)
+    };
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute the bounding box of some vertices
+    /// @remark Uses SSE when available
+    /// @param  pPositions  The positions of the vertices
+    /// @param  nbVertices  Number of vertices
+    /// @param  stride      Number of bytes between two consecutive positions, 0 if the
+    ///                     array is tightly packed
+    /// @return             The bounding box (null if there is no vertex)
+    //-----------------------------------------------------------------------------------
+    static Math::AxisAlignedBox computeAABB(const float* pPositions, unsigned int nbVertices,
+                                            size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute a near-optimal bounding sphere of some vertices, using Ritter's
+    ///         algorithm
+    /// @remark The result is usually less than 10% larger than the minimal sphere. The
+    ///         sphere centered on the bounding box is used instead when it is smaller.
+    /// @param  pPositions  The positions of the vertices
+    /// @param  nbVertices  Number of vertices
+    /// @param  stride      Number of bytes between two consecutive positions, 0 if the
+    ///                     array is tightly packed
+    /// @return             The bounding sphere
+    //-----------------------------------------------------------------------------------
+    static Math::Sphere computeSphere(const float* pPositions, unsigned int nbVertices,
+                                      size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute the bounding box and the bounding sphere of some vertices
+    /// @param  pPositions  The positions of the vertices
+    /// @param  nbVertices  Number of vertices
+    /// @param  stride      Number of bytes between two consecutive positions, 0 if the
+    ///                     array is tightly packed
+    /// @return             The bounding volumes
+    //-----------------------------------------------------------------------------------
+    static tBounds compute(const float* pPositions, unsigned int nbVertices, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the radius of a sphere centered on the origin containing some
+    ///         bounding volumes (as needed by Ogre::Mesh::_setBoundingSphereRadius())
+    /// @remark The smallest of the radii derived from the box and from the sphere is
+    ///         returned
+    //-----------------------------------------------------------------------------------
+    static Math::Real getRadiusFromOrigin(const tBounds& bounds);
+};
+
+}
+}
+
+#endif
@@ -8,6 +8,12 @@
 #define _ATHENA_GRAPHICS_MESHBUILDER_H_
 
 #include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Graphics/VertexCompression.h>
+#include <Athena-Graphics/MeshOptimizer.h>
+#include <Athena-Graphics/MeshClusters.h>
+#include <Athena-Graphics/MeshBounds.h>
+#include <Athena-Graphics/MeshCache.h>
+#include <Athena-Graphics/TangentSpaceGenerator.h>
 #include <Athena-Math/Vector3.h>
 #include <Athena-Math/Vector2.h>
 #include <Athena-Math/Quaternion.h>
@@ -29,9 +35,114 @@ namespace Graphics {
 /// Hardware Buffers approch.
 ///
 /// The design of the class is inspired by the one of Ogre::ManualObject.
+///
+/// When the commit is deferred, end() and endSharedVertices() only prepare the data of
+/// the mesh in system memory, without using any Ogre manager: several builders can then
+/// be used in parallel on worker threads (each builder by one thread at a time). The
+/// mesh and its hardware buffers are created by commit(), which must be called from the
+/// rendering thread.
+///
+/// The built meshes can be stored in an on-disk cache (see setCacheDirectory()), to
+/// skip their construction the next time the same data is given to the builder.
 //---------------------------------------------------------------------------------------
 class ATHENA_GRAPHICS_SYMBOL MeshBuilder
 {
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The ways the vertices and indices can be uploaded into the hardware
+    ///         buffers
+    //-----------------------------------------------------------------------------------
+    enum tUploadMode
+    {
+        UPLOAD_PER_ELEMENT, ///< One writeData() per element of each vertex (slowest,
+                            ///  only useful for comparison purposes)
+        UPLOAD_STAGING,     ///< Each buffer is assembled in system memory, then
+                            ///  uploaded with one writeData()
+        UPLOAD_LOCK,        ///< Each buffer is locked once (with HBL_DISCARD) and
+                            ///  filled directly (default)
+    };
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  The optimizations that can be applied to the triangle lists at end()
+    //-----------------------------------------------------------------------------------
+    enum tOptimization
+    {
+        OPTIMIZE_NONE           = 0,
+        OPTIMIZE_VERTEX_CACHE   = 1 << 0,   ///< Reorder the triangles for the
+                                            ///  post-transform vertex cache
+        OPTIMIZE_OVERDRAW       = 1 << 1,   ///< Reorder clusters of triangles to reduce
+                                            ///  the overdraw (not done on submeshes
+                                            ///  using the shared vertices)
+        OPTIMIZE_VERTEX_FETCH   = 1 << 2,   ///< Reorder the vertices by first use (not
+                                            ///  done on submeshes using the shared
+                                            ///  vertices)
+        OPTIMIZE_ALL            = OPTIMIZE_VERTEX_CACHE | OPTIMIZE_OVERDRAW | OPTIMIZE_VERTEX_FETCH,
+    };
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  The ways the vertex attributes can be distributed among the vertex
+    ///         buffers
+    //-----------------------------------------------------------------------------------
+    enum tVertexLayout
+    {
+        LAYOUT_DECLARED,        ///< One buffer per declared source (default)
+        LAYOUT_SPLIT_POSITIONS, ///< The positions (and the blending data of the hardware
+                                ///  skinning) in source 0, all the other attributes
+                                ///  interleaved in source 1, whatever their declared
+                                ///  source. Depth-only passes (shadow maps, depth
+                                ///  pre-pass) then only fetch the positions.
+    };
+
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Statistics about the construction of the mesh
+    //-----------------------------------------------------------------------------------
+    struct tStatistics
+    {
+        unsigned int    nbVertices;                 ///< Number of vertices uploaded
+        unsigned int    nbVerticesBeforeWelding;    ///< Number of vertices given to the
+                                                    ///  builder, before the welding
+        unsigned int    nbIndices;                  ///< Number of indices uploaded
+        unsigned int    nb32BitIndexBuffers;        ///< Number of index buffers that
+                                                    ///  needed 32-bit indexes
+        unsigned int    nbBufferLocks;              ///< Number of times a hardware buffer
+                                                    ///  was locked (each writeData() is a
+                                                    ///  lock)
+        size_t          nbBytesUploaded;            ///< Number of bytes uploaded
+        unsigned long   buildTime;                  ///< Time spent in end() and
+                                                    ///  endSharedVertices(), in
+                                                    ///  microseconds
+        size_t          nbBytesSaved;               ///< Number of bytes saved by the compact
+                                                    ///  vertex formats, compared to 32-bit
+                                                    ///  floats
+        MeshOptimizer::tCacheStatistics cacheBefore;    ///< Use of the vertex cache by the
+                                                        ///  optimized submeshes, before
+                                                        ///  the optimizations
+        MeshOptimizer::tCacheStatistics cacheAfter;     ///< Use of the vertex cache by the
+                                                        ///  optimized submeshes, after the
+                                                        ///  optimizations
+        unsigned int    nbBonePaletteSplits;        ///< Number of submeshes added by the
+                                                    ///  splitting by bone palette
+        bool            bLoadedFromCache;           ///< Indicates if the mesh was loaded
+                                                    ///  from the cache (the other
+                                                    ///  statistics, except the build time,
+                                                    ///  are the ones of its construction)
+    };
+
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  The scales that the vertex programs must apply to the attributes stored
+    ///         with VertexCompression::FORMAT_SHORT (1 for the other formats)
+    //-----------------------------------------------------------------------------------
+    struct tDequantization
+    {
+        Math::Real  position;                                   ///< Scale of the positions
+        Math::Real  texCoords[OGRE_MAX_TEXTURE_COORD_SETS];     ///< Scale of each set of
+                                                                ///  texture coordinates
+    };
+
+
     //_____ Construction / Destruction __________
 public:
     //-----------------------------------------------------------------------------------
@@ -39,9 +150,12 @@ public:
     /// @param  strMeshName         Name of the mesh
     /// @param  strResourceGroup    Name of the resource group in which the mesh is
     ///                             created
+    /// @param  bDeferredCommit     Indicates if the mesh is only created when commit() is
+    ///                             called
     //-----------------------------------------------------------------------------------
     MeshBuilder(const std::string& strMeshName, const std::string& strResourceGroup =
-                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+                bool bDeferredCommit = false);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Destructor
@@ -51,11 +165,282 @@ public:
 
     //_____ Methods __________
 public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Start the creation of a new mesh, reusing the builder
+    /// @remark The settings of the builder (upload mode, welding, optimizations, ...)
+    ///         are kept, and the memory used to stage the vertices and indices is reused,
+    ///         so building a lot of small meshes with the same builder doesn't allocate
+    ///         memory once the staging buffers are large enough.
+    /// @remark The previous mesh must be complete (all the submeshes ended)
+    /// @param  strMeshName         Name of the new mesh
+    /// @param  strResourceGroup    Name of the resource group in which the mesh is
+    ///                             created
+    //-----------------------------------------------------------------------------------
+    void reset(const std::string& strMeshName, const std::string& strResourceGroup =
+                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
     //-----------------------------------------------------------------------------------
     /// @brief  Set the name of the skeleton to assign to the mesh
     //-----------------------------------------------------------------------------------
     void setSkeletonName(const std::string& strSkeletonName);
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the way the vertices and indices are uploaded into the hardware
+    ///         buffers
+    //-----------------------------------------------------------------------------------
+    inline void setUploadMode(tUploadMode mode)
+    {
+        m_uploadMode = mode;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the way the vertices and indices are uploaded into the hardware
+    ///         buffers
+    //-----------------------------------------------------------------------------------
+    inline tUploadMode getUploadMode() const
+    {
+        return m_uploadMode;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the way the vertex attributes are distributed among the vertex
+    ///         buffers
+    /// @remark With LAYOUT_SPLIT_POSITIONS, the usage of each buffer is the one declared
+    ///         (see declareVertexBuffer()) for the source of its first attribute
+    //-----------------------------------------------------------------------------------
+    inline void setVertexLayout(tVertexLayout layout)
+    {
+        m_vertexLayout = layout;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the way the vertex attributes are distributed among the vertex
+    ///         buffers
+    //-----------------------------------------------------------------------------------
+    inline tVertexLayout getVertexLayout() const
+    {
+        return m_vertexLayout;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable or disable the welding of identical vertices
+    /// @remark When enabled, the vertices that have the same values for all their
+    ///         declared attributes (and blending data) are merged at end() and
+    ///         endSharedVertices(), and the indices are remapped accordingly. Submeshes
+    ///         without indices receive a list of indices.
+    /// @param  bEnabled    Indicates if the welding is enabled
+    /// @param  epsilon     Tolerance used when comparing the values: two vertices are
+    ///                     welded when their values differ by at most epsilon (0 for
+    ///                     exact comparisons). The blending indices are always
+    ///                     compared exactly.
+    //-----------------------------------------------------------------------------------
+    inline void setWelding(bool bEnabled, Math::Real epsilon = 0.0f)
+    {
+        m_bWelding          = bEnabled;
+        m_weldingEpsilon    = epsilon;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the welding of identical vertices is enabled
+    //-----------------------------------------------------------------------------------
+    inline bool isWeldingEnabled() const
+    {
+        return m_bWelding;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the optimizations applied to the indexed triangle lists at end()
+    /// @param  optimizations   Combination of tOptimization values
+    //-----------------------------------------------------------------------------------
+    inline void setOptimizations(unsigned int optimizations)
+    {
+        m_optimizations = optimizations;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the optimizations applied to the indexed triangle lists at end()
+    //-----------------------------------------------------------------------------------
+    inline unsigned int getOptimizations() const
+    {
+        return m_optimizations;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable or disable the generation of the normals of the triangle lists at
+    ///         end()
+    /// @remark The generated normals replace the ones given with normal() or normals().
+    ///         Not done on submeshes using the shared vertices.
+    /// @param  bEnabled    Indicates if the normals must be generated
+    /// @param  weighting   Weighting of the normals of the triangles
+    //-----------------------------------------------------------------------------------
+    inline void setNormalsGeneration(bool bEnabled,
+                                     TangentSpaceGenerator::tWeighting weighting = TangentSpaceGenerator::WEIGHT_ANGLE)
+    {
+        m_bGenerateNormals  = bEnabled;
+        m_normalsWeighting  = weighting;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable or disable the generation of the tangents (and binormals) of the
+    ///         triangle lists at end()
+    /// @remark The tangents are computed from the normals and a set of (2D) texture
+    ///         coordinates, which must both be present (the normals can be generated,
+    ///         see setNormalsGeneration()). Not done on submeshes using the shared
+    ///         vertices.
+    /// @param  bEnabled        Indicates if the tangents must be generated
+    /// @param  bBinormals      Indicates if the binormals must be generated too
+    /// @param  usTexCoordSet   Index of the set of texture coordinates to use
+    //-----------------------------------------------------------------------------------
+    inline void setTangentsGeneration(bool bEnabled, bool bBinormals = false,
+                                      unsigned short usTexCoordSet = 0)
+    {
+        m_bGenerateTangents     = bEnabled;
+        m_bGenerateBinormals    = bBinormals;
+        m_usTangentsTexCoordSet = usTexCoordSet;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable or disable the hardware skinning streams
+    /// @remark When enabled, the blending data is written into VES_BLEND_INDICES
+    ///         (VET_UBYTE4) and VES_BLEND_WEIGHTS elements, in a vertex buffer following
+    ///         the declared ones, instead of being given to Ogre as bone assignments to
+    ///         compile when the mesh is loaded. The blending indices are the ones of the
+    ///         bone palette of the submesh (Ogre::SubMesh::blendIndexToBoneIndexMap).
+    /// @remark The lists using more bones than one draw can hold are split into several
+    ///         submeshes (named "<name>", "<name>.1", "<name>.2", ...), each one with its
+    ///         own palette. The strips, the fans and the shared vertices can't be split.
+    /// @param  bEnabled            Indicates if the hardware skinning streams are used
+    /// @param  usMaxBonesPerDraw   Number of bones that the vertex programs can use in
+    ///                             one draw (at most 256)
+    //-----------------------------------------------------------------------------------
+    inline void setHardwareSkinning(bool bEnabled, unsigned short usMaxBonesPerDraw = 256)
+    {
+        assert((usMaxBonesPerDraw > 0) && (usMaxBonesPerDraw <= 256));
+
+        m_bHardwareSkinning     = bEnabled;
+        m_usMaxBonesPerDraw     = usMaxBonesPerDraw;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the hardware skinning streams are used
+    //-----------------------------------------------------------------------------------
+    inline bool isHardwareSkinningEnabled() const
+    {
+        return m_bHardwareSkinning;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the maximum number of bones influencing each vertex
+    /// @remark At end() and endSharedVertices(), the influences of each vertex are
+    ///         sorted by decreasing weight, only the strongest ones are kept, and their
+    ///         weights are renormalized to sum to 1
+    /// @param  usMaxInfluences     The maximum number of influences, from 1 to 4
+    ///                             (default: 4)
+    //-----------------------------------------------------------------------------------
+    inline void setMaxBoneInfluences(unsigned short usMaxInfluences)
+    {
+        assert((usMaxInfluences > 0) && (usMaxInfluences <= OGRE_MAX_BLEND_WEIGHTS));
+
+        m_usMaxBoneInfluences = usMaxInfluences;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable or disable the partitioning of the indexed triangle lists into
+    ///         clusters
+    /// @remark The triangles are reordered cluster by cluster at end(), after the other
+    ///         optimizations. Not done on submeshes using the shared vertices.
+    /// @param  bEnabled        Indicates if the clusters must be built
+    /// @param  nbMaxTriangles  Maximum number of triangles per cluster
+    //-----------------------------------------------------------------------------------
+    inline void setClustering(bool bEnabled, unsigned int nbMaxTriangles = 128)
+    {
+        m_bClustering           = bEnabled;
+        m_nbMaxClusterTriangles = nbMaxTriangles;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the directory of the on-disk cache of the meshes (empty to disable
+    ///         the cache, the default)
+    /// @remark When the cache is enabled, end() and endSharedVertices() only compute a
+    ///         hash of the data given to the builder (declarations, vertices, indices,
+    ///         materials, skeleton name and settings). If a mesh with the same hash is in
+    ///         the cache, it is loaded by getMesh() (or commit() when the commit is
+    ///         deferred) and the construction of the submeshes is skipped. Otherwise the
+    ///         submeshes are built at that time, and the mesh is saved in the cache.
+    /// @remark The settings in effect when the mesh is completed apply to all its
+    ///         submeshes. The cache isn't used with the clustering or the hardware
+    ///         skinning streams (their data can't be stored), nor if some submeshes were
+    ///         already ended when it was enabled. A submesh with instance buffers disables
+    ///         it for the whole mesh.
+    /// @remark The cache only stores one usage (and shadow buffer flag) for all the
+    ///         vertex buffers of a mesh, and one for all its index buffers: it isn't used
+    ///         for a mesh whose buffers were declared with different ones
+    /// @remark The write-only buffers of a mesh built to be saved in the cache get a
+    ///         shadow buffer, so the mesh can be exported without reading the hardware
+    ///         buffers back
+    /// @param  strDirectory    The cache directory (must exist)
+    //-----------------------------------------------------------------------------------
+    inline void setCacheDirectory(const std::string& strDirectory)
+    {
+        m_strCacheDirectory = strDirectory;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the directory of the on-disk cache of the meshes
+    //-----------------------------------------------------------------------------------
+    inline const std::string& getCacheDirectory() const
+    {
+        return m_strCacheDirectory;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the cache directory of the builders created afterwards (empty to
+    ///         disable the cache, the default)
+    /// @remark Allows to cache the meshes built internally (Debug::Skeleton,
+    ///         Visual::Plane, ...)
+    //-----------------------------------------------------------------------------------
+    static void setDefaultCacheDirectory(const std::string& strDirectory);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the cache directory of the builders created afterwards
+    //-----------------------------------------------------------------------------------
+    static const std::string& getDefaultCacheDirectory();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the clusters of the submeshes (in the order of their creation)
+    /// @remark See Visual::Object::enableClusterCulling()
+    //-----------------------------------------------------------------------------------
+    inline const MeshClusters& getClusters() const
+    {
+        return m_clusters;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the statistics about the construction of the mesh
+    //-----------------------------------------------------------------------------------
+    inline const tStatistics& getStatistics() const
+    {
+        return m_statistics;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the dequantization scales of the vertices of a submesh
+    /// @remark The scales must be given to the vertex program of the submesh, for
+    ///         instance with Ogre::SubEntity::setCustomParameter()
+    /// @param  strSubMeshName  Name of the submesh, empty for the shared vertices
+    //-----------------------------------------------------------------------------------
+    const tDequantization& getDequantization(const std::string& strSubMeshName = "") const;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the bounding box and bounding sphere of the vertices of a submesh
+    /// @remark Useful to cull or pick the submeshes individually. The submeshes using
+    ///         the shared vertices have the bounds of the shared vertices. The bounds of
+    ///         the whole mesh are the ones of Ogre::Mesh (its bounding sphere radius is
+    ///         relative to the origin, as required by Ogre).
+    /// @param  strSubMeshName  Name of the submesh, empty for the shared vertices
+    //-----------------------------------------------------------------------------------
+    const MeshBounds::tBounds& getBounds(const std::string& strSubMeshName = "") const;
+
     //-----------------------------------------------------------------------------------
     /// @brief  Start defining the shared vertices of the mesh
     /// @remark Optional
@@ -121,8 +506,11 @@ public:
     ///         you use one of the declare*() methods (beside declareVertexBuffer() and
     ///         declareIndexBuffer), you must fully declare your vertex structure.
     /// @param  usSource    Vertex buffer index
+    /// @param  format      Format of the positions (FORMAT_FLOAT or FORMAT_SHORT), see
+    ///                     getDequantization()
     //-----------------------------------------------------------------------------------
-    void declarePosition(unsigned short usSource = 0);
+    void declarePosition(unsigned short usSource = 0,
+                         VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Declare the vertex buffer that contains the normals of the vertices
@@ -130,8 +518,10 @@ public:
     ///         you use one of the declare*() methods (beside declareVertexBuffer() and
     ///         declareIndexBuffer), you must fully declare your vertex structure.
     /// @param  usSource    Vertex buffer index
+    /// @param  format      Format of the normals (all the formats are supported)
     //-----------------------------------------------------------------------------------
-    void declareNormal(unsigned short usSource = 0);
+    void declareNormal(unsigned short usSource = 0,
+                       VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Declare the vertex buffer that contains the diffuse colours of the vertices
@@ -159,8 +549,11 @@ public:
     /// @remark A vertex can have more than one texture coordinates set.
     /// @param  usSource    Vertex buffer index
     /// @param  size        Number of texture coordinates in the set
+    /// @param  format      Format of the texture coordinates (FORMAT_FLOAT or FORMAT_SHORT),
+    ///                     see getDequantization()
     //-----------------------------------------------------------------------------------
-    void declareTextureCoordinates(unsigned short usSource = 0, unsigned short size = 2);
+    void declareTextureCoordinates(unsigned short usSource = 0, unsigned short size = 2,
+                                   VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Declare the vertex buffer that contains the binormals of the vertices
@@ -169,9 +562,10 @@ public:
     ///         declareIndexBuffer), you must fully declare your vertex structure.
     /// @remark A vertex can have more than one texture coordinates set.
     /// @param  usSource    Vertex buffer index
-    /// @param  size        Number of texture coordinates in the set
+    /// @param  format      Format of the binormals (all the formats are supported)
     //-----------------------------------------------------------------------------------
-    void declareBinormal(unsigned short usSource = 0);
+    void declareBinormal(unsigned short usSource = 0,
+                         VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Declare the vertex buffer that contains the tangents of the vertices
@@ -180,9 +574,49 @@ public:
     ///         declareIndexBuffer), you must fully declare your vertex structure.
     /// @remark A vertex can have more than one texture coordinates set.
     /// @param  usSource    Vertex buffer index
-    /// @param  size        Number of texture coordinates in the set
-    //-----------------------------------------------------------------------------------
-    void declareTangent(unsigned short usSource = 0);
+    /// @param  format      Format of the tangents (all the formats are supported)
+    //-----------------------------------------------------------------------------------
+    void declareTangent(unsigned short usSource = 0,
+                        VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Declare a vertex buffer containing per-instance data, for the hardware
+    ///         instancing
+    /// @remark The elements of the buffer are declared with declareInstanceElement(), and
+    ///         its content (zero by default) is given with instanceData(). The buffer is
+    ///         created with the per-vertex ones, and flagged as instance data (see
+    ///         Ogre::HardwareVertexBuffer::setIsInstanceData()).
+    /// @remark The source must not be used by the per-vertex buffers (including the
+    ///         skinning streams and the two buffers of LAYOUT_SPLIT_POSITIONS). All the
+    ///         submeshes of a mesh drawn by an InstancedMesh must declare the same instance
+    ///         buffers.
+    /// @remark A mesh with instance buffers isn't stored in the cache
+    /// @param  usSource        Vertex buffer index
+    /// @param  nbInstances     Number of instances the buffer can hold
+    /// @param  stepRate        Number of instances drawn before advancing to the next
+    ///                         element of the buffer
+    /// @param  usage           Usage of the buffer (dynamic by default, since the instance
+    ///                         data is usually updated often)
+    /// @param  bUseShadowBuffer    Indicates if the buffer is 'shadowed' by one in system
+    ///                             memory
+    //-----------------------------------------------------------------------------------
+    void declareInstanceBuffer(unsigned short usSource, unsigned int nbInstances,
+                               unsigned int stepRate = 1,
+                               Ogre::HardwareBuffer::Usage usage = Ogre::HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY_DISCARDABLE,
+                               bool bUseShadowBuffer = false);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Declare an element of an instance buffer
+    /// @remark The elements are stored in the order of their declaration. The usual
+    ///         choice is some texture coordinates (for instance three VET_FLOAT4 for a
+    ///         3x4 transformation matrix), or a colour.
+    /// @param  usSource    Index of the instance buffer (see declareInstanceBuffer())
+    /// @param  type        Type of the element
+    /// @param  semantic    Semantic of the element
+    /// @param  usIndex     Index of the element (for the texture coordinates)
+    //-----------------------------------------------------------------------------------
+    void declareInstanceElement(unsigned short usSource, Ogre::VertexElementType type,
+                                Ogre::VertexElementSemantic semantic, unsigned short usIndex = 0);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Add a vertex position, starting a new vertex at the same time
@@ -382,45 +816,159 @@ public:
     //-----------------------------------------------------------------------------------
     void tangent(Math::Real x, Math::Real y, Math::Real z);
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add the positions of several vertices at once, starting a new batch of
+    ///         vertices at the same time
+    /// @remark This is the bulk counterpart of position(): all the other bulk methods
+    ///         (normals(), textureCoords(), ...) called after this one fill the
+    ///         attributes of the vertices of the batch. The data is copied, so the source
+    ///         arrays can be released as soon as the method returns.
+    /// @remark The bulk methods can be mixed with the per-vertex ones: both append the
+    ///         vertices to the same arrays
+    /// @param  pPositions  Pointer to the first position (3 components per vertex)
+    /// @param  nbVertices  Number of vertices in the batch
+    /// @param  stride      Number of bytes between two consecutive positions, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void positions(const Math::Real* pPositions, unsigned int nbVertices, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some blending weights and indices to the vertices of the current batch
+    /// @param  pIndices        Pointer to the first set of indices
+    /// @param  pWeights        Pointer to the first set of weights
+    /// @param  nbWeights       Number of weights (and indices) per vertex
+    /// @param  indicesStride   Number of bytes between two consecutive sets of indices, 0
+    ///                         if the array is tightly packed
+    /// @param  weightsStride   Number of bytes between two consecutive sets of weights, 0
+    ///                         if the array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void blendingData(const unsigned short* pIndices, const Math::Real* pWeights,
+                      unsigned short nbWeights, size_t indicesStride = 0,
+                      size_t weightsStride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some normals to the vertices of the current batch
+    /// @param  pNormals    Pointer to the first normal (3 components per vertex)
+    /// @param  stride      Number of bytes between two consecutive normals, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void normals(const Math::Real* pNormals, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some diffuse colors to the vertices of the current batch
+    /// @param  pColors     Pointer to the first color (4 components per vertex: red,
+    ///                     green, blue and alpha)
+    /// @param  stride      Number of bytes between two consecutive colors, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void diffuseColors(const Math::Real* pColors, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some specular colors to the vertices of the current batch
+    /// @param  pColors     Pointer to the first color (4 components per vertex: red,
+    ///                     green, blue and alpha)
+    /// @param  stride      Number of bytes between two consecutive colors, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void specularColors(const Math::Real* pColors, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a set of texture coordinates to the vertices of the current batch
+    /// @remark You can call this method multiple times between positions() calls to add
+    ///         multiple texture coordinates sets to the vertices
+    /// @param  pTexCoords  Pointer to the first texture coordinate
+    /// @param  dims        Number of components of each texture coordinate (1 to 3)
+    /// @param  stride      Number of bytes between two consecutive texture coordinates,
+    ///                     0 if the array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void textureCoords(const Math::Real* pTexCoords, unsigned short dims = 2, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some binormals to the vertices of the current batch
+    /// @param  pBinormals  Pointer to the first binormal (3 components per vertex)
+    /// @param  stride      Number of bytes between two consecutive binormals, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void binormals(const Math::Real* pBinormals, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add some tangents to the vertices of the current batch
+    /// @param  pTangents   Pointer to the first tangent (3 components per vertex)
+    /// @param  stride      Number of bytes between two consecutive tangents, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    void tangents(const Math::Real* pTangents, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the initial content of a range of instances of an instance buffer
+    /// @remark The data is copied, in the layout given by the declaration of the buffer.
+    ///         Use InstancedMesh::setInstanceData() to modify it once the mesh is built
+    ///         (an InstancedMesh only starts with this content if the buffer is readable).
+    /// @param  usSource        Index of the instance buffer (see declareInstanceBuffer())
+    /// @param  pData           Pointer to the data of the first instance
+    /// @param  nbInstances     Number of instances
+    /// @param  firstInstance   Index of the first instance to set
+    //-----------------------------------------------------------------------------------
+    void instanceData(unsigned short usSource, const void* pData, unsigned int nbInstances,
+                      unsigned int firstInstance = 0);
+
     //-----------------------------------------------------------------------------------
     /// @brief  Add a vertex index to construct faces/lines/points via indexing rather than
     ///         just by a simple list of vertices
     /// @remark You will have to call this 3 times for each face for a triangle list, or use
     ///         the alternative 3-parameter version. Other operation types require different
     ///         numbers of indexes, @see RenderOperation::OperationType.
-    /// @note   32-bit indexes are not supported on all cards which is why this class only
-    ///         allows 16-bit indexes, for simplicity and ease of use
-    /// @param  idx     A vertex index from 0 to 65535
+    /// @note   A 32-bit index buffer is only used if the submesh references a vertex
+    ///         above 65535, so small meshes keep using 16-bit indexes
+    /// @param  idx     A vertex index
     //-----------------------------------------------------------------------------------
-    void index(unsigned short index);
+    void index(unsigned int index);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Add a set of 2 vertex indices to construct a line; this is a shortcut to
     ///         calling index() 2 times. It is only valid for line lists.
-    /// @note   32-bit indexes are not supported on all cards which is why this class only
-    ///         allows 16-bit indexes, for simplicity and ease of use
-    /// @param  i1, i2, i3  3 vertex indices from 0 to 65535 defining a face
+    /// @note   A 32-bit index buffer is only used if the submesh references a vertex
+    ///         above 65535, so small meshes keep using 16-bit indexes
+    /// @param  i1, i2  2 vertex indices defining a line
     //-----------------------------------------------------------------------------------
-    void line(unsigned short i1, unsigned short i2);
+    void line(unsigned int i1, unsigned int i2);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Add a set of 3 vertex indices to construct a triangle; this is a shortcut to
     ///         calling index() 3 times. It is only valid for triangle lists.
-    /// @note   32-bit indexes are not supported on all cards which is why this class only
-    ///         allows 16-bit indexes, for simplicity and ease of use
-    /// @param  i1, i2, i3  3 vertex indices from 0 to 65535 defining a face
+    /// @note   A 32-bit index buffer is only used if the submesh references a vertex
+    ///         above 65535, so small meshes keep using 16-bit indexes
+    /// @param  i1, i2, i3  3 vertex indices defining a face
     //-----------------------------------------------------------------------------------
-    void triangle(unsigned short i1, unsigned short i2, unsigned short i3);
+    void triangle(unsigned int i1, unsigned int i2, unsigned int i3);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Add a set of 4 vertex indices to construct a quad (out of 2 triangles); this
     ///         is a shortcut to calling index() 6 times, or triangle() twice. It's only
     ///         valid for triangle list operations.
-    /// @note   32-bit indexes are not supported on all cards which is why this class only
-    ///         allows 16-bit indexes, for simplicity and ease of use
-    /// @param  i1, i2, i3, i4  4 vertex indices from 0 to 65535 defining a quad
+    /// @note   A 32-bit index buffer is only used if the submesh references a vertex
+    ///         above 65535, so small meshes keep using 16-bit indexes
+    /// @param  i1, i2, i3, i4  4 vertex indices defining a quad
+    //-----------------------------------------------------------------------------------
+    void quad(unsigned int i1, unsigned int i2, unsigned int i3, unsigned int i4);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add several vertex indices at once
+    /// @remark The indices are relative to the first vertex of the submesh, like the ones
+    ///         given to index()
+    /// @param  pIndices    Pointer to the first index
+    /// @param  nbIndices   Number of indices
+    //-----------------------------------------------------------------------------------
+    void indices(const unsigned short* pIndices, unsigned int nbIndices);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add several 32-bit vertex indices at once
+    /// @remark The indices are relative to the first vertex of the submesh, like the ones
+    ///         given to index()
+    /// @param  pIndices    Pointer to the first index
+    /// @param  nbIndices   Number of indices
     //-----------------------------------------------------------------------------------
-    void quad(unsigned short i1, unsigned short i2, unsigned short i3, unsigned short i4);
+    void indices(const unsigned int* pIndices, unsigned int nbIndices);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Finish defining the submesh
@@ -432,8 +980,17 @@ public:
     //-----------------------------------------------------------------------------------
     void endSharedVertices();
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Create the mesh and its hardware buffers from the data prepared by the
+    ///         calls to end() and endSharedVertices()
+    /// @remark Only needed when the commit is deferred. Must be called from the rendering
+    ///         thread.
+    //-----------------------------------------------------------------------------------
+    void commit();
+
     //-----------------------------------------------------------------------------------
     /// @brief  Returns the mesh
+    /// @remark When the commit is deferred, commit() must be called first
     /// @return The mesh
     //-----------------------------------------------------------------------------------
     Ogre::MeshPtr getMesh();
@@ -442,12 +999,7 @@ public:
     /// @brief  Returns the number of vertices in the current submesh
     /// @return The number of vertices
     //-----------------------------------------------------------------------------------
-    unsigned short getNbVertices();
-
-private:
-    void copyTempVertexToBuffer();
-
-    Ogre::VertexData* createVertexData();
+    unsigned int getNbVertices();
 
 
     //_____ Internal types __________
@@ -457,22 +1009,51 @@ private:
         Ogre::VertexElementSemantic semantic;
         Ogre::VertexElementType     type;
         unsigned short              usIndex;
+        unsigned short              usNbComponents;
+        VertexCompression::tFormat  format;
     };
 
 
-    struct tVertex
+    /// The vertices are staged in one array per attribute, only for the declared
+    /// attributes, with the number of components of their declaration
+    struct tVertexStreams
     {
-        Math::Vector3   position;
-        unsigned short  blendingDim;
-        Math::Real      blendingWeights[OGRE_MAX_BLEND_WEIGHTS];
-        unsigned short  blendingIndices[OGRE_MAX_BLEND_WEIGHTS];
-        Math::Vector3   normal;
-        Math::Color     diffuseColour;
-        Math::Color     specularColour;
-        Math::Vector3   texCoord[OGRE_MAX_TEXTURE_COORD_SETS];
-        unsigned short  texCoordDims[OGRE_MAX_TEXTURE_COORD_SETS];
-        Math::Vector3   binormal;
-        Math::Vector3   tangent;
+        unsigned int                nbVertices;
+        unsigned int                batchStart;
+        std::vector<float>          positions;
+        std::vector<float>          normals;
+        std::vector<float>          diffuseColours;
+        std::vector<float>          specularColours;
+        std::vector<float>          texCoords[OGRE_MAX_TEXTURE_COORD_SETS];
+        unsigned short              texCoordDims[OGRE_MAX_TEXTURE_COORD_SETS];
+        std::vector<float>          binormals;
+        std::vector<float>          tangents;
+        unsigned short              blendingDim;
+        std::vector<float>          blendingWeights;
+        std::vector<unsigned short> blendingIndices;
+
+        /// Exchange the content of two sets of streams, without any allocation
+        void swap(tVertexStreams& other)
+        {
+            std::swap(nbVertices, other.nbVertices);
+            std::swap(batchStart, other.batchStart);
+            positions.swap(other.positions);
+            normals.swap(other.normals);
+            diffuseColours.swap(other.diffuseColours);
+            specularColours.swap(other.specularColours);
+
+            for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+            {
+                texCoords[i].swap(other.texCoords[i]);
+                std::swap(texCoordDims[i], other.texCoordDims[i]);
+            }
+
+            binormals.swap(other.binormals);
+            tangents.swap(other.tangents);
+            std::swap(blendingDim, other.blendingDim);
+            blendingWeights.swap(other.blendingWeights);
+            blendingIndices.swap(other.blendingIndices);
+        }
     };
 
 
@@ -483,32 +1064,291 @@ private:
     };
 
 
+    /// A vertex buffer holding per-instance data (already in the layout of the hardware
+    /// buffer)
+    struct tInstanceBuffer
+    {
+        unsigned short              usSource;
+        std::vector<tElement>       elements;
+        size_t                      instanceSize;
+        unsigned int                nbInstances;
+        unsigned int                stepRate;
+        tHardwareBufferInfo         info;
+        std::vector<unsigned char>  data;
+    };
+
+
     struct tSubMesh
     {
         std::string                                         strName;
         std::string                                         strMaterial;
         bool                                                bUseSharedVertices;
         Ogre::RenderOperation::OperationType                opType;
-        std::map<unsigned short, std::vector<tElement> >    verticesElements;
-        std::map<unsigned short, tHardwareBufferInfo>       vertexBufferInfos;
+        std::vector<std::vector<tElement> >                 verticesElements;
+        unsigned int                                        declaredSemantics;
+        std::vector<tHardwareBufferInfo>                    vertexBufferInfos;
         tHardwareBufferInfo                                 indexBufferInfo;
-        std::vector<tVertex>                                vertices;
-        std::vector<unsigned short>                         indices;
+        tVertexStreams                                      streams;
+        std::vector<unsigned int>                           indices;
+        std::vector<tInstanceBuffer>                        instanceBuffers;
+
+        /// Exchange the content of two submeshes, without any allocation
+        void swap(tSubMesh& other)
+        {
+            strName.swap(other.strName);
+            strMaterial.swap(other.strMaterial);
+            std::swap(bUseSharedVertices, other.bUseSharedVertices);
+            std::swap(opType, other.opType);
+            verticesElements.swap(other.verticesElements);
+            std::swap(declaredSemantics, other.declaredSemantics);
+            vertexBufferInfos.swap(other.vertexBufferInfos);
+            std::swap(indexBufferInfo, other.indexBufferInfo);
+            streams.swap(other.streams);
+            indices.swap(other.indices);
+            instanceBuffers.swap(other.instanceBuffers);
+        }
     };
 
 
+    /// Data of a vertex buffer, ready to be uploaded (the vertices are only interleaved
+    /// in system memory when the commit is deferred)
+    struct tAssembledVertexBuffer
+    {
+        unsigned short              usSource;
+        std::vector<tElement>       elements;
+        size_t                      vertexSize;
+        tHardwareBufferInfo         info;
+        std::vector<unsigned char>  data;
+    };
+
+
+    struct tAssembledVertexData
+    {
+        unsigned int                        nbVertices;
+        std::vector<tAssembledVertexBuffer> buffers;
+        std::vector<unsigned short>         bonePalette;
+        std::vector<tInstanceBuffer>        instanceBuffers;
+    };
+
+
+    struct tAssembledSubMesh
+    {
+        std::string                             strName;
+        std::string                             strMaterial;
+        bool                                    bUseSharedVertices;
+        Ogre::RenderOperation::OperationType    opType;
+        tAssembledVertexData                    vertexData;
+        std::vector<Ogre::VertexBoneAssignment> boneAssignments;
+        Ogre::HardwareIndexBuffer::IndexType    indexType;
+        tHardwareBufferInfo                     indexBufferInfo;
+        std::vector<unsigned int>               indices;
+    };
+
+
+    /// Temporary buffers used by the processing passes of end(), kept from one submesh
+    /// (and mesh) to the next to avoid reallocations
+    struct tScratchBuffers
+    {
+        std::vector<std::vector<tElement> >  sources;
+        std::vector<tHardwareBufferInfo>     infos;
+        std::vector<tElement>                elements;
+        std::vector<unsigned int>            remap;
+        std::vector<unsigned int>            order;
+        std::vector<unsigned int>            table;
+        std::vector<int>                     keys;
+        std::vector<float>                   values;
+        std::vector<long long>               cells;
+        std::vector<float>                   floats;
+        std::vector<unsigned short>          shorts;
+        std::vector<unsigned int>            indices;
+        std::vector<unsigned int>            vertices;
+        std::vector<unsigned int>            groups;
+        std::vector<std::vector<unsigned short> > palettes;
+        tVertexStreams                       streams;
+    };
+
+
+private:
+    void processSubMesh();
+
+    void processSharedVertices();
+
+    void resetCurrentSubMesh();
+
+    void postponeCurrentSubMesh();
+
+    void releasePendingSubMeshes();
+
+    bool isCacheUsed() const;
+
+    bool hasUniformBufferPolicies() const;
+
+    bool getVertexBufferPolicy(const tSubMesh& subMesh, tHardwareBufferInfo& policy) const;
+
+    void hashCurrentSubMesh();
+
+    void hashSettings();
+
+    bool buildPendingSubMeshes();
+
+    void processPendingSubMeshes();
+
+    bool loadFromCache();
+
+    void saveToCache();
+
+    void writeCacheData(std::vector<unsigned char>& data) const;
+
+    bool useShadowBuffer(const tHardwareBufferInfo& info) const;
+
+    bool readCacheData(const std::vector<unsigned char>& data);
+
+    void endSubMesh();
+
+    void splitByBonePalette();
+
+    void assembleSubMesh(tAssembledSubMesh& subMesh);
+
+    void assembleVertexData(tAssembledVertexData& vertexData);
+
+    void groupElements(bool bSkinningStreams, std::vector<std::vector<tElement> >& sources,
+                       std::vector<tHardwareBufferInfo>& infos) const;
+
+    void commitSubMesh(const tAssembledSubMesh& subMesh);
+
+    Ogre::VertexData* createVertexData(const tAssembledVertexData& vertexData);
+
+    void uploadVertices(const Ogre::HardwareVertexBufferSharedPtr& buffer,
+                        const std::vector<tElement>& elements, const unsigned char* pData);
+
+    void uploadIndices(const Ogre::HardwareIndexBufferSharedPtr& buffer,
+                       const std::vector<unsigned int>& indices);
+
+    void createInstanceBuffers(const std::vector<tInstanceBuffer>& instanceBuffers,
+                               Ogre::VertexData* pVertexData);
+
+    tInstanceBuffer* getInstanceBuffer(unsigned short usSource);
+
+    void updateMeshBounds();
+
+    void copyToStream(std::vector<float>& stream, unsigned short nbComponents,
+                      const Math::Real* pSource, size_t stride,
+                      unsigned short nbSourceComponents = 0);
+
+    void setCurrentValues(std::vector<float>& stream, unsigned short nbComponents,
+                          const float* pValues, unsigned short nbValues);
+
+    void setCurrentBlendingIndices(const unsigned short* pIndices, unsigned short nbIndices);
+
+    void setBlendingDim(unsigned short dim);
+
+    void addTextureCoord(const float* pValues, unsigned short dims);
+
+    inline bool isDeclared(Ogre::VertexElementSemantic semantic) const
+    {
+        return (m_currentSubMesh.declaredSemantics & (1 << semantic)) != 0;
+    }
+
+    void writeStreams(const std::vector<tElement>& elements, size_t vertexSize,
+                      unsigned char* pDest);
+
+    void writeElement(const tElement& element, const float* pValues, unsigned char* pDest);
+
+    const std::vector<float>* getStream(const tElement& element, unsigned short& nbComponents) const;
+
+    void addElement(unsigned short usSource, Ogre::VertexElementSemantic semantic,
+                    unsigned short usIndex, unsigned short usNbComponents,
+                    VertexCompression::tFormat format);
+
+    void computeDequantization();
+
+    void weldVertices(std::vector<unsigned int>& remap);
+
+    void findIdenticalVertices(unsigned int keySize, std::vector<unsigned int>& kept,
+                               std::vector<unsigned int>& remap);
+
+    void findSimilarVertices(unsigned int keySize, std::vector<unsigned int>& kept,
+                             std::vector<unsigned int>& remap);
+
+    void reorderVertices(const std::vector<unsigned int>& order);
+
+    void optimizeIndices(unsigned int nbVertices);
+
+    void buildClusters();
+
+    void generateTangentSpace();
+
+    void limitBoneInfluences();
+
+    bool usesSkinningStreams() const;
+
+    void collectBones(std::vector<unsigned short>& bones) const;
+
+    void buildBonePalette(std::vector<unsigned short>& palette);
+
+    void setVertexValues(Ogre::VertexElementSemantic semantic, const float* pValues);
+
+    bool hasElement(Ogre::VertexElementSemantic semantic, unsigned short usIndex = 0) const;
+
+    void remapIndices(const std::vector<unsigned int>& remap);
+
+    void getVertexValues(unsigned int index, const tElement& element, float* pValues) const;
+
+    void clearStaging();
+
+
     //_____ Attributes __________
 private:
-    Ogre::MeshPtr               m_mesh;
-    bool                        m_bIsSharedVertices;
-    tSubMesh                    m_currentSubMesh;
-    bool                        m_bFirstVertex;
-    bool                        m_bAutomaticDeclaration;
-    bool                        m_bTempVertexPending;
-    tVertex                     m_currentVertex;
-    Math::AxisAlignedBox        m_AABB;
-    Math::Real                  m_radius;
-    unsigned short              m_usTextureCoordsIndex;
+    Ogre::MeshPtr                           m_mesh;
+    std::string                             m_strMeshName;
+    std::string                             m_strResourceGroup;
+    std::string                             m_strSkeletonName;
+    bool                                    m_bDeferredCommit;
+    bool                                    m_bIsSharedVertices;
+    bool                                    m_bHasSharedVertices;
+    tAssembledVertexData                    m_sharedVertices;
+    std::list<tAssembledSubMesh>            m_assembledSubMeshes;
+    tSubMesh                                m_currentSubMesh;
+    bool                                    m_bFirstVertex;
+    bool                                    m_bAutomaticDeclaration;
+    Math::AxisAlignedBox                    m_AABB;
+    Math::Real                              m_radius;
+    unsigned short                          m_usTextureCoordsIndex;
+    tUploadMode                             m_uploadMode;
+    tVertexLayout                           m_vertexLayout;
+    tStatistics                             m_statistics;
+    std::vector<unsigned char>              m_stagingBuffer;
+    tDequantization                         m_dequantization;
+    std::map<std::string, tDequantization>  m_dequantizations;
+    std::map<std::string, MeshBounds::tBounds> m_bounds;
+    bool                                    m_bWelding;
+    Math::Real                              m_weldingEpsilon;
+    std::vector<unsigned int>               m_sharedVerticesRemap;
+    unsigned int                            m_optimizations;
+    bool                                    m_bGenerateNormals;
+    TangentSpaceGenerator::tWeighting       m_normalsWeighting;
+    bool                                    m_bGenerateTangents;
+    bool                                    m_bGenerateBinormals;
+    unsigned short                          m_usTangentsTexCoordSet;
+    bool                                    m_bHardwareSkinning;
+    unsigned short                          m_usMaxBonesPerDraw;
+    unsigned short                          m_usMaxBoneInfluences;
+    bool                                    m_bClustering;
+    unsigned int                            m_nbMaxClusterTriangles;
+    MeshClusters                            m_clusters;
+    tScratchBuffers                         m_scratch;
+    std::string                             m_strCacheDirectory;
+    MeshCache::Hasher                       m_hasher;
+    std::list<tSubMesh>                     m_pendingSubMeshes;
+    std::list<tSubMesh>                     m_freeSubMeshes;        ///< Pool of entries
+                                                                    ///  for the postponed
+                                                                    ///  submeshes
+    bool                                    m_bCacheShadowBuffers;  ///< Indicates if the
+                                                                    ///  buffers need a
+                                                                    ///  shadow buffer to
+                                                                    ///  be exported
+
+    static std::string                      s_strDefaultCacheDirectory;
 };
 
 }
@@ -0,0 +1,147 @@
+/** @file   MeshCache.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshCache'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHCACHE_H_
+#define _ATHENA_GRAPHICS_MESHCACHE_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Ogre/OgreMesh.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to store meshes on disk, identified by a hash of the data
+///         used to build them
+///
+/// Each mesh is stored in two files of the cache directory, named after the hash: the
+/// mesh itself (in Ogre's binary format) and a file containing user data (written last,
+/// so a mesh is only considered as cached once both files are complete).
+///
+/// @remark The cache directory must exist
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshCache
+{
+    //_____ Types __________
+public:
+    typedef Ogre::uint64 tHash;
+
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Used to compute the hash of some data (64-bit FNV-1a)
+    //-----------------------------------------------------------------------------------
+    class ATHENA_GRAPHICS_SYMBOL Hasher
+    {
+    public:
+        Hasher();
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Restart the computation of the hash
+        //-------------------------------------------------------------------------------
+        void reset();
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Add some bytes to the hash
+        //-------------------------------------------------------------------------------
+        void add(const void* pData, size_t size);
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Add a value to the hash
+        /// @remark Only use it with types without padding
+        //-------------------------------------------------------------------------------
+        template<typename T>
+        inline void add(const T& value)
+        {
+            add(&value, sizeof(T));
+        }
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Add a string (and its length) to the hash
+        //-------------------------------------------------------------------------------
+        inline void add(const std::string& str)
+        {
+            add(str.size());
+            add(str.data(), str.size());
+        }
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Add the content of an array (and its size) to the hash
+        //-------------------------------------------------------------------------------
+        template<typename T>
+        inline void add(const std::vector<T>& values)
+        {
+            add(values.size());
+
+            if (!values.empty())
+                add(&values[0], values.size() * sizeof(T));
+        }
+
+        //-------------------------------------------------------------------------------
+        /// @brief  Returns the hash of the data added since the last reset
+        //-------------------------------------------------------------------------------
+        inline tHash getHash() const
+        {
+            return m_hash;
+        }
+
+    private:
+        tHash m_hash;
+    };
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if a mesh is in the cache
+    /// @param  strDirectory    The cache directory
+    /// @param  hash            Hash of the mesh
+    //-----------------------------------------------------------------------------------
+    static bool contains(const std::string& strDirectory, tHash hash);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Load a mesh from the cache
+    /// @remark On failure, the mesh may be partially loaded
+    /// @param  strDirectory    The cache directory
+    /// @param  hash            Hash of the mesh
+    /// @param  pMesh           The (manual) mesh to fill
+    /// @param  userData        The user data stored with the mesh
+    /// @return                 'true' if successful
+    //-----------------------------------------------------------------------------------
+    static bool load(const std::string& strDirectory, tHash hash, Ogre::Mesh* pMesh,
+                     std::vector<unsigned char>& userData);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Save a mesh in the cache
+    /// @remark The hardware buffers of the mesh are read back, so they should have a
+    ///         shadow buffer or be readable to avoid a stall
+    /// @param  strDirectory    The cache directory
+    /// @param  hash            Hash of the mesh
+    /// @param  pMesh           The mesh
+    /// @param  userData        User data to store with the mesh
+    /// @return                 'true' if successful
+    //-----------------------------------------------------------------------------------
+    static bool save(const std::string& strDirectory, tHash hash, const Ogre::Mesh* pMesh,
+                     const std::vector<unsigned char>& userData);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the path of the files of a mesh, without extension
+    /// @param  strDirectory    The cache directory
+    /// @param  hash            Hash of the mesh
+    //-----------------------------------------------------------------------------------
+    static std::string getPath(const std::string& strDirectory, tHash hash);
+
+
+    //_____ Constants __________
+public:
+    static const unsigned int VERSION;  ///< Version of the format of the cache, included
+                                        ///  in the hashes and the user data files
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,188 @@
+/** @file   MeshClusters.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshClusters'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHCLUSTERS_H_
+#define _ATHENA_GRAPHICS_MESHCLUSTERS_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Math/Vector3.h>
+#include <Athena-Math/AxisAlignedBox.h>
+#include <Athena-Math/Sphere.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreMatrix4.h>
+#include <Ogre/OgreResourceGroupManager.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Partition of the triangle lists of a mesh into small clusters of triangles,
+///         that can be culled individually
+///
+/// Each cluster is a spatially coherent group of connected triangles, with similar
+/// orientations, stored as a contiguous range of the indices of its submesh. Its
+/// bounding box, bounding sphere and normal cone are used to discard the clusters
+/// outside of the frustum of a camera, or entirely facing away from it.
+///
+/// The reordered indices of each submesh are kept with the clusters, so they can be
+/// copied into a dynamic index buffer without reading the buffers of the mesh (see
+/// Visual::Object::enableClusterCulling()).
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshClusters
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  A cluster of triangles
+    //-----------------------------------------------------------------------------------
+    struct tCluster
+    {
+        unsigned int            indexStart;     ///< First index of the cluster
+        unsigned int            nbIndices;      ///< Number of indices of the cluster
+        Math::AxisAlignedBox    aabb;           ///< Bounding box
+        Math::Sphere            sphere;         ///< Bounding sphere
+        Math::Vector3           coneAxis;       ///< Average normal of the triangles
+        Math::Real              coneCutoff;     ///< Sine of the largest angle between the
+                                                ///  axis and a normal (1 if the cluster
+                                                ///  can't be back-facing)
+    };
+
+    typedef std::vector<tCluster> tClustersList;
+
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  The clusters of a submesh
+    //-----------------------------------------------------------------------------------
+    struct tSubMeshClusters
+    {
+        tClustersList               clusters;   ///< The clusters (empty if the submesh
+                                                ///  isn't clustered)
+        std::vector<unsigned int>   indices;    ///< The indices, reordered cluster by
+                                                ///  cluster
+    };
+
+
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor, without any submesh
+    //-----------------------------------------------------------------------------------
+    MeshClusters();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor, partitioning the indexed triangle lists of a mesh
+    /// @remark The mesh is loaded by GraphicTools::loadReadableMesh()
+    /// @param  strMeshName         Name of the mesh
+    /// @param  strResourceGroup    Name of the resource group in which the mesh is located
+    /// @param  nbMaxTriangles      Maximum number of triangles per cluster
+    /// @param  positionScale       Dequantization scale of the positions, when they are
+    ///                             16-bit integers (see VertexCompression)
+    //-----------------------------------------------------------------------------------
+    MeshClusters(const std::string& strMeshName, const std::string& strResourceGroup =
+                 Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+                 unsigned int nbMaxTriangles = 128, Math::Real positionScale = 1.0f);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor, partitioning the indexed triangle lists of a mesh
+    /// @remark The buffers of the mesh must be readable (see GraphicTools::isReadable())
+    /// @param  mesh                The mesh
+    /// @param  nbMaxTriangles      Maximum number of triangles per cluster
+    /// @param  positionScale       Dequantization scale of the positions, when they are
+    ///                             16-bit integers (see VertexCompression)
+    //-----------------------------------------------------------------------------------
+    MeshClusters(const Ogre::MeshPtr& mesh, unsigned int nbMaxTriangles = 128,
+                 Math::Real positionScale = 1.0f);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    ~MeshClusters();
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the number of submeshes
+    //-----------------------------------------------------------------------------------
+    inline unsigned int getNbSubMeshes() const
+    {
+        return m_subMeshes.size();
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the clusters of a submesh
+    //-----------------------------------------------------------------------------------
+    inline const tSubMeshClusters& getSubMesh(unsigned int index) const
+    {
+        assert(index < m_subMeshes.size());
+        return m_subMeshes[index];
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add the clusters of the next submesh
+    /// @param  clusters    The clusters (can be empty)
+    /// @param  indices     The indices of the submesh, reordered cluster by cluster
+    //-----------------------------------------------------------------------------------
+    void addSubMesh(const tClustersList& clusters, const std::vector<unsigned int>& indices);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Remove all the submeshes
+    //-----------------------------------------------------------------------------------
+    void clear();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Partition a triangle list into clusters
+    /// @param  pPositions      The positions of the vertices (3 floats per vertex)
+    /// @param  nbVertices      Number of vertices
+    /// @param  pIndices        The indices of the triangles, reordered cluster by
+    ///                         cluster (modified in place)
+    /// @param  nbIndices       Number of indices (multiple of 3)
+    /// @param  nbMaxTriangles  Maximum number of triangles per cluster
+    /// @param  clusters        Receives the clusters
+    //-----------------------------------------------------------------------------------
+    static void build(const float* pPositions, unsigned int nbVertices,
+                      unsigned int* pIndices, unsigned int nbIndices,
+                      unsigned int nbMaxTriangles, tClustersList& clusters);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if all the triangles of a cluster face away from a point
+    /// @param  cluster     The cluster
+    /// @param  viewPoint   The point, in the space of the mesh
+    //-----------------------------------------------------------------------------------
+    static bool isBackFacing(const tCluster& cluster, const Math::Vector3& viewPoint);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Determine which clusters can be seen by a camera
+    /// @remark The normal cones assume that the transformation doesn't contain any
+    ///         non-uniform scale
+    /// @param  clusters    The clusters
+    /// @param  pCamera     The camera
+    /// @param  transform   Transformation from the space of the mesh to the world
+    /// @param  visibility  Receives the visibility of each cluster (0 or 1)
+    /// @return             The number of visible clusters
+    //-----------------------------------------------------------------------------------
+    static unsigned int cull(const tClustersList& clusters, const Ogre::Camera* pCamera,
+                             const Ogre::Matrix4& transform,
+                             std::vector<unsigned char>& visibility);
+
+
+private:
+    void build(const Ogre::MeshPtr& mesh, unsigned int nbMaxTriangles, Math::Real positionScale);
+
+    void readPositions(Ogre::VertexData* pVertexData, Math::Real positionScale,
+                       std::vector<float>& positions);
+
+
+    //_____ Attributes __________
+private:
+    std::vector<tSubMeshClusters> m_subMeshes;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,147 @@
+/** @file   MeshConverter.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshConverter'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHCONVERTER_H_
+#define _ATHENA_GRAPHICS_MESHCONVERTER_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Graphics/MeshBuilder.h>
+#include <Athena-Graphics/VertexCompression.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreResourceGroupManager.h>
+#include <map>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to convert the vertices of an existing mesh into compact
+///         formats
+///
+/// Meshes coming from files usually store all their attributes as 32-bit floats. The
+/// converter re-encodes them with VertexCompression (quantized positions and texture
+/// coordinates, packed normals, tangents and binormals), rebuilds the declaration of
+/// each vertex data, and packs the elements of each source in a new vertex buffer
+/// (uploaded once). The other attributes are copied unchanged.
+///
+/// Like the ones produced by MeshBuilder, the converted meshes must be drawn with
+/// vertex programs decoding their attributes (see getDequantization()).
+///
+/// @remark The vertex buffers must be readable (see GraphicTools::isReadable())
+/// @remark The positions and the normals of the vertex data animated by morph or pose
+///         animations are kept as 32-bit floats
+/// @remark The instance buffers are kept unchanged
+/// @remark Ogre reads the positions as floats to build the edge lists of the stencil
+///         shadows, and to do software skinning: the converted meshes can't use them
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshConverter
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The formats into which the attributes are converted
+    //-----------------------------------------------------------------------------------
+    struct tFormats
+    {
+        tFormats()
+        : positions(VertexCompression::FORMAT_SHORT),
+          normals(VertexCompression::FORMAT_OCTAHEDRAL),
+          tangents(VertexCompression::FORMAT_OCTAHEDRAL),
+          texCoords(VertexCompression::FORMAT_SHORT)
+        {
+        }
+
+        VertexCompression::tFormat positions;   ///< FORMAT_FLOAT or FORMAT_SHORT
+        VertexCompression::tFormat normals;
+        VertexCompression::tFormat tangents;    ///< Tangents and binormals (the ones with
+                                                ///  a handedness use FORMAT_UBYTE instead
+                                                ///  of FORMAT_OCTAHEDRAL)
+        VertexCompression::tFormat texCoords;   ///< FORMAT_FLOAT or FORMAT_SHORT
+    };
+
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Memory used by the vertex buffers of the mesh
+    //-----------------------------------------------------------------------------------
+    struct tStatistics
+    {
+        size_t  nbBytesBefore;      ///< Size of the vertex buffers before the conversion
+        size_t  nbBytesAfter;       ///< Size of the vertex buffers after the conversion
+    };
+
+
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    ///
+    /// The mesh is loaded by GraphicTools::loadReadableMesh().
+    /// @param  strMeshName         Name of the mesh
+    /// @param  strResourceGroup    Name of the resource group in which the mesh is located
+    //-----------------------------------------------------------------------------------
+    MeshConverter(const std::string& strMeshName, const std::string& strResourceGroup =
+                  Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @param  mesh    The mesh (must be loaded)
+    //-----------------------------------------------------------------------------------
+    MeshConverter(const Ogre::MeshPtr& mesh);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    ~MeshConverter();
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Convert the vertices of the mesh
+    ///
+    /// Only the attributes stored as 32-bit floats are converted, so converting a mesh
+    /// twice doesn't change it (the scales of the attributes converted by the first
+    /// call are kept). A vertex buffer bound by several vertex data is converted once.
+    /// @param  formats     The formats of the attributes
+    /// @return             The memory used by the vertex buffers, before and after the
+    ///                     conversion
+    //-----------------------------------------------------------------------------------
+    tStatistics convert(const tFormats& formats = tFormats());
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the scales that the vertex programs must apply to the attributes
+    ///         converted to VertexCompression::FORMAT_SHORT (shared by all the
+    ///         submeshes)
+    //-----------------------------------------------------------------------------------
+    inline const MeshBuilder::tDequantization& getDequantization() const
+    {
+        return m_dequantization;
+    }
+
+private:
+    void computeDequantization(const tFormats& formats);
+    void convertVertexData(Ogre::VertexData* pVertexData, const tFormats& formats,
+                           bool bAnimated, tStatistics& statistics);
+
+
+    //_____ Attributes __________
+private:
+    Ogre::MeshPtr                   m_mesh;
+    MeshBuilder::tDequantization    m_dequantization;
+    std::vector<Ogre::VertexData*>  m_vertexDatas;      ///< The vertex data of the mesh
+    std::vector<bool>               m_animated;         ///< Indicates which vertex data
+                                                        ///  are animated by morph or
+                                                        ///  pose animations
+    std::map<Ogre::HardwareVertexBuffer*, Ogre::HardwareVertexBufferSharedPtr>
+                                    m_convertedBuffers; ///< The buffers already converted
+                                                        ///  by convert(), and their copy
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,100 @@
+/** @file   MeshOptimizer.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshOptimizer'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHOPTIMIZER_H_
+#define _ATHENA_GRAPHICS_MESHOPTIMIZER_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class containing algorithms used to reorder the triangles and the
+///         vertices of a triangle list, to make it faster to render
+///
+/// All the methods work on a list of indices (3 per triangle) referencing vertices in
+/// the range [0, nbVertices[.
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshOptimizer
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Statistics about the use of the post-transform vertex cache
+    //-----------------------------------------------------------------------------------
+    struct tCacheStatistics
+    {
+        unsigned int    nbTriangles;            ///< Number of triangles
+        unsigned int    nbVertices;             ///< Number of vertices referenced
+        unsigned int    nbTransformedVertices;  ///< Number of vertices transformed (cache
+                                                ///  misses)
+        Math::Real      acmr;                   ///< Average cache miss ratio (transformed
+                                                ///  vertices per triangle, from 0.5 to 3)
+        Math::Real      atvr;                   ///< Average transformed vertex ratio
+                                                ///  (transformed vertices per vertex, 1
+                                                ///  is optimal)
+    };
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Reorder the triangles to improve the use of the post-transform vertex
+    ///         cache, using Tom Forsyth's linear-speed algorithm
+    /// @param  pIndices    The indices to reorder (modified in place)
+    /// @param  nbIndices   Number of indices (multiple of 3)
+    /// @param  nbVertices  Number of vertices
+    //-----------------------------------------------------------------------------------
+    static void optimizeVertexCache(unsigned int* pIndices, unsigned int nbIndices,
+                                    unsigned int nbVertices);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Reorder clusters of triangles to reduce the overdraw, by drawing first
+    ///         the ones that are the most likely to occlude the others
+    /// @remark The clusters are delimited by the flushes of the vertex cache, so this
+    ///         must be called after optimizeVertexCache() to preserve its benefits
+    /// @param  pIndices    The indices to reorder (modified in place)
+    /// @param  nbIndices   Number of indices (multiple of 3)
+    /// @param  pPositions  The positions of the vertices (3 floats per vertex)
+    /// @param  nbVertices  Number of vertices
+    //-----------------------------------------------------------------------------------
+    static void optimizeOverdraw(unsigned int* pIndices, unsigned int nbIndices,
+                                 const float* pPositions, unsigned int nbVertices);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute a new order of the vertices that improves the locality of the
+    ///         vertex fetches, and remap the indices accordingly
+    /// @remark The vertices are sorted by first use, the unreferenced ones are moved
+    ///         at the end
+    /// @param  pIndices    The indices to remap (modified in place)
+    /// @param  nbIndices   Number of indices
+    /// @param  nbVertices  Number of vertices
+    /// @param  order       Receives the new order of the vertices (the old index of each
+    ///                     new vertex)
+    //-----------------------------------------------------------------------------------
+    static void optimizeVertexFetch(unsigned int* pIndices, unsigned int nbIndices,
+                                    unsigned int nbVertices, std::vector<unsigned int>& order);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Simulate a FIFO post-transform vertex cache to compute the ACMR and ATVR
+    ///         of a triangle list
+    /// @param  pIndices    The indices
+    /// @param  nbIndices   Number of indices (multiple of 3)
+    /// @param  nbVertices  Number of vertices
+    /// @param  cacheSize   Size of the simulated cache
+    //-----------------------------------------------------------------------------------
+    static tCacheStatistics analyzeVertexCache(const unsigned int* pIndices,
+                                               unsigned int nbIndices,
+                                               unsigned int nbVertices,
+                                               unsigned int cacheSize = 16);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,155 @@
+/** @file   MeshSimplifier.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::MeshSimplifier'
+*/
+
+#ifndef _ATHENA_GRAPHICS_MESHSIMPLIFIER_H_
+#define _ATHENA_GRAPHICS_MESHSIMPLIFIER_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreResourceGroupManager.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to generate the levels of detail of a mesh
+///
+/// Each level is a simplified version of the triangle lists of the submeshes, produced
+/// by collapsing the edges with the lowest quadric error. Only the indices are
+/// regenerated, so the levels share the vertex buffers of the mesh.
+///
+/// The vertices on the borders of the mesh and on the seams (several vertices at the
+/// same position, with different texture coordinates or normals) are never removed, and
+/// an edge is only collapsed if its two vertices are mostly influenced by the same bone
+/// (read from the bone assignments, or from the hardware skinning streams).
+///
+/// The buffers of the mesh must be readable (see GraphicTools::isReadable()).
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL MeshSimplifier
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The kinds of values used to select the level of detail
+    //-----------------------------------------------------------------------------------
+    enum tThreshold
+    {
+        THRESHOLD_DISTANCE,     ///< Distance from the camera
+        THRESHOLD_PIXEL_COUNT,  ///< Number of pixels covered on the screen
+    };
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Informations about a generated level of detail
+    //-----------------------------------------------------------------------------------
+    struct tLevelReport
+    {
+        Math::Real      value;              ///< Distance or pixel count of the level
+        unsigned int    nbTriangles;        ///< Number of triangles of the level
+        unsigned int    nbOriginalTriangles;///< Number of triangles of the full mesh
+        Math::Real      reduction;          ///< Proportion of triangles removed
+    };
+
+
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @remark The mesh is loaded by GraphicTools::loadReadableMesh()
+    /// @param  strMeshName         Name of the mesh
+    /// @param  strResourceGroup    Name of the resource group in which the mesh is located
+    //-----------------------------------------------------------------------------------
+    MeshSimplifier(const std::string& strMeshName, const std::string& strResourceGroup =
+                   Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @param  mesh    The mesh
+    //-----------------------------------------------------------------------------------
+    MeshSimplifier(const Ogre::MeshPtr& mesh);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    ~MeshSimplifier();
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a level of detail to generate
+    /// @param  value   Distance or pixel count from which the level is used
+    /// @param  ratio   Proportion of the triangles to keep, in ]0, 1[
+    //-----------------------------------------------------------------------------------
+    void addLevel(Math::Real value, Math::Real ratio);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Remove all the levels of detail to generate
+    //-----------------------------------------------------------------------------------
+    void clearLevels();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Generate the levels of detail of the mesh, replacing the existing ones
+    /// @param  threshold   Kind of values given to addLevel()
+    //-----------------------------------------------------------------------------------
+    void generate(tThreshold threshold = THRESHOLD_DISTANCE);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns informations about the levels generated by the last call to
+    ///         generate()
+    //-----------------------------------------------------------------------------------
+    inline const std::vector<tLevelReport>& getReport() const
+    {
+        return m_report;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Simplify a triangle list
+    /// @param  pPositions      The positions of the vertices (3 floats per vertex)
+    /// @param  pNormals        The normals of the vertices (3 floats per vertex, can be 0)
+    /// @param  pBones          The index of the most influential bone of each vertex (-1
+    ///                         if none, can be 0)
+    /// @param  nbVertices      Number of vertices
+    /// @param  indices         The indices of the triangles, replaced by the simplified
+    ///                         ones
+    /// @param  nbTargetIndices The number of indices to reach (if possible)
+    //-----------------------------------------------------------------------------------
+    static void simplify(const float* pPositions, const float* pNormals, const int* pBones,
+                         unsigned int nbVertices, std::vector<unsigned int>& indices,
+                         unsigned int nbTargetIndices);
+
+
+    //_____ Internal types __________
+private:
+    struct tLevel
+    {
+        Math::Real  value;
+        Math::Real  ratio;
+    };
+
+
+private:
+    void readVertices(Ogre::VertexData* pVertexData, std::vector<float>& positions,
+                      std::vector<float>& normals);
+
+    void readBones(Ogre::VertexData* pVertexData, const Ogre::Mesh::IndexMap& palette,
+                   std::vector<int>& bones);
+
+    Ogre::IndexData* createIndexData(const std::vector<unsigned int>& indices,
+                                     Ogre::HardwareIndexBuffer::IndexType type);
+
+
+    //_____ Attributes __________
+private:
+    Ogre::MeshPtr               m_mesh;
+    std::vector<tLevel>         m_levels;
+    std::vector<tLevelReport>   m_report;
+};
+
+}
+}
+
+#endif
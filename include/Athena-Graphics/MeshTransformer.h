@@ -8,8 +8,13 @@
 #define _ATHENA_GRAPHICS_MESHTRANSFORMER_H_
 
 #include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Math/Matrix4.h>
 #include <Ogre/OgreMesh.h>
+#include <Ogre/OgreMatrix4.h>
 #include <Ogre/OgreResourceGroupManager.h>
+#include <limits>
+#include <map>
+#include <set>
 
 
 namespace Athena {
@@ -17,6 +22,33 @@ namespace Graphics {
 
 //---------------------------------------------------------------------------------------
 /// @brief  Utility class used to modify a mesh
+///
+/// Each transformation locks every vertex buffer of the mesh once (even if it is bound
+/// by several vertex data), and transforms all the positions, normals, tangents and
+/// binormals it contains in place (with SSE when available). When
+/// ATHENA_GRAPHICS_THREADING is enabled, the vertices are split in ranges processed by
+/// several threads. The bounds of the mesh are computed from the transformed positions,
+/// during the same pass.
+///
+/// The normals are transformed by the inverse transpose of the transformation, the
+/// tangents and binormals by the transformation itself. The skeleton (binding pose and
+/// keyframes of its animations), the poses and the morph animations of the mesh are
+/// updated too.
+///
+/// When the transformer is deferred, the transformations are only accumulated in an
+/// affine matrix, and applied in one pass by commit(): normalizing an asset with a
+/// scale, a rotation and a translation then costs one pass over its vertices.
+///
+/// With shadowed vertex buffers (the ones of a mesh loaded by the transformer), the
+/// transformations are done on the copy in system memory, and each buffer is uploaded
+/// once when it is unlocked (so once per commit() with a deferred transformer). Once
+/// the mesh is normalized, releaseShadowBuffers() replaces them (and the index buffers,
+/// shadowed as well) by static write-only buffers without copy.
+///
+/// @remark The vertex buffers must be readable (see GraphicTools::isReadable()), and
+///         their positions, normals, tangents and binormals made of 32-bit floats
+/// @remark A non-uniform scale combined with a rotation can't be represented exactly
+///         by the bones: their positions are exact, but not their orientations
 //---------------------------------------------------------------------------------------
 class ATHENA_GRAPHICS_SYMBOL MeshTransformer
 {
@@ -24,21 +56,28 @@ class ATHENA_GRAPHICS_SYMBOL MeshTransformer
 public:
     //-----------------------------------------------------------------------------------
     /// @brief  Constructor
+    ///
+    /// The mesh is loaded by GraphicTools::loadReadableMesh().
     /// @param  strMeshName         Name of the mesh
     /// @param  strResourceGroup    Name of the resource group in which the mesh is located
+    /// @param  bDeferred           Indicates if the transformations are only applied
+    ///                             when commit() is called
     //-----------------------------------------------------------------------------------
     MeshTransformer(const std::string& strMeshName, const std::string& strResourceGroup =
-                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+                    bool bDeferred = false);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Constructor
-    /// @param  strMeshName         Name of the mesh
-    /// @param  strResourceGroup    Name of the resource group in which the mesh is located
+    /// @param  mesh        The mesh
+    /// @param  bDeferred   Indicates if the transformations are only applied when
+    ///                     commit() is called
     //-----------------------------------------------------------------------------------
-    MeshTransformer(const Ogre::MeshPtr& mesh);
+    MeshTransformer(const Ogre::MeshPtr& mesh, bool bDeferred = false);
 
     //-----------------------------------------------------------------------------------
     /// @brief  Destructor
+    /// @remark When the transformer is deferred, commit() must have been called
     //-----------------------------------------------------------------------------------
     ~MeshTransformer();
 
@@ -55,15 +94,166 @@ public:
     void rotate(const Math::Quaternion& q);
     void rotate(const Math::Vector3& axis, const Math::Radian& angle);
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Apply an affine transformation to the mesh
+    //-----------------------------------------------------------------------------------
+    void transform(const Math::Matrix4& transform);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Apply the transformations accumulated since the last commit, in one pass
+    /// @remark Only needed when the transformer is deferred
+    //-----------------------------------------------------------------------------------
+    void commit();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the transformations are only applied when commit() is
+    ///         called
+    //-----------------------------------------------------------------------------------
+    inline bool isDeferred() const
+    {
+        return m_bDeferred;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the transformation accumulated since the last commit (always the
+    ///         identity when the transformer isn't deferred)
+    //-----------------------------------------------------------------------------------
+    inline const Ogre::Matrix4& getPendingTransform() const
+    {
+        return m_pendingTransform;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Move the positions (and the blending data) of the vertices in their own
+    ///         vertex buffer (source 0), and interleave all the other attributes in a
+    ///         second one (source 1)
+    ///
+    /// Depth-only passes (shadow maps, depth pre-pass) then only fetch the positions.
+    /// This is the layout produced by MeshBuilder::LAYOUT_SPLIT_POSITIONS. The new
+    /// buffers keep the usage and the shadow buffer of the original ones, and the
+    /// vertex data bound to the same buffers are bound to the same new ones.
+    /// @remark The vertex buffers of the mesh must be readable
+    //-----------------------------------------------------------------------------------
+    void splitPositions();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Replace the shadowed vertex and index buffers of the mesh by static
+    ///         write-only ones without shadow buffer, uploaded once from their shadow
+    ///         buffers
+    ///
+    /// Frees the copy in system memory of the vertices and indices once the mesh is
+    /// normalized.
+    /// @remark The mesh can't be transformed anymore afterwards (its vertex buffers
+    ///         aren't readable)
+    /// @remark When the transformer is deferred, commit() must have been called
+    //-----------------------------------------------------------------------------------
+    void releaseShadowBuffers();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Transform some positions in place
+    /// @param  transform   The affine transformation
+    /// @param  pPositions  Pointer to the first position (3 components per vertex)
+    /// @param  nbVertices  Number of vertices
+    /// @param  stride      Number of bytes between two consecutive positions, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    static void transformPositions(const Ogre::Matrix4& transform, Math::Real* pPositions,
+                                   unsigned int nbVertices, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Transform some directions (normals, tangents or binormals) in place, and
+    ///         normalise them
+    /// @remark The normals must be transformed by the inverse transpose of the
+    ///         transformation applied to the positions (see getNormalMatrix()), the
+    ///         tangents and binormals by the transformation itself
+    /// @param  transform   The linear part of the transformation
+    /// @param  pDirections Pointer to the first direction (3 components per vertex)
+    /// @param  nbVertices  Number of vertices
+    /// @param  stride      Number of bytes between two consecutive directions, 0 if the
+    ///                     array is tightly packed
+    //-----------------------------------------------------------------------------------
+    static void transformDirections(const Ogre::Matrix3& transform, Math::Real* pDirections,
+                                    unsigned int nbVertices, size_t stride = 0);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the matrix transforming the normals of vertices transformed by
+    ///         an affine transformation (the inverse transpose of its linear part)
+    //-----------------------------------------------------------------------------------
+    static Ogre::Matrix3 getNormalMatrix(const Ogre::Matrix4& transform);
+
+
+    //_____ Internal types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Bounds of the transformed positions, accumulated by the kernels
+    //-----------------------------------------------------------------------------------
+    struct tBoundsAccumulator
+    {
+        tBoundsAccumulator()
+        : bEmpty(true), radius2(0.0f)
+        {
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                minimum[i] = std::numeric_limits<float>::max();
+                maximum[i] = -std::numeric_limits<float>::max();
+            }
+        }
+
+        bool    bEmpty;
+        float   minimum[3];
+        float   maximum[3];
+        float   radius2;        ///< Squared distance to the origin of the farthest position
+    };
+
 private:
-    void scale(Ogre::VertexData* pVertexData, const Math::Vector3& scale);
-    void translateOrigin(Ogre::VertexData* pVertexData, const Math::Vector3& d, Math::Vector3& max);
-    void rotate(Ogre::VertexData* pVertexData, const Math::Quaternion& q, Math::Vector3& max);
+    //-----------------------------------------------------------------------------------
+    /// @brief  A vertex buffer to transform
+    //-----------------------------------------------------------------------------------
+    struct tBufferJob
+    {
+        Ogre::HardwareVertexBufferSharedPtr     buffer;
+        std::vector<std::pair<size_t, size_t> > ranges;     ///< Vertices used by the
+                                                            ///  vertex data (first, count)
+        std::set<size_t>                        positions;  ///< Offsets of the elements
+        std::set<size_t>                        normals;
+        std::set<size_t>                        tangents;   ///< Tangents and binormals
+    };
+
+    typedef std::map<Ogre::HardwareVertexBuffer*, tBufferJob> tBufferJobsList;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  A range of vertices of a locked buffer, transformed by one thread
+    //-----------------------------------------------------------------------------------
+    struct tTask
+    {
+        const tBufferJob*   pJob;
+        unsigned char*      pData;
+        unsigned int        nbVertices;
+    };
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  The buffers created by splitPositions(), indexed by the buffers they
+    ///         replace
+    //-----------------------------------------------------------------------------------
+    typedef std::map<std::vector<Ogre::HardwareVertexBuffer*>,
+                     std::vector<Ogre::HardwareVertexBufferSharedPtr> > tSplitBuffersList;
+
+    void applyTransform(const Ogre::Matrix4& transform);
+    void collectBuffers(Ogre::VertexData* pVertexData, bool bDirections, tBufferJobsList& jobs);
+    void transformBuffers(tBufferJobsList& jobs, const Ogre::Matrix4& transform,
+                          const Ogre::Matrix3& normalsTransform,
+                          const Ogre::Matrix3& tangentsTransform, tBoundsAccumulator& bounds);
+    void transformSkeleton(const Ogre::Matrix4& transform);
+    void transformVertexAnimations(const Ogre::Matrix4& transform);
+    void splitPositions(Ogre::VertexData* pVertexData, tSplitBuffersList& splitBuffers);
 
 
     //_____ Attributes __________
 private:
     Ogre::MeshPtr   m_mesh;
+    bool            m_bDeferred;
+    Ogre::Matrix4   m_pendingTransform;     ///< Transformation accumulated since the
+                                            ///  last commit
 };
 
 }
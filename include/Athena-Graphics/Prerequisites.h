@@ -36,14 +36,25 @@ namespace Athena
     //------------------------------------------------------------------------------------
     namespace Graphics
     {
+        class DynamicMesh;
         class GraphicTools;
+        class InstancedMesh;
         class Line3D;
         class LinesList;
         class MeshAnimation;
+        class MeshBounds;
         class MeshBuilder;
+        class MeshCache;
+        class MeshClusters;
+        class MeshConverter;
+        class MeshOptimizer;
+        class MeshSimplifier;
         class MeshTransformer;
         class OgreLogListener;
+        class Primitives;
         class SceneRenderTargetListener;
+        class TangentSpaceGenerator;
+        class VertexCompression;
 
         //--------------------------------------------------------------------------------
         /// @brief  Contains all the debug components
@@ -69,6 +80,7 @@ namespace Athena
             class Camera;
             class DirectionalLight;
             class EntityComponent;
+            class InstancedObject;
             class Object;
             class Plane;
             class PointLight;
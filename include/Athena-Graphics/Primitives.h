@@ -0,0 +1,230 @@
+/** @file   Primitives.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::Primitives'
+*/
+
+#ifndef _ATHENA_GRAPHICS_PRIMITIVES_H_
+#define _ATHENA_GRAPHICS_PRIMITIVES_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Math/Vector3.h>
+#include <Ogre/OgreMesh.h>
+#include <Ogre/OgreResourceGroupManager.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class containing generators of procedural primitives
+///
+/// The add*() methods append the primitive to the current submesh of a MeshBuilder, as
+/// a triangle list with positions, normals and texture
+/// coordinates. The vertices are computed in arrays, then given to the builder with
+/// its bulk methods (positions(), normals(), ...).
+///
+/// The get*() methods return a mesh containing only the primitive, shared by all the
+/// callers using the same parameters: the mesh is only built the first time. These
+/// meshes have one submesh using the 'BaseWhite' material, to replace with
+/// Ogre::Entity::setMaterialName(). They must be retrieved from the rendering thread.
+///
+/// All the primitives are centered on the origin, with the Y axis as their main axis.
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL Primitives
+{
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a box
+    /// @param  pBuilder        The mesh builder
+    /// @param  size            Size of the box
+    /// @param  nbSegments      Number of segments along each edge
+    //-----------------------------------------------------------------------------------
+    static void addBox(MeshBuilder* pBuilder, const Math::Vector3& size, unsigned int nbSegments = 1);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a UV sphere (made of rings and segments)
+    /// @param  pBuilder        The mesh builder
+    /// @param  radius          Radius of the sphere
+    /// @param  nbRings         Number of rings, from pole to pole
+    /// @param  nbSegments      Number of segments around the Y axis
+    //-----------------------------------------------------------------------------------
+    static void addUVSphere(MeshBuilder* pBuilder, Math::Real radius, unsigned int nbRings = 16,
+                            unsigned int nbSegments = 32);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add an ico sphere (a subdivided icosahedron, whose triangles have nearly
+    ///         the same size)
+    /// @param  pBuilder            The mesh builder
+    /// @param  radius              Radius of the sphere
+    /// @param  nbSubdivisions      Number of subdivisions (each one multiplies the
+    ///                             number of triangles by 4)
+    //-----------------------------------------------------------------------------------
+    static void addIcoSphere(MeshBuilder* pBuilder, Math::Real radius, unsigned int nbSubdivisions = 2);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a capsule (a cylinder capped with two hemispheres)
+    /// @param  pBuilder        The mesh builder
+    /// @param  radius          Radius of the capsule
+    /// @param  height          Height of the cylindrical part
+    /// @param  nbRings         Number of rings of each hemisphere
+    /// @param  nbSegments      Number of segments around the Y axis
+    //-----------------------------------------------------------------------------------
+    static void addCapsule(MeshBuilder* pBuilder, Math::Real radius, Math::Real height,
+                           unsigned int nbRings = 8, unsigned int nbSegments = 32);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a cylinder
+    /// @param  pBuilder            The mesh builder
+    /// @param  radius              Radius of the cylinder
+    /// @param  height              Height of the cylinder
+    /// @param  nbSegments          Number of segments around the Y axis
+    /// @param  nbHeightSegments    Number of segments along the Y axis
+    /// @param  bCapped             Indicates if the ends are closed
+    //-----------------------------------------------------------------------------------
+    static void addCylinder(MeshBuilder* pBuilder, Math::Real radius, Math::Real height,
+                            unsigned int nbSegments = 32, unsigned int nbHeightSegments = 1,
+                            bool bCapped = true);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a cone, pointing along the Y axis
+    /// @param  pBuilder            The mesh builder
+    /// @param  radius              Radius of the base
+    /// @param  height              Height of the cone
+    /// @param  nbSegments          Number of segments around the Y axis
+    /// @param  nbHeightSegments    Number of segments along the Y axis
+    /// @param  bCapped             Indicates if the base is closed
+    //-----------------------------------------------------------------------------------
+    static void addCone(MeshBuilder* pBuilder, Math::Real radius, Math::Real height,
+                        unsigned int nbSegments = 32, unsigned int nbHeightSegments = 1,
+                        bool bCapped = true);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a torus, around the Y axis
+    /// @param  pBuilder            The mesh builder
+    /// @param  radius              Distance between the center of the torus and the
+    ///                             center of the tube
+    /// @param  tubeRadius          Radius of the tube
+    /// @param  nbSegments          Number of segments around the Y axis
+    /// @param  nbTubeSegments      Number of segments around the tube
+    //-----------------------------------------------------------------------------------
+    static void addTorus(MeshBuilder* pBuilder, Math::Real radius, Math::Real tubeRadius,
+                         unsigned int nbSegments = 32, unsigned int nbTubeSegments = 16);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Add a grid in the XZ plane, facing the Y axis
+    /// @param  pBuilder        The mesh builder
+    /// @param  width           Size of the grid along the X axis
+    /// @param  depth           Size of the grid along the Z axis
+    /// @param  nbXSegments     Number of segments along the X axis
+    /// @param  nbZSegments     Number of segments along the Z axis
+    //-----------------------------------------------------------------------------------
+    static void addGrid(MeshBuilder* pBuilder, Math::Real width, Math::Real depth,
+                        unsigned int nbXSegments = 1, unsigned int nbZSegments = 1);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a box
+    /// @see    addBox()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getBox(const Math::Vector3& size, unsigned int nbSegments = 1,
+                                const std::string& strResourceGroup =
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a UV sphere
+    /// @see    addUVSphere()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getUVSphere(Math::Real radius, unsigned int nbRings = 16,
+                                     unsigned int nbSegments = 32,
+                                     const std::string& strResourceGroup =
+                                        Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of an ico sphere
+    /// @see    addIcoSphere()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getIcoSphere(Math::Real radius, unsigned int nbSubdivisions = 2,
+                                      const std::string& strResourceGroup =
+                                        Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a capsule
+    /// @see    addCapsule()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getCapsule(Math::Real radius, Math::Real height, unsigned int nbRings = 8,
+                                    unsigned int nbSegments = 32,
+                                    const std::string& strResourceGroup =
+                                        Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a cylinder
+    /// @see    addCylinder()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getCylinder(Math::Real radius, Math::Real height, unsigned int nbSegments = 32,
+                                     unsigned int nbHeightSegments = 1, bool bCapped = true,
+                                     const std::string& strResourceGroup =
+                                        Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a cone
+    /// @see    addCone()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getCone(Math::Real radius, Math::Real height, unsigned int nbSegments = 32,
+                                 unsigned int nbHeightSegments = 1, bool bCapped = true,
+                                 const std::string& strResourceGroup =
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a torus
+    /// @see    addTorus()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getTorus(Math::Real radius, Math::Real tubeRadius, unsigned int nbSegments = 32,
+                                  unsigned int nbTubeSegments = 16,
+                                  const std::string& strResourceGroup =
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the shared mesh of a grid
+    /// @see    addGrid()
+    //-----------------------------------------------------------------------------------
+    static Ogre::MeshPtr getGrid(Math::Real width, Math::Real depth, unsigned int nbXSegments = 1,
+                                 unsigned int nbZSegments = 1,
+                                 const std::string& strResourceGroup =
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+
+    //_____ Internal types __________
+private:
+    enum tType
+    {
+        TYPE_BOX,
+        TYPE_UV_SPHERE,
+        TYPE_ICO_SPHERE,
+        TYPE_CAPSULE,
+        TYPE_CYLINDER,
+        TYPE_CONE,
+        TYPE_TORUS,
+        TYPE_GRID,
+    };
+
+    /// The parameters of a primitive, used as the key of its shared mesh
+    struct tParameters
+    {
+        tType           type;
+        Math::Real      values[3];
+        unsigned int    counts[2];
+        bool            bCapped;
+    };
+
+
+private:
+    static Ogre::MeshPtr getMesh(const tParameters& parameters, const std::string& strResourceGroup);
+
+    static void addPrimitive(MeshBuilder* pBuilder, const tParameters& parameters);
+};
+
+}
+}
+
+#endif
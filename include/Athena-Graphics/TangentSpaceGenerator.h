@@ -0,0 +1,82 @@
+/** @file   TangentSpaceGenerator.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::TangentSpaceGenerator'
+*/
+
+#ifndef _ATHENA_GRAPHICS_TANGENTSPACEGENERATOR_H_
+#define _ATHENA_GRAPHICS_TANGENTSPACEGENERATOR_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to compute the normals, tangents and binormals of the
+///         vertices of a triangle list
+///
+/// The values are accumulated per vertex from the corners of the triangles using it, so
+/// the vertices aren't split at the discontinuities: weld the vertices first to get
+/// smooth results.
+///
+/// All the arrays contain 3 floats per vertex (2 for the texture coordinates). When
+/// ATHENA_GRAPHICS_THREADING is enabled, the work is spread over several threads.
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL TangentSpaceGenerator
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The ways the normals of the triangles can be weighted
+    //-----------------------------------------------------------------------------------
+    enum tWeighting
+    {
+        WEIGHT_AREA,        ///< By the area of the triangles
+        WEIGHT_ANGLE,       ///< By the angle of the triangles at the vertex
+    };
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute the normals of the vertices
+    /// @param  pPositions  The positions of the vertices
+    /// @param  nbVertices  Number of vertices
+    /// @param  pIndices    The indices of the triangles
+    /// @param  nbIndices   Number of indices (multiple of 3)
+    /// @param  weighting   Weighting of the normals of the triangles
+    /// @param  pNormals    Receives the normals (zero for unused vertices)
+    //-----------------------------------------------------------------------------------
+    static void computeNormals(const float* pPositions, unsigned int nbVertices,
+                               const unsigned int* pIndices, unsigned int nbIndices,
+                               tWeighting weighting, float* pNormals);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Compute the tangents (and optionally the binormals) of the vertices
+    ///
+    /// The tangents of the triangles are computed like MikkTSpace does: they are derived
+    /// from the texture coordinates, weighted by the angles of the triangles, then made
+    /// orthogonal to the normals. The binormals are the cross product of the normals and
+    /// the tangents, with the handedness of the texture mapping.
+    ///
+    /// @param  pPositions  The positions of the vertices
+    /// @param  pNormals    The normals of the vertices
+    /// @param  pTexCoords  The texture coordinates of the vertices (2 floats per vertex)
+    /// @param  nbVertices  Number of vertices
+    /// @param  pIndices    The indices of the triangles
+    /// @param  nbIndices   Number of indices (multiple of 3)
+    /// @param  pTangents   Receives the tangents
+    /// @param  pBinormals  Receives the binormals (can be 0)
+    //-----------------------------------------------------------------------------------
+    static void computeTangents(const float* pPositions, const float* pNormals,
+                                const float* pTexCoords, unsigned int nbVertices,
+                                const unsigned int* pIndices, unsigned int nbIndices,
+                                float* pTangents, float* pBinormals = 0);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,99 @@
+/** @file   VertexCompression.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::VertexCompression'
+*/
+
+#ifndef _ATHENA_GRAPHICS_VERTEXCOMPRESSION_H_
+#define _ATHENA_GRAPHICS_VERTEXCOMPRESSION_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Ogre/OgreHardwareVertexBuffer.h>
+
+
+namespace Athena {
+namespace Graphics {
+
+//---------------------------------------------------------------------------------------
+/// @brief  Utility class used to encode the vertex attributes into compact formats
+///
+/// Ogre doesn't provide normalized integer or half-float vertex types: the quantized
+/// values are stored as plain integers, and the vertex programs must decode them:
+///   - FORMAT_SHORT:       value = stored * scale
+///   - FORMAT_UBYTE:       value = stored / 127.5 - 1
+///   - FORMAT_OCTAHEDRAL:  see decode(), the stored values are in [-32767, 32767]
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL VertexCompression
+{
+    //_____ Types __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  The formats into which the vertex attributes can be stored
+    //-----------------------------------------------------------------------------------
+    enum tFormat
+    {
+        FORMAT_FLOAT,       ///< 32-bit floats (no compression)
+        FORMAT_SHORT,       ///< 16-bit signed integers, with a dequantization scale
+        FORMAT_UBYTE,       ///< 8-bit unsigned integers (4 components), for unit vectors
+        FORMAT_OCTAHEDRAL,  ///< Octahedral mapping on 2 16-bit signed integers, for unit
+                            ///  vectors
+    };
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the type of the vertex element used to store some values in a
+    ///         specific format
+    /// @param  format          The format
+    /// @param  nbComponents    Number of components of the values (1 to 4, 3 for
+    ///                         FORMAT_OCTAHEDRAL)
+    //-----------------------------------------------------------------------------------
+    static Ogre::VertexElementType getElementType(tFormat format, unsigned short nbComponents);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Retrieve the format of a 3D vector (position, normal, tangent or
+    ///         binormal) from the type of its vertex element
+    /// @remark The 2-component shorts are octahedral unit vectors, and the 4-component
+    ///         ones quantized vectors (with a scale that isn't stored in the element)
+    /// @param  type    The type of the vertex element
+    /// @param  format  Receives the format
+    /// @return         'false' if the element can't contain a 3D vector
+    //-----------------------------------------------------------------------------------
+    static bool getVectorFormat(Ogre::VertexElementType type, tFormat& format);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the dequantization scale to use with FORMAT_SHORT for values in
+    ///         the range [-maxAbsValue, maxAbsValue]
+    //-----------------------------------------------------------------------------------
+    static Math::Real computeScale(Math::Real maxAbsValue);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Encode some values into a vertex element
+    /// @remark The components that doesn't fit in the element are dropped, and the
+    ///         unused ones are set to zero
+    /// @param  format          The format of the element
+    /// @param  pValues         The values to encode
+    /// @param  nbComponents    Number of values
+    /// @param  scale           The dequantization scale (only used by FORMAT_SHORT)
+    /// @param  pDest           The vertex element
+    //-----------------------------------------------------------------------------------
+    static void encode(tFormat format, const float* pValues, unsigned short nbComponents,
+                       Math::Real scale, void* pDest);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Decode the values stored in a vertex element
+    /// @param  format          The format of the element
+    /// @param  pSource         The vertex element
+    /// @param  nbComponents    Number of values to decode
+    /// @param  scale           The dequantization scale (only used by FORMAT_SHORT)
+    /// @param  pValues         The decoded values
+    //-----------------------------------------------------------------------------------
+    static void decode(tFormat format, const void* pSource, unsigned short nbComponents,
+                       Math::Real scale, float* pValues);
+};
+
+}
+}
+
+#endif
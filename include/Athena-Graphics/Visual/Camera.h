@@ -10,6 +10,7 @@
 #include <Athena-Graphics/Prerequisites.h>
 #include <Athena-Graphics/Visual/EntityComponent.h>
 #include <Athena-Graphics/Conversions.h>
+#include <Athena-Graphics/MeshClusters.h>
 #include <Ogre/OgreRenderTarget.h>
 #include <Ogre/OgreCamera.h>
 
@@ -104,6 +105,21 @@ public:
         return pRenderTarget->addViewport(m_pCamera, iZOrder, fLeft, fTop, fWidth, fHeight);
     }
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Determine which clusters of a mesh can be seen by this camera
+    /// @param  clusters    The clusters
+    /// @param  transform   Transformation from the space of the mesh to the world
+    /// @param  visibility  Receives the visibility of each cluster (0 or 1)
+    /// @return             The number of visible clusters
+    /// @see    MeshClusters::cull()
+    //-----------------------------------------------------------------------------------
+    inline unsigned int cullClusters(const MeshClusters::tClustersList& clusters,
+                                     const Math::Matrix4& transform,
+                                     std::vector<unsigned char>& visibility) const
+    {
+        return MeshClusters::cull(clusters, m_pCamera, toOgre(transform), visibility);
+    }
+
 
     //_____ Wrappers to the Ogre::Camera methods __________
 public:
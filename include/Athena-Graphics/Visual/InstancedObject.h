@@ -0,0 +1,183 @@
+/** @file   InstancedObject.h
+    @author Philip Abbet
+
+    Declaration of the class 'Athena::Graphics::Visual::InstancedObject'
+*/
+
+#ifndef _ATHENA_GRAPHICS_INSTANCEDOBJECT_H_
+#define _ATHENA_GRAPHICS_INSTANCEDOBJECT_H_
+
+#include <Athena-Graphics/Prerequisites.h>
+#include <Athena-Graphics/Visual/EntityComponent.h>
+#include <Athena-Graphics/InstancedMesh.h>
+#include <Ogre/OgreResourceGroupManager.h>
+
+
+namespace Athena {
+namespace Graphics {
+namespace Visual {
+
+
+//---------------------------------------------------------------------------------------
+/// @brief  A visual component that draws many copies of a mesh with hardware instancing
+///
+/// The mesh must contain some instance buffers (see
+/// MeshBuilder::declareInstanceBuffer()). The per-instance data (transforms relative
+/// to the component, colours, animation offsets, ...) is modified in bulk with
+/// setInstanceData(), and all the instances are drawn in one batch per submesh.
+//---------------------------------------------------------------------------------------
+class ATHENA_GRAPHICS_SYMBOL InstancedObject: public EntityComponent
+{
+    //_____ Construction / Destruction __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Constructor
+    /// @param  strName     Name of the component
+    //-----------------------------------------------------------------------------------
+    InstancedObject(const std::string& strName, Entities::ComponentsList* pList);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Create a new component (Component creation method)
+    ///
+    /// @param  strName Name of the component
+    /// @param  pList   List to which the component must be added
+    /// @return         The new component
+    //-----------------------------------------------------------------------------------
+    static InstancedObject* create(const std::string& strName, Entities::ComponentsList* pList);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Cast a component to a InstancedObject
+    ///
+    /// @param  pComponent  The component
+    /// @return             The component, 0 if it isn't castable to a InstancedObject
+    //-----------------------------------------------------------------------------------
+    static InstancedObject* cast(Component* pComponent);
+
+protected:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destructor
+    //-----------------------------------------------------------------------------------
+    virtual ~InstancedObject();
+
+
+    //_____ Implementation of EntityComponent __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the type of the component
+    /// @return The type
+    //-----------------------------------------------------------------------------------
+    virtual const std::string getType() const
+    {
+        return TYPE;
+    }
+
+
+    //_____ Methods __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the instanced mesh used by this component
+    /// @return The instanced mesh
+    //-----------------------------------------------------------------------------------
+    inline InstancedMesh* getInstancedMesh()
+    {
+        return m_pInstancedMesh;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Load a mesh
+    ///
+    /// @param  strMeshName     The name of the mesh
+    /// @param  strGroupName    The name of the resource group
+    /// @return                 'true' if successful
+    //-----------------------------------------------------------------------------------
+    bool loadMesh(const std::string& strMeshName, const std::string& strGroupName =
+                  Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the number of instances to draw
+    //-----------------------------------------------------------------------------------
+    void setNbInstances(unsigned int nbInstances);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the number of instances to draw
+    //-----------------------------------------------------------------------------------
+    unsigned int getNbInstances() const;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Modify the data of a range of instances of an instance buffer
+    /// @remark See InstancedMesh::setInstanceData()
+    /// @param  usSource        Source of the instance buffer
+    /// @param  start           Index of the first element of the buffer to modify
+    /// @param  nbElements      Number of elements to modify
+    /// @param  pData           The data, in the layout of the buffer
+    //-----------------------------------------------------------------------------------
+    void setInstanceData(unsigned short usSource, unsigned int start, unsigned int nbElements,
+                         const void* pData);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the bounding box enclosing all the instances, relative to the
+    ///         component
+    //-----------------------------------------------------------------------------------
+    void setInstancesBounds(const Math::AxisAlignedBox& box);
+
+private:
+    void destroyInstancedMesh();
+
+
+    //_____ Management of the properties __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns a list containing the properties of the component
+    ///
+    /// Used in the serialization mecanism of the components
+    /// @remark Must be overriden by each component type. Each implementation must first call
+    ///         its base class one, and add a new category (named after the component's type)
+    ///         AT THE BEGINNING of the obtained list, containing the properties related to
+    ///         this type.
+    /// @return The list of properties
+    //-----------------------------------------------------------------------------------
+    virtual Utils::PropertiesList* getProperties() const;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the value of a property of the component
+    ///
+    /// Used in the deserialization mecanism of the parts
+    /// @param  strCategory     The category of the property
+    /// @param  strName         The name of the property
+    /// @param  pValue          The value of the property
+    /// @return                 'true' if the property was used, 'false' if a required object
+    ///                         is missing
+    /// @remark Must be overriden by each component type. Each implementation must test if the
+    ///         property's category is the one of the component's type, and if so process the
+    ///         property's value. Otherwise, it must call its base class implementation.
+    //-----------------------------------------------------------------------------------
+    virtual bool setProperty(const std::string& strCategory, const std::string& strName,
+                             Utils::Variant* pValue);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the value of a property of the component
+    ///
+    /// Used in the deserialization mecanism of the parts
+    /// @param  strName     The name of the property
+    /// @param  pValue      The value of the property
+    /// @return             'true' if the property was used, 'false' if a required object
+    ///                     is missing
+    //-----------------------------------------------------------------------------------
+    bool setProperty(const std::string& strName, Utils::Variant* pValue);
+
+
+    //_____ Constants __________
+public:
+    static const std::string TYPE;  ///< Name of the type of component
+
+
+    //_____ Attributes __________
+protected:
+    InstancedMesh*  m_pInstancedMesh;
+};
+
+}
+}
+}
+
+#endif
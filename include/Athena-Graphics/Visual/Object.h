@@ -9,6 +9,7 @@
 
 #include <Athena-Graphics/Prerequisites.h>
 #include <Athena-Graphics/Visual/EntityComponent.h>
+#include <Athena-Graphics/MeshClusters.h>
 #include <Ogre/OgreEntity.h>
 #include <Ogre/OgreResourceGroupManager.h>
 
@@ -20,8 +21,15 @@ namespace Visual {
 
 //---------------------------------------------------------------------------------------
 /// @brief  A visual component that contains a mesh
+///
+/// When cluster culling is enabled (see enableClusterCulling()), the clusters of the
+/// mesh outside of the frustum of the camera, or facing away from it, aren't rendered.
+///
+/// The objects marked as static (see setStatic()) can be merged with their neighbours
+/// by the world (see World::buildStaticBatches()): their entity is then detached from
+/// their scene node, and they are rendered as part of a batch.
 //---------------------------------------------------------------------------------------
-class ATHENA_GRAPHICS_SYMBOL Object: public EntityComponent
+class ATHENA_GRAPHICS_SYMBOL Object: public EntityComponent, public Ogre::MovableObject::Listener
 {
     //_____ Construction / Destruction __________
 public:
@@ -88,6 +96,94 @@ public:
     bool loadMesh(const std::string& strMeshName, const std::string& strGroupName =
                   Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
 
+    //-----------------------------------------------------------------------------------
+    /// @brief  Enable the culling of the clusters of the mesh, each time it is rendered
+    ///
+    /// The entity is recreated on a private copy of the mesh, sharing its vertices but
+    /// using dynamic index buffers, in which only the visible clusters are written.
+    /// @param  clusters    The clusters of the mesh (see MeshClusters or
+    ///                     MeshBuilder::setClustering())
+    /// @return             'true' if successful
+    //-----------------------------------------------------------------------------------
+    bool enableClusterCulling(const MeshClusters& clusters);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Disable the culling of the clusters of the mesh
+    //-----------------------------------------------------------------------------------
+    void disableClusterCulling();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the clusters of the mesh are culled
+    //-----------------------------------------------------------------------------------
+    inline bool isClusterCullingEnabled() const
+    {
+        return !m_clusteredMesh.isNull();
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the mesh loaded by loadMesh()
+    /// @remark When cluster culling is enabled, this isn't the mesh of the entity
+    //-----------------------------------------------------------------------------------
+    inline Ogre::MeshPtr getMesh() const
+    {
+        if (isClusterCullingEnabled())
+            return m_originalMesh;
+
+        return (m_pEntity ? m_pEntity->getMesh() : Ogre::MeshPtr());
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Mark the object as static (or not)
+    ///
+    /// The static objects are registered to the world, which can merge them into
+    /// batches (see World::buildStaticBatches()).
+    /// @remark The transforms, visibility and materials of a static object must not be
+    ///         modified while it is batched (use World::unbatchRegion() or
+    ///         World::rebatchRegion() around the modifications)
+    //-----------------------------------------------------------------------------------
+    void setStatic(bool bStatic);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the object is static
+    //-----------------------------------------------------------------------------------
+    inline bool isStatic() const
+    {
+        return m_bStatic;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Indicates if the object is currently rendered as part of a static batch
+    //-----------------------------------------------------------------------------------
+    inline bool isBatched() const
+    {
+        return m_bBatched;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Called by the world when the object is added to (or removed from) a
+    ///         static batch
+    //-----------------------------------------------------------------------------------
+    void _setBatched(bool bBatched);
+
+private:
+    void cullClusters(const Ogre::Camera* pCamera);
+
+    void renderAllClusters(bool bAll);
+
+    void destroyClusteredMesh();
+
+    void replaceEntity(const std::string& strMeshName);
+
+    void destroyEntity();
+
+
+    //_____ Implementation of Ogre::MovableObject::Listener __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Called when the entity is about to be rendered by a camera
+    //-----------------------------------------------------------------------------------
+    virtual bool objectRendering(const Ogre::MovableObject* pObject, const Ogre::Camera* pCamera);
+
 
     //_____ Management of the properties __________
 public:
@@ -138,7 +234,22 @@ public:
 
     //_____ Attributes __________
 protected:
-    Ogre::Entity* m_pEntity;
+    Ogre::Entity*   m_pEntity;
+    Ogre::MeshPtr   m_originalMesh;         ///< The mesh loaded by loadMesh(), when
+                                            ///  cluster culling is enabled
+    Ogre::MeshPtr   m_clusteredMesh;        ///< The private copy of the mesh, when
+                                            ///  cluster culling is enabled
+    MeshClusters    m_clusters;
+    std::vector<std::vector<unsigned char> > m_clustersVisibility;
+    std::vector<Ogre::IndexData*> m_culledIndexData;    ///< Per submesh, the dynamic indices
+                                                        ///  of the visible clusters (0 if
+                                                        ///  not clustered)
+    std::vector<Ogre::IndexData*> m_allIndexData;       ///< Per submesh, all the indices (0
+                                                        ///  if not clustered)
+    const Ogre::Camera* m_pCullingCamera;   ///< The camera the clusters were culled for
+    unsigned long   m_cullingFrame;         ///< The frame the clusters were culled in
+    bool            m_bStatic;
+    bool            m_bBatched;
 };
 
 }
@@ -99,6 +99,10 @@ public:
     ///                         v direction
     /// @param  upVector        The 'Up' direction of the plane
     /// @return                 'true' if successful
+    /// @remark When the number of segments, of texture coordinate sets and the presence
+    ///         of the normals don't change, the vertices of the existing mesh are
+    ///         updated in place (no mesh or entity is recreated). The mesh is static
+    ///         until its first update, it then uses a dynamic vertex buffer.
     //-----------------------------------------------------------------------------------
     bool createPlane(const std::string& strMaterial, const Math::Vector3& normalVector,
                      Math::Real distance, Math::Real width, Math::Real height,
@@ -113,6 +117,11 @@ protected:
     //-----------------------------------------------------------------------------------
     bool createPlane();
 
+private:
+    void updatePlane();
+
+    void destroyPlane();
+
 
 
     //_____ Management of the properties __________
@@ -177,6 +186,13 @@ protected:
     Math::Real      m_uTile;
     Math::Real      m_vTile;
     Math::Vector3   m_upVector;
+
+    DynamicMesh*    m_pDynamicMesh;         ///< Used to update the vertices of the mesh
+                                            ///  (created by the first update)
+    int             m_meshXSegments;        ///< Number of segments of the mesh
+    int             m_meshYSegments;        ///< Number of segments of the mesh
+    bool            m_bMeshNormals;         ///< Indicates if the mesh has normals
+    int             m_iMeshNbTexCoordSet;   ///< Number of texture coordinate sets of the mesh
 };
 
 }
@@ -12,7 +12,10 @@
 #include <Athena-Entities/ComponentsList.h>
 #include <Athena-Core/Signals/SignalsList.h>
 #include <Athena-Core/Signals/Declarations.h>
+#include <Athena-Math/Vector3.h>
+#include <Athena-Math/AxisAlignedBox.h>
 #include <Ogre/OgreSceneManager.h>
+#include <Ogre/OgreEntity.h>
 
 
 namespace Athena {
@@ -28,6 +31,18 @@ namespace Visual {
 /// There can be only one visual world per scene, and it MUST be a component of the
 /// scene itself (not of an entity). Additionally, the name of the world component will
 /// always be equal to World::DEFAULT_NAME.
+///
+/// The world can merge the objects marked as static (see Object::setStatic()) into
+/// batches, to render them with a few draw calls. The space is divided in a grid of
+/// chunks (see setStaticChunkSize()): the static objects are assigned to the chunk
+/// containing the center of their bounding box, and the objects of a chunk are merged
+/// into one mesh, with one submesh per material (and vertex format). The vertices are
+/// transformed in world space, so each batch has its own bounds for the culling.
+///
+/// Only the meshes with readable vertex and index buffers (loaded from a file, or
+/// built with a shadow buffer), without skeleton nor vertex animation, made of triangle
+/// lists of 32-bit float and colour attributes can be batched. The other static objects
+/// keep their own entity.
 //---------------------------------------------------------------------------------------
 class ATHENA_GRAPHICS_SYMBOL World: public VisualComponent
 {
@@ -130,6 +145,106 @@ public:
     const Math::Color getAmbientLight() const;
 
 
+    //_____ Static batching __________
+public:
+    //-----------------------------------------------------------------------------------
+    /// @brief  Set the size of the chunks used to batch the static objects
+    /// @remark Only affects the chunks built afterwards: call clearStaticBatches() and
+    ///         buildStaticBatches() to apply the new size to the existing batches
+    //-----------------------------------------------------------------------------------
+    void setStaticChunkSize(const Math::Vector3& size);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the size of the chunks used to batch the static objects
+    //-----------------------------------------------------------------------------------
+    inline const Math::Vector3& getStaticChunkSize() const
+    {
+        return m_staticChunkSize;
+    }
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Merge the static objects that aren't batched yet into the batches of
+    ///         their chunk
+    /// @remark The chunks receiving new objects, or that lost some, are rebuilt
+    //-----------------------------------------------------------------------------------
+    void buildStaticBatches();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destroy the batches of the chunks intersecting a region, their objects
+    ///         are rendered by their own entity again
+    /// @param  region  The region, in world space
+    //-----------------------------------------------------------------------------------
+    void unbatchRegion(const Math::AxisAlignedBox& region);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Rebuild the batches of the chunks intersecting a region
+    ///
+    /// The static objects are reassigned to the chunks using their current position:
+    /// the region must contain the old and the new positions of the objects that moved.
+    /// @param  region  The region, in world space
+    //-----------------------------------------------------------------------------------
+    void rebatchRegion(const Math::AxisAlignedBox& region);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Destroy all the static batches
+    /// @remark The objects that couldn't be batched are tried again by the next call to
+    ///         buildStaticBatches()
+    //-----------------------------------------------------------------------------------
+    void clearStaticBatches();
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Returns the number of static batches (Ogre entities)
+    //-----------------------------------------------------------------------------------
+    unsigned int getNbStaticBatches() const;
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Called by an object when it is marked as static
+    //-----------------------------------------------------------------------------------
+    void _addStaticObject(Object* pObject);
+
+    //-----------------------------------------------------------------------------------
+    /// @brief  Called by a static object when it isn't static anymore, or destroyed
+    /// @remark The chunk containing the object (if any) is rebuilt without it by the
+    ///         next call to buildStaticBatches() or rebatchRegion(). Until then, its
+    ///         batches still contain the geometry of the object.
+    //-----------------------------------------------------------------------------------
+    void _removeStaticObject(Object* pObject);
+
+private:
+    struct tChunkCoords
+    {
+        int x;
+        int y;
+        int z;
+
+        bool operator<(const tChunkCoords& other) const
+        {
+            if (x != other.x)
+                return x < other.x;
+            if (y != other.y)
+                return y < other.y;
+            return z < other.z;
+        }
+    };
+
+    struct tStaticChunk
+    {
+        std::vector<Object*>        objects;
+        std::vector<Ogre::Entity*>  batches;    ///< At most two: one casting shadows,
+                                                ///  one not
+    };
+
+    typedef std::map<tChunkCoords, tStaticChunk> tStaticChunksList;
+
+    void batchStaticObjects(const Ogre::AxisAlignedBox* pRegion);
+    void buildStaticChunk(tStaticChunk& chunk);
+    void unbatchStaticChunk(tStaticChunksList::iterator iter);
+    void removeFromStaticChunk(tStaticChunksList::iterator iter, Object* pObject);
+    void destroyStaticBatches(tStaticChunk& chunk);
+    tChunkCoords getChunkCoords(const Ogre::Vector3& position) const;
+    Ogre::AxisAlignedBox getChunkBox(const tChunkCoords& coords) const;
+
+
     //_____ Management of the properties __________
 public:
     //-----------------------------------------------------------------------------------
@@ -181,6 +296,18 @@ public:
     //_____ Attributes __________
 protected:
     Ogre::SceneManager* m_pSceneManager;
+
+private:
+    std::vector<Object*>    m_staticObjects;        ///< All the static objects, batched
+                                                    ///  or not
+    std::set<Object*>       m_unbatchableObjects;   ///< The static objects that failed
+                                                    ///  to be batched (not retried)
+    tStaticChunksList       m_staticChunks;
+    std::map<Object*, tChunkCoords> m_staticObjectsChunks;  ///< Chunk of each object
+                                                            ///  assigned to one
+    std::set<tChunkCoords>  m_dirtyChunks;          ///< The chunks that lost some objects
+    Math::Vector3           m_staticChunkSize;
+    Ogre::SceneNode*        m_pStaticBatchesNode;
 };
 
 }
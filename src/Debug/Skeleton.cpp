@@ -357,7 +357,7 @@ void Skeleton::_addFace(const Math::Vector3& point1, const Math::Vector3& point2
                         const Math::Vector3& point3, Ogre::Bone* pBone,
                         Graphics::MeshBuilder* pBuilder)
 {
-    unsigned short usNbVertices = pBuilder->getNbVertices();
+    unsigned int nbVertices = pBuilder->getNbVertices();
 
     Vector3 normal = (point2 - point1).crossProduct(point3 - point1);
 
@@ -373,7 +373,7 @@ void Skeleton::_addFace(const Math::Vector3& point1, const Math::Vector3& point2
     pBuilder->blendingIndices(pBone->getHandle());
     pBuilder->normal(normal);
 
-    pBuilder->triangle(usNbVertices, usNbVertices + 1, usNbVertices + 2);
+    pBuilder->triangle(nbVertices, nbVertices + 1, nbVertices + 2);
 }
 
 
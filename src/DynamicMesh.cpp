@@ -0,0 +1,308 @@
+/** @file   DynamicMesh.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::DynamicMesh'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/DynamicMesh.h>
+#include <Athena-Graphics/GraphicTools.h>
+
+// Ogre's includes
+#include <Ogre/OgreHardwareBufferManager.h>
+#include <Ogre/OgreSubMesh.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace std;
+
+using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::SubMesh;
+using Ogre::VertexBufferBinding;
+using Ogre::VertexData;
+using Ogre::VertexElement;
+
+
+/************************************** CONSTANTS **************************************/
+
+///< Index used for the shared vertices
+const unsigned short DynamicMesh::SHARED_VERTICES = 0xFFFF;
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+DynamicMesh::DynamicMesh(const Ogre::MeshPtr& mesh, tUpdateMode mode, unsigned int nbBuffers)
+: m_mesh(mesh), m_mode(mode), m_nbBuffers(mode == UPDATE_DISCARD ? 1 : nbBuffers)
+{
+    assert(!m_mesh.isNull());
+    assert(((mode == UPDATE_DISCARD) || (nbBuffers >= 3)) &&
+           "With two buffers, the one written by HBL_NO_OVERWRITE can still be in use by the GPU");
+}
+
+//-----------------------------------------------------------------------
+
+DynamicMesh::~DynamicMesh()
+{
+}
+
+
+/*************************************** METHODS ***************************************/
+
+void DynamicMesh::setValues(unsigned short usSubMesh, Ogre::VertexElementSemantic semantic,
+                            unsigned int start, unsigned int nbVertices, const float* pValues,
+                            unsigned short usIndex)
+{
+    assert(pValues || (nbVertices == 0));
+
+    VertexData* pVertexData = getVertexData(usSubMesh);
+
+    const VertexElement* pElement = pVertexData->vertexDeclaration->findElementBySemantic(semantic, usIndex);
+    assert(pElement && "Unknown vertex element");
+    assert((VertexElement::getBaseType(pElement->getType()) == Ogre::VET_FLOAT1) &&
+           "Only the elements made of floats are supported");
+
+    tStream& stream = getStream(pVertexData, pElement->getSource());
+
+    assert((start + nbVertices <= pVertexData->vertexCount) && "Invalid range of vertices");
+
+    const unsigned short nbComponents = VertexElement::getTypeCount(pElement->getType());
+
+    unsigned char* pDest = &stream.data[(pVertexData->vertexStart + start) * stream.vertexSize + pElement->getOffset()];
+
+    for (unsigned int i = 0; i < nbVertices; ++i, pDest += stream.vertexSize, pValues += nbComponents)
+        memcpy(pDest, pValues, nbComponents * sizeof(float));
+
+    markDirty(usSubMesh, pElement->getSource(), start, nbVertices);
+}
+
+//-----------------------------------------------------------------------
+
+unsigned char* DynamicMesh::getVertices(unsigned short usSubMesh, unsigned short usSource)
+{
+    VertexData* pVertexData = getVertexData(usSubMesh);
+
+    tStream& stream = getStream(pVertexData, usSource);
+
+    return &stream.data[pVertexData->vertexStart * stream.vertexSize];
+}
+
+//-----------------------------------------------------------------------
+
+void DynamicMesh::markDirty(unsigned short usSubMesh, unsigned short usSource, unsigned int start,
+                            unsigned int nbVertices)
+{
+    if (nbVertices == 0)
+        return;
+
+    VertexData* pVertexData = getVertexData(usSubMesh);
+
+    tStream& stream = getStream(pVertexData, usSource);
+
+    assert((start + nbVertices <= pVertexData->vertexCount) && "Invalid range of vertices");
+
+    // Each buffer must receive the modification before being used again
+    const tRange range(pVertexData->vertexStart + start, pVertexData->vertexStart + start + nbVertices);
+
+    for (unsigned int i = 0; i < stream.dirtyRanges.size(); ++i)
+        stream.dirtyRanges[i].push_back(range);
+}
+
+//-----------------------------------------------------------------------
+
+size_t DynamicMesh::update()
+{
+    size_t nbBytesUploaded = 0;
+
+    std::list<tStream>::iterator iter, iterEnd;
+    for (iter = m_streams.begin(), iterEnd = m_streams.end(); iter != iterEnd; ++iter)
+    {
+        tStream& stream = *iter;
+
+        if (m_mode == UPDATE_DISCARD)
+        {
+            if (stream.dirtyRanges[0].empty())
+                continue;
+
+            // The content of the buffer is lost by the discard, so it is entirely
+            // rewritten
+            HardwareVertexBufferSharedPtr& buffer = stream.buffers[0];
+
+            void* pDest = buffer->lock(HardwareBuffer::HBL_DISCARD);
+            memcpy(pDest, &stream.data[0], stream.data.size());
+            buffer->unlock();
+
+            nbBytesUploaded += stream.data.size();
+            stream.dirtyRanges[0].clear();
+        }
+        else
+        {
+            // The oldest buffer of the ring isn't used by the frames in flight anymore:
+            // write the ranges modified since it was last written, then use it
+            const unsigned int next = (stream.current + 1) % stream.buffers.size();
+
+            tRangesList& ranges = stream.dirtyRanges[next];
+            if (ranges.empty())
+                continue;
+
+            mergeRanges(ranges);
+
+            HardwareVertexBufferSharedPtr& buffer = stream.buffers[next];
+
+            tRangesList::const_iterator iterRange, iterRangeEnd;
+            for (iterRange = ranges.begin(), iterRangeEnd = ranges.end(); iterRange != iterRangeEnd; ++iterRange)
+            {
+                const size_t offset = iterRange->first * stream.vertexSize;
+                const size_t length = (iterRange->second - iterRange->first) * stream.vertexSize;
+
+                void* pDest = buffer->lock(offset, length, HardwareBuffer::HBL_NO_OVERWRITE);
+                memcpy(pDest, &stream.data[offset], length);
+                buffer->unlock();
+
+                nbBytesUploaded += length;
+            }
+
+            ranges.clear();
+
+            bindBuffer(stream, buffer);
+            stream.current = next;
+        }
+    }
+
+    return nbBytesUploaded;
+}
+
+//-----------------------------------------------------------------------
+
+DynamicMesh::tStream& DynamicMesh::getStream(VertexData* pVertexData, unsigned short usSource)
+{
+    assert(pVertexData->vertexBufferBinding->isBufferBound(usSource) && "Unknown vertex buffer");
+
+    // Copy of the pointer: converting the buffer replaces its binding
+    HardwareVertexBufferSharedPtr buffer = pVertexData->vertexBufferBinding->getBuffer(usSource);
+
+    std::map<Ogre::HardwareVertexBuffer*, tStream*>::iterator iter = m_buffers.find(buffer.get());
+    if (iter != m_buffers.end())
+        return *iter->second;
+
+    return convertBuffer(buffer);
+}
+
+//-----------------------------------------------------------------------
+
+DynamicMesh::tStream& DynamicMesh::convertBuffer(const HardwareVertexBufferSharedPtr& source)
+{
+    assert(GraphicTools::isReadable(source.get()) && "The modified vertex buffers must be readable");
+
+    m_streams.push_back(tStream());
+    tStream& stream = m_streams.back();
+
+    stream.vertexSize   = source->getVertexSize();
+    stream.current      = 0;
+
+    // Retrieve all the vertex data using the buffer (it can be shared between several
+    // ones)
+    std::vector<VertexData*> vertexDatas;
+
+    if (m_mesh->sharedVertexData)
+        vertexDatas.push_back(m_mesh->sharedVertexData);
+
+    for (unsigned short i = 0; i < m_mesh->getNumSubMeshes(); ++i)
+    {
+        SubMesh* pSubMesh = m_mesh->getSubMesh(i);
+
+        if (!pSubMesh->useSharedVertices && pSubMesh->vertexData)
+            vertexDatas.push_back(pSubMesh->vertexData);
+    }
+
+    std::vector<VertexData*>::const_iterator iter, iterEnd;
+    for (iter = vertexDatas.begin(), iterEnd = vertexDatas.end(); iter != iterEnd; ++iter)
+    {
+        const VertexBufferBinding::VertexBufferBindingMap& bindings = (*iter)->vertexBufferBinding->getBindings();
+
+        VertexBufferBinding::VertexBufferBindingMap::const_iterator iterBinding, iterBindingEnd;
+        for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+        {
+            if (iterBinding->second == source)
+                stream.bindings.push_back(tBinding(*iter, iterBinding->first));
+        }
+    }
+
+    // Copy the vertices in system memory
+    stream.data.resize(source->getSizeInBytes());
+    source->readData(0, stream.data.size(), &stream.data[0]);
+
+    // Replace the buffer by dynamic ones
+    const HardwareBuffer::Usage usage = (m_mode == UPDATE_DISCARD ? HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY_DISCARDABLE :
+                                                                    HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY);
+
+    for (unsigned int i = 0; i < m_nbBuffers; ++i)
+    {
+        HardwareVertexBufferSharedPtr buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                                                    stream.vertexSize, source->getNumVertices(), usage);
+
+        buffer->setIsInstanceData(source->getIsInstanceData());
+        buffer->setInstanceDataStepRate(source->getInstanceDataStepRate());
+        buffer->writeData(0, stream.data.size(), &stream.data[0], true);
+
+        stream.buffers.push_back(buffer);
+        m_buffers[buffer.get()] = &stream;
+    }
+
+    stream.dirtyRanges.resize(m_nbBuffers);
+
+    bindBuffer(stream, stream.buffers[0]);
+
+    return stream;
+}
+
+//-----------------------------------------------------------------------
+
+void DynamicMesh::bindBuffer(const tStream& stream, const HardwareVertexBufferSharedPtr& buffer)
+{
+    std::vector<tBinding>::const_iterator iter, iterEnd;
+    for (iter = stream.bindings.begin(), iterEnd = stream.bindings.end(); iter != iterEnd; ++iter)
+        iter->first->vertexBufferBinding->setBinding(iter->second, buffer);
+}
+
+//-----------------------------------------------------------------------
+
+VertexData* DynamicMesh::getVertexData(unsigned short usSubMesh) const
+{
+    if (usSubMesh == SHARED_VERTICES)
+    {
+        assert(m_mesh->sharedVertexData && "The mesh doesn't have shared vertices");
+        return m_mesh->sharedVertexData;
+    }
+
+    assert((usSubMesh < m_mesh->getNumSubMeshes()) && "Invalid submesh index");
+
+    SubMesh* pSubMesh = m_mesh->getSubMesh(usSubMesh);
+
+    return (pSubMesh->useSharedVertices ? m_mesh->sharedVertexData : pSubMesh->vertexData);
+}
+
+//-----------------------------------------------------------------------
+
+void DynamicMesh::mergeRanges(tRangesList& ranges)
+{
+    if (ranges.size() <= 1)
+        return;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    // Merge the overlapping and contiguous ranges
+    unsigned int nbMerged = 0;
+
+    for (unsigned int i = 1; i < ranges.size(); ++i)
+    {
+        if (ranges[i].first <= ranges[nbMerged].second)
+            ranges[nbMerged].second = std::max(ranges[nbMerged].second, ranges[i].second);
+        else
+            ranges[++nbMerged] = ranges[i];
+    }
+
+    ranges.resize(nbMerged + 1);
+}
@@ -21,6 +21,7 @@
 #include <Ogre/OgreEntity.h>
 #include <Ogre/OgreSubEntity.h>
 #include <Ogre/OgreTechnique.h>
+#include <Ogre/OgreHardwareIndexBuffer.h>
 
 
 using namespace Athena;
@@ -32,6 +33,9 @@ using namespace std;
 
 using Ogre::Bone;
 using Ogre::Entity;
+using Ogre::HardwareBuffer;
+using Ogre::HardwareIndexBuffer;
+using Ogre::HardwareIndexBufferSharedPtr;
 using Ogre::Material;
 using Ogre::MaterialPtr;
 using Ogre::Mesh;
@@ -345,3 +349,67 @@ void GraphicTools::resetMaterials(Entities::Entity* pEntity)
         }
     }
 }
+
+//-----------------------------------------------------------------------
+
+bool GraphicTools::isReadable(const HardwareBuffer* pBuffer)
+{
+    // Assertions
+    assert(pBuffer);
+
+    return pBuffer->hasShadowBuffer() || !(pBuffer->getUsage() & HardwareBuffer::HBU_WRITE_ONLY);
+}
+
+//-----------------------------------------------------------------------
+
+Ogre::MeshPtr GraphicTools::loadReadableMesh(const std::string& strMeshName,
+                                             const std::string& strResourceGroup)
+{
+    MeshPtr mesh = MeshManager::getSingletonPtr()->load(strMeshName, strResourceGroup,
+                                                        HardwareBuffer::HBU_STATIC_WRITE_ONLY,
+                                                        HardwareBuffer::HBU_STATIC_WRITE_ONLY,
+                                                        true, true);
+    assert(!mesh.isNull());
+
+    // The mesh was already loaded by someone else, with other policies
+    if ((!mesh->isVertexBufferShadowed() || !mesh->isIndexBufferShadowed()) && !mesh->isManuallyLoaded())
+    {
+        mesh->setVertexBufferPolicy(HardwareBuffer::HBU_STATIC_WRITE_ONLY, true);
+        mesh->setIndexBufferPolicy(HardwareBuffer::HBU_STATIC_WRITE_ONLY, true);
+        mesh->reload();
+    }
+
+    return mesh;
+}
+
+//-----------------------------------------------------------------------
+
+void GraphicTools::readIndices(const Ogre::IndexData* pIndexData, std::vector<unsigned int>& indices)
+{
+    // Assertions
+    assert(pIndexData);
+
+    indices.resize(pIndexData->indexCount);
+
+    if (pIndexData->indexCount == 0)
+        return;
+
+    HardwareIndexBufferSharedPtr buffer = pIndexData->indexBuffer;
+
+    const size_t indexSize = buffer->getIndexSize();
+    const void* pSource = buffer->lock(pIndexData->indexStart * indexSize, pIndexData->indexCount * indexSize,
+                                       HardwareBuffer::HBL_READ_ONLY);
+
+    if (buffer->getType() == HardwareIndexBuffer::IT_32BIT)
+    {
+        memcpy(&indices[0], pSource, pIndexData->indexCount * sizeof(unsigned int));
+    }
+    else
+    {
+        const unsigned short* pIndices = static_cast<const unsigned short*>(pSource);
+        for (size_t i = 0; i < pIndexData->indexCount; ++i)
+            indices[i] = pIndices[i];
+    }
+
+    buffer->unlock();
+}
@@ -0,0 +1,308 @@
+/** @file   InstancedMesh.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::InstancedMesh'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/InstancedMesh.h>
+#include <Athena-Graphics/GraphicTools.h>
+#include <Athena-Graphics/Conversions.h>
+
+// Ogre's includes
+#include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreHardwareBufferManager.h>
+#include <Ogre/OgreMaterialManager.h>
+#include <Ogre/OgreRenderQueue.h>
+#include <Ogre/OgreSceneNode.h>
+#include <Ogre/OgreCamera.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::MaterialManager;
+using Ogre::SubMesh;
+using Ogre::VertexBufferBinding;
+using Ogre::VertexData;
+
+
+/************************************** CONSTANTS **************************************/
+
+const std::string InstancedMesh::TYPE = "Athena/InstancedMesh";
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+InstancedMesh::InstancedMesh(const std::string& strName, const Ogre::MeshPtr& mesh)
+: Ogre::MovableObject(strName), m_mesh(mesh), m_nbInstances(0), m_nbMaxInstances(0xFFFFFFFF)
+{
+    assert(!mesh.isNull() && mesh->isLoaded());
+
+    // Copy the vertex data of the mesh (sharing the vertex buffers), then replace its
+    // instance buffers by the ones of this object
+    VertexData* pSharedVertexData = 0;
+    if (mesh->sharedVertexData)
+    {
+        pSharedVertexData = mesh->sharedVertexData->clone(false);
+        m_vertexDatas.push_back(pSharedVertexData);
+    }
+
+    for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+    {
+        SubMesh* pSubMesh = mesh->getSubMesh(i);
+
+        VertexData* pVertexData = pSharedVertexData;
+        if (!pSubMesh->useSharedVertices)
+        {
+            pVertexData = pSubMesh->vertexData->clone(false);
+            m_vertexDatas.push_back(pVertexData);
+        }
+
+        m_subMeshes.push_back(new InstancedSubMesh(this, pSubMesh, pVertexData));
+    }
+
+    std::vector<VertexData*>::iterator iter, iterEnd;
+    for (iter = m_vertexDatas.begin(), iterEnd = m_vertexDatas.end(); iter != iterEnd; ++iter)
+    {
+        VertexBufferBinding* pBinding = (*iter)->vertexBufferBinding;
+        const VertexBufferBinding::VertexBufferBindingMap& bindings = pBinding->getBindings();
+
+        VertexBufferBinding::VertexBufferBindingMap::const_iterator iterBinding, iterBindingEnd;
+        for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+        {
+            const HardwareVertexBufferSharedPtr& source = iterBinding->second;
+            if (!source->getIsInstanceData())
+                continue;
+
+            HardwareVertexBufferSharedPtr& buffer = m_instanceBuffers[iterBinding->first];
+
+            if (buffer.isNull())
+            {
+                buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                                source->getVertexSize(), source->getNumVertices(),
+                                source->getUsage(), source->hasShadowBuffer());
+
+                buffer->setIsInstanceData(true);
+                buffer->setInstanceDataStepRate(source->getInstanceDataStepRate());
+
+                // Start with the initial content of the instances if it can be read
+                if (GraphicTools::isReadable(source.get()))
+                {
+                    buffer->copyData(*source, 0, 0, source->getSizeInBytes(), true);
+                }
+                else
+                {
+                    memset(buffer->lock(HardwareBuffer::HBL_DISCARD), 0, buffer->getSizeInBytes());
+                    buffer->unlock();
+                }
+
+                m_nbMaxInstances = std::min(m_nbMaxInstances,
+                                            (unsigned int) (source->getNumVertices() * source->getInstanceDataStepRate()));
+            }
+
+            assert((buffer->getVertexSize() == source->getVertexSize()) &&
+                   (buffer->getNumVertices() == source->getNumVertices()) &&
+                   "The submeshes must use the same instance buffers");
+        }
+    }
+
+    for (iter = m_vertexDatas.begin(), iterEnd = m_vertexDatas.end(); iter != iterEnd; ++iter)
+    {
+        std::map<unsigned short, HardwareVertexBufferSharedPtr>::const_iterator iterBuffer, iterBufferEnd;
+        for (iterBuffer = m_instanceBuffers.begin(), iterBufferEnd = m_instanceBuffers.end();
+             iterBuffer != iterBufferEnd; ++iterBuffer)
+        {
+            if ((*iter)->vertexBufferBinding->isBufferBound(iterBuffer->first))
+                (*iter)->vertexBufferBinding->setBinding(iterBuffer->first, iterBuffer->second);
+        }
+    }
+
+    if (m_instanceBuffers.empty())
+        m_nbMaxInstances = 0;
+
+    m_box       = mesh->getBounds();
+    m_radius    = mesh->getBoundingSphereRadius();
+}
+
+//-----------------------------------------------------------------------
+
+InstancedMesh::~InstancedMesh()
+{
+    std::vector<InstancedSubMesh*>::iterator iter, iterEnd;
+    for (iter = m_subMeshes.begin(), iterEnd = m_subMeshes.end(); iter != iterEnd; ++iter)
+        delete *iter;
+
+    std::vector<VertexData*>::iterator iterData, iterDataEnd;
+    for (iterData = m_vertexDatas.begin(), iterDataEnd = m_vertexDatas.end(); iterData != iterDataEnd; ++iterData)
+        delete *iterData;
+}
+
+
+/*************************************** METHODS ***************************************/
+
+void InstancedMesh::setNbInstances(unsigned int nbInstances)
+{
+    assert((nbInstances <= m_nbMaxInstances) && "Too much instances");
+
+    m_nbInstances = std::min(nbInstances, m_nbMaxInstances);
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::setInstanceData(unsigned short usSource, unsigned int start,
+                                    unsigned int nbElements, const void* pData)
+{
+    HardwareVertexBufferSharedPtr buffer = getInstanceBuffer(usSource);
+
+    assert(!buffer.isNull() && "Unknown instance buffer");
+    assert((start + nbElements <= buffer->getNumVertices()) && "Too much instances");
+    assert(pData);
+
+    if (nbElements == 0)
+        return;
+
+    const size_t size = buffer->getVertexSize();
+
+    buffer->writeData(start * size, nbElements * size, pData,
+                      (start == 0) && (nbElements == buffer->getNumVertices()));
+}
+
+//-----------------------------------------------------------------------
+
+HardwareVertexBufferSharedPtr InstancedMesh::getInstanceBuffer(unsigned short usSource) const
+{
+    std::map<unsigned short, HardwareVertexBufferSharedPtr>::const_iterator iter = m_instanceBuffers.find(usSource);
+    if (iter == m_instanceBuffers.end())
+        return HardwareVertexBufferSharedPtr();
+
+    return iter->second;
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::setBoundingBox(const AxisAlignedBox& box)
+{
+    m_box = toOgre(box);
+
+    if (box.isNull())
+        m_radius = 0.0f;
+    else
+        m_radius = std::max(box.getMinimum().length(), box.getMaximum().length());
+
+    if (mParentNode)
+        mParentNode->needUpdate();
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::setMaterialName(const std::string& strMaterial)
+{
+    std::vector<InstancedSubMesh*>::iterator iter, iterEnd;
+    for (iter = m_subMeshes.begin(), iterEnd = m_subMeshes.end(); iter != iterEnd; ++iter)
+        (*iter)->setMaterialName(strMaterial);
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::setMaterialName(unsigned int subMesh, const std::string& strMaterial)
+{
+    assert(subMesh < m_subMeshes.size());
+
+    m_subMeshes[subMesh]->setMaterialName(strMaterial);
+}
+
+
+/************************* IMPLEMENTATION OF Ogre::MovableObject ***********************/
+
+const Ogre::String& InstancedMesh::getMovableType() const
+{
+    return TYPE;
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::_updateRenderQueue(Ogre::RenderQueue* pQueue)
+{
+    if (m_nbInstances == 0)
+        return;
+
+    std::vector<InstancedSubMesh*>::iterator iter, iterEnd;
+    for (iter = m_subMeshes.begin(), iterEnd = m_subMeshes.end(); iter != iterEnd; ++iter)
+    {
+        if (mRenderQueueIDSet)
+            pQueue->addRenderable(*iter, mRenderQueueID);
+        else
+            pQueue->addRenderable(*iter);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::visitRenderables(Ogre::Renderable::Visitor* pVisitor, bool debugRenderables)
+{
+    std::vector<InstancedSubMesh*>::iterator iter, iterEnd;
+    for (iter = m_subMeshes.begin(), iterEnd = m_subMeshes.end(); iter != iterEnd; ++iter)
+        pVisitor->visit(*iter, 0, false);
+}
+
+
+/************************************ INSTANCED SUBMESH ********************************/
+
+InstancedMesh::InstancedSubMesh::InstancedSubMesh(InstancedMesh* pParent, SubMesh* pSubMesh,
+                                                  VertexData* pVertexData)
+: m_pParent(pParent), m_pSubMesh(pSubMesh), m_pVertexData(pVertexData)
+{
+    setMaterialName(pSubMesh->getMaterialName());
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::InstancedSubMesh::setMaterialName(const std::string& strMaterial)
+{
+    m_material = MaterialManager::getSingleton().getByName(strMaterial);
+
+    if (m_material.isNull())
+        m_material = MaterialManager::getSingleton().getByName("BaseWhite");
+
+    m_material->load();
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::InstancedSubMesh::getRenderOperation(Ogre::RenderOperation& op)
+{
+    m_pSubMesh->_getRenderOperation(op, 0);
+
+    // All the instances in one draw, with the instance buffers of the object
+    op.vertexData                           = m_pVertexData;
+    op.numberOfInstances                    = m_pParent->getNbInstances();
+    op.useGlobalInstancingVertexBufferData  = false;
+    op.srcRenderable                        = this;
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedMesh::InstancedSubMesh::getWorldTransforms(Ogre::Matrix4* xform) const
+{
+    *xform = m_pParent->_getParentNodeFullTransform();
+}
+
+//-----------------------------------------------------------------------
+
+Ogre::Real InstancedMesh::InstancedSubMesh::getSquaredViewDepth(const Ogre::Camera* pCamera) const
+{
+    return m_pParent->getParentNode()->getSquaredViewDepth(pCamera);
+}
+
+//-----------------------------------------------------------------------
+
+const Ogre::LightList& InstancedMesh::InstancedSubMesh::getLights() const
+{
+    return m_pParent->queryLights();
+}
@@ -0,0 +1,300 @@
+/** @file   MeshBounds.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshBounds'
+*/
+
+#include <Athena-Graphics/MeshBounds.h>
+
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+    #define ATHENA_GRAPHICS_BOUNDS_SSE
+    #include <xmmintrin.h>
+#endif
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+static inline const float* getPosition(const float* pPositions, unsigned int index, size_t stride)
+{
+    return reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(pPositions) + index * stride);
+}
+
+//-----------------------------------------------------------------------
+
+static inline float squaredDistance(const float* a, const float* b)
+{
+    const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the radius of the smallest sphere with a given center containing the
+/// vertices
+static float computeRadius(const float* pPositions, unsigned int nbVertices, size_t stride,
+                           const float* pCenter)
+{
+    float radius2 = 0.0f;
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+        radius2 = std::max(radius2, squaredDistance(getPosition(pPositions, i, stride), pCenter));
+
+    return sqrtf(radius2);
+}
+
+//-----------------------------------------------------------------------
+
+/// Ritter's algorithm, compared with the sphere centered on the bounding box
+static Sphere buildSphere(const float* pPositions, unsigned int nbVertices, size_t stride,
+                          const AxisAlignedBox& aabb)
+{
+    // Find the vertices with the smallest and largest coordinates along each axis
+    unsigned int minVertex[3] = { 0, 0, 0 };
+    unsigned int maxVertex[3] = { 0, 0, 0 };
+
+    for (unsigned int i = 1; i < nbVertices; ++i)
+    {
+        const float* p = getPosition(pPositions, i, stride);
+
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            if (p[j] < getPosition(pPositions, minVertex[j], stride)[j])
+                minVertex[j] = i;
+            if (p[j] > getPosition(pPositions, maxVertex[j], stride)[j])
+                maxVertex[j] = i;
+        }
+    }
+
+    // The initial sphere is built on the most distant pair
+    unsigned int axis = 0;
+    float maxDistance2 = -1.0f;
+
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+        const float distance2 = squaredDistance(getPosition(pPositions, minVertex[j], stride),
+                                                getPosition(pPositions, maxVertex[j], stride));
+        if (distance2 > maxDistance2)
+        {
+            maxDistance2 = distance2;
+            axis = j;
+        }
+    }
+
+    const float* pMin = getPosition(pPositions, minVertex[axis], stride);
+    const float* pMax = getPosition(pPositions, maxVertex[axis], stride);
+
+    float center[3] = { (pMin[0] + pMax[0]) * 0.5f, (pMin[1] + pMax[1]) * 0.5f, (pMin[2] + pMax[2]) * 0.5f };
+    float radius    = sqrtf(maxDistance2) * 0.5f;
+    float radius2   = radius * radius;
+
+    // Grow the sphere to include the vertices outside of it
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        const float* p = getPosition(pPositions, i, stride);
+        const float distance2 = squaredDistance(p, center);
+
+        if (distance2 > radius2)
+        {
+            const float distance = sqrtf(distance2);
+            const float newRadius = (radius + distance) * 0.5f;
+            const float k = (newRadius - radius) / distance;
+
+            radius  = newRadius;
+            radius2 = radius * radius;
+
+            for (unsigned int j = 0; j < 3; ++j)
+                center[j] += (p[j] - center[j]) * k;
+        }
+    }
+
+    // Compare with the sphere centered on the box
+    const Vector3 boxCenter = aabb.getCenter();
+    const float boxCenterValues[3] = { boxCenter.x, boxCenter.y, boxCenter.z };
+
+    const float boxRadius = computeRadius(pPositions, nbVertices, stride, boxCenterValues);
+
+    if (boxRadius < radius)
+        return Sphere(boxCenter, boxRadius);
+
+    return Sphere(Vector3(center[0], center[1], center[2]), radius);
+}
+
+
+/*************************************** METHODS ***************************************/
+
+AxisAlignedBox MeshBounds::computeAABB(const float* pPositions, unsigned int nbVertices, size_t stride)
+{
+    assert(pPositions || (nbVertices == 0));
+
+    AxisAlignedBox aabb;
+    aabb.setNull();
+
+    if (nbVertices == 0)
+        return aabb;
+
+    if (stride == 0)
+        stride = 3 * sizeof(float);
+
+    float minimum[3] = { pPositions[0], pPositions[1], pPositions[2] };
+    float maximum[3] = { pPositions[0], pPositions[1], pPositions[2] };
+
+    unsigned int start = 1;
+
+#ifdef ATHENA_GRAPHICS_BOUNDS_SSE
+    if (stride == 3 * sizeof(float))
+    {
+        // Tightly packed: 4 positions are loaded in 3 registers, each lane always
+        // receiving the same components (a: x y z x, b: y z x y, c: z x y z)
+        const unsigned int nbBlocks = nbVertices / 4;
+
+        if (nbBlocks > 0)
+        {
+            __m128 minA = _mm_loadu_ps(pPositions);
+            __m128 minB = _mm_loadu_ps(pPositions + 4);
+            __m128 minC = _mm_loadu_ps(pPositions + 8);
+            __m128 maxA = minA;
+            __m128 maxB = minB;
+            __m128 maxC = minC;
+
+            for (unsigned int i = 1; i < nbBlocks; ++i)
+            {
+                const float* p = pPositions + i * 12;
+
+                const __m128 a = _mm_loadu_ps(p);
+                const __m128 b = _mm_loadu_ps(p + 4);
+                const __m128 c = _mm_loadu_ps(p + 8);
+
+                minA = _mm_min_ps(minA, a);
+                minB = _mm_min_ps(minB, b);
+                minC = _mm_min_ps(minC, c);
+                maxA = _mm_max_ps(maxA, a);
+                maxB = _mm_max_ps(maxB, b);
+                maxC = _mm_max_ps(maxC, c);
+            }
+
+            float lanes[12];
+
+            _mm_storeu_ps(lanes, minA);
+            _mm_storeu_ps(lanes + 4, minB);
+            _mm_storeu_ps(lanes + 8, minC);
+
+            minimum[0] = std::min(std::min(lanes[0], lanes[3]), std::min(lanes[6], lanes[9]));
+            minimum[1] = std::min(std::min(lanes[1], lanes[4]), std::min(lanes[7], lanes[10]));
+            minimum[2] = std::min(std::min(lanes[2], lanes[5]), std::min(lanes[8], lanes[11]));
+
+            _mm_storeu_ps(lanes, maxA);
+            _mm_storeu_ps(lanes + 4, maxB);
+            _mm_storeu_ps(lanes + 8, maxC);
+
+            maximum[0] = std::max(std::max(lanes[0], lanes[3]), std::max(lanes[6], lanes[9]));
+            maximum[1] = std::max(std::max(lanes[1], lanes[4]), std::max(lanes[7], lanes[10]));
+            maximum[2] = std::max(std::max(lanes[2], lanes[5]), std::max(lanes[8], lanes[11]));
+
+            start = nbBlocks * 4;
+        }
+    }
+    else if (nbVertices > 1)
+    {
+        // Interleaved: one position per register (the fourth lane, read from the next
+        // attribute of the vertex, is ignored). The last position is done below, to
+        // not read past the end of the array.
+        __m128 minP = _mm_loadu_ps(pPositions);
+        __m128 maxP = minP;
+
+        for (unsigned int i = 1; i < nbVertices - 1; ++i)
+        {
+            const __m128 p = _mm_loadu_ps(getPosition(pPositions, i, stride));
+            minP = _mm_min_ps(minP, p);
+            maxP = _mm_max_ps(maxP, p);
+        }
+
+        float lanes[4];
+
+        _mm_storeu_ps(lanes, minP);
+        minimum[0] = lanes[0];
+        minimum[1] = lanes[1];
+        minimum[2] = lanes[2];
+
+        _mm_storeu_ps(lanes, maxP);
+        maximum[0] = lanes[0];
+        maximum[1] = lanes[1];
+        maximum[2] = lanes[2];
+
+        start = nbVertices - 1;
+    }
+#endif
+
+    for (unsigned int i = start; i < nbVertices; ++i)
+    {
+        const float* p = getPosition(pPositions, i, stride);
+
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            minimum[j] = std::min(minimum[j], p[j]);
+            maximum[j] = std::max(maximum[j], p[j]);
+        }
+    }
+
+    aabb.setExtents(Vector3(minimum[0], minimum[1], minimum[2]),
+                    Vector3(maximum[0], maximum[1], maximum[2]));
+
+    return aabb;
+}
+
+//-----------------------------------------------------------------------
+
+Sphere MeshBounds::computeSphere(const float* pPositions, unsigned int nbVertices, size_t stride)
+{
+    assert(pPositions || (nbVertices == 0));
+
+    if (nbVertices == 0)
+        return Sphere(Vector3::ZERO, 0.0f);
+
+    if (stride == 0)
+        stride = 3 * sizeof(float);
+
+    return buildSphere(pPositions, nbVertices, stride, computeAABB(pPositions, nbVertices, stride));
+}
+
+//-----------------------------------------------------------------------
+
+MeshBounds::tBounds MeshBounds::compute(const float* pPositions, unsigned int nbVertices, size_t stride)
+{
+    assert(pPositions || (nbVertices == 0));
+
+    tBounds bounds;
+
+    bounds.aabb = computeAABB(pPositions, nbVertices, stride);
+
+    if (nbVertices == 0)
+        bounds.sphere = Sphere(Vector3::ZERO, 0.0f);
+    else
+        bounds.sphere = buildSphere(pPositions, nbVertices, (stride == 0 ? 3 * sizeof(float) : stride), bounds.aabb);
+
+    return bounds;
+}
+
+//-----------------------------------------------------------------------
+
+Real MeshBounds::getRadiusFromOrigin(const tBounds& bounds)
+{
+    if (bounds.aabb.isNull())
+        return 0.0f;
+
+    const Vector3& minimum = bounds.aabb.getMinimum();
+    const Vector3& maximum = bounds.aabb.getMaximum();
+
+    const Vector3 corner(std::max(fabsf(minimum.x), fabsf(maximum.x)),
+                         std::max(fabsf(minimum.y), fabsf(maximum.y)),
+                         std::max(fabsf(minimum.z), fabsf(maximum.z)));
+
+    return std::min(corner.length(), bounds.sphere.getCenter().length() + bounds.sphere.getRadius());
+}
@@ -12,6 +12,8 @@
 #include <Ogre/OgreMeshManager.h>
 #include <Ogre/OgreHardwareBufferManager.h>
 #include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreStringConverter.h>
+#include <Ogre/OgreTimer.h>
 
 
 using namespace Athena;
@@ -23,6 +25,7 @@ using Ogre::MeshManager;
 using Ogre::HardwareBuffer;
 using Ogre::HardwareBufferManager;
 using Ogre::HardwareIndexBuffer;
+using Ogre::HardwareIndexBufferSharedPtr;
 using Ogre::HardwareVertexBufferSharedPtr;
 using Ogre::SubMesh;
 using Ogre::VertexBoneAssignment;
@@ -31,27 +34,279 @@ using Ogre::VertexData;
 using Ogre::VertexElement;
 
 
+/********************************** STATIC ATTRIBUTES **********************************/
+
+std::string MeshBuilder::s_strDefaultCacheDirectory;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Convert a value into a key usable for exact comparisons
+static int weldingKey(float value)
+{
+    // Comparison of the bits (-0 and +0 are considered equal)
+    value += 0.0f;
+
+    int key;
+    memcpy(&key, &value, sizeof(int));
+    return key;
+}
+
+//-----------------------------------------------------------------------
+
+/// Returns the cell of the welding grid (of size epsilon) containing a value. Computed
+/// in 64-bit and clamped, so large values divided by a small epsilon don't overflow.
+static long long weldingCell(float value, Real epsilon)
+{
+    const double LIMIT = 4611686018427387904.0;     // 2^62
+
+    const double cell = floor((double) value / epsilon);
+
+    if (cell != cell)
+        return 0;
+    else if (cell >= LIMIT)
+        return (long long) LIMIT;
+    else if (cell <= -LIMIT)
+        return -(long long) LIMIT;
+
+    return (long long) cell;
+}
+
+//-----------------------------------------------------------------------
+
+/// Indicates if two vertices can be welded: their first values differ by at most
+/// epsilon, the remaining ones (the blending indices) are identical
+static bool areWeldable(const float* pValues1, const float* pValues2, unsigned int nbValues,
+                        unsigned int nbTolerantValues, Real epsilon)
+{
+    for (unsigned int i = 0; i < nbTolerantValues; ++i)
+    {
+        if (!(fabs(pValues1[i] - pValues2[i]) <= epsilon))
+            return false;
+    }
+
+    for (unsigned int i = nbTolerantValues; i < nbValues; ++i)
+    {
+        if (pValues1[i] != pValues2[i])
+            return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the hash of a welding key (FNV-1a)
+static unsigned int hashWeldingKey(const void* pKey, unsigned int nbBytes)
+{
+    unsigned int hash = 2166136261u;
+
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pKey);
+    for (unsigned int i = 0; i < nbBytes; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//-----------------------------------------------------------------------
+
+/// Only keep the values of some vertices of a stream, in the given order. The result is
+/// assembled in the scratch buffer, which receives the old content of the stream.
+template<typename T>
+static void compactStream(std::vector<T>& stream, unsigned int nbComponents,
+                          const std::vector<unsigned int>& vertices, std::vector<T>& result)
+{
+    if (stream.empty() || (nbComponents == 0))
+        return;
+
+    result.assign(vertices.size() * nbComponents, T(0));
+
+    for (unsigned int i = 0; i < vertices.size(); ++i)
+    {
+        // The attributes missing from the end of the stream are zero
+        if ((vertices[i] + 1) * nbComponents <= stream.size())
+        {
+            for (unsigned int j = 0; j < nbComponents; ++j)
+                result[i * nbComponents + j] = stream[vertices[i] * nbComponents + j];
+        }
+    }
+
+    stream.swap(result);
+}
+
+//-----------------------------------------------------------------------
+
+/// Append a value to the data stored in the cache
+template<typename T>
+static void writeValue(std::vector<unsigned char>& data, const T& value)
+{
+    const unsigned char* pBytes = reinterpret_cast<const unsigned char*>(&value);
+    data.insert(data.end(), pBytes, pBytes + sizeof(T));
+}
+
+//-----------------------------------------------------------------------
+
+static void writeString(std::vector<unsigned char>& data, const std::string& str)
+{
+    writeValue(data, (Ogre::uint32) str.size());
+    data.insert(data.end(), str.begin(), str.end());
+}
+
+//-----------------------------------------------------------------------
+
+static void writeVector(std::vector<unsigned char>& data, const Vector3& v)
+{
+    writeValue(data, v.x);
+    writeValue(data, v.y);
+    writeValue(data, v.z);
+}
+
+//-----------------------------------------------------------------------
+
+static void writeBool(std::vector<unsigned char>& data, bool bValue)
+{
+    writeValue(data, (Ogre::uint8) (bValue ? 1 : 0));
+}
+
+//-----------------------------------------------------------------------
+
+static void writeBox(std::vector<unsigned char>& data, const AxisAlignedBox& box)
+{
+    writeBool(data, box.isNull());
+
+    if (!box.isNull())
+    {
+        writeVector(data, box.getMinimum());
+        writeVector(data, box.getMaximum());
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Read a value from the data stored in the cache
+template<typename T>
+static bool readValue(const std::vector<unsigned char>& data, size_t& offset, T& value)
+{
+    if (offset + sizeof(T) > data.size())
+        return false;
+
+    memcpy(&value, &data[offset], sizeof(T));
+    offset += sizeof(T);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+static bool readString(const std::vector<unsigned char>& data, size_t& offset, std::string& str)
+{
+    Ogre::uint32 length;
+    if (!readValue(data, offset, length) || (offset + length > data.size()))
+        return false;
+
+    str.assign(data.begin() + offset, data.begin() + offset + length);
+    offset += length;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+static bool readVector(const std::vector<unsigned char>& data, size_t& offset, Vector3& v)
+{
+    return readValue(data, offset, v.x) && readValue(data, offset, v.y) && readValue(data, offset, v.z);
+}
+
+//-----------------------------------------------------------------------
+
+static bool readBool(const std::vector<unsigned char>& data, size_t& offset, bool& bValue)
+{
+    Ogre::uint8 value;
+    if (!readValue(data, offset, value))
+        return false;
+
+    bValue = (value != 0);
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+/// Read a size stored on 64 bits
+static bool readSize(const std::vector<unsigned char>& data, size_t& offset, size_t& value)
+{
+    Ogre::uint64 value64;
+    if (!readValue(data, offset, value64))
+        return false;
+
+    value = (size_t) value64;
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+static bool readBox(const std::vector<unsigned char>& data, size_t& offset, AxisAlignedBox& box)
+{
+    bool bNull;
+    if (!readBool(data, offset, bNull))
+        return false;
+
+    if (bNull)
+    {
+        box.setNull();
+        return true;
+    }
+
+    Vector3 minimum;
+    Vector3 maximum;
+
+    if (!readVector(data, offset, minimum) || !readVector(data, offset, maximum))
+        return false;
+
+    box.setExtents(minimum, maximum);
+
+    return true;
+}
+
+
 /***************************** CONSTRUCTION / DESTRUCTION ******************************/
 
-MeshBuilder::MeshBuilder(const std::string& strMeshName, const std::string& strResourceGroup)
-: m_bIsSharedVertices(false), m_bFirstVertex(true), m_bAutomaticDeclaration(true),
-  m_bTempVertexPending(false), m_AABB(Vector3::ZERO, Vector3::ZERO), m_radius(0.0f)
+MeshBuilder::MeshBuilder(const std::string& strMeshName, const std::string& strResourceGroup,
+                         bool bDeferredCommit)
+: m_strMeshName(strMeshName), m_strResourceGroup(strResourceGroup), m_bDeferredCommit(bDeferredCommit),
+  m_bIsSharedVertices(false), m_bHasSharedVertices(false), m_bFirstVertex(true), m_bAutomaticDeclaration(true),
+  m_radius(0.0f), m_usTextureCoordsIndex(0),
+  m_uploadMode(UPLOAD_LOCK), m_vertexLayout(LAYOUT_DECLARED), m_bWelding(false), m_weldingEpsilon(0.0f),
+  m_optimizations(OPTIMIZE_NONE), m_bGenerateNormals(false),
+  m_normalsWeighting(TangentSpaceGenerator::WEIGHT_ANGLE), m_bGenerateTangents(false),
+  m_bGenerateBinormals(false), m_usTangentsTexCoordSet(0), m_bHardwareSkinning(false),
+  m_usMaxBonesPerDraw(256), m_usMaxBoneInfluences(OGRE_MAX_BLEND_WEIGHTS), m_bClustering(false),
+  m_nbMaxClusterTriangles(128), m_strCacheDirectory(s_strDefaultCacheDirectory),
+  m_bCacheShadowBuffers(false)
 {
-    // Creation of the mesh
-    m_mesh = MeshManager::getSingletonPtr()->createManual(strMeshName, strResourceGroup);
+    // Creation of the mesh (a deferred one is created by commit())
+    if (!m_bDeferredCommit)
+        m_mesh = MeshManager::getSingletonPtr()->createManual(strMeshName, strResourceGroup);
+
+    m_currentSubMesh.declaredSemantics = 0;
+
+    m_sharedVertices.nbVertices = 0;
+
+    m_AABB.setNull();
 
-    m_currentVertex.position        = Vector3::ZERO;
-    m_currentVertex.blendingDim     = 0;
-    m_currentVertex.normal          = Vector3::ZERO;
-    m_currentVertex.diffuseColour   = Color::Black;
-    m_currentVertex.specularColour  = Color::Black;
-    m_currentVertex.binormal        = Vector3::ZERO;
-    m_currentVertex.tangent         = Vector3::ZERO;
+    m_currentSubMesh.streams.nbVertices     = 0;
+    m_currentSubMesh.streams.batchStart     = 0;
+    m_currentSubMesh.streams.blendingDim    = 0;
 
-    memset(m_currentVertex.blendingWeights, 0, sizeof(m_currentVertex.blendingWeights));
-    memset(m_currentVertex.blendingIndices, 0, sizeof(m_currentVertex.blendingIndices));
-    memset(m_currentVertex.texCoord, 0, sizeof(m_currentVertex.texCoord));
-    memset(m_currentVertex.texCoordDims, 0, sizeof(m_currentVertex.texCoordDims));
+    memset(m_currentSubMesh.streams.texCoordDims, 0, sizeof(m_currentSubMesh.streams.texCoordDims));
+
+    memset(&m_statistics, 0, sizeof(m_statistics));
+
+    m_dequantization.position = 1.0f;
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        m_dequantization.texCoords[i] = 1.0f;
 }
 
 //-----------------------------------------------------------------------
@@ -60,25 +315,81 @@ MeshBuilder::~MeshBuilder()
 {
 }
 
+//-----------------------------------------------------------------------
+
+void MeshBuilder::reset(const std::string& strMeshName, const std::string& strResourceGroup)
+{
+    assert(!m_bIsSharedVertices && m_currentSubMesh.strName.empty() && "You cannot call reset() until after you call end()");
+    assert((!m_bDeferredCommit || !m_mesh.isNull() || (m_assembledSubMeshes.empty() && !m_bHasSharedVertices)) &&
+           "You must call commit() before you call reset()");
+
+    m_strMeshName       = strMeshName;
+    m_strResourceGroup  = strResourceGroup;
+    m_strSkeletonName   = "";
+
+    if (!m_bDeferredCommit)
+        m_mesh = MeshManager::getSingletonPtr()->createManual(strMeshName, strResourceGroup);
+    else
+        m_mesh.setNull();
+
+    m_bHasSharedVertices    = false;
+    m_bFirstVertex          = true;
+    m_bAutomaticDeclaration = true;
+    m_radius                = 0.0f;
+    m_usTextureCoordsIndex  = 0;
+
+    m_AABB.setNull();
+
+    memset(&m_statistics, 0, sizeof(m_statistics));
+
+    m_dequantizations.clear();
+    m_bounds.clear();
+    m_sharedVerticesRemap.clear();
+    m_clusters.clear();
+    releasePendingSubMeshes();
+    m_hasher.reset();
+
+    m_bCacheShadowBuffers = false;
+
+    // The staging containers were cleared by end() and endSharedVertices(), but kept
+    // their capacity
+}
+
 
 /************************************** METHODS ****************************************/
 
+void MeshBuilder::setDefaultCacheDirectory(const std::string& strDirectory)
+{
+    s_strDefaultCacheDirectory = strDirectory;
+}
+
+//-----------------------------------------------------------------------
+
+const std::string& MeshBuilder::getDefaultCacheDirectory()
+{
+    return s_strDefaultCacheDirectory;
+}
+
+//-----------------------------------------------------------------------
+
 void MeshBuilder::setSkeletonName(const std::string& strSkeletonName)
 {
-    m_mesh->setSkeletonName(strSkeletonName);
+    m_strSkeletonName = strSkeletonName;
+
+    if (!m_mesh.isNull())
+        m_mesh->setSkeletonName(strSkeletonName);
 }
 
 //-----------------------------------------------------------------------
 
 void MeshBuilder::beginSharedVertices()
 {
-    assert(!m_bIsSharedVertices && !m_mesh->sharedVertexData && "You cannot call beginSharedVertices() more than one time");
+    assert(!m_bIsSharedVertices && !m_bHasSharedVertices && "You cannot call beginSharedVertices() more than one time");
     assert(m_currentSubMesh.strName.empty() && "You cannot call beginSharedVertices() until after you call end()");
 
     m_bIsSharedVertices     = true;
     m_bFirstVertex          = true;
     m_bAutomaticDeclaration = true;
-    m_bTempVertexPending    = false;
 }
 
 //-----------------------------------------------------------------------
@@ -89,7 +400,7 @@ void MeshBuilder::begin(const std::string& strSubMeshName, const std::string& st
     assert(!m_bIsSharedVertices && "You cannot call begin() until after you call endSharedVertices()");
     assert(m_currentSubMesh.strName.empty() && "You cannot call begin() again until after you call end()");
     assert(!strSubMeshName.empty() && "The name of the submesh can't be empty");
-    assert(!bUseSharedVertices || m_mesh->sharedVertexData);
+    assert(!bUseSharedVertices || m_bHasSharedVertices);
 
     m_currentSubMesh.strName            = strSubMeshName;
     m_currentSubMesh.strMaterial        = strMaterial;
@@ -98,7 +409,6 @@ void MeshBuilder::begin(const std::string& strSubMeshName, const std::string& st
 
     m_bFirstVertex          = true;
     m_bAutomaticDeclaration = true;
-    m_bTempVertexPending    = false;
 
     m_currentSubMesh.indexBufferInfo.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
     m_currentSubMesh.indexBufferInfo.bUseShadowBuffer   = false;
@@ -111,8 +421,19 @@ void MeshBuilder::declareVertexBuffer(unsigned short usSource, Ogre::HardwareBuf
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareVertexBuffer()");
 
-    m_currentSubMesh.vertexBufferInfos[usSource].usage              = usage;
-    m_currentSubMesh.vertexBufferInfos[usSource].bUseShadowBuffer   = bUseShadowBuffer;
+    std::vector<tHardwareBufferInfo>& infos = m_currentSubMesh.vertexBufferInfos;
+
+    if (infos.size() <= usSource)
+    {
+        tHardwareBufferInfo info;
+        info.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
+        info.bUseShadowBuffer   = false;
+
+        infos.resize(usSource + 1, info);
+    }
+
+    infos[usSource].usage              = usage;
+    infos[usSource].bUseShadowBuffer   = bUseShadowBuffer;
 }
 
 //-----------------------------------------------------------------------
@@ -127,34 +448,22 @@ void MeshBuilder::declareIndexBuffer(Ogre::HardwareBuffer::Usage usage, bool bUs
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::declarePosition(unsigned short usSource)
+void MeshBuilder::declarePosition(unsigned short usSource, VertexCompression::tFormat format)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declarePosition()");
+    assert(((format == VertexCompression::FORMAT_FLOAT) || (format == VertexCompression::FORMAT_SHORT)) &&
+           "Unsupported format for the positions");
 
-    tElement element;
-    element.semantic    = Ogre::VES_POSITION;
-    element.type        = Ogre::VET_FLOAT3;
-    element.usIndex     = 0;
-
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
-
-    m_bAutomaticDeclaration = false;
+    addElement(usSource, Ogre::VES_POSITION, 0, 3, format);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::declareNormal(unsigned short usSource)
+void MeshBuilder::declareNormal(unsigned short usSource, VertexCompression::tFormat format)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareNormal()");
 
-    tElement element;
-    element.semantic    = Ogre::VES_NORMAL;
-    element.type        = Ogre::VET_FLOAT3;
-    element.usIndex     = 0;
-
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
-
-    m_bAutomaticDeclaration = false;
+    addElement(usSource, Ogre::VES_NORMAL, 0, 3, format);
 }
 
 //-----------------------------------------------------------------------
@@ -163,14 +472,7 @@ void MeshBuilder::declareDiffuseColor(unsigned short usSource)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareDiffuseColour()");
 
-    tElement element;
-    element.semantic    = Ogre::VES_DIFFUSE;
-    element.type        = Ogre::VET_COLOUR_ARGB;
-    element.usIndex     = 0;
-
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
-
-    m_bAutomaticDeclaration = false;
+    addElement(usSource, Ogre::VES_DIFFUSE, 0, 4, VertexCompression::FORMAT_FLOAT);
 }
 
 //-----------------------------------------------------------------------
@@ -179,46 +481,28 @@ void MeshBuilder::declareSpecularColor(unsigned short usSource)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareSpecularColour()");
 
-    tElement element;
-    element.semantic    = Ogre::VES_SPECULAR;
-    element.type        = Ogre::VET_COLOUR_ARGB;
-    element.usIndex     = 0;
-
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
-
-    m_bAutomaticDeclaration = false;
+    addElement(usSource, Ogre::VES_SPECULAR, 0, 4, VertexCompression::FORMAT_FLOAT);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::declareTextureCoordinates(unsigned short usSource, unsigned short size)
+void MeshBuilder::declareTextureCoordinates(unsigned short usSource, unsigned short size,
+                                            VertexCompression::tFormat format)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareTextureCoordinates()");
+    assert((size >= 1) && (size <= 3));
+    assert(((format == VertexCompression::FORMAT_FLOAT) || (format == VertexCompression::FORMAT_SHORT)) &&
+           "Unsupported format for the texture coordinates");
 
-    tElement element;
-    element.semantic = Ogre::VES_TEXTURE_COORDINATES;
-
-    switch (size)
-    {
-    case 1:
-        element.type = Ogre::VET_FLOAT1;
-        break;
-
-    case 2:
-        element.type = Ogre::VET_FLOAT2;
-        break;
-
-    case 3:
-        element.type = Ogre::VET_FLOAT3;
-        break;
-    }
+    // The texture coordinates are staged with the dimensions of their declaration
+    unsigned short* texCoordDims = m_currentSubMesh.streams.texCoordDims;
 
     for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
     {
-        if (m_currentVertex.texCoordDims[i] == 0)
+        if (texCoordDims[i] == 0)
         {
-            m_currentVertex.texCoordDims[i] = size;
-            element.usIndex                 = i;
+            texCoordDims[i] = size;
+            addElement(usSource, Ogre::VES_TEXTURE_COORDINATES, i, size, format);
             break;
         }
         else if (i == OGRE_MAX_TEXTURE_COORD_SETS - 1)
@@ -226,42 +510,65 @@ void MeshBuilder::declareTextureCoordinates(unsigned short usSource, unsigned sh
             assert(false && "Too much texture coordinates set");
         }
     }
-
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
-
-    m_bAutomaticDeclaration = false;
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::declareBinormal(unsigned short usSource)
+void MeshBuilder::declareBinormal(unsigned short usSource, VertexCompression::tFormat format)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareBinormal()");
 
-    tElement element;
-    element.semantic    = Ogre::VES_BINORMAL;
-    element.type        = Ogre::VET_FLOAT3;
-    element.usIndex     = 0;
+    addElement(usSource, Ogre::VES_BINORMAL, 0, 3, format);
+}
 
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
+//-----------------------------------------------------------------------
 
-    m_bAutomaticDeclaration = false;
+void MeshBuilder::declareTangent(unsigned short usSource, VertexCompression::tFormat format)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareTangent()");
+
+    addElement(usSource, Ogre::VES_TANGENT, 0, 3, format);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::declareTangent(unsigned short usSource)
+void MeshBuilder::declareInstanceBuffer(unsigned short usSource, unsigned int nbInstances,
+                                        unsigned int stepRate, Ogre::HardwareBuffer::Usage usage,
+                                        bool bUseShadowBuffer)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareTangent()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call declareInstanceBuffer()");
+    assert(!getInstanceBuffer(usSource) && "This instance buffer is already declared");
+    assert((nbInstances > 0) && (stepRate > 0));
+
+    tInstanceBuffer buffer;
+    buffer.usSource                 = usSource;
+    buffer.instanceSize             = 0;
+    buffer.nbInstances              = nbInstances;
+    buffer.stepRate                 = stepRate;
+    buffer.info.usage               = usage;
+    buffer.info.bUseShadowBuffer    = bUseShadowBuffer;
+
+    m_currentSubMesh.instanceBuffers.push_back(buffer);
+}
 
-    tElement element;
-    element.semantic    = Ogre::VES_TANGENT;
-    element.type        = Ogre::VET_FLOAT3;
-    element.usIndex     = 0;
+//-----------------------------------------------------------------------
 
-    m_currentSubMesh.verticesElements[usSource].push_back(element);
+void MeshBuilder::declareInstanceElement(unsigned short usSource, Ogre::VertexElementType type,
+                                         Ogre::VertexElementSemantic semantic, unsigned short usIndex)
+{
+    tInstanceBuffer* pBuffer = getInstanceBuffer(usSource);
+    assert(pBuffer && "You must call declareInstanceBuffer() before you call declareInstanceElement()");
+    assert(pBuffer->data.empty() && "You cannot call declareInstanceElement() after instanceData()");
 
-    m_bAutomaticDeclaration = false;
+    tElement element;
+    element.semantic        = semantic;
+    element.type            = type;
+    element.usIndex         = usIndex;
+    element.usNbComponents  = VertexElement::getTypeCount(type);
+    element.format          = VertexCompression::FORMAT_FLOAT;
+
+    pBuffer->elements.push_back(element);
+    pBuffer->instanceSize += VertexElement::getTypeSize(type);
 }
 
 //-----------------------------------------------------------------------
@@ -270,10 +577,6 @@ void MeshBuilder::position(const Vector3& pos)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call position()");
 
-    // If a temporary vertex is pending, add it to the list
-    if (m_bTempVertexPending)
-        copyTempVertexToBuffer();
-
     if (m_bAutomaticDeclaration)
     {
         if (m_bFirstVertex)
@@ -288,16 +591,18 @@ void MeshBuilder::position(const Vector3& pos)
         }
     }
 
-    m_currentVertex.position = pos;
+    // The new vertex is a batch of one vertex
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    streams.batchStart = streams.nbVertices;
+    ++streams.nbVertices;
 
-    // Update bounds
-    m_AABB.merge(pos);
-    m_radius = std::max(m_radius, pos.length());
+    streams.positions.push_back(pos.x);
+    streams.positions.push_back(pos.y);
+    streams.positions.push_back(pos.z);
 
     // Reset current texture coord
     m_usTextureCoordsIndex = 0;
-
-    m_bTempVertexPending = true;
 }
 
 //-----------------------------------------------------------------------
@@ -312,11 +617,12 @@ void MeshBuilder::position(Real x, Real y, Real z)
 void MeshBuilder::blendingWeights(Real w1, Real w2)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingWeights()");
-    assert((m_currentVertex.blendingDim == 0) && "You can't call blendingWeights more than one time");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call blendingWeights()");
+
+    const float weights[2] = { w1, w2 };
 
-    m_currentVertex.blendingDim         = 2;
-    m_currentVertex.blendingWeights[0]  = w1;
-    m_currentVertex.blendingWeights[1]  = w2;
+    setBlendingDim(2);
+    setCurrentValues(m_currentSubMesh.streams.blendingWeights, m_currentSubMesh.streams.blendingDim, weights, 2);
 }
 
 //-----------------------------------------------------------------------
@@ -324,12 +630,12 @@ void MeshBuilder::blendingWeights(Real w1, Real w2)
 void MeshBuilder::blendingWeights(Real w1, Real w2, Real w3)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingWeights()");
-    assert((m_currentVertex.blendingDim == 0) && "You can't call blendingWeights more than one time");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call blendingWeights()");
 
-    m_currentVertex.blendingDim         = 3;
-    m_currentVertex.blendingWeights[0]  = w1;
-    m_currentVertex.blendingWeights[1]  = w2;
-    m_currentVertex.blendingWeights[2]  = w3;
+    const float weights[3] = { w1, w2, w3 };
+
+    setBlendingDim(3);
+    setCurrentValues(m_currentSubMesh.streams.blendingWeights, m_currentSubMesh.streams.blendingDim, weights, 3);
 }
 
 //-----------------------------------------------------------------------
@@ -337,13 +643,12 @@ void MeshBuilder::blendingWeights(Real w1, Real w2, Real w3)
 void MeshBuilder::blendingWeights(Real w1, Real w2, Real w3, Real w4)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingWeights()");
-    assert((m_currentVertex.blendingDim == 0) && "You can't call blendingWeights more than one time");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call blendingWeights()");
+
+    const float weights[4] = { w1, w2, w3, w4 };
 
-    m_currentVertex.blendingDim         = 3;
-    m_currentVertex.blendingWeights[0]  = w1;
-    m_currentVertex.blendingWeights[1]  = w2;
-    m_currentVertex.blendingWeights[2]  = w3;
-    m_currentVertex.blendingWeights[3]  = w4;
+    setBlendingDim(4);
+    setCurrentValues(m_currentSubMesh.streams.blendingWeights, m_currentSubMesh.streams.blendingDim, weights, 4);
 }
 
 //-----------------------------------------------------------------------
@@ -351,11 +656,13 @@ void MeshBuilder::blendingWeights(Real w1, Real w2, Real w3, Real w4)
 void MeshBuilder::blendingIndices(unsigned short index)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingIndices()");
-    assert((m_currentVertex.blendingDim == 0) && "You can't call blendingIndices more than one time");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call blendingIndices()");
 
-    m_currentVertex.blendingDim         = 1;
-    m_currentVertex.blendingWeights[0]  = 1.0f;
-    m_currentVertex.blendingIndices[0]  = index;
+    const float weight = 1.0f;
+
+    setBlendingDim(1);
+    setCurrentValues(m_currentSubMesh.streams.blendingWeights, m_currentSubMesh.streams.blendingDim, &weight, 1);
+    setCurrentBlendingIndices(&index, 1);
 }
 
 //-----------------------------------------------------------------------
@@ -363,10 +670,11 @@ void MeshBuilder::blendingIndices(unsigned short index)
 void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingIndices()");
-    assert((m_currentVertex.blendingDim == 2) && "The number of blending indices is incorrect");
+    assert((m_currentSubMesh.streams.blendingDim >= 2) && "The number of blending indices is incorrect");
+
+    const unsigned short indices[2] = { i1, i2 };
 
-    m_currentVertex.blendingIndices[0] = i1;
-    m_currentVertex.blendingIndices[1] = i2;
+    setCurrentBlendingIndices(indices, 2);
 }
 
 //-----------------------------------------------------------------------
@@ -374,11 +682,11 @@ void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2)
 void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2, unsigned short i3)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingIndices()");
-    assert((m_currentVertex.blendingDim == 3) && "The number of blending indices is incorrect");
+    assert((m_currentSubMesh.streams.blendingDim >= 3) && "The number of blending indices is incorrect");
 
-    m_currentVertex.blendingIndices[0] = i1;
-    m_currentVertex.blendingIndices[1] = i2;
-    m_currentVertex.blendingIndices[2] = i3;
+    const unsigned short indices[3] = { i1, i2, i3 };
+
+    setCurrentBlendingIndices(indices, 3);
 }
 
 //-----------------------------------------------------------------------
@@ -386,12 +694,11 @@ void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2, unsigned
 void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2, unsigned short i3, unsigned short i4)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingIndices()");
-    assert((m_currentVertex.blendingDim == 4) && "The number of blending indices is incorrect");
+    assert((m_currentSubMesh.streams.blendingDim >= 4) && "The number of blending indices is incorrect");
+
+    const unsigned short indices[4] = { i1, i2, i3, i4 };
 
-    m_currentVertex.blendingIndices[0] = i1;
-    m_currentVertex.blendingIndices[1] = i2;
-    m_currentVertex.blendingIndices[2] = i3;
-    m_currentVertex.blendingIndices[3] = i4;
+    setCurrentBlendingIndices(indices, 4);
 }
 
 //-----------------------------------------------------------------------
@@ -399,6 +706,7 @@ void MeshBuilder::blendingIndices(unsigned short i1, unsigned short i2, unsigned
 void MeshBuilder::normal(const Vector3& normal)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call normal()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call normal()");
 
     if (m_bAutomaticDeclaration)
     {
@@ -406,7 +714,12 @@ void MeshBuilder::normal(const Vector3& normal)
         m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.normal = normal;
+    // Only the declared attributes are staged
+    if (!isDeclared(Ogre::VES_NORMAL))
+        return;
+
+    const float values[3] = { normal.x, normal.y, normal.z };
+    setCurrentValues(m_currentSubMesh.streams.normals, 3, values, 3);
 }
 
 //-----------------------------------------------------------------------
@@ -420,7 +733,8 @@ void MeshBuilder::normal(Real x, Real y, Real z)
 
 void MeshBuilder::diffuseColor(const Color& col)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call diffuseColour()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call diffuseColor()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call diffuseColor()");
 
     if (m_bAutomaticDeclaration)
     {
@@ -428,7 +742,12 @@ void MeshBuilder::diffuseColor(const Color& col)
         m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.diffuseColour = col;
+    // Only the declared attributes are staged
+    if (!isDeclared(Ogre::VES_DIFFUSE))
+        return;
+
+    const float values[4] = { col.r, col.g, col.b, col.a };
+    setCurrentValues(m_currentSubMesh.streams.diffuseColours, 4, values, 4);
 }
 
 //-----------------------------------------------------------------------
@@ -442,7 +761,8 @@ void MeshBuilder::diffuseColor(Real r, Real g, Real b, Real a)
 
 void MeshBuilder::specularColor(const Color& col)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call specularColour()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call specularColor()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call specularColor()");
 
     if (m_bAutomaticDeclaration)
     {
@@ -450,7 +770,12 @@ void MeshBuilder::specularColor(const Color& col)
         m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.specularColour = col;
+    // Only the declared attributes are staged
+    if (!isDeclared(Ogre::VES_SPECULAR))
+        return;
+
+    const float values[4] = { col.r, col.g, col.b, col.a };
+    setCurrentValues(m_currentSubMesh.streams.specularColours, 4, values, 4);
 }
 
 //-----------------------------------------------------------------------
@@ -464,128 +789,299 @@ void MeshBuilder::specularColor(Real r, Real g, Real b, Real a)
 
 void MeshBuilder::textureCoord(Real u)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoord()");
-
-    if (m_bAutomaticDeclaration)
-    {
-        declareTextureCoordinates(0, 1);
-        m_bAutomaticDeclaration = true;
-
-        m_currentVertex.texCoordDims[m_usTextureCoordsIndex] = 1;
-    }
+    const float values[1] = { u };
+    addTextureCoord(values, 1);
+}
 
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].x = u;
+//-----------------------------------------------------------------------
 
-    ++m_usTextureCoordsIndex;
+void MeshBuilder::textureCoord(Real u, Real v)
+{
+    const float values[2] = { u, v };
+    addTextureCoord(values, 2);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::textureCoord(Real u, Real v)
+void MeshBuilder::textureCoord(Real u, Real v, Real w)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoord()");
+    const float values[3] = { u, v, w };
+    addTextureCoord(values, 3);
+}
 
-    if (m_bAutomaticDeclaration)
-    {
-        declareTextureCoordinates(0, 2);
-        m_bAutomaticDeclaration = true;
+//-----------------------------------------------------------------------
 
-        m_currentVertex.texCoordDims[m_usTextureCoordsIndex] = 2;
-    }
+void MeshBuilder::textureCoord(const Vector2& uv)
+{
+    const float values[2] = { uv.x, uv.y };
+    addTextureCoord(values, 2);
+}
 
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].x = u;
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].y = v;
+//-----------------------------------------------------------------------
 
-    ++m_usTextureCoordsIndex;
+void MeshBuilder::textureCoord(const Vector3& uvw)
+{
+    const float values[3] = { uvw.x, uvw.y, uvw.z };
+    addTextureCoord(values, 3);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::textureCoord(Real u, Real v, Real w)
+void MeshBuilder::addTextureCoord(const float* pValues, unsigned short dims)
 {
     assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoord()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call textureCoord()");
+    assert((m_usTextureCoordsIndex < OGRE_MAX_TEXTURE_COORD_SETS) && "Too much texture coordinates set");
 
     if (m_bAutomaticDeclaration)
     {
-        declareTextureCoordinates(0, 3);
+        declareTextureCoordinates(0, dims);
         m_bAutomaticDeclaration = true;
-
-        m_currentVertex.texCoordDims[m_usTextureCoordsIndex] = 3;
     }
 
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].x = u;
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].y = v;
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].z = w;
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    // Only the declared sets are staged
+    if (streams.texCoordDims[m_usTextureCoordsIndex] > 0)
+    {
+        setCurrentValues(streams.texCoords[m_usTextureCoordsIndex], streams.texCoordDims[m_usTextureCoordsIndex],
+                         pValues, dims);
+    }
 
     ++m_usTextureCoordsIndex;
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::textureCoord(const Vector2& uv)
+void MeshBuilder::binormal(const Vector3& binormal)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoord()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call binormal()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call binormal()");
 
     if (m_bAutomaticDeclaration)
     {
-        declareTextureCoordinates(0, 2);
+        declareBinormal();
         m_bAutomaticDeclaration = true;
+    }
+
+    // Only the declared attributes are staged
+    if (!isDeclared(Ogre::VES_BINORMAL))
+        return;
+
+    const float values[3] = { binormal.x, binormal.y, binormal.z };
+    setCurrentValues(m_currentSubMesh.streams.binormals, 3, values, 3);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::binormal(Real x, Real y, Real z)
+{
+    binormal(Vector3(x, y, z));
+}
+
+//-----------------------------------------------------------------------
 
-        m_currentVertex.texCoordDims[m_usTextureCoordsIndex] = 2;
+void MeshBuilder::tangent(const Vector3& tangent)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call tangent()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call position() before you call tangent()");
+
+    if (m_bAutomaticDeclaration)
+    {
+        declareTangent();
+        m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].x = uv.x;
-    m_currentVertex.texCoord[m_usTextureCoordsIndex].y = uv.y;
+    // Only the declared attributes are staged
+    if (!isDeclared(Ogre::VES_TANGENT))
+        return;
 
-    ++m_usTextureCoordsIndex;
+    const float values[3] = { tangent.x, tangent.y, tangent.z };
+    setCurrentValues(m_currentSubMesh.streams.tangents, 3, values, 3);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::textureCoord(const Vector3& uvw)
+void MeshBuilder::tangent(Real x, Real y, Real z)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoord()");
+    tangent(Vector3(x, y, z));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::positions(const Real* pPositions, unsigned int nbVertices, size_t stride)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call positions()");
+    assert(pPositions);
+
+    if (m_bAutomaticDeclaration)
+    {
+        if (m_bFirstVertex)
+        {
+            declarePosition();
+            m_bAutomaticDeclaration = true;
+            m_bFirstVertex = false;
+        }
+        else
+        {
+            m_bAutomaticDeclaration = false;
+        }
+    }
+
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    streams.batchStart = streams.nbVertices;
+    streams.nbVertices += nbVertices;
+
+    copyToStream(streams.positions, 3, pPositions, stride);
+
+    // Reset current texture coord
+    m_usTextureCoordsIndex = 0;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::blendingData(const unsigned short* pIndices, const Real* pWeights,
+                               unsigned short nbWeights, size_t indicesStride,
+                               size_t weightsStride)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call blendingData()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call blendingData()");
+    assert(pIndices && pWeights);
+    assert((nbWeights > 0) && (nbWeights <= OGRE_MAX_BLEND_WEIGHTS));
+
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    setBlendingDim(nbWeights);
+
+    copyToStream(streams.blendingWeights, streams.blendingDim, pWeights, weightsStride, nbWeights);
+
+    if (indicesStride == 0)
+        indicesStride = nbWeights * sizeof(unsigned short);
+
+    streams.blendingIndices.resize(streams.nbVertices * streams.blendingDim, 0);
+
+    const unsigned char* pSource = reinterpret_cast<const unsigned char*>(pIndices);
+    unsigned short* pDest = &streams.blendingIndices[streams.batchStart * streams.blendingDim];
+    for (unsigned int i = streams.batchStart; i < streams.nbVertices; ++i)
+    {
+        memcpy(pDest, pSource, nbWeights * sizeof(unsigned short));
+        pDest += streams.blendingDim;
+        pSource += indicesStride;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::normals(const Real* pNormals, size_t stride)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call normals()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call normals()");
+    assert(pNormals);
 
     if (m_bAutomaticDeclaration)
     {
-        declareTextureCoordinates(0, 3);
+        declareNormal();
         m_bAutomaticDeclaration = true;
+    }
+
+    // Only the declared attributes are staged
+    if (isDeclared(Ogre::VES_NORMAL))
+        copyToStream(m_currentSubMesh.streams.normals, 3, pNormals, stride);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::diffuseColors(const Real* pColors, size_t stride)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call diffuseColors()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call diffuseColors()");
+    assert(pColors);
 
-        m_currentVertex.texCoordDims[m_usTextureCoordsIndex] = 3;
+    if (m_bAutomaticDeclaration)
+    {
+        declareDiffuseColor();
+        m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.texCoord[m_usTextureCoordsIndex] = uvw;
+    // Only the declared attributes are staged
+    if (isDeclared(Ogre::VES_DIFFUSE))
+        copyToStream(m_currentSubMesh.streams.diffuseColours, 4, pColors, stride);
+}
 
-    ++m_usTextureCoordsIndex;
+//-----------------------------------------------------------------------
+
+void MeshBuilder::specularColors(const Real* pColors, size_t stride)
+{
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call specularColors()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call specularColors()");
+    assert(pColors);
+
+    if (m_bAutomaticDeclaration)
+    {
+        declareSpecularColor();
+        m_bAutomaticDeclaration = true;
+    }
+
+    // Only the declared attributes are staged
+    if (isDeclared(Ogre::VES_SPECULAR))
+        copyToStream(m_currentSubMesh.streams.specularColours, 4, pColors, stride);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::binormal(const Vector3& binormal)
+void MeshBuilder::textureCoords(const Real* pTexCoords, unsigned short dims, size_t stride)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call binormal()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call textureCoords()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call textureCoords()");
+    assert(pTexCoords);
+    assert((dims >= 1) && (dims <= 3));
+    assert((m_usTextureCoordsIndex < OGRE_MAX_TEXTURE_COORD_SETS) && "Too much texture coordinates set");
+
+    tVertexStreams& streams = m_currentSubMesh.streams;
 
     if (m_bAutomaticDeclaration)
     {
-        declareBinormal();
+        declareTextureCoordinates(0, dims);
         m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.binormal = binormal;
+    // Only the declared sets are staged, with the dimensions of their declaration
+    if (streams.texCoordDims[m_usTextureCoordsIndex] > 0)
+    {
+        copyToStream(streams.texCoords[m_usTextureCoordsIndex], streams.texCoordDims[m_usTextureCoordsIndex],
+                     pTexCoords, stride, dims);
+    }
+
+    ++m_usTextureCoordsIndex;
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::binormal(Real x, Real y, Real z)
+void MeshBuilder::binormals(const Real* pBinormals, size_t stride)
 {
-    binormal(Vector3(x, y, z));
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call binormals()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call binormals()");
+    assert(pBinormals);
+
+    if (m_bAutomaticDeclaration)
+    {
+        declareBinormal();
+        m_bAutomaticDeclaration = true;
+    }
+
+    // Only the declared attributes are staged
+    if (isDeclared(Ogre::VES_BINORMAL))
+        copyToStream(m_currentSubMesh.streams.binormals, 3, pBinormals, stride);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::tangent(const Vector3& tangent)
+void MeshBuilder::tangents(const Real* pTangents, size_t stride)
 {
-    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call tangent()");
+    assert(m_bIsSharedVertices || !m_currentSubMesh.strName.empty() && "You must call begin() before you call tangents()");
+    assert((m_currentSubMesh.streams.nbVertices > 0) && "You must call positions() before you call tangents()");
+    assert(pTangents);
 
     if (m_bAutomaticDeclaration)
     {
@@ -593,19 +1089,32 @@ void MeshBuilder::tangent(const Vector3& tangent)
         m_bAutomaticDeclaration = true;
     }
 
-    m_currentVertex.tangent = tangent;
+    // Only the declared attributes are staged
+    if (isDeclared(Ogre::VES_TANGENT))
+        copyToStream(m_currentSubMesh.streams.tangents, 3, pTangents, stride);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::tangent(Real x, Real y, Real z)
+void MeshBuilder::instanceData(unsigned short usSource, const void* pData, unsigned int nbInstances,
+                               unsigned int firstInstance)
 {
-    tangent(Vector3(x, y, z));
+    tInstanceBuffer* pBuffer = getInstanceBuffer(usSource);
+    assert(pBuffer && "You must call declareInstanceBuffer() before you call instanceData()");
+    assert(pBuffer->instanceSize > 0 && "You must call declareInstanceElement() before you call instanceData()");
+    assert((firstInstance + nbInstances <= pBuffer->nbInstances) && "Too much instances");
+    assert(pData);
+
+    // The buffer is only staged once some data is given (it is zero by default)
+    if (pBuffer->data.empty())
+        pBuffer->data.assign(pBuffer->instanceSize * pBuffer->nbInstances, 0);
+
+    memcpy(&pBuffer->data[firstInstance * pBuffer->instanceSize], pData, nbInstances * pBuffer->instanceSize);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::index(unsigned short index)
+void MeshBuilder::index(unsigned int index)
 {
     assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call index()");
 
@@ -614,7 +1123,7 @@ void MeshBuilder::index(unsigned short index)
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::line(unsigned short i1, unsigned short i2)
+void MeshBuilder::line(unsigned int i1, unsigned int i2)
 {
     assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call line()");
 
@@ -624,7 +1133,7 @@ void MeshBuilder::line(unsigned short i1, unsigned short i2)
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::triangle(unsigned short i1, unsigned short i2, unsigned short i3)
+void MeshBuilder::triangle(unsigned int i1, unsigned int i2, unsigned int i3)
 {
     assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call triangle()");
 
@@ -635,7 +1144,7 @@ void MeshBuilder::triangle(unsigned short i1, unsigned short i2, unsigned short
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::quad(unsigned short i1, unsigned short i2, unsigned short i3, unsigned short i4)
+void MeshBuilder::quad(unsigned int i1, unsigned int i2, unsigned int i3, unsigned int i4)
 {
     assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call triangle()");
 
@@ -645,282 +1154,2416 @@ void MeshBuilder::quad(unsigned short i1, unsigned short i2, unsigned short i3,
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::end()
+void MeshBuilder::indices(const unsigned short* pIndices, unsigned int nbIndices)
 {
-    assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call end()");
-    assert(!m_currentSubMesh.bUseSharedVertices || m_mesh->sharedVertexData);
+    assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call indices()");
+    assert(pIndices || (nbIndices == 0));
 
-    // Declarations
-    std::map<unsigned short, std::vector<tElement> >::iterator  iterSource, iterSourceEnd;
-    std::vector<tVertex>::iterator                              iterVertex, iterVertexEnd;
-    HardwareVertexBufferSharedPtr                               vbuffer;
-    VertexData*                                                 pVertexData;
+    m_currentSubMesh.indices.insert(m_currentSubMesh.indices.end(), pIndices, pIndices + nbIndices);
+}
 
-    // If a temporary vertex is pending, add it to the list
-    if (m_bTempVertexPending)
-        copyTempVertexToBuffer();
+//-----------------------------------------------------------------------
 
-    m_bFirstVertex          = false;
-    m_bAutomaticDeclaration = false;
-    m_bIsSharedVertices     = false;
+void MeshBuilder::indices(const unsigned int* pIndices, unsigned int nbIndices)
+{
+    assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call indices()");
+    assert(pIndices || (nbIndices == 0));
 
-    // Create the submesh
-    SubMesh* pSubMesh = m_mesh->createSubMesh(m_currentSubMesh.strName);
-    pSubMesh->setMaterialName(m_currentSubMesh.strMaterial);
-    pSubMesh->useSharedVertices = m_currentSubMesh.bUseSharedVertices;
-    pSubMesh->operationType = m_currentSubMesh.opType;
+    m_currentSubMesh.indices.insert(m_currentSubMesh.indices.end(), pIndices, pIndices + nbIndices);
+}
 
-    // Initializes the vertex declaration if necessary
-    if (!m_currentSubMesh.bUseSharedVertices)
-    {
-        pSubMesh->vertexData = createVertexData();
-        pVertexData = pSubMesh->vertexData;
-    }
-    else
+//-----------------------------------------------------------------------
+
+static void writeCacheStatistics(std::vector<unsigned char>& data,
+                                 const MeshOptimizer::tCacheStatistics& statistics)
+{
+    writeValue(data, (Ogre::uint32) statistics.nbTriangles);
+    writeValue(data, (Ogre::uint32) statistics.nbVertices);
+    writeValue(data, (Ogre::uint32) statistics.nbTransformedVertices);
+    writeValue(data, statistics.acmr);
+    writeValue(data, statistics.atvr);
+}
+
+//-----------------------------------------------------------------------
+
+static bool readCacheStatistics(const std::vector<unsigned char>& data, size_t& offset,
+                                MeshOptimizer::tCacheStatistics& statistics)
+{
+    Ogre::uint32 values[3];
+
+    for (unsigned int i = 0; i < 3; ++i)
     {
-        pVertexData = m_mesh->sharedVertexData;
+        if (!readValue(data, offset, values[i]))
+            return false;
     }
 
-    // Add the vertices into their buffers
-    VertexBufferBinding::VertexBufferBindingMap bindings = pVertexData->vertexBufferBinding->getBindings();
-    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
-        iterSource != iterSourceEnd; ++iterSource)
-    {
-        unsigned int vertexIndex = 0;
+    statistics.nbTriangles              = values[0];
+    statistics.nbVertices               = values[1];
+    statistics.nbTransformedVertices    = values[2];
 
-        for (iterVertex = m_currentSubMesh.vertices.begin(), iterVertexEnd = m_currentSubMesh.vertices.end();
-            iterVertex != iterVertexEnd; ++iterVertex)
-        {
-            if ((iterVertex->blendingDim > 0) && !m_mesh->getSkeletonName().empty())
-            {
-                VertexBoneAssignment ass;
-                ass.vertexIndex = vertexIndex;
+    return readValue(data, offset, statistics.acmr) && readValue(data, offset, statistics.atvr);
+}
 
-                for (unsigned int i = 0; i < iterVertex->blendingDim; ++i)
-                {
-                    ass.boneIndex   = iterVertex->blendingIndices[i];
-                    ass.weight      = iterVertex->blendingWeights[i];
-                    pSubMesh->addBoneAssignment(ass);
-                }
-            }
+//-----------------------------------------------------------------------
 
-            ++vertexIndex;
-        }
-    }
+static void writeStatistics(std::vector<unsigned char>& data, const MeshBuilder::tStatistics& statistics)
+{
+    writeValue(data, (Ogre::uint32) statistics.nbVertices);
+    writeValue(data, (Ogre::uint32) statistics.nbVerticesBeforeWelding);
+    writeValue(data, (Ogre::uint32) statistics.nbIndices);
+    writeValue(data, (Ogre::uint32) statistics.nb32BitIndexBuffers);
+    writeValue(data, (Ogre::uint32) statistics.nbBufferLocks);
+    writeValue(data, (Ogre::uint64) statistics.nbBytesUploaded);
+    writeValue(data, (Ogre::uint64) statistics.buildTime);
+    writeValue(data, (Ogre::uint64) statistics.nbBytesSaved);
+    writeCacheStatistics(data, statistics.cacheBefore);
+    writeCacheStatistics(data, statistics.cacheAfter);
+    writeValue(data, (Ogre::uint32) statistics.nbBonePaletteSplits);
+    writeBool(data, statistics.bLoadedFromCache);
+}
 
+//-----------------------------------------------------------------------
 
-    // Add the indices into their buffer
-    pSubMesh->indexData->indexCount = m_currentSubMesh.indices.size();
-    pSubMesh->indexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
-                                                    HardwareIndexBuffer::IT_16BIT, m_currentSubMesh.indices.size(),
-                                                    m_currentSubMesh.indexBufferInfo.usage,
-                                                    m_currentSubMesh.indexBufferInfo.bUseShadowBuffer);
-    pSubMesh->indexData->indexBuffer->writeData(0, m_currentSubMesh.indices.size() * sizeof(unsigned short),
-                                                &m_currentSubMesh.indices[0]);
+static bool readStatistics(const std::vector<unsigned char>& data, size_t& offset,
+                           MeshBuilder::tStatistics& statistics)
+{
+    Ogre::uint32 values[5];
 
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        if (!readValue(data, offset, values[i]))
+            return false;
+    }
 
-    // Update the AABB and the radius of the mesh
-    m_mesh->_setBounds(toOgre(m_AABB));
-    m_mesh->_setBoundingSphereRadius(m_radius);
+    statistics.nbVertices               = values[0];
+    statistics.nbVerticesBeforeWelding  = values[1];
+    statistics.nbIndices                = values[2];
+    statistics.nb32BitIndexBuffers      = values[3];
+    statistics.nbBufferLocks            = values[4];
 
+    Ogre::uint64 buildTime;
+    Ogre::uint32 nbBonePaletteSplits;
 
-    // Reset the internal state
-    m_currentSubMesh.strName            = "";
-    m_currentSubMesh.strMaterial        = "";
-    m_currentSubMesh.bUseSharedVertices = false;
+    if (!readSize(data, offset, statistics.nbBytesUploaded) || !readValue(data, offset, buildTime) ||
+        !readSize(data, offset, statistics.nbBytesSaved) ||
+        !readCacheStatistics(data, offset, statistics.cacheBefore) ||
+        !readCacheStatistics(data, offset, statistics.cacheAfter) ||
+        !readValue(data, offset, nbBonePaletteSplits) || !readBool(data, offset, statistics.bLoadedFromCache))
+    {
+        return false;
+    }
 
-    m_currentSubMesh.indexBufferInfo.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
-    m_currentSubMesh.indexBufferInfo.bUseShadowBuffer   = false;
+    statistics.buildTime            = (unsigned long) buildTime;
+    statistics.nbBonePaletteSplits  = nbBonePaletteSplits;
 
-    m_currentSubMesh.verticesElements.clear();
-    m_currentSubMesh.vertexBufferInfos.clear();
-    m_currentSubMesh.vertices.clear();
-    m_currentSubMesh.indices.clear();
+    return true;
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::endSharedVertices()
+void MeshBuilder::end()
 {
-    assert(m_bIsSharedVertices && "You must call beginSharedVertices() before you call endSharedVertices()");
-
-    // If a temporary vertex is pending, add it to the list
-    if (m_bTempVertexPending)
-        copyTempVertexToBuffer();
+    assert(!m_bIsSharedVertices && !m_currentSubMesh.strName.empty() && "You must call begin() before you call end()");
+    assert(!m_currentSubMesh.bUseSharedVertices || m_bHasSharedVertices);
 
     m_bFirstVertex          = false;
     m_bAutomaticDeclaration = false;
     m_bIsSharedVertices     = false;
 
-    // Create the vertex data
-    m_mesh->sharedVertexData = createVertexData();
+    // When the cache is used, the construction of the submesh is postponed until the
+    // hash of the whole mesh is known. The instance buffers can't be stored in the
+    // cache: the postponed submeshes are then built right away, without it.
+    if (isCacheUsed() && m_currentSubMesh.instanceBuffers.empty())
+    {
+        hashCurrentSubMesh();
+        postponeCurrentSubMesh();
+    }
+    else if (!m_pendingSubMeshes.empty())
+    {
+        postponeCurrentSubMesh();
+        processPendingSubMeshes();
+    }
+    else
+    {
+        processSubMesh();
+    }
 
-    // Update the AABB and the radius of the mesh
-    m_mesh->_setBounds(toOgre(m_AABB));
-    m_mesh->_setBoundingSphereRadius(m_radius);
+    resetCurrentSubMesh();
+}
 
-    // Reset the internal state
-    m_currentSubMesh.strName            = "";
-    m_currentSubMesh.strMaterial        = "";
-    m_currentSubMesh.strMaterial        = "";
-    m_currentSubMesh.bUseSharedVertices = false;
+//-----------------------------------------------------------------------
 
-    m_currentSubMesh.indexBufferInfo.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
-    m_currentSubMesh.indexBufferInfo.bUseShadowBuffer   = false;
+void MeshBuilder::endSharedVertices()
+{
+    assert(m_bIsSharedVertices && "You must call beginSharedVertices() before you call endSharedVertices()");
 
-    m_currentSubMesh.verticesElements.clear();
-    m_currentSubMesh.vertexBufferInfos.clear();
-    m_currentSubMesh.vertices.clear();
-    m_currentSubMesh.indices.clear();
+    m_bFirstVertex          = false;
+    m_bAutomaticDeclaration = false;
+    m_bIsSharedVertices     = false;
+    m_bHasSharedVertices    = true;
+
+    if (isCacheUsed() && m_currentSubMesh.instanceBuffers.empty())
+    {
+        hashCurrentSubMesh();
+        postponeCurrentSubMesh();
+    }
+    else if (!m_pendingSubMeshes.empty())
+    {
+        postponeCurrentSubMesh();
+        processPendingSubMeshes();
+    }
+    else
+    {
+        processSharedVertices();
+    }
+
+    resetCurrentSubMesh();
 }
 
 //-----------------------------------------------------------------------
 
-Ogre::VertexData* MeshBuilder::createVertexData()
+void MeshBuilder::commit()
 {
-    // Declarations
-    std::map<unsigned short, std::vector<tElement> >::iterator  iterSource, iterSourceEnd;
-    std::vector<tVertex>::iterator                              iterVertex, iterVertexEnd;
-    HardwareVertexBufferSharedPtr                               vbuffer;
-    float                                                       fBuffer[4];
+    assert(m_bDeferredCommit && "The mesh is already committed by end()");
+    assert(!m_bIsSharedVertices && m_currentSubMesh.strName.empty() && "You must call end() before you call commit()");
+    assert(m_mesh.isNull() && "You cannot call commit() more than one time");
 
+    // Creation of the mesh
+    m_mesh = MeshManager::getSingletonPtr()->createManual(m_strMeshName, m_strResourceGroup);
 
-    // Create the vertex data
-    VertexData* pVertexData = new VertexData();
-    pVertexData->vertexStart = 0;
-    pVertexData->vertexCount = m_currentSubMesh.vertices.size();
+    if (!m_strSkeletonName.empty())
+        m_mesh->setSkeletonName(m_strSkeletonName);
 
+    // Load the mesh from the cache, or build the postponed submeshes
+    bool bSaveToCache = false;
 
-    // Initializes the vertex declaration
-    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
-         iterSource != iterSourceEnd; ++iterSource)
+    if (!m_pendingSubMeshes.empty())
     {
-        size_t offset = 0;
+        if (buildPendingSubMeshes())
+            return;
 
-        std::vector<tElement>::iterator iter, iterEnd;
-        for (iter = iterSource->second.begin(), iterEnd = iterSource->second.end();
-             iter != iterEnd; ++iter)
-        {
-            pVertexData->vertexDeclaration->addElement(iterSource->first, offset, iter->type, iter->semantic, iter->usIndex);
-            offset += VertexElement::getTypeSize(iter->type);
-        }
+        bSaveToCache = true;
+    }
 
-        vbuffer = HardwareBufferManager::getSingleton().createVertexBuffer(offset, m_currentSubMesh.vertices.size(),
-                                            m_currentSubMesh.vertexBufferInfos[iterSource->first].usage,
-                                            m_currentSubMesh.vertexBufferInfos[iterSource->first].bUseShadowBuffer);
+    Ogre::Timer timer;
 
-        pVertexData->vertexBufferBinding->setBinding(iterSource->first, vbuffer);
+    if (m_bHasSharedVertices)
+    {
+        m_mesh->sharedVertexData = createVertexData(m_sharedVertices);
+        m_mesh->sharedBlendIndexToBoneIndexMap = m_sharedVertices.bonePalette;
     }
 
+    std::list<tAssembledSubMesh>::const_iterator iter, iterEnd;
+    for (iter = m_assembledSubMeshes.begin(), iterEnd = m_assembledSubMeshes.end(); iter != iterEnd; ++iter)
+        commitSubMesh(*iter);
 
-    // Add the vertices into their buffers
-    VertexBufferBinding::VertexBufferBindingMap bindings = pVertexData->vertexBufferBinding->getBindings();
-    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
-        iterSource != iterSourceEnd; ++iterSource)
-    {
-        vbuffer = bindings[iterSource->first];
+    updateMeshBounds();
 
-        size_t          offset = 0;
-        unsigned int    vertexIndex = 0;
+    // The data is now in the hardware buffers
+    m_assembledSubMeshes.clear();
+    m_sharedVertices.buffers.clear();
+    m_sharedVertices.instanceBuffers.clear();
 
-        for (iterVertex = m_currentSubMesh.vertices.begin(), iterVertexEnd = m_currentSubMesh.vertices.end();
-            iterVertex != iterVertexEnd; ++iterVertex)
-        {
-            std::vector<tElement>::iterator iter, iterEnd;
-            for (iter = iterSource->second.begin(), iterEnd = iterSource->second.end();
-                iter != iterEnd; ++iter)
-            {
-                switch (iter->semantic)
-                {
-                case Ogre::VES_POSITION:
-                    fBuffer[0] = iterVertex->position.x;
-                    fBuffer[1] = iterVertex->position.y;
-                    fBuffer[2] = iterVertex->position.z;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+    m_statistics.buildTime += timer.getMicroseconds();
 
-                case Ogre::VES_NORMAL:
-                    fBuffer[0] = iterVertex->normal.x;
-                    fBuffer[1] = iterVertex->normal.y;
-                    fBuffer[2] = iterVertex->normal.z;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+    if (bSaveToCache)
+        saveToCache();
+}
 
-                case Ogre::VES_BINORMAL:
-                    fBuffer[0] = iterVertex->binormal.x;
-                    fBuffer[1] = iterVertex->binormal.y;
-                    fBuffer[2] = iterVertex->binormal.z;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+//-----------------------------------------------------------------------
 
-                case Ogre::VES_TANGENT:
-                    fBuffer[0] = iterVertex->tangent.x;
-                    fBuffer[1] = iterVertex->tangent.y;
-                    fBuffer[2] = iterVertex->tangent.z;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+void MeshBuilder::processSubMesh()
+{
+    Ogre::Timer timer;
 
-                case Ogre::VES_DIFFUSE:
-                    fBuffer[0] = iterVertex->diffuseColour.a;
-                    fBuffer[1] = iterVertex->diffuseColour.r;
-                    fBuffer[2] = iterVertex->diffuseColour.g;
-                    fBuffer[3] = iterVertex->diffuseColour.b;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+    // Keep only the strongest bone influences (before the welding, so more vertices
+    // become identical)
+    if (!m_strSkeletonName.empty())
+        limitBoneInfluences();
 
-                case Ogre::VES_SPECULAR:
-                    fBuffer[0] = iterVertex->specularColour.a;
-                    fBuffer[1] = iterVertex->specularColour.r;
-                    fBuffer[2] = iterVertex->specularColour.g;
-                    fBuffer[3] = iterVertex->specularColour.b;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+    // Weld the identical vertices if necessary
+    if (!m_currentSubMesh.bUseSharedVertices)
+    {
+        m_statistics.nbVerticesBeforeWelding += getNbVertices();
 
-                case Ogre::VES_TEXTURE_COORDINATES:
-                    fBuffer[0] = iterVertex->texCoord[iter->usIndex].x;
-                    fBuffer[1] = iterVertex->texCoord[iter->usIndex].y;
-                    fBuffer[2] = iterVertex->texCoord[iter->usIndex].z;
-                    vbuffer->writeData(offset, VertexElement::getTypeSize(iter->type), fBuffer);
-                    break;
+        if (m_bWelding)
+        {
+            weldVertices(m_scratch.remap);
+            remapIndices(m_scratch.remap);
+        }
+    }
+    else if (!m_sharedVerticesRemap.empty())
+    {
+        remapIndices(m_sharedVerticesRemap);
+    }
 
-                case Ogre::VES_BLEND_WEIGHTS:
-                case Ogre::VES_BLEND_INDICES:
-                    // Nothing to do, but the compiler complains if not present
-                    break;
-                }
+    // Generate the normals and tangents if necessary
+    if ((m_bGenerateNormals || m_bGenerateTangents) && !m_currentSubMesh.bUseSharedVertices &&
+        (m_currentSubMesh.opType == Ogre::RenderOperation::OT_TRIANGLE_LIST))
+    {
+        generateTangentSpace();
+    }
 
-                offset += VertexElement::getTypeSize(iter->type);
-            }
+    // Split the submesh if its vertices use more bones than one draw can hold
+    bool bSplit = false;
 
-            ++vertexIndex;
-        }
+    if (usesSkinningStreams() && !m_currentSubMesh.bUseSharedVertices &&
+        ((m_currentSubMesh.opType == Ogre::RenderOperation::OT_TRIANGLE_LIST) ||
+         (m_currentSubMesh.opType == Ogre::RenderOperation::OT_LINE_LIST) ||
+         (m_currentSubMesh.opType == Ogre::RenderOperation::OT_POINT_LIST)))
+    {
+        std::vector<unsigned short>& bones = m_scratch.shorts;
+        collectBones(bones);
+        bSplit = (bones.size() > m_usMaxBonesPerDraw);
     }
 
-    return pVertexData;
+    if (bSplit)
+        splitByBonePalette();
+    else
+        endSubMesh();
+
+    m_statistics.buildTime += timer.getMicroseconds();
 }
 
 //-----------------------------------------------------------------------
 
-void MeshBuilder::copyTempVertexToBuffer()
+void MeshBuilder::processSharedVertices()
 {
-    assert(m_bTempVertexPending);
+    Ogre::Timer timer;
 
-    m_currentSubMesh.vertices.push_back(m_currentVertex);
+    if (!m_strSkeletonName.empty())
+        limitBoneInfluences();
 
-    m_currentVertex.position        = Vector3::ZERO;
-    m_currentVertex.blendingDim     = 0;
-    m_currentVertex.normal          = Vector3::ZERO;
-    m_currentVertex.diffuseColour   = Color::Black;
-    m_currentVertex.specularColour  = Color::Black;
-    m_currentVertex.binormal        = Vector3::ZERO;
-    m_currentVertex.tangent         = Vector3::ZERO;
+    // Weld the identical vertices if necessary (the indices of the submeshes will be
+    // remapped later)
+    m_statistics.nbVerticesBeforeWelding += m_currentSubMesh.streams.nbVertices;
 
-    memset(m_currentVertex.blendingWeights, 0, sizeof(m_currentVertex.blendingWeights));
-    memset(m_currentVertex.blendingIndices, 0, sizeof(m_currentVertex.blendingIndices));
-    memset(m_currentVertex.texCoord, 0, sizeof(m_currentVertex.texCoord));
-    memset(m_currentVertex.texCoordDims, 0, sizeof(m_currentVertex.texCoordDims));
+    if (m_bWelding)
+        weldVertices(m_sharedVerticesRemap);
 
-    m_bTempVertexPending = false;
+    // Create the vertex data
+    assembleVertexData(m_sharedVertices);
+
+    if (!m_bDeferredCommit)
+    {
+        m_mesh->sharedVertexData = createVertexData(m_sharedVertices);
+        m_mesh->sharedBlendIndexToBoneIndexMap = m_sharedVertices.bonePalette;
+
+        updateMeshBounds();
+    }
+
+    m_statistics.buildTime += timer.getMicroseconds();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::resetCurrentSubMesh()
+{
+    m_currentSubMesh.strName            = "";
+    m_currentSubMesh.strMaterial        = "";
+    m_currentSubMesh.bUseSharedVertices = false;
+
+    m_currentSubMesh.indexBufferInfo.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
+    m_currentSubMesh.indexBufferInfo.bUseShadowBuffer   = false;
+
+    clearStaging();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::postponeCurrentSubMesh()
+{
+    // The entries are recycled: the current submesh is exchanged with a free one, and
+    // receives its containers (cleared by resetCurrentSubMesh(), but keeping their
+    // capacity)
+    if (m_freeSubMeshes.empty())
+        m_freeSubMeshes.push_back(tSubMesh());
+
+    m_pendingSubMeshes.splice(m_pendingSubMeshes.end(), m_freeSubMeshes, m_freeSubMeshes.begin());
+    m_pendingSubMeshes.back().swap(m_currentSubMesh);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::releasePendingSubMeshes()
+{
+    m_freeSubMeshes.splice(m_freeSubMeshes.end(), m_pendingSubMeshes);
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::isCacheUsed() const
+{
+    // The cache can only restore one policy for all the vertex buffers, and one for all
+    // the index buffers. If the current submesh breaks that, the postponed ones are built
+    // without it.
+    if (!hasUniformBufferPolicies())
+        return false;
+
+    // Once a submesh is postponed, all the following ones must be too
+    if (!m_pendingSubMeshes.empty())
+        return true;
+
+    // The cache can't be used if some submeshes were already built (they all have
+    // bounds)
+    return !m_strCacheDirectory.empty() && m_bounds.empty() && !m_bClustering && !m_bHardwareSkinning;
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::hasUniformBufferPolicies() const
+{
+    tHardwareBufferInfo policy;
+    if (!getVertexBufferPolicy(m_currentSubMesh, policy))
+        return false;
+
+    if (m_pendingSubMeshes.empty())
+        return true;
+
+    // Compare with the policies of the postponed submeshes (they are all identical)
+    tHardwareBufferInfo reference;
+    getVertexBufferPolicy(m_pendingSubMeshes.front(), reference);
+
+    if ((policy.usage != reference.usage) || (policy.bUseShadowBuffer != reference.bUseShadowBuffer))
+        return false;
+
+    // The shared vertices have no index buffer
+    if (m_currentSubMesh.strName.empty())
+        return true;
+
+    std::list<tSubMesh>::const_iterator iter, iterEnd;
+    for (iter = m_pendingSubMeshes.begin(), iterEnd = m_pendingSubMeshes.end(); iter != iterEnd; ++iter)
+    {
+        if (!iter->strName.empty())
+        {
+            return (iter->indexBufferInfo.usage == m_currentSubMesh.indexBufferInfo.usage) &&
+                   (iter->indexBufferInfo.bUseShadowBuffer == m_currentSubMesh.indexBufferInfo.bUseShadowBuffer);
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::getVertexBufferPolicy(const tSubMesh& subMesh, tHardwareBufferInfo& policy) const
+{
+    // The sources without a declared policy use the default one (see groupElements())
+    policy.usage            = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
+    policy.bUseShadowBuffer = false;
+
+    bool bFirst = true;
+
+    for (unsigned short usSource = 0; usSource < subMesh.verticesElements.size(); ++usSource)
+    {
+        if (subMesh.verticesElements[usSource].empty())
+            continue;
+
+        tHardwareBufferInfo info;
+        if (usSource < subMesh.vertexBufferInfos.size())
+        {
+            info = subMesh.vertexBufferInfos[usSource];
+        }
+        else
+        {
+            info.usage              = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
+            info.bUseShadowBuffer   = false;
+        }
+
+        if (bFirst)
+        {
+            policy = info;
+            bFirst = false;
+        }
+        else if ((info.usage != policy.usage) || (info.bUseShadowBuffer != policy.bUseShadowBuffer))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::hashCurrentSubMesh()
+{
+    const tSubMesh& subMesh = m_currentSubMesh;
+
+    m_hasher.add(subMesh.strName);
+    m_hasher.add(subMesh.strMaterial);
+    m_hasher.add(subMesh.bUseSharedVertices);
+    m_hasher.add(subMesh.opType);
+
+    // Declarations (the structures are hashed member by member, to skip their padding).
+    // The staging keeps empty sources from the previous submeshes, they are skipped.
+    for (unsigned short usSource = 0; usSource < subMesh.verticesElements.size(); ++usSource)
+    {
+        const std::vector<tElement>& elements = subMesh.verticesElements[usSource];
+        if (elements.empty())
+            continue;
+
+        m_hasher.add(usSource);
+        m_hasher.add(elements.size());
+
+        std::vector<tElement>::const_iterator iter, iterEnd;
+        for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+        {
+            m_hasher.add(iter->semantic);
+            m_hasher.add(iter->type);
+            m_hasher.add(iter->usIndex);
+            m_hasher.add(iter->usNbComponents);
+            m_hasher.add(iter->format);
+        }
+    }
+
+    m_hasher.add(subMesh.vertexBufferInfos.size());
+
+    std::vector<tHardwareBufferInfo>::const_iterator iterInfo, iterInfoEnd;
+    for (iterInfo = subMesh.vertexBufferInfos.begin(), iterInfoEnd = subMesh.vertexBufferInfos.end();
+         iterInfo != iterInfoEnd; ++iterInfo)
+    {
+        m_hasher.add(iterInfo->usage);
+        m_hasher.add(iterInfo->bUseShadowBuffer);
+    }
+
+    m_hasher.add(subMesh.indexBufferInfo.usage);
+    m_hasher.add(subMesh.indexBufferInfo.bUseShadowBuffer);
+
+    // Vertices
+    const tVertexStreams& streams = subMesh.streams;
+
+    m_hasher.add(streams.nbVertices);
+    m_hasher.add(streams.positions);
+    m_hasher.add(streams.normals);
+    m_hasher.add(streams.diffuseColours);
+    m_hasher.add(streams.specularColours);
+
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+    {
+        m_hasher.add(streams.texCoordDims[i]);
+        m_hasher.add(streams.texCoords[i]);
+    }
+
+    m_hasher.add(streams.binormals);
+    m_hasher.add(streams.tangents);
+    m_hasher.add(streams.blendingDim);
+    m_hasher.add(streams.blendingWeights);
+    m_hasher.add(streams.blendingIndices);
+
+    // Indices
+    m_hasher.add(subMesh.indices);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::hashSettings()
+{
+    m_hasher.add(MeshCache::VERSION);
+    m_hasher.add(sizeof(Real));
+    m_hasher.add(m_strSkeletonName);
+    m_hasher.add(m_vertexLayout);
+    m_hasher.add(m_bWelding);
+    m_hasher.add(m_weldingEpsilon);
+    m_hasher.add(m_optimizations);
+    m_hasher.add(m_bGenerateNormals);
+    m_hasher.add(m_normalsWeighting);
+    m_hasher.add(m_bGenerateTangents);
+    m_hasher.add(m_bGenerateBinormals);
+    m_hasher.add(m_usTangentsTexCoordSet);
+    m_hasher.add(m_usMaxBoneInfluences);
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::buildPendingSubMeshes()
+{
+    hashSettings();
+
+    if (loadFromCache())
+    {
+        releasePendingSubMeshes();
+        return true;
+    }
+
+    // The mesh will be exported from its hardware buffers: they need a copy in system
+    // memory to be read back
+    m_bCacheShadowBuffers = true;
+
+    processPendingSubMeshes();
+
+    return false;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::processPendingSubMeshes()
+{
+    // Build the submeshes in the order they were ended
+    while (!m_pendingSubMeshes.empty())
+    {
+        m_currentSubMesh.swap(m_pendingSubMeshes.front());
+        m_freeSubMeshes.splice(m_freeSubMeshes.end(), m_pendingSubMeshes, m_pendingSubMeshes.begin());
+
+        if (m_currentSubMesh.strName.empty())
+            processSharedVertices();
+        else
+            processSubMesh();
+
+        resetCurrentSubMesh();
+    }
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::loadFromCache()
+{
+    assert(!m_pendingSubMeshes.empty());
+
+    const MeshCache::tHash hash = m_hasher.getHash();
+
+    if (!MeshCache::contains(m_strCacheDirectory, hash))
+        return false;
+
+    Ogre::Timer timer;
+
+    // All the buffers of the mesh were declared with the same policies (see isCacheUsed())
+    tHardwareBufferInfo policy;
+    getVertexBufferPolicy(m_pendingSubMeshes.front(), policy);
+
+    m_mesh->setVertexBufferPolicy(policy.usage, policy.bUseShadowBuffer);
+
+    std::list<tSubMesh>::const_iterator iter, iterEnd;
+    for (iter = m_pendingSubMeshes.begin(), iterEnd = m_pendingSubMeshes.end(); iter != iterEnd; ++iter)
+    {
+        if (!iter->strName.empty())
+        {
+            m_mesh->setIndexBufferPolicy(iter->indexBufferInfo.usage, iter->indexBufferInfo.bUseShadowBuffer);
+            break;
+        }
+    }
+
+    std::vector<unsigned char> data;
+
+    if (MeshCache::load(m_strCacheDirectory, hash, m_mesh.getPointer(), data) && readCacheData(data))
+    {
+        m_statistics.bLoadedFromCache = true;
+        m_statistics.buildTime = timer.getMicroseconds();
+        return true;
+    }
+
+    // The mesh may be partially loaded: start again with an empty one
+    MeshManager::getSingletonPtr()->remove(m_strMeshName);
+    m_mesh = MeshManager::getSingletonPtr()->createManual(m_strMeshName, m_strResourceGroup);
+
+    if (!m_strSkeletonName.empty())
+        m_mesh->setSkeletonName(m_strSkeletonName);
+
+    m_AABB.setNull();
+    m_radius = 0.0f;
+
+    memset(&m_statistics, 0, sizeof(m_statistics));
+
+    m_dequantizations.clear();
+    m_bounds.clear();
+
+    return false;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::saveToCache()
+{
+    std::vector<unsigned char> data;
+    writeCacheData(data);
+
+    // Failing to save the mesh isn't an error, it will just be built again next time
+    MeshCache::save(m_strCacheDirectory, m_hasher.getHash(), m_mesh.getPointer(), data);
+
+    m_bCacheShadowBuffers = false;
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::useShadowBuffer(const tHardwareBufferInfo& info) const
+{
+    return info.bUseShadowBuffer || (m_bCacheShadowBuffers && (info.usage & HardwareBuffer::HBU_WRITE_ONLY));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::writeCacheData(std::vector<unsigned char>& data) const
+{
+    // The informations that aren't stored in the Ogre mesh (field by field, so the
+    // format doesn't depend on the padding of the structures)
+    writeStatistics(data, m_statistics);
+    writeBox(data, m_AABB);
+    writeValue(data, m_radius);
+
+    writeValue(data, (Ogre::uint32) m_dequantizations.size());
+
+    std::map<std::string, tDequantization>::const_iterator iterDequantization, iterDequantizationEnd;
+    for (iterDequantization = m_dequantizations.begin(), iterDequantizationEnd = m_dequantizations.end();
+         iterDequantization != iterDequantizationEnd; ++iterDequantization)
+    {
+        writeString(data, iterDequantization->first);
+        writeValue(data, iterDequantization->second.position);
+
+        for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+            writeValue(data, iterDequantization->second.texCoords[i]);
+    }
+
+    writeValue(data, (Ogre::uint32) m_bounds.size());
+
+    std::map<std::string, MeshBounds::tBounds>::const_iterator iterBounds, iterBoundsEnd;
+    for (iterBounds = m_bounds.begin(), iterBoundsEnd = m_bounds.end(); iterBounds != iterBoundsEnd; ++iterBounds)
+    {
+        writeString(data, iterBounds->first);
+        writeBox(data, iterBounds->second.aabb);
+        writeVector(data, iterBounds->second.sphere.getCenter());
+        writeValue(data, iterBounds->second.sphere.getRadius());
+    }
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::readCacheData(const std::vector<unsigned char>& data)
+{
+    size_t offset = 0;
+
+    if (!readStatistics(data, offset, m_statistics) || !readBox(data, offset, m_AABB) ||
+        !readValue(data, offset, m_radius))
+    {
+        return false;
+    }
+
+    Ogre::uint32 nbDequantizations;
+    if (!readValue(data, offset, nbDequantizations))
+        return false;
+
+    for (Ogre::uint32 i = 0; i < nbDequantizations; ++i)
+    {
+        std::string strName;
+        tDequantization dequantization;
+
+        if (!readString(data, offset, strName) || !readValue(data, offset, dequantization.position))
+            return false;
+
+        for (unsigned int j = 0; j < OGRE_MAX_TEXTURE_COORD_SETS; ++j)
+        {
+            if (!readValue(data, offset, dequantization.texCoords[j]))
+                return false;
+        }
+
+        m_dequantizations[strName] = dequantization;
+    }
+
+    Ogre::uint32 nbBounds;
+    if (!readValue(data, offset, nbBounds))
+        return false;
+
+    for (Ogre::uint32 i = 0; i < nbBounds; ++i)
+    {
+        std::string strName;
+        MeshBounds::tBounds bounds;
+        Vector3 center;
+        Real radius;
+
+        if (!readString(data, offset, strName) || !readBox(data, offset, bounds.aabb) ||
+            !readVector(data, offset, center) || !readValue(data, offset, radius))
+        {
+            return false;
+        }
+
+        bounds.sphere = Sphere(center, radius);
+        m_bounds[strName] = bounds;
+    }
+
+    return (offset == data.size());
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::endSubMesh()
+{
+    // Optimize the order of the triangles (and vertices) if necessary
+    if ((m_optimizations != OPTIMIZE_NONE) && (m_currentSubMesh.opType == Ogre::RenderOperation::OT_TRIANGLE_LIST) &&
+        !m_currentSubMesh.indices.empty())
+    {
+        optimizeIndices(m_currentSubMesh.bUseSharedVertices ? m_sharedVertices.nbVertices : getNbVertices());
+    }
+
+    // Partition the triangles into clusters if necessary (each submesh has an entry,
+    // even if empty)
+    buildClusters();
+
+    // Assemble the submesh (in the only entry of the list if it is committed right
+    // away, to reuse its memory)
+    if (m_bDeferredCommit || m_assembledSubMeshes.empty())
+        m_assembledSubMeshes.push_back(tAssembledSubMesh());
+
+    tAssembledSubMesh& subMesh = m_assembledSubMeshes.back();
+    assembleSubMesh(subMesh);
+
+    if (!m_bDeferredCommit)
+    {
+        commitSubMesh(subMesh);
+
+        updateMeshBounds();
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::splitByBonePalette()
+{
+    // Declarations
+    const tVertexStreams&   streams         = m_currentSubMesh.streams;
+    const unsigned short    dim             = streams.blendingDim;
+    const unsigned int      nbVertices      = streams.nbVertices;
+    const unsigned int      primitiveSize   = (m_currentSubMesh.opType == Ogre::RenderOperation::OT_TRIANGLE_LIST ? 3 :
+                                               (m_currentSubMesh.opType == Ogre::RenderOperation::OT_LINE_LIST ? 2 : 1));
+
+    // The lists without indices use the vertices in order
+    std::vector<unsigned int>& indices = m_scratch.indices;
+    indices.swap(m_currentSubMesh.indices);
+
+    if (indices.empty())
+    {
+        indices.resize(nbVertices);
+        for (unsigned int i = 0; i < nbVertices; ++i)
+            indices[i] = i;
+    }
+
+    const unsigned int nbPrimitives = indices.size() / primitiveSize;
+
+
+    // Assign each primitive to the first group whose palette can receive its bones (the
+    // palettes are recycled from one submesh to the next)
+    std::vector<std::vector<unsigned short> >&  palettes = m_scratch.palettes;
+    std::vector<unsigned int>&                  groups = m_scratch.groups;
+    unsigned int                                nbPalettes = 0;
+    unsigned short                              primitiveBones[3 * OGRE_MAX_BLEND_WEIGHTS];
+
+    groups.resize(nbPrimitives);
+
+    for (unsigned int p = 0; p < nbPrimitives; ++p)
+    {
+        unsigned int nbPrimitiveBones = 0;
+
+        for (unsigned int i = 0; i < primitiveSize; ++i)
+        {
+            const unsigned int vertex = indices[p * primitiveSize + i];
+
+            for (unsigned short j = 0; j < dim; ++j)
+            {
+                if (streams.blendingWeights[vertex * dim + j] <= 0.0f)
+                    continue;
+
+                const unsigned short bone = streams.blendingIndices[vertex * dim + j];
+
+                if (std::find(primitiveBones, primitiveBones + nbPrimitiveBones, bone) == primitiveBones + nbPrimitiveBones)
+                    primitiveBones[nbPrimitiveBones++] = bone;
+            }
+        }
+
+        assert((nbPrimitiveBones <= m_usMaxBonesPerDraw) && "A primitive uses more bones than one draw can hold");
+
+        unsigned int group = 0;
+        for (; group < nbPalettes; ++group)
+        {
+            std::vector<unsigned short>& palette = palettes[group];
+
+            unsigned int nbNewBones = 0;
+            for (unsigned int i = 0; i < nbPrimitiveBones; ++i)
+            {
+                if (std::find(palette.begin(), palette.end(), primitiveBones[i]) == palette.end())
+                    ++nbNewBones;
+            }
+
+            if (palette.size() + nbNewBones <= m_usMaxBonesPerDraw)
+                break;
+        }
+
+        if (group == nbPalettes)
+        {
+            if (nbPalettes == palettes.size())
+                palettes.push_back(std::vector<unsigned short>());
+
+            palettes[nbPalettes++].clear();
+        }
+
+        std::vector<unsigned short>& palette = palettes[group];
+        for (unsigned int i = 0; i < nbPrimitiveBones; ++i)
+        {
+            if (std::find(palette.begin(), palette.end(), primitiveBones[i]) == palette.end())
+                palette.push_back(primitiveBones[i]);
+        }
+
+        groups[p] = group;
+    }
+
+
+    // End one submesh per group, with only the vertices it uses (the streams of the
+    // full submesh are kept aside)
+    const std::string strName = m_currentSubMesh.strName;
+    m_scratch.streams = m_currentSubMesh.streams;
+
+    std::vector<unsigned int>&  vertices = m_scratch.vertices;
+    std::vector<unsigned int>&  remap = m_scratch.table;
+
+    for (unsigned int group = 0; group < nbPalettes; ++group)
+    {
+        remap.assign(nbVertices, 0xFFFFFFFF);
+        vertices.clear();
+        m_currentSubMesh.indices.clear();
+
+        for (unsigned int p = 0; p < nbPrimitives; ++p)
+        {
+            if (groups[p] != group)
+                continue;
+
+            for (unsigned int i = 0; i < primitiveSize; ++i)
+            {
+                const unsigned int vertex = indices[p * primitiveSize + i];
+
+                if (remap[vertex] == 0xFFFFFFFF)
+                {
+                    remap[vertex] = vertices.size();
+                    vertices.push_back(vertex);
+                }
+
+                m_currentSubMesh.indices.push_back(remap[vertex]);
+            }
+        }
+
+        if (group > 0)
+        {
+            m_currentSubMesh.strName = strName + "." + Ogre::StringConverter::toString(group);
+            m_currentSubMesh.streams = m_scratch.streams;
+            ++m_statistics.nbBonePaletteSplits;
+        }
+
+        reorderVertices(vertices);
+        endSubMesh();
+    }
+
+    indices.clear();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::assembleSubMesh(tAssembledSubMesh& subMesh)
+{
+    subMesh.strName             = m_currentSubMesh.strName;
+    subMesh.strMaterial         = m_currentSubMesh.strMaterial;
+    subMesh.bUseSharedVertices  = m_currentSubMesh.bUseSharedVertices;
+    subMesh.opType              = m_currentSubMesh.opType;
+    subMesh.indexBufferInfo     = m_currentSubMesh.indexBufferInfo;
+
+    // Assemble the vertices if necessary
+    if (!m_currentSubMesh.bUseSharedVertices)
+    {
+        assembleVertexData(subMesh.vertexData);
+    }
+    else
+    {
+        subMesh.vertexData.nbVertices = 0;
+        subMesh.vertexData.buffers.clear();
+        m_dequantizations[m_currentSubMesh.strName] = m_dequantizations[""];
+        m_bounds[m_currentSubMesh.strName] = m_bounds[""];
+    }
+
+    // Retrieve the bone assignments of the vertices
+    subMesh.boneAssignments.clear();
+
+    if (!m_strSkeletonName.empty() && !m_bHardwareSkinning)
+    {
+        const tVertexStreams& streams = m_currentSubMesh.streams;
+        const unsigned int nbBlendedVertices = (streams.blendingDim > 0 ?
+                                                streams.blendingWeights.size() / streams.blendingDim : 0);
+
+        for (unsigned int vertexIndex = 0; vertexIndex < nbBlendedVertices; ++vertexIndex)
+        {
+            VertexBoneAssignment ass;
+            ass.vertexIndex = vertexIndex;
+
+            for (unsigned int i = 0; i < streams.blendingDim; ++i)
+            {
+                ass.boneIndex   = streams.blendingIndices[vertexIndex * streams.blendingDim + i];
+                ass.weight      = streams.blendingWeights[vertexIndex * streams.blendingDim + i];
+
+                // The vertices with less influences than the others are padded with
+                // null weights
+                if (ass.weight > 0.0f)
+                    subMesh.boneAssignments.push_back(ass);
+            }
+        }
+    }
+
+
+    // Use 32-bit indexes only if needed
+    const unsigned int nbVertices = (m_currentSubMesh.bUseSharedVertices ? m_sharedVertices.nbVertices :
+                                                                           subMesh.vertexData.nbVertices);
+
+    unsigned int maxIndex = 0;
+    if (!m_currentSubMesh.indices.empty())
+        maxIndex = *std::max_element(m_currentSubMesh.indices.begin(), m_currentSubMesh.indices.end());
+
+    assert((m_currentSubMesh.indices.empty() || (maxIndex < nbVertices)) &&
+           "The submesh references a vertex that doesn't exist");
+
+    subMesh.indexType = (maxIndex > 0xFFFF ? HardwareIndexBuffer::IT_32BIT : HardwareIndexBuffer::IT_16BIT);
+
+    if (subMesh.indexType == HardwareIndexBuffer::IT_32BIT)
+        ++m_statistics.nb32BitIndexBuffers;
+
+    m_statistics.nbIndices += m_currentSubMesh.indices.size();
+
+    // The indices of a deferred submesh are kept until the commit, the other ones are
+    // uploaded from the staging data
+    if (m_bDeferredCommit)
+        subMesh.indices.swap(m_currentSubMesh.indices);
+    else
+        subMesh.indices.clear();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::assembleVertexData(tAssembledVertexData& vertexData)
+{
+    const unsigned int nbVertices = m_currentSubMesh.streams.nbVertices;
+
+    vertexData.nbVertices = nbVertices;
+
+    computeDequantization();
+    m_dequantizations[m_currentSubMesh.strName] = m_dequantization;
+
+    // Compute the bounds of the vertices, and update the ones of the mesh
+    const std::vector<float>& positions = m_currentSubMesh.streams.positions;
+    const MeshBounds::tBounds bounds = MeshBounds::compute(positions.empty() ? 0 : &positions[0],
+                                                           positions.size() / 3);
+
+    m_bounds[m_currentSubMesh.strName] = bounds;
+
+    if (!bounds.aabb.isNull())
+    {
+        m_AABB.merge(bounds.aabb);
+        m_radius = std::max(m_radius, MeshBounds::getRadiusFromOrigin(bounds));
+    }
+
+    // The blending indices of the skinning streams are the ones of the bone palette
+    const bool bSkinningStreams = usesSkinningStreams();
+
+    if (bSkinningStreams)
+        buildBonePalette(vertexData.bonePalette);
+    else
+        vertexData.bonePalette.clear();
+
+
+    // Distribute the elements among the buffers
+    std::vector<std::vector<tElement> >&    sources = m_scratch.sources;
+    std::vector<tHardwareBufferInfo>&       infos   = m_scratch.infos;
+
+    groupElements(bSkinningStreams, sources, infos);
+
+    const unsigned short nbSources = sources.size();
+
+    unsigned int nbBuffers = 0;
+    for (unsigned short usSource = 0; usSource < nbSources; ++usSource)
+    {
+        if (!sources[usSource].empty())
+            ++nbBuffers;
+    }
+
+    vertexData.buffers.resize(nbBuffers);
+
+    std::vector<tAssembledVertexBuffer>::iterator iterBuffer = vertexData.buffers.begin();
+
+    for (unsigned short usSource = 0; usSource < nbSources; ++usSource)
+    {
+        const std::vector<tElement>& elements = sources[usSource];
+        if (elements.empty())
+            continue;
+
+        tAssembledVertexBuffer& buffer = *iterBuffer;
+        ++iterBuffer;
+
+        buffer.usSource     = usSource;
+        buffer.elements     = elements;
+        buffer.info         = infos[usSource];
+        buffer.vertexSize   = 0;
+
+        std::vector<tElement>::const_iterator iter, iterEnd;
+        for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+        {
+            const size_t elementSize = VertexElement::getTypeSize(iter->type);
+
+            buffer.vertexSize += elementSize;
+
+            // Compare with the size of the same element made of floats
+            if (iter->format != VertexCompression::FORMAT_FLOAT)
+                m_statistics.nbBytesSaved += (iter->usNbComponents * sizeof(float) - elementSize) * nbVertices;
+        }
+
+        // The vertices of a deferred mesh are interleaved now, the other ones directly
+        // into the hardware buffer
+        if (m_bDeferredCommit && (nbVertices > 0))
+        {
+            buffer.data.assign(buffer.vertexSize * nbVertices, 0);
+            writeStreams(elements, buffer.vertexSize, &buffer.data[0]);
+        }
+        else
+        {
+            buffer.data.clear();
+        }
+    }
+
+    // The instance buffers are already in their final layout
+    vertexData.instanceBuffers = m_currentSubMesh.instanceBuffers;
+
+    std::vector<tInstanceBuffer>::const_iterator iterInstances, iterInstancesEnd;
+    for (iterInstances = vertexData.instanceBuffers.begin(), iterInstancesEnd = vertexData.instanceBuffers.end();
+         iterInstances != iterInstancesEnd; ++iterInstances)
+    {
+        assert(((iterInstances->usSource >= nbSources) || sources[iterInstances->usSource].empty()) &&
+               "The source of an instance buffer is used by the vertices");
+        assert(!iterInstances->elements.empty() && "An instance buffer has no element");
+    }
+
+    m_statistics.nbVertices += nbVertices;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::groupElements(bool bSkinningStreams, std::vector<std::vector<tElement> >& sources,
+                                std::vector<tHardwareBufferInfo>& infos) const
+{
+    // Declarations
+    const std::vector<std::vector<tElement> >&  declared        = m_currentSubMesh.verticesElements;
+    const std::vector<tHardwareBufferInfo>&     declaredInfos   = m_currentSubMesh.vertexBufferInfos;
+    tHardwareBufferInfo                         defaultInfo;
+
+    defaultInfo.usage               = HardwareBuffer::HBU_STATIC_WRITE_ONLY;
+    defaultInfo.bUseShadowBuffer    = false;
+
+    // The elements of the skinning streams
+    std::vector<tElement> skinningElements;
+
+    if (bSkinningStreams)
+    {
+        tElement element;
+        element.semantic        = Ogre::VES_BLEND_INDICES;
+        element.type            = Ogre::VET_UBYTE4;
+        element.usIndex         = 0;
+        element.usNbComponents  = 4;
+        element.format          = VertexCompression::FORMAT_UBYTE;
+
+        skinningElements.push_back(element);
+
+        element.semantic        = Ogre::VES_BLEND_WEIGHTS;
+        element.usNbComponents  = m_currentSubMesh.streams.blendingDim;
+        element.format          = VertexCompression::FORMAT_FLOAT;
+        element.type            = VertexCompression::getElementType(element.format, element.usNbComponents);
+
+        skinningElements.push_back(element);
+    }
+
+    if (m_vertexLayout == LAYOUT_DECLARED)
+    {
+        // One buffer per source used by the declaration, and one for the skinning
+        // streams
+        sources.assign(declared.begin(), declared.end());
+        infos.resize(sources.size());
+
+        for (unsigned short usSource = 0; usSource < sources.size(); ++usSource)
+            infos[usSource] = (usSource < declaredInfos.size() ? declaredInfos[usSource] : defaultInfo);
+
+        if (bSkinningStreams)
+        {
+            sources.push_back(skinningElements);
+            infos.push_back(defaultInfo);
+        }
+    }
+    else
+    {
+        // The positions and the skinning streams in the first buffer, everything else
+        // in the second one
+        sources.resize(2);
+        sources[0].clear();
+        sources[1].clear();
+        infos.assign(2, defaultInfo);
+
+        for (unsigned short usSource = 0; usSource < declared.size(); ++usSource)
+        {
+            std::vector<tElement>::const_iterator iter, iterEnd;
+            for (iter = declared[usSource].begin(), iterEnd = declared[usSource].end(); iter != iterEnd; ++iter)
+            {
+                const unsigned short usTarget = (iter->semantic == Ogre::VES_POSITION ? 0 : 1);
+
+                if (sources[usTarget].empty() && (usSource < declaredInfos.size()))
+                    infos[usTarget] = declaredInfos[usSource];
+
+                sources[usTarget].push_back(*iter);
+            }
+        }
+
+        sources[0].insert(sources[0].end(), skinningElements.begin(), skinningElements.end());
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::commitSubMesh(const tAssembledSubMesh& subMesh)
+{
+    // Create the submesh
+    SubMesh* pSubMesh = m_mesh->createSubMesh(subMesh.strName);
+    pSubMesh->setMaterialName(subMesh.strMaterial);
+    pSubMesh->useSharedVertices = subMesh.bUseSharedVertices;
+    pSubMesh->operationType = subMesh.opType;
+
+    if (!subMesh.bUseSharedVertices)
+    {
+        pSubMesh->vertexData = createVertexData(subMesh.vertexData);
+        pSubMesh->blendIndexToBoneIndexMap = subMesh.vertexData.bonePalette;
+    }
+
+    // Add the bone assignments of the vertices
+    std::vector<VertexBoneAssignment>::const_iterator iter, iterEnd;
+    for (iter = subMesh.boneAssignments.begin(), iterEnd = subMesh.boneAssignments.end(); iter != iterEnd; ++iter)
+        pSubMesh->addBoneAssignment(*iter);
+
+    // Add the indices into their buffer
+    const std::vector<unsigned int>& indices = (m_bDeferredCommit ? subMesh.indices : m_currentSubMesh.indices);
+
+    pSubMesh->indexData->indexCount = indices.size();
+    pSubMesh->indexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+                                                    subMesh.indexType, indices.size(),
+                                                    subMesh.indexBufferInfo.usage,
+                                                    useShadowBuffer(subMesh.indexBufferInfo));
+    if (!indices.empty())
+        uploadIndices(pSubMesh->indexData->indexBuffer, indices);
+}
+
+//-----------------------------------------------------------------------
+
+Ogre::VertexData* MeshBuilder::createVertexData(const tAssembledVertexData& vertexData)
+{
+    VertexData* pVertexData = new VertexData();
+    pVertexData->vertexStart = 0;
+    pVertexData->vertexCount = vertexData.nbVertices;
+
+    std::vector<tAssembledVertexBuffer>::const_iterator iterBuffer, iterBufferEnd;
+    for (iterBuffer = vertexData.buffers.begin(), iterBufferEnd = vertexData.buffers.end();
+         iterBuffer != iterBufferEnd; ++iterBuffer)
+    {
+        // Initializes the vertex declaration
+        size_t offset = 0;
+
+        std::vector<tElement>::const_iterator iter, iterEnd;
+        for (iter = iterBuffer->elements.begin(), iterEnd = iterBuffer->elements.end(); iter != iterEnd; ++iter)
+        {
+            pVertexData->vertexDeclaration->addElement(iterBuffer->usSource, offset, iter->type,
+                                                       iter->semantic, iter->usIndex);
+            offset += VertexElement::getTypeSize(iter->type);
+        }
+
+        HardwareVertexBufferSharedPtr vbuffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                                                    iterBuffer->vertexSize, vertexData.nbVertices,
+                                                    iterBuffer->info.usage, useShadowBuffer(iterBuffer->info));
+
+        pVertexData->vertexBufferBinding->setBinding(iterBuffer->usSource, vbuffer);
+
+        // Add the vertices into the buffer
+        if (vertexData.nbVertices > 0)
+            uploadVertices(vbuffer, iterBuffer->elements, (iterBuffer->data.empty() ? 0 : &iterBuffer->data[0]));
+    }
+
+    createInstanceBuffers(vertexData.instanceBuffers, pVertexData);
+
+    return pVertexData;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::createInstanceBuffers(const std::vector<tInstanceBuffer>& instanceBuffers,
+                                        Ogre::VertexData* pVertexData)
+{
+    std::vector<tInstanceBuffer>::const_iterator iterBuffer, iterBufferEnd;
+    for (iterBuffer = instanceBuffers.begin(), iterBufferEnd = instanceBuffers.end();
+         iterBuffer != iterBufferEnd; ++iterBuffer)
+    {
+        size_t offset = 0;
+
+        std::vector<tElement>::const_iterator iter, iterEnd;
+        for (iter = iterBuffer->elements.begin(), iterEnd = iterBuffer->elements.end(); iter != iterEnd; ++iter)
+        {
+            pVertexData->vertexDeclaration->addElement(iterBuffer->usSource, offset, iter->type,
+                                                       iter->semantic, iter->usIndex);
+            offset += VertexElement::getTypeSize(iter->type);
+        }
+
+        HardwareVertexBufferSharedPtr vbuffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                                                    iterBuffer->instanceSize, iterBuffer->nbInstances,
+                                                    iterBuffer->info.usage, iterBuffer->info.bUseShadowBuffer);
+
+        vbuffer->setIsInstanceData(true);
+        vbuffer->setInstanceDataStepRate(iterBuffer->stepRate);
+
+        pVertexData->vertexBufferBinding->setBinding(iterBuffer->usSource, vbuffer);
+
+        // Upload the initial data in one go (a buffer without data is left to zero)
+        const size_t size = vbuffer->getSizeInBytes();
+
+        void* pDest = vbuffer->lock(HardwareBuffer::HBL_DISCARD);
+
+        if (iterBuffer->data.empty())
+            memset(pDest, 0, size);
+        else
+            memcpy(pDest, &iterBuffer->data[0], size);
+
+        vbuffer->unlock();
+
+        ++m_statistics.nbBufferLocks;
+        m_statistics.nbBytesUploaded += size;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+MeshBuilder::tInstanceBuffer* MeshBuilder::getInstanceBuffer(unsigned short usSource)
+{
+    std::vector<tInstanceBuffer>::iterator iter, iterEnd;
+    for (iter = m_currentSubMesh.instanceBuffers.begin(), iterEnd = m_currentSubMesh.instanceBuffers.end();
+         iter != iterEnd; ++iter)
+    {
+        if (iter->usSource == usSource)
+            return &(*iter);
+    }
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::uploadVertices(const HardwareVertexBufferSharedPtr& buffer,
+                                 const std::vector<tElement>& elements, const unsigned char* pData)
+{
+    const size_t vertexSize = buffer->getVertexSize();
+    const size_t size       = buffer->getSizeInBytes();
+
+    unsigned char* pDest = 0;
+
+    // Retrieve the memory into which the vertices must be written: either the hardware
+    // buffer itself, or the staging buffer (not needed if the vertices are already
+    // interleaved)
+    if (m_uploadMode == UPLOAD_LOCK)
+    {
+        pDest = static_cast<unsigned char*>(buffer->lock(HardwareBuffer::HBL_DISCARD));
+
+        if (pData)
+            memcpy(pDest, pData, size);
+        else
+            memset(pDest, 0, size);
+    }
+    else if (!pData)
+    {
+        m_stagingBuffer.assign(size, 0);
+        pDest = &m_stagingBuffer[0];
+    }
+
+    // Interleave the vertices into the layout of the vertex buffer
+    if (!pData)
+    {
+        writeStreams(elements, vertexSize, pDest);
+        pData = pDest;
+    }
+
+    // Upload them
+    switch (m_uploadMode)
+    {
+    case UPLOAD_LOCK:
+        buffer->unlock();
+        ++m_statistics.nbBufferLocks;
+        break;
+
+    case UPLOAD_STAGING:
+        buffer->writeData(0, size, pData, true);
+        ++m_statistics.nbBufferLocks;
+        break;
+
+    case UPLOAD_PER_ELEMENT:
+        {
+            const size_t nbVertices = size / vertexSize;
+            size_t offset = 0;
+
+            for (size_t i = 0; i < nbVertices; ++i)
+            {
+                std::vector<tElement>::const_iterator iter, iterEnd;
+                for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+                {
+                    const size_t elementSize = VertexElement::getTypeSize(iter->type);
+
+                    buffer->writeData(offset, elementSize, pData + offset);
+                    ++m_statistics.nbBufferLocks;
+
+                    offset += elementSize;
+                }
+            }
+        }
+        break;
+    }
+
+    m_statistics.nbBytesUploaded += size;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::uploadIndices(const HardwareIndexBufferSharedPtr& buffer,
+                                const std::vector<unsigned int>& indices)
+{
+    const size_t nbIndices  = indices.size();
+    const bool   b32Bits    = (buffer->getType() == HardwareIndexBuffer::IT_32BIT);
+    const size_t size       = buffer->getSizeInBytes();
+
+    void* pDest = 0;
+    const void* pSource = 0;
+
+    if (m_uploadMode == UPLOAD_LOCK)
+    {
+        pDest = buffer->lock(HardwareBuffer::HBL_DISCARD);
+    }
+    else if (!b32Bits)
+    {
+        m_stagingBuffer.resize(size);
+        pDest = &m_stagingBuffer[0];
+    }
+
+    // The indices are stored on 32 bits, so they only need to be converted for a
+    // 16-bit buffer
+    if (b32Bits)
+    {
+        if (pDest)
+            memcpy(pDest, &indices[0], size);
+
+        pSource = &indices[0];
+    }
+    else
+    {
+        unsigned short* pIndex = static_cast<unsigned short*>(pDest);
+        for (size_t i = 0; i < nbIndices; ++i)
+            pIndex[i] = (unsigned short) indices[i];
+
+        pSource = pDest;
+    }
+
+    if (m_uploadMode == UPLOAD_LOCK)
+        buffer->unlock();
+    else
+        buffer->writeData(0, size, pSource, true);
+
+    ++m_statistics.nbBufferLocks;
+    m_statistics.nbBytesUploaded += size;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::updateMeshBounds()
+{
+    // Update the AABB and the radius of the mesh (its bounding sphere is centered on
+    // the origin)
+    if (m_AABB.isNull())
+        m_mesh->_setBounds(Ogre::AxisAlignedBox::BOX_NULL);
+    else
+        m_mesh->_setBounds(toOgre(m_AABB));
+
+    m_mesh->_setBoundingSphereRadius(m_radius);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::copyToStream(std::vector<float>& stream, unsigned short nbComponents,
+                               const Real* pSource, size_t stride, unsigned short nbSourceComponents)
+{
+    const tVertexStreams& streams = m_currentSubMesh.streams;
+
+    if (nbSourceComponents == 0)
+        nbSourceComponents = nbComponents;
+
+    if (stride == 0)
+        stride = nbSourceComponents * sizeof(Real);
+
+    // Attributes missing from the previous batches are left to zero
+    stream.resize(streams.nbVertices * nbComponents, 0.0f);
+
+    if (streams.nbVertices == streams.batchStart)
+        return;
+
+    const unsigned char*    pData   = reinterpret_cast<const unsigned char*>(pSource);
+    float*                  pDest   = &stream[streams.batchStart * nbComponents];
+    const unsigned short    nbCopy  = std::min(nbComponents, nbSourceComponents);
+
+    for (unsigned int i = streams.batchStart; i < streams.nbVertices; ++i)
+    {
+        const Real* pValues = reinterpret_cast<const Real*>(pData);
+
+        for (unsigned short j = 0; j < nbCopy; ++j)
+            pDest[j] = (float) pValues[j];
+
+        for (unsigned short j = nbCopy; j < nbComponents; ++j)
+            pDest[j] = 0.0f;
+
+        pDest += nbComponents;
+        pData += stride;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::setCurrentValues(std::vector<float>& stream, unsigned short nbComponents,
+                                   const float* pValues, unsigned short nbValues)
+{
+    const unsigned int index = m_currentSubMesh.streams.nbVertices - 1;
+
+    // Attributes missing from the previous vertices are left to zero
+    stream.resize(m_currentSubMesh.streams.nbVertices * nbComponents, 0.0f);
+
+    memcpy(&stream[index * nbComponents], pValues, std::min(nbComponents, nbValues) * sizeof(float));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::setCurrentBlendingIndices(const unsigned short* pIndices, unsigned short nbIndices)
+{
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    const unsigned int index = streams.nbVertices - 1;
+
+    streams.blendingIndices.resize(streams.nbVertices * streams.blendingDim, 0);
+
+    memcpy(&streams.blendingIndices[index * streams.blendingDim], pIndices,
+           std::min(streams.blendingDim, nbIndices) * sizeof(unsigned short));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::setBlendingDim(unsigned short dim)
+{
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    if (dim <= streams.blendingDim)
+        return;
+
+    // The blending data of the previous vertices must be padded to the new dimension
+    if (streams.blendingDim > 0)
+    {
+        const unsigned int nbVertices = streams.blendingWeights.size() / streams.blendingDim;
+
+        // The padded data is assembled in the scratch buffers, which receive the old
+        // content of the streams
+        std::vector<float>&          weights = m_scratch.floats;
+        std::vector<unsigned short>& indices = m_scratch.shorts;
+
+        weights.assign(nbVertices * dim, 0.0f);
+        indices.assign(nbVertices * dim, 0);
+
+        for (unsigned int i = 0; i < nbVertices; ++i)
+        {
+            for (unsigned int j = 0; j < streams.blendingDim; ++j)
+            {
+                weights[i * dim + j] = streams.blendingWeights[i * streams.blendingDim + j];
+
+                if ((i + 1) * streams.blendingDim <= streams.blendingIndices.size())
+                    indices[i * dim + j] = streams.blendingIndices[i * streams.blendingDim + j];
+            }
+        }
+
+        streams.blendingWeights.swap(weights);
+        streams.blendingIndices.swap(indices);
+    }
+
+    streams.blendingDim = dim;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::writeStreams(const std::vector<tElement>& elements, size_t vertexSize,
+                               unsigned char* pDest)
+{
+    const tVertexStreams& streams = m_currentSubMesh.streams;
+
+    size_t offset = 0;
+
+    std::vector<tElement>::const_iterator iter, iterEnd;
+    for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+    {
+        unsigned short              nbComponents    = 0;
+        const std::vector<float>*   pStream         = getStream(*iter, nbComponents);
+
+        const size_t elementSize = VertexElement::getTypeSize(iter->type);
+
+        // The blending indices (already converted into indices in the bone palette)
+        // are the only attribute not stored as floats
+        if ((iter->semantic == Ogre::VES_BLEND_INDICES) && (streams.blendingDim > 0))
+        {
+            const unsigned short    dim         = streams.blendingDim;
+            const unsigned int      nbValues    = std::min((unsigned int) (streams.blendingIndices.size() / dim), streams.nbVertices);
+            const unsigned short*   pSource     = (nbValues > 0 ? &streams.blendingIndices[0] : 0);
+            unsigned char*          pElement    = pDest + offset;
+
+            for (unsigned int i = 0; i < nbValues; ++i)
+            {
+                for (unsigned short j = 0; j < dim; ++j)
+                    pElement[j] = (unsigned char) pSource[j];
+
+                pSource += dim;
+                pElement += vertexSize;
+            }
+        }
+
+        // Attributes never given are left to zero
+        else if (pStream && (nbComponents > 0) && !pStream->empty())
+        {
+            const unsigned int  nbValues    = std::min((unsigned int) (pStream->size() / nbComponents), streams.nbVertices);
+            const float*        pSource     = &(*pStream)[0];
+            unsigned char*      pElement    = pDest + offset;
+            const size_t        size        = std::min(nbComponents, (unsigned short) 4) * sizeof(float);
+            float               values[4];
+
+            for (unsigned int i = 0; i < nbValues; ++i)
+            {
+                memset(values, 0, sizeof(values));
+                memcpy(values, pSource, size);
+
+                writeElement(*iter, values, pElement);
+
+                pSource += nbComponents;
+                pElement += vertexSize;
+            }
+        }
+
+        offset += elementSize;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+const std::vector<float>* MeshBuilder::getStream(const tElement& element, unsigned short& nbComponents) const
+{
+    const tVertexStreams& streams = m_currentSubMesh.streams;
+
+    switch (element.semantic)
+    {
+    case Ogre::VES_POSITION:
+        nbComponents = 3;
+        return &streams.positions;
+
+    case Ogre::VES_NORMAL:
+        nbComponents = 3;
+        return &streams.normals;
+
+    case Ogre::VES_BINORMAL:
+        nbComponents = 3;
+        return &streams.binormals;
+
+    case Ogre::VES_TANGENT:
+        nbComponents = 3;
+        return &streams.tangents;
+
+    case Ogre::VES_DIFFUSE:
+        nbComponents = 4;
+        return &streams.diffuseColours;
+
+    case Ogre::VES_SPECULAR:
+        nbComponents = 4;
+        return &streams.specularColours;
+
+    case Ogre::VES_TEXTURE_COORDINATES:
+        nbComponents = streams.texCoordDims[element.usIndex];
+        return &streams.texCoords[element.usIndex];
+
+    case Ogre::VES_BLEND_WEIGHTS:
+        nbComponents = streams.blendingDim;
+        return &streams.blendingWeights;
+
+    case Ogre::VES_BLEND_INDICES:
+        // Not stored as floats, see writeStreams()
+        break;
+    }
+
+    nbComponents = 0;
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::writeElement(const tElement& element, const float* pValues, unsigned char* pDest)
+{
+    if ((element.type == Ogre::VET_COLOUR_ARGB) || (element.type == Ogre::VET_COLOUR_ABGR))
+    {
+        Ogre::uint32 colour = VertexElement::convertColourValue(
+                Ogre::ColourValue(pValues[0], pValues[1], pValues[2], pValues[3]), element.type);
+        memcpy(pDest, &colour, sizeof(Ogre::uint32));
+        return;
+    }
+
+    // Unit vectors are quantized on the full range of the format
+    Real scale = VertexCompression::computeScale(1.0f);
+
+    if (element.semantic == Ogre::VES_POSITION)
+        scale = m_dequantization.position;
+    else if (element.semantic == Ogre::VES_TEXTURE_COORDINATES)
+        scale = m_dequantization.texCoords[element.usIndex];
+
+    VertexCompression::encode(element.format, pValues, element.usNbComponents, scale, pDest);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::addElement(unsigned short usSource, Ogre::VertexElementSemantic semantic,
+                             unsigned short usIndex, unsigned short usNbComponents,
+                             VertexCompression::tFormat format)
+{
+    tElement element;
+    element.semantic        = semantic;
+    element.usIndex         = usIndex;
+    element.usNbComponents  = usNbComponents;
+    element.format          = format;
+
+    m_currentSubMesh.declaredSemantics |= (1 << semantic);
+
+    if ((semantic == Ogre::VES_DIFFUSE) || (semantic == Ogre::VES_SPECULAR))
+        element.type = Ogre::VET_COLOUR_ARGB;
+    else
+        element.type = VertexCompression::getElementType(format, usNbComponents);
+
+    if (m_currentSubMesh.verticesElements.size() <= usSource)
+        m_currentSubMesh.verticesElements.resize(usSource + 1);
+
+    m_currentSubMesh.verticesElements[usSource].push_back(element);
+
+    m_bAutomaticDeclaration = false;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::computeDequantization()
+{
+    // Declarations
+    std::vector<std::vector<tElement> >::iterator   iterSource, iterSourceEnd;
+    std::vector<tElement>::iterator                 iter, iterEnd;
+    const tVertexStreams&                           streams = m_currentSubMesh.streams;
+
+    m_dequantization.position = 1.0f;
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        m_dequantization.texCoords[i] = 1.0f;
+
+    // Only the attributes stored as shorts need a scale, computed from their largest
+    // absolute value
+    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
+         iterSource != iterSourceEnd; ++iterSource)
+    {
+        for (iter = iterSource->begin(), iterEnd = iterSource->end(); iter != iterEnd; ++iter)
+        {
+            if (iter->format != VertexCompression::FORMAT_SHORT)
+                continue;
+
+            Real maxValue = 0.0f;
+
+            if (iter->semantic == Ogre::VES_POSITION)
+            {
+                for (size_t i = 0; i < streams.positions.size(); ++i)
+                    maxValue = std::max(maxValue, (Real) fabs(streams.positions[i]));
+
+                m_dequantization.position = VertexCompression::computeScale(maxValue);
+            }
+            else if (iter->semantic == Ogre::VES_TEXTURE_COORDINATES)
+            {
+                const std::vector<float>& texCoords = streams.texCoords[iter->usIndex];
+                for (size_t i = 0; i < texCoords.size(); ++i)
+                    maxValue = std::max(maxValue, (Real) fabs(texCoords[i]));
+
+                // Keep texture coordinates in [-1, 1] on the full range
+                m_dequantization.texCoords[iter->usIndex] = VertexCompression::computeScale(std::max(maxValue, (Real) 1.0f));
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::getVertexValues(unsigned int index, const tElement& element, float* pValues) const
+{
+    memset(pValues, 0, element.usNbComponents * sizeof(float));
+
+    unsigned short nbComponents = 0;
+    const std::vector<float>* pStream = getStream(element, nbComponents);
+
+    if (pStream && ((index + 1) * nbComponents <= pStream->size()))
+    {
+        memcpy(pValues, &(*pStream)[index * nbComponents],
+               std::min(nbComponents, element.usNbComponents) * sizeof(float));
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::weldVertices(std::vector<unsigned int>& remap)
+{
+    // Declarations
+    std::vector<std::vector<tElement> >::iterator   iterSource, iterSourceEnd;
+    std::vector<tElement>::iterator                 iter, iterEnd;
+    std::vector<tElement>&                          elements = m_scratch.elements;
+    tVertexStreams&                                 streams = m_currentSubMesh.streams;
+
+    const unsigned int nbVertices = streams.nbVertices;
+
+    remap.resize(nbVertices);
+
+    if (nbVertices == 0)
+        return;
+
+
+    // Compute the size of the key of a vertex: all the declared attributes and the
+    // blending data
+    unsigned int keySize = 0;
+
+    elements.clear();
+
+    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
+         iterSource != iterSourceEnd; ++iterSource)
+    {
+        for (iter = iterSource->begin(), iterEnd = iterSource->end(); iter != iterEnd; ++iter)
+        {
+            elements.push_back(*iter);
+            keySize += iter->usNbComponents;
+        }
+    }
+
+    keySize += streams.blendingDim * 2;
+
+
+    // Find the vertices to keep
+    std::vector<unsigned int>& kept = m_scratch.order;
+    kept.clear();
+    kept.reserve(nbVertices);
+
+    if (m_weldingEpsilon > 0.0f)
+        findSimilarVertices(keySize, kept, remap);
+    else
+        findIdenticalVertices(keySize, kept, remap);
+
+    if (kept.size() == nbVertices)
+        return;
+
+
+    // Only keep the first occurrence of each vertex
+    reorderVertices(kept);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::findIdenticalVertices(unsigned int keySize, std::vector<unsigned int>& kept,
+                                        std::vector<unsigned int>& remap)
+{
+    // Declarations
+    std::vector<tElement>::iterator iter, iterEnd;
+    std::vector<tElement>&          elements = m_scratch.elements;
+    tVertexStreams&                 streams = m_currentSubMesh.streams;
+    float                           values[4];
+
+    const unsigned int nbVertices = streams.nbVertices;
+
+
+    // Compute the keys
+    std::vector<int>& keys = m_scratch.keys;
+    keys.assign(nbVertices * keySize, 0);
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        int* pKey = &keys[i * keySize];
+
+        for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+        {
+            getVertexValues(i, *iter, values);
+
+            for (unsigned short j = 0; j < iter->usNbComponents; ++j)
+                *pKey++ = weldingKey(values[j]);
+        }
+
+        if ((i + 1) * streams.blendingDim <= streams.blendingWeights.size())
+        {
+            for (unsigned int j = 0; j < streams.blendingDim; ++j)
+            {
+                *pKey++ = weldingKey(streams.blendingWeights[i * streams.blendingDim + j]);
+                *pKey++ = streams.blendingIndices[i * streams.blendingDim + j];
+            }
+        }
+    }
+
+
+    // Find the identical vertices, using an open-addressing hash table containing the
+    // new indices of the vertices
+    const unsigned int EMPTY = 0xFFFFFFFF;
+
+    unsigned int tableSize = 1;
+    while (tableSize < nbVertices * 2)
+        tableSize <<= 1;
+
+    std::vector<unsigned int>& table = m_scratch.table;
+    table.assign(tableSize, EMPTY);
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        const int* pKey = &keys[i * keySize];
+        unsigned int slot = hashWeldingKey(pKey, keySize * sizeof(int)) & (tableSize - 1);
+
+        while (table[slot] != EMPTY)
+        {
+            if (memcmp(&keys[kept[table[slot]] * keySize], pKey, keySize * sizeof(int)) == 0)
+                break;
+
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == EMPTY)
+        {
+            table[slot] = kept.size();
+            kept.push_back(i);
+        }
+
+        remap[i] = table[slot];
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::findSimilarVertices(unsigned int keySize, std::vector<unsigned int>& kept,
+                                      std::vector<unsigned int>& remap)
+{
+    // Declarations
+    std::vector<tElement>::iterator iter, iterEnd;
+    std::vector<tElement>&          elements = m_scratch.elements;
+    tVertexStreams&                 streams = m_currentSubMesh.streams;
+
+    const unsigned int nbVertices = streams.nbVertices;
+
+    // The blending indices are compared exactly
+    const unsigned int nbTolerantValues = keySize - streams.blendingDim;
+
+
+    // Retrieve the values of the vertices (the blending indices last), and the cells of
+    // their positions in a grid of size epsilon
+    std::vector<float>& values = m_scratch.values;
+    values.assign(nbVertices * keySize, 0.0f);
+
+    std::vector<long long>& cells = m_scratch.cells;
+    cells.resize(nbVertices * 3);
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        float* pValues = &values[i * keySize];
+
+        for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+        {
+            getVertexValues(i, *iter, pValues);
+            pValues += iter->usNbComponents;
+        }
+
+        if ((i + 1) * streams.blendingDim <= streams.blendingWeights.size())
+        {
+            for (unsigned int j = 0; j < streams.blendingDim; ++j)
+            {
+                pValues[j]                          = streams.blendingWeights[i * streams.blendingDim + j];
+                pValues[streams.blendingDim + j]    = streams.blendingIndices[i * streams.blendingDim + j];
+            }
+        }
+
+        for (unsigned int j = 0; j < 3; ++j)
+            cells[i * 3 + j] = weldingCell(streams.positions[i * 3 + j], m_weldingEpsilon);
+    }
+
+
+    // Two positions closer than epsilon are in the same cell, or in neighbouring ones:
+    // each vertex is compared to the ones already kept in the 27 cells around it, found
+    // with an open-addressing hash table containing the new indices of the vertices
+    const unsigned int EMPTY = 0xFFFFFFFF;
+
+    unsigned int tableSize = 1;
+    while (tableSize < nbVertices * 2)
+        tableSize <<= 1;
+
+    std::vector<unsigned int>& table = m_scratch.table;
+    table.assign(tableSize, EMPTY);
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        const long long* pCell = &cells[i * 3];
+        const float* pValues = &values[i * keySize];
+        unsigned int match = EMPTY;
+
+        for (int n = 0; (n < 27) && (match == EMPTY); ++n)
+        {
+            const long long neighbour[3] = { pCell[0] + n % 3 - 1,
+                                             pCell[1] + (n / 3) % 3 - 1,
+                                             pCell[2] + n / 9 - 1 };
+
+            unsigned int slot = hashWeldingKey(neighbour, sizeof(neighbour)) & (tableSize - 1);
+
+            while (table[slot] != EMPTY)
+            {
+                const unsigned int candidate = kept[table[slot]];
+
+                if ((memcmp(&cells[candidate * 3], neighbour, sizeof(neighbour)) == 0) &&
+                    areWeldable(&values[candidate * keySize], pValues, keySize,
+                                nbTolerantValues, m_weldingEpsilon))
+                {
+                    match = table[slot];
+                    break;
+                }
+
+                slot = (slot + 1) & (tableSize - 1);
+            }
+        }
+
+        if (match == EMPTY)
+        {
+            unsigned int slot = hashWeldingKey(pCell, 3 * sizeof(long long)) & (tableSize - 1);
+            while (table[slot] != EMPTY)
+                slot = (slot + 1) & (tableSize - 1);
+
+            match = kept.size();
+            table[slot] = match;
+            kept.push_back(i);
+        }
+
+        remap[i] = match;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::reorderVertices(const std::vector<unsigned int>& order)
+{
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    compactStream(streams.positions, 3, order, m_scratch.floats);
+    compactStream(streams.normals, 3, order, m_scratch.floats);
+    compactStream(streams.binormals, 3, order, m_scratch.floats);
+    compactStream(streams.tangents, 3, order, m_scratch.floats);
+    compactStream(streams.diffuseColours, 4, order, m_scratch.floats);
+    compactStream(streams.specularColours, 4, order, m_scratch.floats);
+    compactStream(streams.blendingWeights, streams.blendingDim, order, m_scratch.floats);
+    compactStream(streams.blendingIndices, streams.blendingDim, order, m_scratch.shorts);
+
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        compactStream(streams.texCoords[i], streams.texCoordDims[i], order, m_scratch.floats);
+
+    streams.nbVertices = order.size();
+    streams.batchStart = order.size();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::optimizeIndices(unsigned int nbVertices)
+{
+    std::vector<unsigned int>& indices = m_currentSubMesh.indices;
+
+    MeshOptimizer::tCacheStatistics before = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), nbVertices);
+
+    if (m_optimizations & OPTIMIZE_VERTEX_CACHE)
+        MeshOptimizer::optimizeVertexCache(&indices[0], indices.size(), nbVertices);
+
+    // The other optimizations need the vertices, which are only known when they
+    // aren't shared
+    if (!m_currentSubMesh.bUseSharedVertices)
+    {
+        if (m_optimizations & OPTIMIZE_OVERDRAW)
+        {
+            std::vector<float>& positions = m_scratch.floats;
+            positions.assign(nbVertices * 3, 0.0f);
+
+            tElement element;
+            element.semantic        = Ogre::VES_POSITION;
+            element.usIndex         = 0;
+            element.usNbComponents  = 3;
+
+            for (unsigned int i = 0; i < nbVertices; ++i)
+                getVertexValues(i, element, &positions[i * 3]);
+
+            MeshOptimizer::optimizeOverdraw(&indices[0], indices.size(), &positions[0], nbVertices);
+        }
+
+        if (m_optimizations & OPTIMIZE_VERTEX_FETCH)
+        {
+            std::vector<unsigned int>& order = m_scratch.order;
+            MeshOptimizer::optimizeVertexFetch(&indices[0], indices.size(), nbVertices, order);
+            reorderVertices(order);
+        }
+    }
+
+    MeshOptimizer::tCacheStatistics after = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), nbVertices);
+
+
+    // Accumulate the statistics of all the optimized submeshes
+    MeshOptimizer::tCacheStatistics* pStatistics[2] = { &m_statistics.cacheBefore, &m_statistics.cacheAfter };
+    const MeshOptimizer::tCacheStatistics* pSubMeshStatistics[2] = { &before, &after };
+
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        pStatistics[i]->nbTriangles             += pSubMeshStatistics[i]->nbTriangles;
+        pStatistics[i]->nbVertices              += pSubMeshStatistics[i]->nbVertices;
+        pStatistics[i]->nbTransformedVertices   += pSubMeshStatistics[i]->nbTransformedVertices;
+
+        pStatistics[i]->acmr = Real(pStatistics[i]->nbTransformedVertices) / std::max(pStatistics[i]->nbTriangles, 1u);
+        pStatistics[i]->atvr = Real(pStatistics[i]->nbTransformedVertices) / std::max(pStatistics[i]->nbVertices, 1u);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::buildClusters()
+{
+    MeshClusters::tClustersList clusters;
+
+    // The positions of the shared vertices aren't available anymore
+    if (m_bClustering && (m_currentSubMesh.opType == Ogre::RenderOperation::OT_TRIANGLE_LIST) &&
+        !m_currentSubMesh.bUseSharedVertices && !m_currentSubMesh.indices.empty())
+    {
+        std::vector<unsigned int>& indices = m_currentSubMesh.indices;
+        const unsigned int nbVertices = getNbVertices();
+
+        std::vector<float>& positions = m_scratch.floats;
+        positions.assign(nbVertices * 3, 0.0f);
+
+        tElement element;
+        element.semantic        = Ogre::VES_POSITION;
+        element.usIndex         = 0;
+        element.usNbComponents  = 3;
+
+        for (unsigned int i = 0; i < nbVertices; ++i)
+            getVertexValues(i, element, &positions[i * 3]);
+
+        MeshClusters::build(&positions[0], nbVertices, &indices[0], indices.size(),
+                            m_nbMaxClusterTriangles, clusters);
+    }
+
+    m_clusters.addSubMesh(clusters, m_currentSubMesh.indices);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::generateTangentSpace()
+{
+    const unsigned int nbVertices = getNbVertices();
+    if (nbVertices == 0)
+        return;
+
+    // Non-indexed triangle lists use the vertices in order
+    std::vector<unsigned int>& sequence = m_scratch.order;
+    const std::vector<unsigned int>* pIndices = &m_currentSubMesh.indices;
+
+    if (pIndices->empty())
+    {
+        sequence.resize(nbVertices - nbVertices % 3);
+        for (unsigned int i = 0; i < sequence.size(); ++i)
+            sequence[i] = i;
+
+        pIndices = &sequence;
+    }
+
+    if (pIndices->empty())
+        return;
+
+    // All the attributes needed are stored one after the other in the scratch buffer
+    m_scratch.floats.resize(nbVertices * (m_bGenerateTangents ? (m_bGenerateBinormals ? 14 : 11) : 6));
+
+    float* pPositions   = &m_scratch.floats[0];
+    float* pNormals     = pPositions + nbVertices * 3;
+    float* pTexCoords   = pNormals + nbVertices * 3;
+    float* pTangents    = pTexCoords + nbVertices * 2;
+    float* pBinormals   = pTangents + nbVertices * 3;
+
+    // Retrieve the attributes needed
+    tElement element;
+    element.usIndex         = 0;
+    element.usNbComponents  = 3;
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        element.semantic = Ogre::VES_POSITION;
+        getVertexValues(i, element, &pPositions[i * 3]);
+
+        element.semantic = Ogre::VES_NORMAL;
+        getVertexValues(i, element, &pNormals[i * 3]);
+    }
+
+    // Generate the normals
+    if (m_bGenerateNormals)
+    {
+        TangentSpaceGenerator::computeNormals(pPositions, nbVertices, &(*pIndices)[0], pIndices->size(),
+                                              m_normalsWeighting, pNormals);
+
+        setVertexValues(Ogre::VES_NORMAL, pNormals);
+    }
+
+    // Generate the tangents and binormals
+    if (m_bGenerateTangents)
+    {
+        assert((m_bGenerateNormals || hasElement(Ogre::VES_NORMAL)) &&
+               "The normals needed to generate the tangents are missing");
+        assert(hasElement(Ogre::VES_TEXTURE_COORDINATES, m_usTangentsTexCoordSet) &&
+               "The texture coordinates needed to generate the tangents are missing");
+
+        element.semantic        = Ogre::VES_TEXTURE_COORDINATES;
+        element.usIndex         = m_usTangentsTexCoordSet;
+        element.usNbComponents  = 2;
+
+        for (unsigned int i = 0; i < nbVertices; ++i)
+            getVertexValues(i, element, &pTexCoords[i * 2]);
+
+        TangentSpaceGenerator::computeTangents(pPositions, pNormals, pTexCoords, nbVertices,
+                                               &(*pIndices)[0], pIndices->size(), pTangents,
+                                               (m_bGenerateBinormals ? pBinormals : 0));
+
+        setVertexValues(Ogre::VES_TANGENT, pTangents);
+
+        if (m_bGenerateBinormals)
+            setVertexValues(Ogre::VES_BINORMAL, pBinormals);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::setVertexValues(Ogre::VertexElementSemantic semantic, const float* pValues)
+{
+    // Declare the attribute if necessary
+    if (!hasElement(semantic))
+        addElement(0, semantic, 0, 3, VertexCompression::FORMAT_FLOAT);
+
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    const float* pEnd = pValues + streams.nbVertices * 3;
+
+    if (semantic == Ogre::VES_NORMAL)
+        streams.normals.assign(pValues, pEnd);
+    else if (semantic == Ogre::VES_TANGENT)
+        streams.tangents.assign(pValues, pEnd);
+    else if (semantic == Ogre::VES_BINORMAL)
+        streams.binormals.assign(pValues, pEnd);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::limitBoneInfluences()
+{
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    const unsigned short dim = streams.blendingDim;
+    if (dim == 0)
+        return;
+
+    // The vertices without blending data have no influence
+    streams.blendingWeights.resize(streams.nbVertices * dim, 0.0f);
+    streams.blendingIndices.resize(streams.nbVertices * dim, 0);
+
+    unsigned short nbMaxInfluences = 1;
+
+    for (unsigned int v = 0; v < streams.nbVertices; ++v)
+    {
+        float*          pWeights = &streams.blendingWeights[v * dim];
+        unsigned short* pIndices = &streams.blendingIndices[v * dim];
+
+        // Sort the influences by decreasing weight
+        for (unsigned short i = 1; i < dim; ++i)
+        {
+            const float             weight  = pWeights[i];
+            const unsigned short    index   = pIndices[i];
+
+            unsigned short j = i;
+            for (; (j > 0) && (pWeights[j - 1] < weight); --j)
+            {
+                pWeights[j] = pWeights[j - 1];
+                pIndices[j] = pIndices[j - 1];
+            }
+
+            pWeights[j] = weight;
+            pIndices[j] = index;
+        }
+
+        // Only keep the strongest ones, and renormalize their weights
+        unsigned short nbInfluences = 0;
+        float total = 0.0f;
+
+        for (; (nbInfluences < std::min(dim, m_usMaxBoneInfluences)) && (pWeights[nbInfluences] > 0.0f); ++nbInfluences)
+            total += pWeights[nbInfluences];
+
+        for (unsigned short i = nbInfluences; i < dim; ++i)
+        {
+            pWeights[i] = 0.0f;
+            pIndices[i] = 0;
+        }
+
+        if (total > 0.0f)
+        {
+            const float invTotal = 1.0f / total;
+            for (unsigned short i = 0; i < nbInfluences; ++i)
+                pWeights[i] *= invTotal;
+        }
+
+        nbMaxInfluences = std::max(nbMaxInfluences, nbInfluences);
+    }
+
+    // Remove the influences that no vertex uses anymore
+    if (nbMaxInfluences < dim)
+    {
+        for (unsigned int v = 0; v < streams.nbVertices; ++v)
+        {
+            for (unsigned short i = 0; i < nbMaxInfluences; ++i)
+            {
+                streams.blendingWeights[v * nbMaxInfluences + i] = streams.blendingWeights[v * dim + i];
+                streams.blendingIndices[v * nbMaxInfluences + i] = streams.blendingIndices[v * dim + i];
+            }
+        }
+
+        streams.blendingWeights.resize(streams.nbVertices * nbMaxInfluences);
+        streams.blendingIndices.resize(streams.nbVertices * nbMaxInfluences);
+        streams.blendingDim = nbMaxInfluences;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::usesSkinningStreams() const
+{
+    return m_bHardwareSkinning && !m_strSkeletonName.empty() && (m_currentSubMesh.streams.blendingDim > 0);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::collectBones(std::vector<unsigned short>& bones) const
+{
+    const tVertexStreams& streams = m_currentSubMesh.streams;
+
+    bones.clear();
+
+    const size_t nbValues = std::min(streams.blendingWeights.size(), streams.blendingIndices.size());
+
+    for (size_t i = 0; i < nbValues; ++i)
+    {
+        if (streams.blendingWeights[i] > 0.0f)
+            bones.push_back(streams.blendingIndices[i]);
+    }
+
+    std::sort(bones.begin(), bones.end());
+    bones.erase(std::unique(bones.begin(), bones.end()), bones.end());
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::buildBonePalette(std::vector<unsigned short>& palette)
+{
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    collectBones(palette);
+
+    assert((palette.size() <= m_usMaxBonesPerDraw) && "The vertices use more bones than one draw can hold");
+
+    if (palette.empty())
+        palette.push_back(0);
+
+    // Replace the bones by their index in the palette (the unused influences point to
+    // the first entry)
+    for (size_t i = 0; i < streams.blendingIndices.size(); ++i)
+    {
+        if ((i < streams.blendingWeights.size()) && (streams.blendingWeights[i] > 0.0f))
+        {
+            streams.blendingIndices[i] = std::lower_bound(palette.begin(), palette.end(),
+                                                          streams.blendingIndices[i]) - palette.begin();
+        }
+        else
+        {
+            streams.blendingIndices[i] = 0;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshBuilder::hasElement(Ogre::VertexElementSemantic semantic, unsigned short usIndex) const
+{
+    std::vector<std::vector<tElement> >::const_iterator iterSource, iterSourceEnd;
+    std::vector<tElement>::const_iterator               iter, iterEnd;
+
+    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
+         iterSource != iterSourceEnd; ++iterSource)
+    {
+        for (iter = iterSource->begin(), iterEnd = iterSource->end(); iter != iterEnd; ++iter)
+        {
+            if ((iter->semantic == semantic) && (iter->usIndex == usIndex))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::remapIndices(const std::vector<unsigned int>& remap)
+{
+    std::vector<unsigned int>& indices = m_currentSubMesh.indices;
+
+    // Submeshes without indices use all the vertices in order
+    if (indices.empty())
+    {
+        indices = remap;
+        return;
+    }
+
+    for (unsigned int i = 0; i < indices.size(); ++i)
+    {
+        assert((indices[i] < remap.size()) && "The submesh references a vertex that doesn't exist");
+        indices[i] = remap[indices[i]];
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshBuilder::clearStaging()
+{
+    // The containers are only cleared, to keep their capacity for the next submeshes
+    std::vector<std::vector<tElement> >::iterator iterSource, iterSourceEnd;
+    for (iterSource = m_currentSubMesh.verticesElements.begin(), iterSourceEnd = m_currentSubMesh.verticesElements.end();
+         iterSource != iterSourceEnd; ++iterSource)
+    {
+        iterSource->clear();
+    }
+
+    m_currentSubMesh.declaredSemantics = 0;
+    m_currentSubMesh.vertexBufferInfos.clear();
+    m_currentSubMesh.indices.clear();
+    m_currentSubMesh.instanceBuffers.clear();
+
+    tVertexStreams& streams = m_currentSubMesh.streams;
+
+    streams.nbVertices  = 0;
+    streams.batchStart  = 0;
+    streams.blendingDim = 0;
+
+    streams.positions.clear();
+    streams.normals.clear();
+    streams.diffuseColours.clear();
+    streams.specularColours.clear();
+    streams.binormals.clear();
+    streams.tangents.clear();
+    streams.blendingWeights.clear();
+    streams.blendingIndices.clear();
+
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        streams.texCoords[i].clear();
+
+    memset(streams.texCoordDims, 0, sizeof(streams.texCoordDims));
 }
 
 //-----------------------------------------------------------------------
@@ -928,6 +3571,12 @@ void MeshBuilder::copyTempVertexToBuffer()
 Ogre::MeshPtr MeshBuilder::getMesh()
 {
     assert(m_currentSubMesh.strName.empty() && "You must call end() before you call getMesh()");
+    assert(!m_mesh.isNull() && "You must call commit() before you call getMesh()");
+
+    // Load the mesh from the cache, or build the postponed submeshes
+    if (!m_pendingSubMeshes.empty() && !buildPendingSubMeshes())
+        saveToCache();
+
     assert((m_mesh->getNumSubMeshes() > 0) && "You must create at least one submesh before you call getMesh()");
 
     if (!m_mesh->isLoaded())
@@ -938,9 +3587,29 @@ Ogre::MeshPtr MeshBuilder::getMesh()
 
 //-----------------------------------------------------------------------
 
-unsigned short MeshBuilder::getNbVertices()
+unsigned int MeshBuilder::getNbVertices()
 {
     assert(!m_currentSubMesh.strName.empty() && "You must call begin() before you call getNbVertices()");
 
-    return (unsigned short) m_currentSubMesh.vertices.size() + (m_bTempVertexPending ? 1 : 0);
+    return m_currentSubMesh.streams.nbVertices;
+}
+
+//-----------------------------------------------------------------------
+
+const MeshBuilder::tDequantization& MeshBuilder::getDequantization(const std::string& strSubMeshName) const
+{
+    std::map<std::string, tDequantization>::const_iterator iter = m_dequantizations.find(strSubMeshName);
+    assert((iter != m_dequantizations.end()) && "Unknown submesh");
+
+    return iter->second;
+}
+
+//-----------------------------------------------------------------------
+
+const MeshBounds::tBounds& MeshBuilder::getBounds(const std::string& strSubMeshName) const
+{
+    std::map<std::string, MeshBounds::tBounds>::const_iterator iter = m_bounds.find(strSubMeshName);
+    assert((iter != m_bounds.end()) && "Unknown submesh");
+
+    return iter->second;
 }
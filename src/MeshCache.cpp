@@ -0,0 +1,194 @@
+/** @file   MeshCache.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshCache'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/MeshCache.h>
+
+// Ogre's includes
+#include <Ogre/OgreMeshSerializer.h>
+#include <Ogre/OgreDataStream.h>
+
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace std;
+
+
+/************************************** CONSTANTS **************************************/
+
+///< Version of the format of the cache
+const unsigned int MeshCache::VERSION = 2;
+
+///< Identifies the user data files
+static const char MAGIC[4] = { 'A', 'M', 'C', 'D' };
+
+
+/****************************** IMPLEMENTATION OF Hasher *******************************/
+
+MeshCache::Hasher::Hasher()
+: m_hash(14695981039346656037ULL)
+{
+}
+
+//-----------------------------------------------------------------------
+
+void MeshCache::Hasher::reset()
+{
+    m_hash = 14695981039346656037ULL;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshCache::Hasher::add(const void* pData, size_t size)
+{
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        m_hash ^= pBytes[i];
+        m_hash *= 1099511628211ULL;
+    }
+}
+
+
+/*************************************** METHODS ***************************************/
+
+bool MeshCache::contains(const std::string& strDirectory, tHash hash)
+{
+    const std::string strPath = getPath(strDirectory, hash);
+
+    std::ifstream meshFile((strPath + ".mesh").c_str(), std::ios::binary);
+    std::ifstream dataFile((strPath + ".data").c_str(), std::ios::binary);
+
+    return meshFile.is_open() && dataFile.is_open();
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshCache::load(const std::string& strDirectory, tHash hash, Ogre::Mesh* pMesh,
+                     std::vector<unsigned char>& userData)
+{
+    assert(pMesh);
+
+    const std::string strPath = getPath(strDirectory, hash);
+
+    // Read the user data (their presence indicates that the mesh file is complete)
+    std::ifstream dataFile((strPath + ".data").c_str(), std::ios::binary);
+    if (!dataFile.is_open())
+        return false;
+
+    char magic[4];
+    unsigned int version;
+    unsigned int size;
+
+    dataFile.read(magic, sizeof(magic));
+    dataFile.read(reinterpret_cast<char*>(&version), sizeof(version));
+    dataFile.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    if (!dataFile || (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) || (version != VERSION))
+        return false;
+
+    userData.resize(size);
+
+    if (size > 0)
+    {
+        dataFile.read(reinterpret_cast<char*>(&userData[0]), size);
+        if (!dataFile)
+            return false;
+    }
+
+    // Import the mesh
+    std::ifstream* pMeshFile = new std::ifstream((strPath + ".mesh").c_str(), std::ios::binary);
+    if (!pMeshFile->is_open())
+    {
+        delete pMeshFile;
+        return false;
+    }
+
+    try
+    {
+        Ogre::DataStreamPtr stream(OGRE_NEW Ogre::FileStreamDataStream(strPath + ".mesh", pMeshFile, true));
+
+        Ogre::MeshSerializer serializer;
+        serializer.importMesh(stream, pMesh);
+    }
+    catch (Ogre::Exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshCache::save(const std::string& strDirectory, tHash hash, const Ogre::Mesh* pMesh,
+                     const std::vector<unsigned char>& userData)
+{
+    assert(pMesh);
+
+    const std::string strPath = getPath(strDirectory, hash);
+
+    // The mesh isn't considered as cached until its user data are written
+    remove((strPath + ".data").c_str());
+
+    // Export the mesh
+    try
+    {
+        Ogre::MeshSerializer serializer;
+        serializer.exportMesh(pMesh, strPath + ".mesh");
+    }
+    catch (Ogre::Exception&)
+    {
+        return false;
+    }
+
+    // Write the user data in a temporary file, renamed once complete
+    {
+        std::ofstream dataFile((strPath + ".data.tmp").c_str(), std::ios::binary | std::ios::trunc);
+        if (!dataFile.is_open())
+            return false;
+
+        const unsigned int size = userData.size();
+
+        dataFile.write(MAGIC, sizeof(MAGIC));
+        dataFile.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+        dataFile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+
+        if (size > 0)
+            dataFile.write(reinterpret_cast<const char*>(&userData[0]), size);
+
+        if (!dataFile)
+        {
+            dataFile.close();
+            remove((strPath + ".data.tmp").c_str());
+            return false;
+        }
+    }
+
+    return (rename((strPath + ".data.tmp").c_str(), (strPath + ".data").c_str()) == 0);
+}
+
+//-----------------------------------------------------------------------
+
+std::string MeshCache::getPath(const std::string& strDirectory, tHash hash)
+{
+    char name[17];
+    sprintf(name, "%08x%08x", (unsigned int) (hash >> 32), (unsigned int) (hash & 0xFFFFFFFF));
+
+    if (strDirectory.empty())
+        return name;
+
+    const char last = strDirectory[strDirectory.size() - 1];
+    if ((last == '/') || (last == '\\'))
+        return strDirectory + name;
+
+    return strDirectory + "/" + name;
+}
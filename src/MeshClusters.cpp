@@ -0,0 +1,555 @@
+/** @file   MeshClusters.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshClusters'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/MeshClusters.h>
+#include <Athena-Graphics/GraphicTools.h>
+#include <Athena-Graphics/MeshBounds.h>
+#include <Athena-Graphics/Conversions.h>
+#include <Athena-Graphics/VertexCompression.h>
+
+// Ogre's includes
+#include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreCamera.h>
+
+#include <math.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+using Ogre::HardwareBuffer;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::SubMesh;
+using Ogre::VertexData;
+using Ogre::VertexElement;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Value of the triangles that don't belong to a cluster yet
+static const unsigned int NO_CLUSTER = 0xFFFFFFFF;
+
+/// Below this value of the smallest dot product between the normals and the axis, the
+/// normal cone is too wide to be useful
+static const float MIN_CONE_DOT = 0.1f;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Spread the 10 lowest bits of a value so there are two zero bits between each of them
+static unsigned int spreadBits(unsigned int value)
+{
+    value &= 0x000003FF;
+    value = (value | (value << 16)) & 0xFF0000FF;
+    value = (value | (value << 8)) & 0x0300F00F;
+    value = (value | (value << 4)) & 0x030C30C3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the position of a point along a Morton curve covering a box
+static unsigned int mortonCode(const float* p, const float* pMin, const float* pScale)
+{
+    unsigned int code = 0;
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const float value = std::max(0.0f, std::min(1023.0f, (p[i] - pMin[i]) * pScale[i]));
+        code |= spreadBits((unsigned int) value) << i;
+    }
+
+    return code;
+}
+
+//-----------------------------------------------------------------------
+
+static inline float dot(const float* a, const float* b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//-----------------------------------------------------------------------
+
+static inline float distanceBetween(const float* a, const float* b)
+{
+    const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    return sqrtf(dot(d, d));
+}
+
+//-----------------------------------------------------------------------
+
+/// Normalize a vector, returns its original length
+static inline float normalize(float* v)
+{
+    const float length = sqrtf(dot(v, v));
+
+    if (length > 1e-20f)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+
+    return length;
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the bounding volumes and the normal cone of a cluster
+static void computeBounds(const float* pPositions, const unsigned int* pIndices,
+                          const float* pNormals, const std::vector<unsigned int>& triangles,
+                          MeshClusters::tCluster& cluster)
+{
+    // Bounding volumes
+    std::vector<float> positions;
+    positions.reserve(triangles.size() * 9);
+
+    for (unsigned int i = 0; i < triangles.size(); ++i)
+    {
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            const float* p = &pPositions[pIndices[triangles[i] * 3 + j] * 3];
+            positions.insert(positions.end(), p, p + 3);
+        }
+    }
+
+    const MeshBounds::tBounds bounds = MeshBounds::compute(&positions[0], positions.size() / 3);
+
+    cluster.aabb    = bounds.aabb;
+    cluster.sphere  = bounds.sphere;
+
+    // Normal cone: the axis is the average of the normals, and the cutoff is derived
+    // from the normal the farthest from it
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+
+    for (unsigned int i = 0; i < triangles.size(); ++i)
+    {
+        const float* n = &pNormals[triangles[i] * 3];
+        axis[0] += n[0];
+        axis[1] += n[1];
+        axis[2] += n[2];
+    }
+
+    float minDot = -1.0f;
+
+    if (normalize(axis) > 1e-20f)
+    {
+        minDot = 1.0f;
+
+        for (unsigned int i = 0; i < triangles.size(); ++i)
+        {
+            const float* n = &pNormals[triangles[i] * 3];
+
+            // The degenerated triangles have no normal, and are never visible
+            if (dot(n, n) > 0.0f)
+                minDot = std::min(minDot, dot(n, axis));
+        }
+    }
+
+    cluster.coneAxis    = Vector3(axis[0], axis[1], axis[2]);
+    cluster.coneCutoff  = (minDot <= MIN_CONE_DOT ? 1.0f : sqrtf(1.0f - minDot * minDot));
+}
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+MeshClusters::MeshClusters()
+{
+}
+
+//-----------------------------------------------------------------------
+
+MeshClusters::MeshClusters(const std::string& strMeshName, const std::string& strResourceGroup,
+                           unsigned int nbMaxTriangles, Real positionScale)
+{
+    build(GraphicTools::loadReadableMesh(strMeshName, strResourceGroup), nbMaxTriangles, positionScale);
+}
+
+//-----------------------------------------------------------------------
+
+MeshClusters::MeshClusters(const Ogre::MeshPtr& mesh, unsigned int nbMaxTriangles,
+                           Real positionScale)
+{
+    assert(!mesh.isNull());
+
+    build(mesh, nbMaxTriangles, positionScale);
+}
+
+//-----------------------------------------------------------------------
+
+MeshClusters::~MeshClusters()
+{
+}
+
+
+/*************************************** METHODS ***************************************/
+
+void MeshClusters::addSubMesh(const tClustersList& clusters, const std::vector<unsigned int>& indices)
+{
+    m_subMeshes.push_back(tSubMeshClusters());
+
+    if (!clusters.empty())
+    {
+        m_subMeshes.back().clusters = clusters;
+        m_subMeshes.back().indices = indices;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshClusters::clear()
+{
+    m_subMeshes.clear();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshClusters::build(const float* pPositions, unsigned int nbVertices,
+                         unsigned int* pIndices, unsigned int nbIndices,
+                         unsigned int nbMaxTriangles, tClustersList& clusters)
+{
+    assert(pPositions || (nbVertices == 0));
+    assert(pIndices || (nbIndices == 0));
+    assert((nbIndices % 3 == 0) && "Only triangle lists are supported");
+    assert(nbMaxTriangles > 0);
+
+    clusters.clear();
+
+    const unsigned int nbTriangles = nbIndices / 3;
+    if (nbTriangles == 0)
+        return;
+
+
+    // Compute the centroid and the normal of each triangle
+    std::vector<float> centroids(nbTriangles * 3);
+    std::vector<float> normals(nbTriangles * 3);
+
+    float minimum[3] = {  1e30f,  1e30f,  1e30f };
+    float maximum[3] = { -1e30f, -1e30f, -1e30f };
+
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+    {
+        assert((pIndices[t * 3] < nbVertices) && (pIndices[t * 3 + 1] < nbVertices) &&
+               (pIndices[t * 3 + 2] < nbVertices));
+
+        const float* p0 = &pPositions[pIndices[t * 3] * 3];
+        const float* p1 = &pPositions[pIndices[t * 3 + 1] * 3];
+        const float* p2 = &pPositions[pIndices[t * 3 + 2] * 3];
+
+        float* pCentroid = &centroids[t * 3];
+        float* pNormal = &normals[t * 3];
+
+        const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+        pNormal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        pNormal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        pNormal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+        if (normalize(pNormal) <= 1e-20f)
+        {
+            pNormal[0] = 0.0f;
+            pNormal[1] = 0.0f;
+            pNormal[2] = 0.0f;
+        }
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            pCentroid[i] = (p0[i] + p1[i] + p2[i]) / 3.0f;
+            minimum[i] = std::min(minimum[i], pCentroid[i]);
+            maximum[i] = std::max(maximum[i], pCentroid[i]);
+        }
+    }
+
+
+    // Build the list of the triangles using each vertex
+    std::vector<unsigned int> offsets(nbVertices + 1, 0);
+    std::vector<unsigned int> adjacency(nbIndices);
+
+    for (unsigned int i = 0; i < nbIndices; ++i)
+        ++offsets[pIndices[i] + 1];
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        offsets[v + 1] += offsets[v];
+
+    {
+        std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+        for (unsigned int i = 0; i < nbIndices; ++i)
+            adjacency[cursors[pIndices[i]]++] = i / 3;
+    }
+
+
+    // The clusters are started from the triangles in the order of a Morton curve, so
+    // the remaining triangles stay grouped
+    std::vector<std::pair<unsigned int, unsigned int> > seeds(nbTriangles);
+
+    float scale[3];
+    for (unsigned int i = 0; i < 3; ++i)
+        scale[i] = (maximum[i] > minimum[i] ? 1023.0f / (maximum[i] - minimum[i]) : 0.0f);
+
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+        seeds[t] = std::make_pair(mortonCode(&centroids[t * 3], minimum, scale), t);
+
+    std::sort(seeds.begin(), seeds.end());
+
+
+    // Grow each cluster from its seed, by adding the neighbour triangle the closest to
+    // the cluster (in position and in orientation)
+    std::vector<unsigned int> clusterOf(nbTriangles, NO_CLUSTER);
+    std::vector<unsigned int> candidateOf(nbTriangles, NO_CLUSTER);
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> triangles;
+    std::vector<unsigned int> result;
+
+    result.reserve(nbIndices);
+
+    for (unsigned int s = 0; s < nbTriangles; ++s)
+    {
+        unsigned int triangle = seeds[s].second;
+        if (clusterOf[triangle] != NO_CLUSTER)
+            continue;
+
+        const unsigned int clusterIndex = clusters.size();
+
+        float centroidSum[3]    = { 0.0f, 0.0f, 0.0f };
+        float normalSum[3]      = { 0.0f, 0.0f, 0.0f };
+        float radius            = 0.0f;
+
+        triangles.clear();
+        candidates.clear();
+
+        while (true)
+        {
+            // Add the triangle to the cluster
+            const float* pCentroid = &centroids[triangle * 3];
+            const float* pNormal = &normals[triangle * 3];
+
+            clusterOf[triangle] = clusterIndex;
+            triangles.push_back(triangle);
+
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                centroidSum[i] += pCentroid[i];
+                normalSum[i] += pNormal[i];
+            }
+
+            const float center[3] = { centroidSum[0] / triangles.size(),
+                                      centroidSum[1] / triangles.size(),
+                                      centroidSum[2] / triangles.size() };
+
+            radius = std::max(radius, distanceBetween(pCentroid, center));
+
+            if (triangles.size() >= nbMaxTriangles)
+                break;
+
+            // Its neighbours become candidates
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                const unsigned int vertex = pIndices[triangle * 3 + i];
+
+                for (unsigned int j = offsets[vertex]; j < offsets[vertex + 1]; ++j)
+                {
+                    const unsigned int neighbour = adjacency[j];
+
+                    if ((clusterOf[neighbour] == NO_CLUSTER) && (candidateOf[neighbour] != clusterIndex))
+                    {
+                        candidateOf[neighbour] = clusterIndex;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+
+            if (candidates.empty())
+                break;
+
+            // Select the best candidate
+            float axis[3] = { normalSum[0], normalSum[1], normalSum[2] };
+            normalize(axis);
+
+            const float invRadius = 1.0f / std::max(radius, 1e-6f);
+
+            unsigned int best = 0;
+            float bestScore = 1e30f;
+
+            for (unsigned int i = 0; i < candidates.size(); ++i)
+            {
+                const unsigned int candidate = candidates[i];
+
+                const float score = (1.0f - dot(&normals[candidate * 3], axis)) +
+                                    distanceBetween(&centroids[candidate * 3], center) * invRadius;
+
+                if (score < bestScore)
+                {
+                    bestScore = score;
+                    best = i;
+                }
+            }
+
+            triangle = candidates[best];
+            candidates[best] = candidates.back();
+            candidates.pop_back();
+        }
+
+        // The triangles of the cluster keep their relative order, to preserve the
+        // optimizations of the vertex cache
+        std::sort(triangles.begin(), triangles.end());
+
+        tCluster cluster;
+        cluster.indexStart  = result.size();
+        cluster.nbIndices   = triangles.size() * 3;
+
+        computeBounds(pPositions, pIndices, &normals[0], triangles, cluster);
+
+        for (unsigned int i = 0; i < triangles.size(); ++i)
+        {
+            result.push_back(pIndices[triangles[i] * 3]);
+            result.push_back(pIndices[triangles[i] * 3 + 1]);
+            result.push_back(pIndices[triangles[i] * 3 + 2]);
+        }
+
+        clusters.push_back(cluster);
+    }
+
+    memcpy(pIndices, &result[0], nbIndices * sizeof(unsigned int));
+}
+
+//-----------------------------------------------------------------------
+
+bool MeshClusters::isBackFacing(const tCluster& cluster, const Math::Vector3& viewPoint)
+{
+    if (cluster.coneCutoff >= 1.0f)
+        return false;
+
+    const Vector3 direction = cluster.sphere.getCenter() - viewPoint;
+
+    return direction.dotProduct(cluster.coneAxis) >=
+           cluster.coneCutoff * direction.length() + cluster.sphere.getRadius();
+}
+
+//-----------------------------------------------------------------------
+
+unsigned int MeshClusters::cull(const tClustersList& clusters, const Ogre::Camera* pCamera,
+                                const Ogre::Matrix4& transform,
+                                std::vector<unsigned char>& visibility)
+{
+    assert(pCamera);
+
+    visibility.resize(clusters.size());
+
+    // Largest scale of the transformation, applied to the radius of the spheres
+    Real scale = 0.0f;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const Real length = sqrtf(transform[0][i] * transform[0][i] + transform[1][i] * transform[1][i] +
+                                  transform[2][i] * transform[2][i]);
+        scale = std::max(scale, length);
+    }
+
+    // The back-facing clusters are detected in the space of the mesh. An orthographic
+    // camera looks at all the clusters from the same direction, which is the same as
+    // a point very far behind it.
+    const Ogre::Matrix4 inverse = transform.inverseAffine();
+
+    Ogre::Vector3 viewPoint = pCamera->getDerivedPosition();
+    if (pCamera->getProjectionType() == Ogre::PT_ORTHOGRAPHIC)
+        viewPoint = viewPoint - pCamera->getDerivedDirection() * 1e6f;
+
+    const Vector3 localViewPoint = fromOgre(inverse.transformAffine(viewPoint));
+
+    unsigned int nbVisibles = 0;
+
+    for (unsigned int i = 0; i < clusters.size(); ++i)
+    {
+        const tCluster& cluster = clusters[i];
+
+        const Ogre::Sphere sphere(transform.transformAffine(toOgre(cluster.sphere.getCenter())),
+                                  cluster.sphere.getRadius() * scale);
+
+        visibility[i] = (pCamera->isVisible(sphere) && !isBackFacing(cluster, localViewPoint) ? 1 : 0);
+        nbVisibles += visibility[i];
+    }
+
+    return nbVisibles;
+}
+
+
+//-----------------------------------------------------------------------
+
+void MeshClusters::build(const Ogre::MeshPtr& mesh, unsigned int nbMaxTriangles, Real positionScale)
+{
+    std::vector<float> sharedPositions;
+
+    m_subMeshes.resize(mesh->getNumSubMeshes());
+
+    for (unsigned short subIndex = 0; subIndex < mesh->getNumSubMeshes(); ++subIndex)
+    {
+        SubMesh* pSubMesh = mesh->getSubMesh(subIndex);
+        tSubMeshClusters& subMesh = m_subMeshes[subIndex];
+
+        // Only the indexed triangle lists are clustered
+        if ((pSubMesh->operationType != Ogre::RenderOperation::OT_TRIANGLE_LIST) ||
+            !pSubMesh->indexData || (pSubMesh->indexData->indexCount == 0))
+        {
+            continue;
+        }
+
+        // Retrieve the vertices (only once for the shared ones)
+        std::vector<float> positions;
+        std::vector<float>* pPositions = &positions;
+
+        if (pSubMesh->useSharedVertices)
+        {
+            if (sharedPositions.empty())
+                readPositions(mesh->sharedVertexData, positionScale, sharedPositions);
+
+            pPositions = &sharedPositions;
+        }
+        else
+        {
+            readPositions(pSubMesh->vertexData, positionScale, positions);
+        }
+
+        GraphicTools::readIndices(pSubMesh->indexData, subMesh.indices);
+
+        build(&(*pPositions)[0], pPositions->size() / 3, &subMesh.indices[0], subMesh.indices.size(),
+              nbMaxTriangles, subMesh.clusters);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshClusters::readPositions(VertexData* pVertexData, Real positionScale,
+                                 std::vector<float>& positions)
+{
+    assert(pVertexData);
+
+    const VertexElement* pElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
+    assert(pElement);
+
+    // The compact positions (see MeshBuilder and MeshConverter) are decoded
+    VertexCompression::tFormat format = VertexCompression::FORMAT_FLOAT;
+    const bool bValidFormat = VertexCompression::getVectorFormat(pElement->getType(), format) &&
+                              ((format == VertexCompression::FORMAT_FLOAT) ||
+                               (format == VertexCompression::FORMAT_SHORT));
+    assert(bValidFormat && "Unsupported type of vertex positions");
+
+    positions.resize(pVertexData->vertexCount * 3);
+
+    HardwareVertexBufferSharedPtr buffer = pVertexData->vertexBufferBinding->getBuffer(pElement->getSource());
+
+    const unsigned char* pSource = static_cast<const unsigned char*>(buffer->lock(HardwareBuffer::HBL_READ_ONLY)) +
+                                   pVertexData->vertexStart * buffer->getVertexSize() + pElement->getOffset();
+
+    for (unsigned int v = 0; v < pVertexData->vertexCount; ++v, pSource += buffer->getVertexSize())
+        VertexCompression::decode(format, pSource, 3, positionScale, &positions[v * 3]);
+
+    buffer->unlock();
+}
@@ -0,0 +1,411 @@
+/** @file   MeshConverter.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshConverter'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/MeshConverter.h>
+#include <Athena-Graphics/GraphicTools.h>
+
+// Ogre's includes
+#include <Ogre/OgreHardwareBufferManager.h>
+#include <Ogre/OgreSubMesh.h>
+
+#include <math.h>
+#include <map>
+#include <set>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::Mesh;
+using Ogre::SubMesh;
+using Ogre::VertexBufferBinding;
+using Ogre::VertexData;
+using Ogre::VertexDeclaration;
+using Ogre::VertexElement;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Dequantization scale of the unit vectors (quantized on the full range of the format)
+static const Real UNIT_SCALE = VertexCompression::computeScale(1.0f);
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Conversion of a vertex element
+struct tConversion
+{
+    VertexElement               source;
+    VertexCompression::tFormat  format;
+    size_t                      offset;     ///< Offset in the new vertex
+};
+
+//-----------------------------------------------------------------------
+
+/// Indicates if a vertex element contains 32-bit floats
+static bool isFloat(const VertexElement& element)
+{
+    return (VertexElement::getBaseType(element.getType()) == Ogre::VET_FLOAT1);
+}
+
+//-----------------------------------------------------------------------
+
+/// Returns the format into which a vertex element must be converted
+static VertexCompression::tFormat getFormat(const VertexElement& element,
+                                            const MeshConverter::tFormats& formats,
+                                            bool bAnimated)
+{
+    if (!isFloat(element))
+        return VertexCompression::FORMAT_FLOAT;
+
+    const unsigned short nbComponents = VertexElement::getTypeCount(element.getType());
+
+    switch (element.getSemantic())
+    {
+    case Ogre::VES_POSITION:
+        if (bAnimated || (element.getIndex() != 0))
+            return VertexCompression::FORMAT_FLOAT;
+        return formats.positions;
+
+    case Ogre::VES_NORMAL:
+        if (bAnimated || (nbComponents != 3))
+            return VertexCompression::FORMAT_FLOAT;
+        return formats.normals;
+
+    case Ogre::VES_TANGENT:
+    case Ogre::VES_BINORMAL:
+        if (nbComponents < 3)
+            return VertexCompression::FORMAT_FLOAT;
+        else if ((nbComponents == 4) && (formats.tangents == VertexCompression::FORMAT_OCTAHEDRAL))
+            return VertexCompression::FORMAT_UBYTE;
+        return formats.tangents;
+
+    case Ogre::VES_TEXTURE_COORDINATES:
+        return formats.texCoords;
+
+    default:
+        return VertexCompression::FORMAT_FLOAT;
+    }
+}
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+MeshConverter::MeshConverter(const std::string& strMeshName, const std::string& strResourceGroup)
+{
+    m_mesh = GraphicTools::loadReadableMesh(strMeshName, strResourceGroup);
+
+    m_dequantization.position = 1.0f;
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        m_dequantization.texCoords[i] = 1.0f;
+}
+
+//-----------------------------------------------------------------------
+
+MeshConverter::MeshConverter(const Ogre::MeshPtr& mesh)
+: m_mesh(mesh)
+{
+    assert(!m_mesh.isNull());
+    assert(m_mesh->isLoaded());
+
+    m_dequantization.position = 1.0f;
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+        m_dequantization.texCoords[i] = 1.0f;
+}
+
+//-----------------------------------------------------------------------
+
+MeshConverter::~MeshConverter()
+{
+}
+
+
+/*************************************** METHODS ***************************************/
+
+MeshConverter::tStatistics MeshConverter::convert(const tFormats& formats)
+{
+    assert(((formats.positions == VertexCompression::FORMAT_FLOAT) || (formats.positions == VertexCompression::FORMAT_SHORT)) &&
+           "Unsupported format for the positions");
+    assert(((formats.texCoords == VertexCompression::FORMAT_FLOAT) || (formats.texCoords == VertexCompression::FORMAT_SHORT)) &&
+           "Unsupported format for the texture coordinates");
+
+    // Retrieve the vertex data of the mesh
+    m_vertexDatas.clear();
+    m_animated.clear();
+
+    if (m_mesh->sharedVertexData)
+    {
+        m_vertexDatas.push_back(m_mesh->sharedVertexData);
+        m_animated.push_back(m_mesh->getSharedVertexDataAnimationType() != Ogre::VAT_NONE);
+    }
+
+    Mesh::SubMeshIterator iter = m_mesh->getSubMeshIterator();
+    while (iter.hasMoreElements())
+    {
+        SubMesh* pSubMesh = iter.getNext();
+
+        if (!pSubMesh->useSharedVertices && pSubMesh->vertexData)
+        {
+            m_vertexDatas.push_back(pSubMesh->vertexData);
+            m_animated.push_back(pSubMesh->getVertexAnimationType() != Ogre::VAT_NONE);
+        }
+    }
+
+    // The quantized attributes use the same scales in all the submeshes
+    computeDequantization(formats);
+
+    tStatistics statistics;
+    statistics.nbBytesBefore    = 0;
+    statistics.nbBytesAfter     = 0;
+
+    for (size_t i = 0; i < m_vertexDatas.size(); ++i)
+        convertVertexData(m_vertexDatas[i], formats, m_animated[i], statistics);
+
+    // Release the original buffers
+    m_convertedBuffers.clear();
+
+    return statistics;
+}
+
+//-----------------------------------------------------------------------
+
+void MeshConverter::computeDequantization(const tFormats& formats)
+{
+    Real maxPosition = 0.0f;
+    Real maxTexCoords[OGRE_MAX_TEXTURE_COORD_SETS];
+    bool bPositions = false;
+    bool bTexCoords[OGRE_MAX_TEXTURE_COORD_SETS];
+    std::set<Ogre::HardwareVertexBuffer*> buffers;
+
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+    {
+        maxTexCoords[i] = 0.0f;
+        bTexCoords[i] = false;
+    }
+
+    // Only the attributes converted to shorts need a scale, computed from their largest
+    // absolute value
+    for (size_t i = 0; i < m_vertexDatas.size(); ++i)
+    {
+        VertexData* pVertexData = m_vertexDatas[i];
+
+        const VertexBufferBinding::VertexBufferBindingMap& bindings = pVertexData->vertexBufferBinding->getBindings();
+
+        VertexBufferBinding::VertexBufferBindingMap::const_iterator iter, iterEnd;
+        for (iter = bindings.begin(), iterEnd = bindings.end(); iter != iterEnd; ++iter)
+        {
+            // A buffer bound by several vertex data is only read once
+            const HardwareVertexBufferSharedPtr& buffer = iter->second;
+            if (buffer->getIsInstanceData() || !buffers.insert(buffer.get()).second)
+                continue;
+
+            VertexDeclaration::VertexElementList elements = pVertexData->vertexDeclaration->findElementsBySource(iter->first);
+
+            VertexDeclaration::VertexElementList::iterator iterElement = elements.begin();
+            while (iterElement != elements.end())
+            {
+                if (getFormat(*iterElement, formats, m_animated[i]) == VertexCompression::FORMAT_SHORT)
+                    ++iterElement;
+                else
+                    iterElement = elements.erase(iterElement);
+            }
+
+            if (elements.empty())
+                continue;
+
+            for (iterElement = elements.begin(); iterElement != elements.end(); ++iterElement)
+            {
+                if (iterElement->getSemantic() == Ogre::VES_POSITION)
+                    bPositions = true;
+                else
+                    bTexCoords[iterElement->getIndex()] = true;
+            }
+
+            assert(GraphicTools::isReadable(buffer.get()) && "The vertex buffers of the mesh must be readable");
+
+            // All the vertices of the buffer are converted, not only the ones used by the
+            // vertex data
+            const size_t stride = buffer->getVertexSize();
+            const unsigned char* pData = static_cast<const unsigned char*>(buffer->lock(HardwareBuffer::HBL_READ_ONLY));
+
+            for (size_t v = 0; v < buffer->getNumVertices(); ++v, pData += stride)
+            {
+                VertexDeclaration::VertexElementList::const_iterator iterElementEnd;
+                for (iterElement = elements.begin(), iterElementEnd = elements.end(); iterElement != iterElementEnd; ++iterElement)
+                {
+                    const float* pValues = reinterpret_cast<const float*>(pData + iterElement->getOffset());
+                    const unsigned short nbComponents = VertexElement::getTypeCount(iterElement->getType());
+
+                    Real& maxValue = (iterElement->getSemantic() == Ogre::VES_POSITION ?
+                                        maxPosition : maxTexCoords[iterElement->getIndex()]);
+
+                    for (unsigned short c = 0; c < nbComponents; ++c)
+                        maxValue = std::max(maxValue, (Real) fabs(pValues[c]));
+                }
+            }
+
+            buffer->unlock();
+        }
+    }
+
+    // The scales of the attributes without any float to convert are kept: they are
+    // either unused, or the ones of an attribute already converted by a previous call
+    if (bPositions)
+        m_dequantization.position = VertexCompression::computeScale(maxPosition);
+
+    // Keep texture coordinates in [-1, 1] on the full range
+    for (unsigned int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; ++i)
+    {
+        if (bTexCoords[i])
+            m_dequantization.texCoords[i] = VertexCompression::computeScale(std::max(maxTexCoords[i], (Real) 1.0f));
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshConverter::convertVertexData(Ogre::VertexData* pVertexData, const tFormats& formats,
+                                      bool bAnimated, tStatistics& statistics)
+{
+    VertexDeclaration* pDeclaration = HardwareBufferManager::getSingleton().createVertexDeclaration();
+    std::map<unsigned short, std::vector<tConversion> > conversions;
+    std::map<unsigned short, size_t> vertexSizes;
+    bool bConverted = false;
+
+    // Build the new declaration: the elements of each source are packed in their
+    // original order, with their new types (the instance buffers are kept unchanged)
+    const VertexDeclaration::VertexElementList& elements = pVertexData->vertexDeclaration->getElements();
+    VertexDeclaration::VertexElementList::const_iterator iter, iterEnd;
+
+    for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
+    {
+        const unsigned short usSource = iter->getSource();
+
+        if (pVertexData->vertexBufferBinding->getBuffer(usSource)->getIsInstanceData())
+        {
+            pDeclaration->addElement(usSource, iter->getOffset(), iter->getType(), iter->getSemantic(), iter->getIndex());
+            continue;
+        }
+
+        tConversion conversion = { *iter, getFormat(*iter, formats, bAnimated), vertexSizes[usSource] };
+
+        Ogre::VertexElementType type = iter->getType();
+        if (conversion.format != VertexCompression::FORMAT_FLOAT)
+        {
+            type = VertexCompression::getElementType(conversion.format, VertexElement::getTypeCount(type));
+            bConverted = true;
+        }
+
+        pDeclaration->addElement(usSource, conversion.offset, type, iter->getSemantic(), iter->getIndex());
+
+        vertexSizes[usSource] += VertexElement::getTypeSize(type);
+        conversions[usSource].push_back(conversion);
+    }
+
+    // Convert the vertices of each buffer in system memory, then upload them once into
+    // a new buffer (all the vertices of the buffer are converted, so the indices stay
+    // valid). A buffer bound by several vertex data is only converted (and counted)
+    // once, the other ones are bound to the same copy.
+    const VertexBufferBinding::VertexBufferBindingMap bindings = pVertexData->vertexBufferBinding->getBindings();
+    VertexBufferBinding::VertexBufferBindingMap::const_iterator iterBinding, iterBindingEnd;
+
+    for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+    {
+        const unsigned short usSource = iterBinding->first;
+        const HardwareVertexBufferSharedPtr& source = iterBinding->second;
+
+        std::map<Ogre::HardwareVertexBuffer*, HardwareVertexBufferSharedPtr>::const_iterator iterConverted =
+                                                            m_convertedBuffers.find(source.get());
+
+        if (iterConverted != m_convertedBuffers.end())
+        {
+            assert((!bConverted || source->getIsInstanceData() || (conversions.find(usSource) == conversions.end()) ||
+                    (iterConverted->second->getVertexSize() == vertexSizes[usSource])) &&
+                   "A vertex buffer is bound by several vertex data with different declarations");
+
+            if (iterConverted->second.get() != source.get())
+                pVertexData->vertexBufferBinding->setBinding(usSource, iterConverted->second);
+
+            continue;
+        }
+
+        statistics.nbBytesBefore += source->getSizeInBytes();
+
+        if (!bConverted || source->getIsInstanceData() || (conversions.find(usSource) == conversions.end()))
+        {
+            m_convertedBuffers[source.get()] = source;
+            statistics.nbBytesAfter += source->getSizeInBytes();
+            continue;
+        }
+
+        assert(GraphicTools::isReadable(source.get()) && "The vertex buffers of the mesh must be readable");
+
+        const std::vector<tConversion>& sourceConversions = conversions[usSource];
+        const size_t sourceSize = source->getVertexSize();
+        const size_t vertexSize = vertexSizes[usSource];
+        const size_t nbVertices = source->getNumVertices();
+
+        std::vector<unsigned char> data(nbVertices * vertexSize);
+
+        const unsigned char* pSource = static_cast<const unsigned char*>(source->lock(HardwareBuffer::HBL_READ_ONLY));
+        unsigned char* pDest = &data[0];
+
+        for (size_t v = 0; v < nbVertices; ++v, pSource += sourceSize, pDest += vertexSize)
+        {
+            std::vector<tConversion>::const_iterator iterConversion, iterConversionEnd;
+            for (iterConversion = sourceConversions.begin(), iterConversionEnd = sourceConversions.end();
+                 iterConversion != iterConversionEnd; ++iterConversion)
+            {
+                const VertexElement& element = iterConversion->source;
+
+                if (iterConversion->format == VertexCompression::FORMAT_FLOAT)
+                {
+                    memcpy(pDest + iterConversion->offset, pSource + element.getOffset(), element.getSize());
+                    continue;
+                }
+
+                Real scale = UNIT_SCALE;
+                if (element.getSemantic() == Ogre::VES_POSITION)
+                    scale = m_dequantization.position;
+                else if (element.getSemantic() == Ogre::VES_TEXTURE_COORDINATES)
+                    scale = m_dequantization.texCoords[element.getIndex()];
+
+                VertexCompression::encode(iterConversion->format,
+                                          reinterpret_cast<const float*>(pSource + element.getOffset()),
+                                          VertexElement::getTypeCount(element.getType()), scale,
+                                          pDest + iterConversion->offset);
+            }
+        }
+
+        source->unlock();
+
+        HardwareVertexBufferSharedPtr buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                        vertexSize, nbVertices, m_mesh->getVertexBufferUsage(),
+                        m_mesh->isVertexBufferShadowed());
+
+        buffer->writeData(0, buffer->getSizeInBytes(), &data[0], true);
+
+        pVertexData->vertexBufferBinding->setBinding(usSource, buffer);
+
+        m_convertedBuffers[source.get()] = buffer;
+        statistics.nbBytesAfter += buffer->getSizeInBytes();
+    }
+
+    if (!bConverted)
+    {
+        HardwareBufferManager::getSingleton().destroyVertexDeclaration(pDeclaration);
+        return;
+    }
+
+    // The new declaration replaces the old one
+    HardwareBufferManager::getSingleton().destroyVertexDeclaration(pVertexData->vertexDeclaration);
+    pVertexData->vertexDeclaration = pDeclaration;
+}
@@ -0,0 +1,455 @@
+/** @file   MeshOptimizer.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshOptimizer'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/MeshOptimizer.h>
+
+#include <math.h>
+#include <algorithm>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Size of the vertex cache modelled by the Forsyth algorithm
+static const unsigned int   FORSYTH_CACHE_SIZE      = 32;
+
+/// Parameters of the scoring function of the Forsyth algorithm
+static const float          CACHE_DECAY_POWER       = 1.5f;
+static const float          LAST_TRIANGLE_SCORE     = 0.75f;
+static const float          VALENCE_BOOST_SCALE     = 2.0f;
+static const float          VALENCE_BOOST_POWER     = 0.5f;
+
+/// Size of the vertex cache used to delimit the clusters of triangles
+static const unsigned int   CLUSTERS_CACHE_SIZE     = 16;
+
+/// Marks an invalid triangle or vertex
+static const unsigned int   INVALID                 = 0xFFFFFFFF;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Compute the score of a vertex (Forsyth algorithm)
+static float vertexScore(int cachePosition, unsigned int nbRemainingTriangles)
+{
+    // No triangle needs this vertex anymore
+    if (nbRemainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0)
+    {
+        // The vertices used by the last triangle get a fixed score, to avoid favouring
+        // one of them over the others
+        if (cachePosition < 3)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Bonus for the vertices with few remaining triangles, to get rid of them quickly
+    score += VALENCE_BOOST_SCALE * powf((float) nbRemainingTriangles, -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+//-----------------------------------------------------------------------
+
+/// Used to sort the clusters of triangles by decreasing sort key
+struct ClusterSorter
+{
+    ClusterSorter(const std::vector<float>& keys)
+    : keys(keys)
+    {
+    }
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        return keys[a] > keys[b];
+    }
+
+    const std::vector<float>& keys;
+};
+
+
+/*************************************** METHODS ***************************************/
+
+void MeshOptimizer::optimizeVertexCache(unsigned int* pIndices, unsigned int nbIndices,
+                                        unsigned int nbVertices)
+{
+    assert(pIndices || (nbIndices == 0));
+    assert((nbIndices % 3 == 0) && "Only triangle lists are supported");
+
+    const unsigned int nbTriangles = nbIndices / 3;
+    if (nbTriangles == 0)
+        return;
+
+
+    // Build the list of triangles using each vertex
+    std::vector<unsigned int> nbRemainingTriangles(nbVertices, 0);
+    std::vector<unsigned int> offsets(nbVertices + 1, 0);
+    std::vector<unsigned int> adjacency(nbIndices);
+
+    for (unsigned int i = 0; i < nbIndices; ++i)
+    {
+        assert(pIndices[i] < nbVertices);
+        ++nbRemainingTriangles[pIndices[i]];
+    }
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        offsets[v + 1] = offsets[v] + nbRemainingTriangles[v];
+
+    std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < nbIndices; ++i)
+        adjacency[cursors[pIndices[i]]++] = i / 3;
+
+
+    // Compute the initial scores
+    std::vector<int>    cachePositions(nbVertices, -1);
+    std::vector<float>  vertexScores(nbVertices);
+    std::vector<float>  triangleScores(nbTriangles, 0.0f);
+    std::vector<char>   added(nbTriangles, 0);
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        vertexScores[v] = vertexScore(-1, nbRemainingTriangles[v]);
+
+    unsigned int bestTriangle = INVALID;
+    float bestScore = -1.0f;
+
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+    {
+        triangleScores[t] = vertexScores[pIndices[t * 3]] + vertexScores[pIndices[t * 3 + 1]] +
+                            vertexScores[pIndices[t * 3 + 2]];
+
+        if (triangleScores[t] > bestScore)
+        {
+            bestScore = triangleScores[t];
+            bestTriangle = t;
+        }
+    }
+
+
+    // Add the triangles one by one
+    std::vector<unsigned int> result(nbIndices);
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    unsigned int nextCandidate = 0;
+
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    for (unsigned int n = 0; n < nbTriangles; ++n)
+    {
+        // No good triangle around the cache: take the next one not added yet
+        if (bestTriangle == INVALID)
+        {
+            while (added[nextCandidate])
+                ++nextCandidate;
+
+            bestTriangle = nextCandidate;
+        }
+
+        const unsigned int* pTriangle = &pIndices[bestTriangle * 3];
+
+        added[bestTriangle] = 1;
+        result[n * 3]       = pTriangle[0];
+        result[n * 3 + 1]   = pTriangle[1];
+        result[n * 3 + 2]   = pTriangle[2];
+
+        // Remove the triangle from the lists of its vertices, and put them on top of
+        // the cache
+        newCache.clear();
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            const unsigned int v = pTriangle[i];
+
+            unsigned int* pAdjacency = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < nbRemainingTriangles[v]; ++j)
+            {
+                if (pAdjacency[j] == bestTriangle)
+                {
+                    pAdjacency[j] = pAdjacency[nbRemainingTriangles[v] - 1];
+                    --nbRemainingTriangles[v];
+                    break;
+                }
+            }
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                newCache.push_back(v);
+        }
+
+        for (unsigned int i = 0; i < cache.size(); ++i)
+        {
+            if (std::find(newCache.begin(), newCache.end(), cache[i]) == newCache.end())
+                newCache.push_back(cache[i]);
+        }
+
+        // Update the scores of the vertices in the cache (and of the ones that just
+        // left it)
+        for (unsigned int i = 0; i < newCache.size(); ++i)
+        {
+            const unsigned int v = newCache[i];
+
+            cachePositions[v] = (i < FORSYTH_CACHE_SIZE ? (int) i : -1);
+            vertexScores[v] = vertexScore(cachePositions[v], nbRemainingTriangles[v]);
+        }
+
+        // Update the scores of the triangles using those vertices, and find the best one
+        bestTriangle = INVALID;
+        bestScore = -1.0f;
+
+        for (unsigned int i = 0; i < newCache.size(); ++i)
+        {
+            const unsigned int v = newCache[i];
+
+            for (unsigned int j = 0; j < nbRemainingTriangles[v]; ++j)
+            {
+                const unsigned int t = adjacency[offsets[v] + j];
+
+                triangleScores[t] = vertexScores[pIndices[t * 3]] + vertexScores[pIndices[t * 3 + 1]] +
+                                    vertexScores[pIndices[t * 3 + 2]];
+
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE)
+            newCache.resize(FORSYTH_CACHE_SIZE);
+
+        cache.swap(newCache);
+    }
+
+    memcpy(pIndices, &result[0], nbIndices * sizeof(unsigned int));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshOptimizer::optimizeOverdraw(unsigned int* pIndices, unsigned int nbIndices,
+                                     const float* pPositions, unsigned int nbVertices)
+{
+    assert(pIndices || (nbIndices == 0));
+    assert(pPositions || (nbVertices == 0));
+    assert((nbIndices % 3 == 0) && "Only triangle lists are supported");
+
+    const unsigned int nbTriangles = nbIndices / 3;
+    if (nbTriangles == 0)
+        return;
+
+
+    // Split the triangles into clusters, at each flush of the vertex cache (when the
+    // three vertices of a triangle are missing from the cache)
+    std::vector<unsigned int> clusters;
+    std::vector<unsigned int> cacheTimestamps(nbVertices, 0);
+    unsigned int time = CLUSTERS_CACHE_SIZE + 1;
+
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+    {
+        unsigned int nbMisses = 0;
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            const unsigned int v = pIndices[t * 3 + i];
+
+            if (time - cacheTimestamps[v] > CLUSTERS_CACHE_SIZE)
+            {
+                cacheTimestamps[v] = time++;
+                ++nbMisses;
+            }
+        }
+
+        if ((t == 0) || (nbMisses == 3))
+            clusters.push_back(t);
+    }
+
+    if (clusters.size() == 1)
+        return;
+
+
+    // Compute the area-weighted centroid and normal of each cluster, and of the mesh
+    const unsigned int nbClusters = clusters.size();
+
+    std::vector<float> centroids(nbClusters * 3, 0.0f);
+    std::vector<float> normals(nbClusters * 3, 0.0f);
+    std::vector<float> areas(nbClusters, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for (unsigned int c = 0; c < nbClusters; ++c)
+    {
+        const unsigned int end = (c + 1 < nbClusters ? clusters[c + 1] : nbTriangles);
+
+        for (unsigned int t = clusters[c]; t < end; ++t)
+        {
+            const float* p0 = &pPositions[pIndices[t * 3] * 3];
+            const float* p1 = &pPositions[pIndices[t * 3 + 1] * 3];
+            const float* p2 = &pPositions[pIndices[t * 3 + 2] * 3];
+
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+            const float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                                      e1[2] * e2[0] - e1[0] * e2[2],
+                                      e1[0] * e2[1] - e1[1] * e2[0] };
+
+            const float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                const float center = (p0[i] + p1[i] + p2[i]) / 3.0f;
+
+                centroids[c * 3 + i] += center * area;
+                normals[c * 3 + i] += normal[i];
+                meshCentroid[i] += center * area;
+            }
+
+            areas[c] += area;
+            meshArea += area;
+        }
+    }
+
+    if (meshArea > 0.0f)
+    {
+        for (unsigned int i = 0; i < 3; ++i)
+            meshCentroid[i] /= meshArea;
+    }
+
+
+    // The clusters facing away from the center of the mesh are the most likely to
+    // occlude the others, so they are drawn first
+    std::vector<float> keys(nbClusters, 0.0f);
+    std::vector<unsigned int> order(nbClusters);
+
+    for (unsigned int c = 0; c < nbClusters; ++c)
+    {
+        order[c] = c;
+
+        const float* pNormal = &normals[c * 3];
+        const float length = sqrtf(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+
+        if ((areas[c] > 0.0f) && (length > 0.0f))
+        {
+            for (unsigned int i = 0; i < 3; ++i)
+                keys[c] += (centroids[c * 3 + i] / areas[c] - meshCentroid[i]) * pNormal[i] / length;
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), ClusterSorter(keys));
+
+
+    // Rebuild the list of indices
+    std::vector<unsigned int> result;
+    result.reserve(nbIndices);
+
+    for (unsigned int c = 0; c < nbClusters; ++c)
+    {
+        const unsigned int start = clusters[order[c]];
+        const unsigned int end = (order[c] + 1 < nbClusters ? clusters[order[c] + 1] : nbTriangles);
+
+        result.insert(result.end(), pIndices + start * 3, pIndices + end * 3);
+    }
+
+    memcpy(pIndices, &result[0], nbIndices * sizeof(unsigned int));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshOptimizer::optimizeVertexFetch(unsigned int* pIndices, unsigned int nbIndices,
+                                        unsigned int nbVertices, std::vector<unsigned int>& order)
+{
+    assert(pIndices || (nbIndices == 0));
+
+    std::vector<unsigned int> remap(nbVertices, INVALID);
+
+    order.clear();
+    order.reserve(nbVertices);
+
+    // Number the vertices by first use
+    for (unsigned int i = 0; i < nbIndices; ++i)
+    {
+        const unsigned int v = pIndices[i];
+        assert(v < nbVertices);
+
+        if (remap[v] == INVALID)
+        {
+            remap[v] = order.size();
+            order.push_back(v);
+        }
+
+        pIndices[i] = remap[v];
+    }
+
+    // Keep the unreferenced vertices at the end
+    for (unsigned int v = 0; v < nbVertices; ++v)
+    {
+        if (remap[v] == INVALID)
+            order.push_back(v);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+MeshOptimizer::tCacheStatistics MeshOptimizer::analyzeVertexCache(const unsigned int* pIndices,
+                                                                  unsigned int nbIndices,
+                                                                  unsigned int nbVertices,
+                                                                  unsigned int cacheSize)
+{
+    assert(pIndices || (nbIndices == 0));
+
+    tCacheStatistics result;
+    result.nbTriangles              = nbIndices / 3;
+    result.nbVertices               = 0;
+    result.nbTransformedVertices    = 0;
+    result.acmr                     = 0.0f;
+    result.atvr                     = 0.0f;
+
+    // A vertex is in the FIFO cache if less than 'cacheSize' vertices were transformed
+    // since it was
+    std::vector<unsigned int> cacheTimestamps(nbVertices, 0);
+    std::vector<char> used(nbVertices, 0);
+    unsigned int time = cacheSize + 1;
+
+    for (unsigned int i = 0; i < nbIndices; ++i)
+    {
+        const unsigned int v = pIndices[i];
+        assert(v < nbVertices);
+
+        if (time - cacheTimestamps[v] > cacheSize)
+        {
+            cacheTimestamps[v] = time++;
+            ++result.nbTransformedVertices;
+        }
+
+        if (!used[v])
+        {
+            used[v] = 1;
+            ++result.nbVertices;
+        }
+    }
+
+    if (result.nbTriangles > 0)
+        result.acmr = Real(result.nbTransformedVertices) / result.nbTriangles;
+
+    if (result.nbVertices > 0)
+        result.atvr = Real(result.nbTransformedVertices) / result.nbVertices;
+
+    return result;
+}
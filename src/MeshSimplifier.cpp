@@ -0,0 +1,734 @@
+/** @file   MeshSimplifier.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::MeshSimplifier'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/MeshSimplifier.h>
+#include <Athena-Graphics/GraphicTools.h>
+#include <Athena-Graphics/VertexCompression.h>
+
+// Ogre's includes
+#include <Ogre/OgreHardwareBufferManager.h>
+#include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreDistanceLodStrategy.h>
+#include <Ogre/OgrePixelCountLodStrategy.h>
+
+#include <math.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareIndexBuffer;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::IndexData;
+using Ogre::LodStrategy;
+using Ogre::SubMesh;
+using Ogre::VertexData;
+using Ogre::VertexElement;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Symmetric 4x4 matrix measuring the squared distance to a set of planes
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric()
+    : a2(0.0), ab(0.0), ac(0.0), ad(0.0), b2(0.0), bc(0.0), bd(0.0), c2(0.0), cd(0.0), d2(0.0)
+    {
+    }
+
+    Quadric(double a, double b, double c, double d, double weight)
+    : a2(a * a * weight), ab(a * b * weight), ac(a * c * weight), ad(a * d * weight),
+      b2(b * b * weight), bc(b * c * weight), bd(b * d * weight),
+      c2(c * c * weight), cd(c * d * weight), d2(d * d * weight)
+    {
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd; d2 += q.d2;
+        return *this;
+    }
+
+    double evaluate(const float* p) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+
+        return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+               b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+               c2 * z * z + 2.0 * cd * z + d2;
+    }
+};
+
+//-----------------------------------------------------------------------
+
+/// A possible collapse of the vertex 'from' onto the vertex 'to'
+struct Collapse
+{
+    double          cost;
+    unsigned int    from;
+    unsigned int    to;
+
+    bool operator<(const Collapse& c) const
+    {
+        return cost < c.cost;
+    }
+};
+
+//-----------------------------------------------------------------------
+
+/// Used to sort the vertices by position
+struct PositionSorter
+{
+    PositionSorter(const float* pPositions)
+    : pPositions(pPositions)
+    {
+    }
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        const float* pa = &pPositions[a * 3];
+        const float* pb = &pPositions[b * 3];
+
+        if (pa[0] != pb[0])
+            return pa[0] < pb[0];
+        if (pa[1] != pb[1])
+            return pa[1] < pb[1];
+        return pa[2] < pb[2];
+    }
+
+    const float* pPositions;
+};
+
+//-----------------------------------------------------------------------
+
+static void triangleNormal(const float* p0, const float* p1, const float* p2, float* normal)
+{
+    const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+MeshSimplifier::MeshSimplifier(const std::string& strMeshName, const std::string& strResourceGroup)
+: m_mesh(0)
+{
+    m_mesh = GraphicTools::loadReadableMesh(strMeshName, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshSimplifier::MeshSimplifier(const Ogre::MeshPtr& mesh)
+: m_mesh(mesh)
+{
+    assert(!m_mesh.isNull());
+}
+
+//-----------------------------------------------------------------------
+
+MeshSimplifier::~MeshSimplifier()
+{
+}
+
+
+/************************************** METHODS ****************************************/
+
+void MeshSimplifier::addLevel(Real value, Real ratio)
+{
+    assert((ratio > 0.0f) && (ratio < 1.0f));
+
+    tLevel level;
+    level.value = value;
+    level.ratio = ratio;
+
+    // Sort the levels from the most detailed to the least detailed one
+    std::vector<tLevel>::iterator iter = m_levels.begin();
+    while ((iter != m_levels.end()) && (iter->ratio >= ratio))
+        ++iter;
+
+    m_levels.insert(iter, level);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshSimplifier::clearLevels()
+{
+    m_levels.clear();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshSimplifier::generate(tThreshold threshold)
+{
+    assert(!m_levels.empty() && "You must call addLevel() before you call generate()");
+
+    const unsigned short nbLevels = (unsigned short) m_levels.size();
+
+    // Declare the levels
+    LodStrategy* pStrategy = (threshold == THRESHOLD_DISTANCE ?
+                                (LodStrategy*) Ogre::DistanceLodStrategy::getSingletonPtr() :
+                                (LodStrategy*) Ogre::PixelCountLodStrategy::getSingletonPtr());
+
+    m_mesh->removeLodLevels();
+    m_mesh->setLodStrategy(pStrategy);
+    m_mesh->_setLodInfo(nbLevels + 1, false);
+
+    m_report.resize(nbLevels);
+
+    for (unsigned short i = 0; i < nbLevels; ++i)
+    {
+        assert((i == 0) || (threshold != THRESHOLD_DISTANCE) || (m_levels[i].value > m_levels[i - 1].value));
+        assert((i == 0) || (threshold != THRESHOLD_PIXEL_COUNT) || (m_levels[i].value < m_levels[i - 1].value));
+
+        Ogre::MeshLodUsage usage;
+        usage.userValue = m_levels[i].value;
+        usage.value     = pStrategy->transformUserValue(m_levels[i].value);
+        usage.edgeData  = 0;
+
+        m_mesh->_setLodUsage(i + 1, usage);
+
+        m_report[i].value               = m_levels[i].value;
+        m_report[i].nbTriangles         = 0;
+        m_report[i].nbOriginalTriangles = 0;
+        m_report[i].reduction           = 0.0f;
+    }
+
+
+    // Simplify the submeshes
+    std::vector<float> sharedPositions;
+    std::vector<float> sharedNormals;
+    std::vector<int>   sharedBones;
+
+    for (unsigned short subIndex = 0; subIndex < m_mesh->getNumSubMeshes(); ++subIndex)
+    {
+        SubMesh* pSubMesh = m_mesh->getSubMesh(subIndex);
+
+        // Only the indexed triangle lists can be simplified, the others are used as-is
+        if ((pSubMesh->operationType != Ogre::RenderOperation::OT_TRIANGLE_LIST) ||
+            !pSubMesh->indexData || (pSubMesh->indexData->indexCount == 0))
+        {
+            for (unsigned short i = 0; i < nbLevels; ++i)
+            {
+                m_mesh->_setSubMeshLodFaceList(subIndex, i + 1, (pSubMesh->indexData ?
+                                                                 pSubMesh->indexData->clone() :
+                                                                 new IndexData()));
+            }
+
+            continue;
+        }
+
+        // Retrieve the vertices (only once for the shared ones)
+        std::vector<float>  positions;
+        std::vector<float>  normals;
+        std::vector<int>    bones;
+
+        std::vector<float>* pPositions  = &positions;
+        std::vector<float>* pNormals    = &normals;
+        std::vector<int>*   pBones      = &bones;
+
+        if (pSubMesh->useSharedVertices)
+        {
+            if (sharedPositions.empty())
+            {
+                readVertices(m_mesh->sharedVertexData, sharedPositions, sharedNormals);
+                sharedBones.assign(m_mesh->sharedVertexData->vertexCount, -1);
+            }
+
+            pPositions  = &sharedPositions;
+            pNormals    = &sharedNormals;
+            pBones      = &sharedBones;
+        }
+        else
+        {
+            readVertices(pSubMesh->vertexData, positions, normals);
+            bones.assign(pSubMesh->vertexData->vertexCount, -1);
+        }
+
+        // Retrieve the most influential bone of each vertex
+        const Ogre::Mesh::VertexBoneAssignmentList& assignments = (pSubMesh->useSharedVertices ?
+                                                                   m_mesh->getBoneAssignments() :
+                                                                   pSubMesh->getBoneAssignments());
+
+        std::vector<Real> weights(pBones->size(), 0.0f);
+
+        Ogre::Mesh::VertexBoneAssignmentList::const_iterator iterBone, iterBoneEnd;
+        for (iterBone = assignments.begin(), iterBoneEnd = assignments.end(); iterBone != iterBoneEnd; ++iterBone)
+        {
+            const Ogre::VertexBoneAssignment& assignment = iterBone->second;
+
+            if ((assignment.vertexIndex < pBones->size()) && (assignment.weight > weights[assignment.vertexIndex]))
+            {
+                weights[assignment.vertexIndex] = assignment.weight;
+                (*pBones)[assignment.vertexIndex] = assignment.boneIndex;
+            }
+        }
+
+        // The meshes using hardware skinning streams have no bone assignments
+        if (assignments.empty())
+        {
+            if (pSubMesh->useSharedVertices)
+                readBones(m_mesh->sharedVertexData, m_mesh->sharedBlendIndexToBoneIndexMap, *pBones);
+            else
+                readBones(pSubMesh->vertexData, pSubMesh->blendIndexToBoneIndexMap, *pBones);
+        }
+
+        // Generate the levels, each one from the previous one
+        std::vector<unsigned int> indices;
+        GraphicTools::readIndices(pSubMesh->indexData, indices);
+
+        const unsigned int nbOriginalIndices = indices.size();
+        const HardwareIndexBuffer::IndexType indexType = pSubMesh->indexData->indexBuffer->getType();
+
+        for (unsigned short i = 0; i < nbLevels; ++i)
+        {
+            const unsigned int nbTargetIndices = (unsigned int) (nbOriginalIndices / 3 * m_levels[i].ratio) * 3;
+
+            simplify(&(*pPositions)[0], (pNormals->empty() ? 0 : &(*pNormals)[0]), &(*pBones)[0],
+                     pPositions->size() / 3, indices, nbTargetIndices);
+
+            m_mesh->_setSubMeshLodFaceList(subIndex, i + 1, createIndexData(indices, indexType));
+
+            m_report[i].nbTriangles += indices.size() / 3;
+            m_report[i].nbOriginalTriangles += nbOriginalIndices / 3;
+        }
+    }
+
+    for (unsigned short i = 0; i < nbLevels; ++i)
+    {
+        if (m_report[i].nbOriginalTriangles > 0)
+            m_report[i].reduction = 1.0f - Real(m_report[i].nbTriangles) / m_report[i].nbOriginalTriangles;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshSimplifier::simplify(const float* pPositions, const float* pNormals, const int* pBones,
+                              unsigned int nbVertices, std::vector<unsigned int>& indices,
+                              unsigned int nbTargetIndices)
+{
+    assert(pPositions || (nbVertices == 0));
+    assert((indices.size() % 3 == 0) && "Only triangle lists are supported");
+
+    if (indices.size() <= nbTargetIndices)
+        return;
+
+
+    // Group the vertices by position, to detect the seams
+    std::vector<unsigned int> sorted(nbVertices);
+    std::vector<unsigned int> groups(nbVertices);
+    std::vector<unsigned int> groupSizes(nbVertices, 0);
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        sorted[v] = v;
+
+    std::sort(sorted.begin(), sorted.end(), PositionSorter(pPositions));
+
+    for (unsigned int i = 0; i < nbVertices; ++i)
+    {
+        const unsigned int v = sorted[i];
+
+        if ((i > 0) && (memcmp(&pPositions[v * 3], &pPositions[sorted[i - 1] * 3], 3 * sizeof(float)) == 0))
+            groups[v] = groups[sorted[i - 1]];
+        else
+            groups[v] = v;
+
+        ++groupSizes[groups[v]];
+    }
+
+
+    // Detect the borders (edges used by only one triangle)
+    std::vector<std::pair<unsigned int, unsigned int> > edges;
+    edges.reserve(indices.size());
+
+    for (unsigned int i = 0; i < indices.size(); i += 3)
+    {
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            const unsigned int a = groups[indices[i + j]];
+            const unsigned int b = groups[indices[i + (j + 1) % 3]];
+
+            edges.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<char> borders(nbVertices, 0);
+
+    for (unsigned int i = 0; i < edges.size(); )
+    {
+        unsigned int j = i + 1;
+        while ((j < edges.size()) && (edges[j] == edges[i]))
+            ++j;
+
+        if (j - i == 1)
+        {
+            borders[edges[i].first] = 1;
+            borders[edges[i].second] = 1;
+        }
+
+        i = j;
+    }
+
+    // The vertices on the seams and on the borders can't be removed
+    std::vector<char> locked(nbVertices, 0);
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        locked[v] = ((groupSizes[groups[v]] > 1) || borders[groups[v]]);
+
+
+    // Compute the quadric of each vertex, from the planes of its triangles (weighted
+    // by their area)
+    std::vector<Quadric> quadrics(nbVertices);
+
+    for (unsigned int i = 0; i < indices.size(); i += 3)
+    {
+        const float* p0 = &pPositions[indices[i] * 3];
+
+        float normal[3];
+        triangleNormal(p0, &pPositions[indices[i + 1] * 3], &pPositions[indices[i + 2] * 3], normal);
+
+        const double length = sqrt(double(normal[0]) * normal[0] + double(normal[1]) * normal[1] +
+                                   double(normal[2]) * normal[2]);
+        if (length <= 0.0)
+            continue;
+
+        const double a = normal[0] / length;
+        const double b = normal[1] / length;
+        const double c = normal[2] / length;
+        const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+
+        const Quadric quadric(a, b, c, d, length * 0.5);
+
+        quadrics[indices[i]] += quadric;
+        quadrics[indices[i + 1]] += quadric;
+        quadrics[indices[i + 2]] += quadric;
+    }
+
+
+    // Collapse the cheapest edges, in several passes. In each pass, a vertex is only
+    // involved in one collapse, so the costs stay valid.
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> adjacency;
+    std::vector<unsigned int> remap(nbVertices);
+    std::vector<char> touched(nbVertices);
+    std::vector<Collapse> collapses;
+
+    while (indices.size() > nbTargetIndices)
+    {
+        const unsigned int nbTriangles = indices.size() / 3;
+
+        // Build the list of the triangles using each vertex
+        offsets.assign(nbVertices + 1, 0);
+        adjacency.resize(indices.size());
+
+        for (unsigned int i = 0; i < indices.size(); ++i)
+            ++offsets[indices[i] + 1];
+
+        for (unsigned int v = 0; v < nbVertices; ++v)
+            offsets[v + 1] += offsets[v];
+
+        std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+        for (unsigned int i = 0; i < indices.size(); ++i)
+            adjacency[cursors[indices[i]]++] = i / 3;
+
+        // List the possible collapses
+        collapses.clear();
+
+        for (unsigned int t = 0; t < nbTriangles; ++t)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                const unsigned int a = indices[t * 3 + j];
+                const unsigned int b = indices[t * 3 + (j + 1) % 3];
+
+                if (pBones && (pBones[a] != pBones[b]))
+                    continue;
+
+                const unsigned int ends[2][2] = { { a, b }, { b, a } };
+
+                for (unsigned int k = 0; k < 2; ++k)
+                {
+                    const unsigned int from = ends[k][0];
+                    const unsigned int to   = ends[k][1];
+
+                    if (locked[from])
+                        continue;
+
+                    Quadric quadric = quadrics[from];
+                    quadric += quadrics[to];
+
+                    Collapse collapse;
+                    collapse.from   = from;
+                    collapse.to     = to;
+                    collapse.cost   = quadric.evaluate(&pPositions[to * 3]);
+
+                    // Penalize the collapses between vertices with different normals
+                    if (pNormals)
+                    {
+                        const float* n1 = &pNormals[from * 3];
+                        const float* n2 = &pNormals[to * 3];
+                        const float* p1 = &pPositions[from * 3];
+                        const float* p2 = &pPositions[to * 3];
+
+                        const double dot = n1[0] * n2[0] + n1[1] * n2[1] + n1[2] * n2[2];
+                        const double length2 = (p1[0] - p2[0]) * (p1[0] - p2[0]) + (p1[1] - p2[1]) * (p1[1] - p2[1]) +
+                                               (p1[2] - p2[2]) * (p1[2] - p2[2]);
+
+                        collapse.cost += (1.0 - dot) * length2;
+                    }
+
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end());
+
+        // Apply the collapses
+        const unsigned int nbTrianglesToRemove = (indices.size() - nbTargetIndices) / 3;
+        unsigned int nbRemovedTriangles = 0;
+        unsigned int nbCollapses = 0;
+
+        for (unsigned int v = 0; v < nbVertices; ++v)
+            remap[v] = v;
+
+        touched.assign(nbVertices, 0);
+
+        for (unsigned int i = 0; (i < collapses.size()) && (nbRemovedTriangles < nbTrianglesToRemove); ++i)
+        {
+            const Collapse& collapse = collapses[i];
+
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Reject the collapses that would flip a triangle
+            bool bFlip = false;
+            unsigned int nbRemoved = 0;
+
+            for (unsigned int j = offsets[collapse.from]; (j < offsets[collapse.from + 1]) && !bFlip; ++j)
+            {
+                const unsigned int* pTriangle = &indices[adjacency[j] * 3];
+
+                if ((pTriangle[0] == collapse.to) || (pTriangle[1] == collapse.to) || (pTriangle[2] == collapse.to))
+                {
+                    ++nbRemoved;
+                    continue;
+                }
+
+                const float* p[3];
+                const float* q[3];
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    p[k] = &pPositions[pTriangle[k] * 3];
+                    q[k] = &pPositions[(pTriangle[k] == collapse.from ? collapse.to : pTriangle[k]) * 3];
+                }
+
+                float before[3], after[3];
+                triangleNormal(p[0], p[1], p[2], before);
+                triangleNormal(q[0], q[1], q[2], after);
+
+                bFlip = (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0f);
+            }
+
+            if (bFlip)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+
+            // The triangles around the removed vertex change: their vertices can't be
+            // involved in another collapse during this pass
+            for (unsigned int j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j)
+            {
+                const unsigned int* pTriangle = &indices[adjacency[j] * 3];
+                touched[pTriangle[0]] = 1;
+                touched[pTriangle[1]] = 1;
+                touched[pTriangle[2]] = 1;
+            }
+
+            nbRemovedTriangles += nbRemoved;
+            ++nbCollapses;
+        }
+
+        if (nbCollapses == 0)
+            break;
+
+        // Remap the indices and remove the degenerated triangles
+        unsigned int nbIndices = 0;
+
+        for (unsigned int i = 0; i < indices.size(); i += 3)
+        {
+            const unsigned int a = remap[indices[i]];
+            const unsigned int b = remap[indices[i + 1]];
+            const unsigned int c = remap[indices[i + 2]];
+
+            if ((a != b) && (b != c) && (a != c))
+            {
+                indices[nbIndices++] = a;
+                indices[nbIndices++] = b;
+                indices[nbIndices++] = c;
+            }
+        }
+
+        indices.resize(nbIndices);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshSimplifier::readVertices(VertexData* pVertexData, std::vector<float>& positions,
+                                  std::vector<float>& normals)
+{
+    assert(pVertexData);
+
+    const VertexElement* pPositionElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
+    const VertexElement* pNormalElement   = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_NORMAL);
+
+    // The compact vertices (see MeshBuilder and MeshConverter) are decoded. The scale of
+    // the quantized positions isn't stored in the mesh, but the simplification doesn't
+    // depend on the size of the mesh: they are decoded with a scale of 1.
+    VertexCompression::tFormat formats[2];
+
+    assert(pPositionElement);
+
+    const bool bValidPositions = VertexCompression::getVectorFormat(pPositionElement->getType(), formats[0]) &&
+                                 ((formats[0] == VertexCompression::FORMAT_FLOAT) ||
+                                  (formats[0] == VertexCompression::FORMAT_SHORT));
+    assert(bValidPositions && "Unsupported type of vertex positions");
+
+    if (pNormalElement && (!VertexCompression::getVectorFormat(pNormalElement->getType(), formats[1]) ||
+                           (formats[1] == VertexCompression::FORMAT_SHORT)))
+    {
+        pNormalElement = 0;
+    }
+
+    positions.resize(pVertexData->vertexCount * 3);
+
+    if (pNormalElement)
+        normals.resize(pVertexData->vertexCount * 3);
+
+    const VertexElement* elements[2] = { pPositionElement, pNormalElement };
+    std::vector<float>* destinations[2] = { &positions, &normals };
+
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        if (!elements[i])
+            continue;
+
+        HardwareVertexBufferSharedPtr buffer = pVertexData->vertexBufferBinding->getBuffer(elements[i]->getSource());
+
+        const unsigned char* pSource = static_cast<const unsigned char*>(buffer->lock(HardwareBuffer::HBL_READ_ONLY)) +
+                                       pVertexData->vertexStart * buffer->getVertexSize() + elements[i]->getOffset();
+
+        for (unsigned int v = 0; v < pVertexData->vertexCount; ++v, pSource += buffer->getVertexSize())
+            VertexCompression::decode(formats[i], pSource, 3, 1.0f, &(*destinations[i])[v * 3]);
+
+        buffer->unlock();
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void MeshSimplifier::readBones(VertexData* pVertexData, const Ogre::Mesh::IndexMap& palette,
+                               std::vector<int>& bones)
+{
+    assert(pVertexData);
+
+    const VertexElement* pIndicesElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_BLEND_INDICES);
+    const VertexElement* pWeightsElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_BLEND_WEIGHTS);
+
+    if (!pIndicesElement || !pWeightsElement || (pIndicesElement->getType() != Ogre::VET_UBYTE4) ||
+        (pWeightsElement->getType() < Ogre::VET_FLOAT1) || (pWeightsElement->getType() > Ogre::VET_FLOAT4))
+    {
+        return;
+    }
+
+    const unsigned short nbWeights = VertexElement::getTypeCount(pWeightsElement->getType());
+
+    HardwareVertexBufferSharedPtr indicesBuffer = pVertexData->vertexBufferBinding->getBuffer(pIndicesElement->getSource());
+    HardwareVertexBufferSharedPtr weightsBuffer = pVertexData->vertexBufferBinding->getBuffer(pWeightsElement->getSource());
+
+    const unsigned char* pIndicesData = static_cast<const unsigned char*>(indicesBuffer->lock(HardwareBuffer::HBL_READ_ONLY)) +
+                                        pVertexData->vertexStart * indicesBuffer->getVertexSize();
+
+    // Both elements are usually in the same buffer, which must only be locked once
+    const unsigned char* pWeightsData = pIndicesData;
+    if (weightsBuffer.get() != indicesBuffer.get())
+    {
+        pWeightsData = static_cast<const unsigned char*>(weightsBuffer->lock(HardwareBuffer::HBL_READ_ONLY)) +
+                       pVertexData->vertexStart * weightsBuffer->getVertexSize();
+    }
+
+    const unsigned char* pIndices = pIndicesData + pIndicesElement->getOffset();
+    const unsigned char* pWeights = pWeightsData + pWeightsElement->getOffset();
+
+    // Keep the most influential bone of each vertex
+    for (unsigned int v = 0; v < std::min((size_t) pVertexData->vertexCount, bones.size()); ++v)
+    {
+        float weights[4];
+        memcpy(weights, pWeights, nbWeights * sizeof(float));
+
+        float maxWeight = 0.0f;
+        for (unsigned short i = 0; i < nbWeights; ++i)
+        {
+            if ((weights[i] > maxWeight) && (pIndices[i] < palette.size()))
+            {
+                maxWeight = weights[i];
+                bones[v] = palette[pIndices[i]];
+            }
+        }
+
+        pIndices += indicesBuffer->getVertexSize();
+        pWeights += weightsBuffer->getVertexSize();
+    }
+
+    indicesBuffer->unlock();
+
+    if (weightsBuffer.get() != indicesBuffer.get())
+        weightsBuffer->unlock();
+}
+
+//-----------------------------------------------------------------------
+
+IndexData* MeshSimplifier::createIndexData(const std::vector<unsigned int>& indices,
+                                           HardwareIndexBuffer::IndexType type)
+{
+    IndexData* pIndexData = new IndexData();
+    pIndexData->indexStart = 0;
+    pIndexData->indexCount = indices.size();
+
+    if (indices.empty())
+        return pIndexData;
+
+    pIndexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+                                        type, indices.size(), HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+
+    if (type == HardwareIndexBuffer::IT_32BIT)
+    {
+        pIndexData->indexBuffer->writeData(0, indices.size() * sizeof(unsigned int), &indices[0], true);
+    }
+    else
+    {
+        std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+        pIndexData->indexBuffer->writeData(0, shortIndices.size() * sizeof(unsigned short), &shortIndices[0], true);
+    }
+
+    return pIndexData;
+}
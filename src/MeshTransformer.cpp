@@ -6,15 +6,29 @@
 
 // Athena's includes
 #include <Athena-Graphics/MeshTransformer.h>
+#include <Athena-Graphics/GraphicTools.h>
 #include <Athena-Graphics/Conversions.h>
 
 // Ogre's includes
-#include <Ogre/OgreMeshManager.h>
 #include <Ogre/OgreBone.h>
 #include <Ogre/OgreHardwareBufferManager.h>
 #include <Ogre/OgreMesh.h>
 #include <Ogre/OgreSkeleton.h>
 #include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreAnimation.h>
+#include <Ogre/OgreAnimationTrack.h>
+#include <Ogre/OgreKeyFrame.h>
+#include <Ogre/OgrePose.h>
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+    #define ATHENA_GRAPHICS_TRANSFORMER_SSE
+    #include <xmmintrin.h>
+#endif
 
 
 using namespace Athena;
@@ -24,30 +38,184 @@ using namespace std;
 
 using Ogre::Bone;
 using Ogre::Mesh;
-using Ogre::MeshManager;
 using Ogre::Node;
 using Ogre::Skeleton;
 using Ogre::SkeletonPtr;
 using Ogre::SubMesh;
 using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareIndexBufferSharedPtr;
 using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::IndexData;
+using Ogre::VertexData;
+using Ogre::VertexDeclaration;
+using Ogre::VertexBufferBinding;
 using Ogre::VertexElement;
 
 
+/************************************** CONSTANTS **************************************/
+
+/// Maximum number of vertices of a buffer transformed by one task (the tasks are
+/// distributed among the threads when ATHENA_GRAPHICS_THREADING is enabled)
+static const unsigned int VERTICES_PER_TASK = 16384;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Transform some positions (3 floats each) in place with an affine transformation,
+/// and accumulate their bounds (if pBounds isn't 0)
+static void transformPositionsKernel(unsigned char* pData, unsigned int nbVertices, size_t stride,
+                                     const Ogre::Matrix4& m, MeshTransformer::tBoundsAccumulator* pBounds)
+{
+    if (nbVertices == 0)
+        return;
+
+#ifdef ATHENA_GRAPHICS_TRANSFORMER_SSE
+    // The columns of the matrix: each position is computed as x * c0 + y * c1 + z * c2 + c3
+    const __m128 c0 = _mm_setr_ps(m[0][0], m[1][0], m[2][0], 0.0f);
+    const __m128 c1 = _mm_setr_ps(m[0][1], m[1][1], m[2][1], 0.0f);
+    const __m128 c2 = _mm_setr_ps(m[0][2], m[1][2], m[2][2], 0.0f);
+    const __m128 c3 = _mm_setr_ps(m[0][3], m[1][3], m[2][3], 0.0f);
+
+    __m128 minimum = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 maximum = _mm_set1_ps(-std::numeric_limits<float>::max());
+    __m128 radius2 = _mm_setzero_ps();
+
+    for (unsigned int i = 0; i < nbVertices; ++i, pData += stride)
+    {
+        float* p = reinterpret_cast<float*>(pData);
+
+        const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), c0),
+                                               _mm_mul_ps(_mm_set1_ps(p[1]), c1)),
+                                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[2]), c2), c3));
+
+        // Only 3 floats are written: the element can be the last one of the buffer
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), r);
+        _mm_store_ss(p + 2, _mm_movehl_ps(r, r));
+
+        minimum = _mm_min_ps(minimum, r);
+        maximum = _mm_max_ps(maximum, r);
+
+        // Squared distance to the origin (the last lane is always 0)
+        __m128 sq = _mm_mul_ps(r, r);
+        sq = _mm_add_ps(sq, _mm_movehl_ps(sq, sq));
+        sq = _mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1)));
+        radius2 = _mm_max_ss(radius2, sq);
+    }
+
+    if (!pBounds)
+        return;
+
+    float lanes[4];
+
+    _mm_storeu_ps(lanes, minimum);
+    for (unsigned int j = 0; j < 3; ++j)
+        pBounds->minimum[j] = std::min(pBounds->minimum[j], lanes[j]);
+
+    _mm_storeu_ps(lanes, maximum);
+    for (unsigned int j = 0; j < 3; ++j)
+        pBounds->maximum[j] = std::max(pBounds->maximum[j], lanes[j]);
+
+    _mm_store_ss(lanes, radius2);
+    pBounds->radius2 = std::max(pBounds->radius2, lanes[0]);
+#else
+    for (unsigned int i = 0; i < nbVertices; ++i, pData += stride)
+    {
+        float* p = reinterpret_cast<float*>(pData);
+
+        const float x = p[0];
+        const float y = p[1];
+        const float z = p[2];
+
+        for (unsigned int j = 0; j < 3; ++j)
+            p[j] = m[j][0] * x + m[j][1] * y + m[j][2] * z + m[j][3];
+
+        if (!pBounds)
+            continue;
+
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            pBounds->minimum[j] = std::min(pBounds->minimum[j], p[j]);
+            pBounds->maximum[j] = std::max(pBounds->maximum[j], p[j]);
+        }
+
+        pBounds->radius2 = std::max(pBounds->radius2, p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    }
+#endif
+
+    if (pBounds)
+        pBounds->bEmpty = false;
+}
+
+//-----------------------------------------------------------------------
+
+/// Transform some directions (the first 3 floats of each element) in place with a
+/// linear transformation, normalising them if needed
+static void transformDirectionsKernel(unsigned char* pData, unsigned int nbVertices, size_t stride,
+                                      const Ogre::Matrix3& m, bool bNormalise)
+{
+#ifdef ATHENA_GRAPHICS_TRANSFORMER_SSE
+    const __m128 c0 = _mm_setr_ps(m[0][0], m[1][0], m[2][0], 0.0f);
+    const __m128 c1 = _mm_setr_ps(m[0][1], m[1][1], m[2][1], 0.0f);
+    const __m128 c2 = _mm_setr_ps(m[0][2], m[1][2], m[2][2], 0.0f);
+
+    for (unsigned int i = 0; i < nbVertices; ++i, pData += stride)
+    {
+        float* p = reinterpret_cast<float*>(pData);
+
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), c0),
+                                         _mm_mul_ps(_mm_set1_ps(p[1]), c1)),
+                              _mm_mul_ps(_mm_set1_ps(p[2]), c2));
+
+        if (bNormalise)
+        {
+            __m128 sq = _mm_mul_ps(r, r);
+            sq = _mm_add_ps(sq, _mm_movehl_ps(sq, sq));
+            sq = _mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1)));
+
+            float length2;
+            _mm_store_ss(&length2, sq);
+
+            if (length2 > 0.0f)
+                r = _mm_mul_ps(r, _mm_set1_ps(1.0f / sqrtf(length2)));
+        }
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), r);
+        _mm_store_ss(p + 2, _mm_movehl_ps(r, r));
+    }
+#else
+    for (unsigned int i = 0; i < nbVertices; ++i, pData += stride)
+    {
+        float* p = reinterpret_cast<float*>(pData);
+
+        Ogre::Vector3 direction = m * Ogre::Vector3(p[0], p[1], p[2]);
+
+        if (bNormalise)
+            direction.normalise();
+
+        p[0] = direction.x;
+        p[1] = direction.y;
+        p[2] = direction.z;
+    }
+#endif
+}
+
+
 /***************************** CONSTRUCTION / DESTRUCTION ******************************/
 
 MeshTransformer::MeshTransformer(const std::string& strMeshName,
-                                 const std::string& strResourceGroup)
-: m_mesh(0)
+                                 const std::string& strResourceGroup, bool bDeferred)
+: m_mesh(0), m_bDeferred(bDeferred), m_pendingTransform(Ogre::Matrix4::IDENTITY)
 {
-    m_mesh = MeshManager::getSingletonPtr()->load(strMeshName, strResourceGroup, HardwareBuffer::HBU_DYNAMIC);
-    assert(!m_mesh.isNull());
+    // With shadowed buffers, the transformations are done in system memory, and only
+    // uploaded when the buffers are unlocked
+    m_mesh = GraphicTools::loadReadableMesh(strMeshName, strResourceGroup);
 }
 
 //-----------------------------------------------------------------------
 
-MeshTransformer::MeshTransformer(const Ogre::MeshPtr& mesh)
-: m_mesh(mesh)
+MeshTransformer::MeshTransformer(const Ogre::MeshPtr& mesh, bool bDeferred)
+: m_mesh(mesh), m_bDeferred(bDeferred), m_pendingTransform(Ogre::Matrix4::IDENTITY)
 {
     assert(!m_mesh.isNull());
 }
@@ -56,6 +224,7 @@ MeshTransformer::MeshTransformer(const Ogre::MeshPtr& mesh)
 
 MeshTransformer::~MeshTransformer()
 {
+    assert((m_pendingTransform == Ogre::Matrix4::IDENTITY) && "You must call commit() before destroying a deferred transformer");
 }
 
 
@@ -83,238 +252,451 @@ void MeshTransformer::scale(Real x, Real y, Real z)
 
 void MeshTransformer::scale(const Vector3& scale)
 {
-    // Process the shared vertex data (if any)
+    Ogre::Matrix4 transform = Ogre::Matrix4::IDENTITY;
+    transform.setScale(toOgre(scale));
+
+    applyTransform(transform);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::translateOrigin(Real x, Real y, Real z)
+{
+    translateOrigin(Vector3(x, y, z));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::translateOrigin(const Vector3& d)
+{
+    Ogre::Matrix4 transform = Ogre::Matrix4::IDENTITY;
+    transform.setTrans(toOgre(d));
+
+    applyTransform(transform);
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::rotate(const Quaternion& q)
+{
+    Ogre::Matrix3 rotation;
+    toOgre(q).ToRotationMatrix(rotation);
+
+    applyTransform(Ogre::Matrix4(rotation));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::rotate(const Vector3& axis, const Radian& angle)
+{
+    rotate(Quaternion(angle, axis));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::transform(const Math::Matrix4& transform)
+{
+    applyTransform(toOgre(transform));
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::applyTransform(const Ogre::Matrix4& transform)
+{
+    assert(transform.isAffine());
+
+    // The transformation is applied after the ones accumulated before
+    m_pendingTransform = transform * m_pendingTransform;
+
+    if (!m_bDeferred)
+        commit();
+}
+
+//-----------------------------------------------------------------------
+
+void MeshTransformer::commit()
+{
+    if (m_pendingTransform == Ogre::Matrix4::IDENTITY)
+        return;
+
+    const Ogre::Matrix4 transform = m_pendingTransform;
+    m_pendingTransform = Ogre::Matrix4::IDENTITY;
+
+    // The normals are transformed by the inverse transpose of the transformation, the
+    // tangents and binormals by the transformation itself (a pure translation doesn't
+    // modify them)
+    Ogre::Matrix3 tangentsTransform;
+    transform.extract3x3Matrix(tangentsTransform);
+
+    const Ogre::Matrix3 normalsTransform = getNormalMatrix(transform);
+    const bool bDirections = (tangentsTransform != Ogre::Matrix3::IDENTITY);
+
+    // Collect the vertex buffers used by the mesh: a buffer bound by several vertex
+    // data is only transformed once
+    tBufferJobsList jobs;
+
     if (m_mesh->sharedVertexData)
-        this->scale(m_mesh->sharedVertexData, scale);
+        collectBuffers(m_mesh->sharedVertexData, bDirections, jobs);
 
-    // Process the submeshes' vertex data
     Mesh::SubMeshIterator iter = m_mesh->getSubMeshIterator();
     while (iter.hasMoreElements())
     {
         SubMesh* pSubMesh = iter.getNext();
 
-        if (pSubMesh->vertexData)
-            this->scale(pSubMesh->vertexData, scale);
+        if (!pSubMesh->useSharedVertices && pSubMesh->vertexData)
+            collectBuffers(pSubMesh->vertexData, bDirections, jobs);
     }
 
-    // Update the bounding informations
-    AxisAlignedBox aabb(fromOgre(m_mesh->getBounds()));
-    aabb.scale(scale);
-    m_mesh->_setBounds(toOgre(aabb));
-    m_mesh->_setBoundingSphereRadius(m_mesh->getBoundingSphereRadius() * std::max(scale.x, std::max(scale.y, scale.z)));
+    tBoundsAccumulator bounds;
+    transformBuffers(jobs, transform, normalsTransform, tangentsTransform, bounds);
 
-    SkeletonPtr pSkeleton = m_mesh->getSkeleton();
-    if (!pSkeleton.isNull())
+    // Update the bounding informations, with the ones of the transformed positions
+    if (bounds.bEmpty)
     {
-        pSkeleton->reset();
-
-        Skeleton::BoneIterator iter = pSkeleton->getBoneIterator();
-        Ogre::Vector3 ogreScale = toOgre(scale);
-        while (iter.hasMoreElements())
-        {
-            Bone* pBone = iter.getNext();
-            pBone->setPosition(pBone->getPosition() * ogreScale);
-            pBone->_update(false, false);
-        }
-
-        pSkeleton->setBindingPose();
+        m_mesh->_setBounds(Ogre::AxisAlignedBox::BOX_NULL);
+        m_mesh->_setBoundingSphereRadius(0.0f);
+    }
+    else
+    {
+        m_mesh->_setBounds(Ogre::AxisAlignedBox(bounds.minimum[0], bounds.minimum[1], bounds.minimum[2],
+                                                bounds.maximum[0], bounds.maximum[1], bounds.maximum[2]));
+        m_mesh->_setBoundingSphereRadius(sqrtf(bounds.radius2));
     }
+
+    transformSkeleton(transform);
+    transformVertexAnimations(transform);
 }
 
 //-----------------------------------------------------------------------
 
-void MeshTransformer::scale(Ogre::VertexData* pVertexData, const Vector3& scale)
+void MeshTransformer::collectBuffers(Ogre::VertexData* pVertexData, bool bDirections,
+                                     tBufferJobsList& jobs)
 {
-    // Retrieve the declaration of the interesting elements of the vertices
-    const VertexElement* pPositionVertexElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
-    const VertexElement* pNormalVertexElement   = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_NORMAL);
-    const VertexElement* pTangentVertexElement  = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_TANGENT);
-    const VertexElement* pBinormalVertexElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_BINORMAL);
-
-    // Retrieve the buffer that contains the interesting elements
-    HardwareVertexBufferSharedPtr bufferPositions =
-        pVertexData->vertexBufferBinding->getBuffer(pPositionVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferNormals = !pNormalVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pNormalVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferTangents = !pTangentVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pTangentVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferBinormals = !pBinormalVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pBinormalVertexElement->getSource());
-
-    // Update the elements of each vertex
-    float buffer[3];
-    size_t offsetPosition   = pVertexData->vertexStart * bufferPositions->getVertexSize() + pPositionVertexElement->getOffset();
-    size_t offsetNormal     = !pNormalVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferNormals->getVertexSize() + pNormalVertexElement->getOffset();
-    size_t offsetTangent    = !pTangentVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferTangents->getVertexSize() + pTangentVertexElement->getOffset();
-    size_t offsetBinormal   = !pBinormalVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferBinormals->getVertexSize() + pBinormalVertexElement->getOffset();
-    for (unsigned int i = 0; i < pVertexData->vertexCount; ++i)
+    if (pVertexData->vertexCount == 0)
+        return;
+
+    const VertexBufferBinding::VertexBufferBindingMap& bindings = pVertexData->vertexBufferBinding->getBindings();
+
+    VertexBufferBinding::VertexBufferBindingMap::const_iterator iter, iterEnd;
+    for (iter = bindings.begin(), iterEnd = bindings.end(); iter != iterEnd; ++iter)
     {
-        // Position
-        bufferPositions->readData(offsetPosition, pPositionVertexElement->getSize(), &buffer);
+        VertexDeclaration::VertexElementList elements = pVertexData->vertexDeclaration->findElementsBySource(iter->first);
 
-        Vector3 pos = scale * Vector3(buffer);
+        std::set<size_t> positions;
+        std::set<size_t> normals;
+        std::set<size_t> tangents;
+
+        VertexDeclaration::VertexElementList::const_iterator iterElement, iterElementEnd;
+        for (iterElement = elements.begin(), iterElementEnd = elements.end(); iterElement != iterElementEnd; ++iterElement)
+        {
+            const Ogre::VertexElementSemantic semantic = iterElement->getSemantic();
+
+            if ((semantic == Ogre::VES_POSITION) && (iterElement->getIndex() == 0))
+                positions.insert(iterElement->getOffset());
+            else if (bDirections && (semantic == Ogre::VES_NORMAL))
+                normals.insert(iterElement->getOffset());
+            else if (bDirections && ((semantic == Ogre::VES_TANGENT) || (semantic == Ogre::VES_BINORMAL)))
+                tangents.insert(iterElement->getOffset());
+            else
+                continue;
+
+            assert((VertexElement::getBaseType(iterElement->getType()) == Ogre::VET_FLOAT1) &&
+                   (VertexElement::getTypeCount(iterElement->getType()) >= 3) &&
+                   "Only the attributes made of (at least) 3 floats can be transformed");
+        }
 
-        buffer[0] = pos.x;
-        buffer[1] = pos.y;
-        buffer[2] = pos.z;
+        if (positions.empty() && normals.empty() && tangents.empty())
+            continue;
 
-        bufferPositions->writeData(offsetPosition, pPositionVertexElement->getSize(), &buffer);
+        assert(GraphicTools::isReadable(iter->second.get()) && "The vertex buffers of the mesh must be readable");
 
-        offsetPosition += bufferPositions->getVertexSize();
+        tBufferJob& job = jobs[iter->second.get()];
 
+        job.buffer = iter->second;
+        job.ranges.push_back(std::make_pair(pVertexData->vertexStart, pVertexData->vertexCount));
+        job.positions.insert(positions.begin(), positions.end());
+        job.normals.insert(normals.begin(), normals.end());
+        job.tangents.insert(tangents.begin(), tangents.end());
+    }
+}
 
-        // Normal
-        if (pNormalVertexElement)
-        {
-            bufferNormals->readData(offsetNormal, pNormalVertexElement->getSize(), &buffer);
+//-----------------------------------------------------------------------
 
-            Vector3 normal = scale * Vector3(buffer);
-            normal.normalise();
+void MeshTransformer::transformBuffers(tBufferJobsList& jobs, const Ogre::Matrix4& transform,
+                                       const Ogre::Matrix3& normalsTransform,
+                                       const Ogre::Matrix3& tangentsTransform,
+                                       tBoundsAccumulator& bounds)
+{
+    // Lock each buffer once (from this thread, Ogre doesn't support concurrent locks),
+    // and split its ranges of vertices into tasks
+    std::vector<tTask> tasks;
 
-            buffer[0] = normal.x;
-            buffer[1] = normal.y;
-            buffer[2] = normal.z;
+    tBufferJobsList::iterator iter, iterEnd;
+    for (iter = jobs.begin(), iterEnd = jobs.end(); iter != iterEnd; ++iter)
+    {
+        tBufferJob& job = iter->second;
 
-            bufferNormals->writeData(offsetNormal, pNormalVertexElement->getSize(), &buffer);
+        // Merge the overlapping ranges, so no vertex is transformed twice
+        std::sort(job.ranges.begin(), job.ranges.end());
 
-            offsetNormal += bufferNormals->getVertexSize();
+        std::vector<std::pair<size_t, size_t> > ranges;
+        std::vector<std::pair<size_t, size_t> >::const_iterator iterRange, iterRangeEnd;
+        for (iterRange = job.ranges.begin(), iterRangeEnd = job.ranges.end(); iterRange != iterRangeEnd; ++iterRange)
+        {
+            if (!ranges.empty() && (iterRange->first <= ranges.back().first + ranges.back().second))
+            {
+                ranges.back().second = std::max(ranges.back().second,
+                                                iterRange->first + iterRange->second - ranges.back().first);
+            }
+            else
+            {
+                ranges.push_back(*iterRange);
+            }
         }
 
+        const size_t stride = job.buffer->getVertexSize();
+        const size_t firstVertex = ranges.front().first;
+        const size_t nbVertices = ranges.back().first + ranges.back().second - firstVertex;
 
-        // Tangent
-        if (pTangentVertexElement)
+        unsigned char* pData = static_cast<unsigned char*>(
+                job.buffer->lock(firstVertex * stride, nbVertices * stride, HardwareBuffer::HBL_NORMAL));
+
+        for (iterRange = ranges.begin(), iterRangeEnd = ranges.end(); iterRange != iterRangeEnd; ++iterRange)
         {
-            bufferTangents->readData(offsetTangent, pTangentVertexElement->getSize(), &buffer);
+            for (size_t start = 0; start < iterRange->second; start += VERTICES_PER_TASK)
+            {
+                tTask task;
+                task.pJob       = &job;
+                task.pData      = pData + (iterRange->first - firstVertex + start) * stride;
+                task.nbVertices = (unsigned int) std::min((size_t) VERTICES_PER_TASK, iterRange->second - start);
+
+                tasks.push_back(task);
+            }
+        }
+    }
 
-            Vector3 tangent = scale * Vector3(buffer);
-            tangent.normalise();
+    // Transform the vertices, each task accumulating its own bounds
+    std::vector<tBoundsAccumulator> tasksBounds(tasks.size());
+    const int nbTasks = (int) tasks.size();
 
-            buffer[0] = tangent.x;
-            buffer[1] = tangent.y;
-            buffer[2] = tangent.z;
+#if ATHENA_GRAPHICS_THREADING
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < nbTasks; ++i)
+    {
+        const tTask& task = tasks[i];
+        const size_t stride = task.pJob->buffer->getVertexSize();
 
-            bufferTangents->writeData(offsetTangent, pTangentVertexElement->getSize(), &buffer);
+        std::set<size_t>::const_iterator iterOffset, iterOffsetEnd;
 
-            offsetTangent += bufferTangents->getVertexSize();
+        for (iterOffset = task.pJob->positions.begin(), iterOffsetEnd = task.pJob->positions.end();
+             iterOffset != iterOffsetEnd; ++iterOffset)
+        {
+            transformPositionsKernel(task.pData + *iterOffset, task.nbVertices, stride, transform, &tasksBounds[i]);
         }
 
-
-        // Binormal
-        if (pBinormalVertexElement)
+        for (iterOffset = task.pJob->normals.begin(), iterOffsetEnd = task.pJob->normals.end();
+             iterOffset != iterOffsetEnd; ++iterOffset)
         {
-            bufferBinormals->readData(offsetBinormal, pBinormalVertexElement->getSize(), &buffer);
+            transformDirectionsKernel(task.pData + *iterOffset, task.nbVertices, stride, normalsTransform, true);
+        }
 
-            Vector3 binormal = scale * Vector3(buffer);
-            binormal.normalise();
+        for (iterOffset = task.pJob->tangents.begin(), iterOffsetEnd = task.pJob->tangents.end();
+             iterOffset != iterOffsetEnd; ++iterOffset)
+        {
+            transformDirectionsKernel(task.pData + *iterOffset, task.nbVertices, stride, tangentsTransform, true);
+        }
+    }
 
-            buffer[0] = binormal.x;
-            buffer[1] = binormal.y;
-            buffer[2] = binormal.z;
+    for (iter = jobs.begin(), iterEnd = jobs.end(); iter != iterEnd; ++iter)
+        iter->second.buffer->unlock();
 
-            bufferBinormals->writeData(offsetBinormal, pBinormalVertexElement->getSize(), &buffer);
+    // Merge the bounds of the tasks
+    std::vector<tBoundsAccumulator>::const_iterator iterBounds, iterBoundsEnd;
+    for (iterBounds = tasksBounds.begin(), iterBoundsEnd = tasksBounds.end(); iterBounds != iterBoundsEnd; ++iterBounds)
+    {
+        if (iterBounds->bEmpty)
+            continue;
 
-            offsetBinormal += bufferBinormals->getVertexSize();
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            bounds.minimum[j] = std::min(bounds.minimum[j], iterBounds->minimum[j]);
+            bounds.maximum[j] = std::max(bounds.maximum[j], iterBounds->maximum[j]);
         }
+
+        bounds.radius2 = std::max(bounds.radius2, iterBounds->radius2);
+        bounds.bEmpty = false;
     }
 }
 
 //-----------------------------------------------------------------------
 
-void MeshTransformer::translateOrigin(Real x, Real y, Real z)
+void MeshTransformer::transformSkeleton(const Ogre::Matrix4& transform)
 {
-    translateOrigin(Vector3(x, y, z));
-}
+    SkeletonPtr pSkeleton = m_mesh->getSkeleton();
+    if (pSkeleton.isNull())
+        return;
 
-//-----------------------------------------------------------------------
+    Ogre::Vector3 translation;
+    Ogre::Vector3 scale;
+    Ogre::Quaternion rotation;
+    transform.decomposition(translation, scale, rotation);
 
-void MeshTransformer::translateOrigin(const Vector3& d)
-{
-    AxisAlignedBox aabb = fromOgre(m_mesh->getBounds());
-    Vector3 max = aabb.getCenter();
+    Ogre::Matrix3 linear;
+    transform.extract3x3Matrix(linear);
 
-    // Process the shared vertex data (if any)
-    if (m_mesh->sharedVertexData)
-        translateOrigin(m_mesh->sharedVertexData, d, max);
+    pSkeleton->reset();
 
-    // Process the submeshes' vertex data
-    Mesh::SubMeshIterator iter = m_mesh->getSubMeshIterator();
-    while (iter.hasMoreElements())
-    {
-        SubMesh* pSubMesh = iter.getNext();
+    // Retrieve the frames of the parents of the bones in the binding pose, before any
+    // modification: the offsets of the bones are scaled in skeleton space
+    const unsigned short nbBones = pSkeleton->getNumBones();
 
-        if (pSubMesh->vertexData)
-            translateOrigin(pSubMesh->vertexData, d, max);
+    std::vector<Ogre::Quaternion> parentOrientations(nbBones, Ogre::Quaternion::IDENTITY);
+    std::vector<Ogre::Vector3> parentScales(nbBones, Ogre::Vector3::UNIT_SCALE);
+
+    for (unsigned short i = 0; i < nbBones; ++i)
+    {
+        Node* pParent = pSkeleton->getBone(i)->getParent();
+        if (pParent)
+        {
+            parentOrientations[i]   = pParent->_getDerivedOrientation();
+            parentScales[i]         = pParent->_getDerivedScale();
+        }
     }
 
-    // Update the bounding informations
-    m_mesh->_setBounds(Ogre::AxisAlignedBox(toOgre(aabb.getMinimum() + d), toOgre(aabb.getMaximum() + d)));
-    float fDelta = m_mesh->getBoundingSphereRadius() - max.length();
-    max += d;
-    m_mesh->_setBoundingSphereRadius(max.length() + fDelta);
+    // Transform the binding pose: the root bones receive the whole transformation, the
+    // other ones only the scale of their offset
+    for (unsigned short i = 0; i < nbBones; ++i)
+    {
+        Bone* pBone = pSkeleton->getBone(i);
 
-    SkeletonPtr pSkeleton = m_mesh->getSkeleton();
-    if (!pSkeleton.isNull())
+        if (!pBone->getParent())
+        {
+            pBone->setPosition(transform.transformAffine(pBone->getPosition()));
+            pBone->setOrientation(rotation * pBone->getOrientation());
+        }
+        else
+        {
+            const Ogre::Quaternion& q = parentOrientations[i];
+            const Ogre::Vector3& parentScale = parentScales[i];
+
+            pBone->setPosition((q.Inverse() * (scale * (q * (parentScale * pBone->getPosition())))) / parentScale);
+        }
+    }
+
+    // Transform the translations of the keyframes of the animations the same way (they
+    // are offsets in the space of the parent of their bone)
+    for (unsigned short i = 0; i < pSkeleton->getNumAnimations(); ++i)
     {
-        pSkeleton->reset();
+        Ogre::Animation* pAnimation = pSkeleton->getAnimation(i);
 
-        Skeleton::BoneIterator iter = pSkeleton->getRootBoneIterator();
-        Ogre::Vector3 d2 = toOgre(d);
+        Ogre::Animation::NodeTrackIterator iter = pAnimation->getNodeTrackIterator();
         while (iter.hasMoreElements())
         {
-            Bone* pBone = iter.getNext();
-            pBone->translate(d2, Node::TS_PARENT);
-            pBone->_update(false, false);
-        }
+            Ogre::NodeAnimationTrack* pTrack = iter.getNext();
+            const unsigned short usHandle = pTrack->getHandle();
 
-        pSkeleton->setBindingPose();
+            if (usHandle >= nbBones)
+                continue;
+
+            const bool bRoot = !pSkeleton->getBone(usHandle)->getParent();
+            const Ogre::Quaternion& q = parentOrientations[usHandle];
+            const Ogre::Vector3& parentScale = parentScales[usHandle];
+
+            for (unsigned short j = 0; j < pTrack->getNumKeyFrames(); ++j)
+            {
+                Ogre::TransformKeyFrame* pKeyFrame = pTrack->getNodeKeyFrame(j);
+
+                if (bRoot)
+                    pKeyFrame->setTranslate(linear * pKeyFrame->getTranslate());
+                else
+                    pKeyFrame->setTranslate((q.Inverse() * (scale * (q * (parentScale * pKeyFrame->getTranslate())))) / parentScale);
+            }
+        }
     }
+
+    pSkeleton->setBindingPose();
 }
 
 //-----------------------------------------------------------------------
 
-void MeshTransformer::translateOrigin(Ogre::VertexData* pVertexData, const Vector3& d, Vector3& max)
+void MeshTransformer::transformVertexAnimations(const Ogre::Matrix4& transform)
 {
-    // Retrieve the declaration of the positions of the vertices
-    const VertexElement* pVertexElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
-
-    // Retrieve the buffer that contains the positions
-    HardwareVertexBufferSharedPtr buffer =
-        pVertexData->vertexBufferBinding->getBuffer(pVertexElement->getSource());
+    Ogre::Matrix3 linear;
+    transform.extract3x3Matrix(linear);
 
-    // Update the position of each vertex
-    float pos[3];
-    size_t offset = pVertexData->vertexStart * buffer->getVertexSize() + pVertexElement->getOffset();
-    for (unsigned int i = 0; i < pVertexData->vertexCount; ++i)
+    // The offsets of the poses are only affected by the linear part of the transformation
+    if (linear != Ogre::Matrix3::IDENTITY)
     {
-        buffer->readData(offset, pVertexElement->getSize(), &pos);
+        const Ogre::Matrix3 normalsTransform = getNormalMatrix(transform);
+
+        for (unsigned short i = 0; i < m_mesh->getPoseCount(); ++i)
+        {
+            Ogre::Pose* pPose = m_mesh->getPose(i);
 
-        max.x = std::max(pos[0], max.x);
-        max.y = std::max(pos[1], max.y);
-        max.z = std::max(pos[2], max.z);
+            const Ogre::Pose::VertexOffsetMap offsets = pPose->getVertexOffsets();
+            const Ogre::Pose::NormalsMap normals = pPose->getNormals();
+            const bool bNormals = pPose->getIncludesNormals();
 
-        pos[0] += d.x;
-        pos[1] += d.y;
-        pos[2] += d.z;
+            pPose->clearVertices();
 
-        buffer->writeData(offset, pVertexElement->getSize(), &pos);
+            Ogre::Pose::VertexOffsetMap::const_iterator iter, iterEnd;
+            for (iter = offsets.begin(), iterEnd = offsets.end(); iter != iterEnd; ++iter)
+            {
+                if (!bNormals)
+                {
+                    pPose->addVertex(iter->first, linear * iter->second);
+                    continue;
+                }
 
-        offset += buffer->getVertexSize();
+                Ogre::Vector3 normal = normalsTransform * normals.find(iter->first)->second;
+                normal.normalise();
+
+                pPose->addVertex(iter->first, linear * iter->second, normal);
+            }
+        }
+    }
+
+    // The keyframes of the morph animations contain positions (each buffer is only
+    // transformed once, even if shared by several keyframes)
+    std::set<Ogre::HardwareVertexBuffer*> buffers;
+
+    for (unsigned short i = 0; i < m_mesh->getNumAnimations(); ++i)
+    {
+        Ogre::Animation* pAnimation = m_mesh->getAnimation(i);
+
+        Ogre::Animation::VertexTrackIterator iter = pAnimation->getVertexTrackIterator();
+        while (iter.hasMoreElements())
+        {
+            Ogre::VertexAnimationTrack* pTrack = iter.getNext();
+            if (pTrack->getAnimationType() != Ogre::VAT_MORPH)
+                continue;
+
+            for (unsigned short j = 0; j < pTrack->getNumKeyFrames(); ++j)
+            {
+                HardwareVertexBufferSharedPtr buffer = pTrack->getVertexMorphKeyFrame(j)->getVertexBuffer();
+                if (buffer.isNull() || !buffers.insert(buffer.get()).second)
+                    continue;
+
+                unsigned char* pData = static_cast<unsigned char*>(buffer->lock(HardwareBuffer::HBL_NORMAL));
+                transformPositionsKernel(pData, (unsigned int) buffer->getNumVertices(),
+                                         buffer->getVertexSize(), transform, 0);
+                buffer->unlock();
+            }
+        }
     }
 }
 
 //-----------------------------------------------------------------------
 
-void MeshTransformer::rotate(const Quaternion& q)
+void MeshTransformer::splitPositions()
 {
-    AxisAlignedBox aabb = fromOgre(m_mesh->getBounds());
-    Vector3 max = aabb.getCenter();
+    // The vertex data bound to the same buffers are bound to the same split buffers
+    tSplitBuffersList splitBuffers;
 
     // Process the shared vertex data (if any)
     if (m_mesh->sharedVertexData)
-        rotate(m_mesh->sharedVertexData, q, max);
+        splitPositions(m_mesh->sharedVertexData, splitBuffers);
 
     // Process the submeshes' vertex data
     Mesh::SubMeshIterator iter = m_mesh->getSubMeshIterator();
@@ -322,136 +704,251 @@ void MeshTransformer::rotate(const Quaternion& q)
     {
         SubMesh* pSubMesh = iter.getNext();
 
-        if (pSubMesh->vertexData)
-            rotate(pSubMesh->vertexData, q, max);
+        if (!pSubMesh->useSharedVertices && pSubMesh->vertexData)
+            splitPositions(pSubMesh->vertexData, splitBuffers);
     }
+}
 
-    // Update the bounding informations
-    m_mesh->_setBounds(Ogre::AxisAlignedBox(toOgre(q * aabb.getMinimum()), toOgre(q * aabb.getMaximum())));
+//-----------------------------------------------------------------------
 
-    SkeletonPtr pSkeleton = m_mesh->getSkeleton();
-    if (!pSkeleton.isNull())
+void MeshTransformer::splitPositions(Ogre::VertexData* pVertexData, tSplitBuffersList& splitBuffers)
+{
+    VertexBufferBinding* pBinding = pVertexData->vertexBufferBinding;
+    const VertexBufferBinding::VertexBufferBindingMap bindings = pBinding->getBindings();
+
+    // Build the new declaration: the positions and the blending data in source 0,
+    // everything else in source 1 (in the original order)
+    VertexDeclaration* pDeclaration = HardwareBufferManager::getSingleton().createVertexDeclaration();
+
+    std::vector<VertexElement> sourceElements[2];   // The original elements of each source
+    size_t offsets[2] = { 0, 0 };
+
+    const VertexDeclaration::VertexElementList& elements = pVertexData->vertexDeclaration->getElements();
+    VertexDeclaration::VertexElementList::const_iterator iter, iterEnd;
+
+    for (iter = elements.begin(), iterEnd = elements.end(); iter != iterEnd; ++iter)
     {
-        pSkeleton->reset();
+        const unsigned short usSource = ((iter->getSemantic() == Ogre::VES_POSITION) ||
+                                         (iter->getSemantic() == Ogre::VES_BLEND_INDICES) ||
+                                         (iter->getSemantic() == Ogre::VES_BLEND_WEIGHTS) ? 0 : 1);
 
-        Skeleton::BoneIterator iter = pSkeleton->getRootBoneIterator();
-        Ogre::Quaternion q2 = toOgre(q);
-        while (iter.hasMoreElements())
+        pDeclaration->addElement(usSource, offsets[usSource], iter->getType(), iter->getSemantic(), iter->getIndex());
+        offsets[usSource] += iter->getSize();
+
+        sourceElements[usSource].push_back(*iter);
+    }
+
+    // Split the buffers, unless another vertex data bound to the same ones already did
+    std::vector<Ogre::HardwareVertexBuffer*> key;
+
+    VertexBufferBinding::VertexBufferBindingMap::const_iterator iterBinding, iterBindingEnd;
+    for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+        key.push_back(iterBinding->second.get());
+
+    std::vector<HardwareVertexBufferSharedPtr>& buffers = splitBuffers[key];
+
+    if (buffers.empty() && !bindings.empty())
+    {
+        // All the vertices of the buffers are copied (not only the ones used by the
+        // vertex data), so the vertex start of the vertex data sharing them stays valid
+        size_t nbVertices = bindings.begin()->second->getNumVertices();
+        std::map<unsigned short, const unsigned char*> sources;
+
+        for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+        {
+            const HardwareVertexBufferSharedPtr& source = iterBinding->second;
+
+            assert(!source->getIsInstanceData() && "The instance buffers can't be split");
+            assert(GraphicTools::isReadable(source.get()) && "The vertex buffers of the mesh must be readable");
+
+            nbVertices = std::min(nbVertices, source->getNumVertices());
+            sources[iterBinding->first] = static_cast<const unsigned char*>(source->lock(HardwareBuffer::HBL_READ_ONLY));
+        }
+
+        assert(pVertexData->vertexStart + pVertexData->vertexCount <= nbVertices);
+
+        for (unsigned int i = 0; i < 2; ++i)
         {
-            Bone* pBone = iter.getNext();
-            pBone->setPosition(q2 * pBone->getPosition());
-            pBone->rotate(q2, Node::TS_WORLD);
-            pBone->_update(true, false);
+            if (sourceElements[i].empty())
+                continue;
+
+            // Interleave the elements of the new buffer in system memory, then upload
+            // them at once
+            std::vector<unsigned char> data(nbVertices * offsets[i]);
+
+            size_t offset = 0;
+
+            std::vector<VertexElement>::const_iterator iterElement, iterElementEnd;
+            for (iterElement = sourceElements[i].begin(), iterElementEnd = sourceElements[i].end();
+                 iterElement != iterElementEnd; ++iterElement)
+            {
+                const size_t stride = pBinding->getBuffer(iterElement->getSource())->getVertexSize();
+                const size_t size = iterElement->getSize();
+
+                const unsigned char* pSource = sources[iterElement->getSource()] + iterElement->getOffset();
+                unsigned char* pDest = &data[offset];
+
+                for (size_t v = 0; v < nbVertices; ++v, pSource += stride, pDest += offsets[i])
+                    memcpy(pDest, pSource, size);
+
+                offset += size;
+            }
+
+            // Each new buffer keeps the usage and the shadow buffer of the buffer of its
+            // first element
+            const HardwareVertexBufferSharedPtr& first = pBinding->getBuffer(sourceElements[i].front().getSource());
+
+            HardwareVertexBufferSharedPtr buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                            offsets[i], nbVertices, first->getUsage(), first->hasShadowBuffer());
+
+            buffer->writeData(0, buffer->getSizeInBytes(), &data[0], true);
+
+            buffers.push_back(buffer);
         }
 
-        pSkeleton->setBindingPose();
+        for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
+            iterBinding->second->unlock();
     }
-}
 
-//-----------------------------------------------------------------------
+    // The new declaration and buffers replace the old ones
+    pBinding->unsetAllBindings();
 
-void MeshTransformer::rotate(const Vector3& axis, const Radian& angle)
-{
-    rotate(Quaternion(angle, axis));
+    for (unsigned short i = 0; i < buffers.size(); ++i)
+        pBinding->setBinding(i, buffers[i]);
+
+    HardwareBufferManager::getSingleton().destroyVertexDeclaration(pVertexData->vertexDeclaration);
+    pVertexData->vertexDeclaration = pDeclaration;
 }
 
 //-----------------------------------------------------------------------
 
-void MeshTransformer::rotate(Ogre::VertexData* pVertexData, const Quaternion& q, Vector3& max)
+void MeshTransformer::releaseShadowBuffers()
 {
-    // Retrieve the declaration of the interesting elements of the vertices
-    const VertexElement* pPositionVertexElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_POSITION);
-    const VertexElement* pNormalVertexElement   = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_NORMAL);
-    const VertexElement* pTangentVertexElement  = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_TANGENT);
-    const VertexElement* pBinormalVertexElement = pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_BINORMAL);
-
-    // Retrieve the buffer that contains the interesting elements
-    HardwareVertexBufferSharedPtr bufferPositions =
-        pVertexData->vertexBufferBinding->getBuffer(pPositionVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferNormals = !pNormalVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pNormalVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferTangents = !pTangentVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pTangentVertexElement->getSource());
-    HardwareVertexBufferSharedPtr bufferBinormals = !pBinormalVertexElement ? HardwareVertexBufferSharedPtr(0) :
-        pVertexData->vertexBufferBinding->getBuffer(pBinormalVertexElement->getSource());
-
-    // Update the elements of each vertex
-    float buffer[3];
-    size_t offsetPosition   = pVertexData->vertexStart * bufferPositions->getVertexSize() + pPositionVertexElement->getOffset();
-    size_t offsetNormal     = !pNormalVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferNormals->getVertexSize() + pNormalVertexElement->getOffset();
-    size_t offsetTangent    = !pTangentVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferTangents->getVertexSize() + pTangentVertexElement->getOffset();
-    size_t offsetBinormal   = !pBinormalVertexElement ? 0 :
-                              pVertexData->vertexStart * bufferBinormals->getVertexSize() + pBinormalVertexElement->getOffset();
-    for (unsigned int i = 0; i < pVertexData->vertexCount; ++i)
-    {
-        // Position
-        bufferPositions->readData(offsetPosition, pPositionVertexElement->getSize(), &buffer);
+    assert((m_pendingTransform == Ogre::Matrix4::IDENTITY) && "You must call commit() before releasing the shadow buffers");
+
+    std::vector<VertexData*> vertexDatas;
+    std::vector<IndexData*> indexDatas;
 
-        max.x = std::max(buffer[0], max.x);
-        max.y = std::max(buffer[1], max.y);
-        max.z = std::max(buffer[2], max.z);
+    if (m_mesh->sharedVertexData)
+        vertexDatas.push_back(m_mesh->sharedVertexData);
+
+    Mesh::SubMeshIterator iterSubMesh = m_mesh->getSubMeshIterator();
+    while (iterSubMesh.hasMoreElements())
+    {
+        SubMesh* pSubMesh = iterSubMesh.getNext();
 
-        Vector3 pos = q * Vector3(buffer);
+        if (!pSubMesh->useSharedVertices && pSubMesh->vertexData)
+            vertexDatas.push_back(pSubMesh->vertexData);
 
-        buffer[0] = pos.x;
-        buffer[1] = pos.y;
-        buffer[2] = pos.z;
+        if (pSubMesh->indexData)
+            indexDatas.push_back(pSubMesh->indexData);
 
-        bufferPositions->writeData(offsetPosition, pPositionVertexElement->getSize(), &buffer);
+        indexDatas.insert(indexDatas.end(), pSubMesh->mLodFaceList.begin(), pSubMesh->mLodFaceList.end());
+    }
 
-        offsetPosition += bufferPositions->getVertexSize();
+    // Create one static write-only copy of each shadowed buffer (a buffer bound by
+    // several vertex data is only copied once), filled from its shadow buffer in one
+    // upload
+    std::map<Ogre::HardwareVertexBuffer*, HardwareVertexBufferSharedPtr> copies;
 
+    std::vector<VertexData*>::iterator iter, iterEnd;
+    for (iter = vertexDatas.begin(), iterEnd = vertexDatas.end(); iter != iterEnd; ++iter)
+    {
+        VertexBufferBinding* pBinding = (*iter)->vertexBufferBinding;
+        const VertexBufferBinding::VertexBufferBindingMap bindings = pBinding->getBindings();
 
-        // Normal
-        if (pNormalVertexElement)
+        VertexBufferBinding::VertexBufferBindingMap::const_iterator iterBinding, iterBindingEnd;
+        for (iterBinding = bindings.begin(), iterBindingEnd = bindings.end(); iterBinding != iterBindingEnd; ++iterBinding)
         {
-            bufferNormals->readData(offsetNormal, pNormalVertexElement->getSize(), &buffer);
+            const HardwareVertexBufferSharedPtr& source = iterBinding->second;
+            if (!source->hasShadowBuffer())
+                continue;
+
+            HardwareVertexBufferSharedPtr& buffer = copies[source.get()];
 
-            Vector3 normal = q * Vector3(buffer);
+            if (buffer.isNull())
+            {
+                buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+                                source->getVertexSize(), source->getNumVertices(),
+                                HardwareBuffer::HBU_STATIC_WRITE_ONLY, false);
 
-            buffer[0] = normal.x;
-            buffer[1] = normal.y;
-            buffer[2] = normal.z;
+                buffer->setIsInstanceData(source->getIsInstanceData());
+                buffer->setInstanceDataStepRate(source->getInstanceDataStepRate());
 
-            bufferNormals->writeData(offsetNormal, pNormalVertexElement->getSize(), &buffer);
+                // Reading a shadowed buffer only reads its shadow buffer
+                buffer->writeData(0, source->getSizeInBytes(),
+                                  source->lock(HardwareBuffer::HBL_READ_ONLY), true);
+                source->unlock();
+            }
 
-            offsetNormal += bufferNormals->getVertexSize();
+            pBinding->setBinding(iterBinding->first, buffer);
         }
+    }
+
+    // Same thing for the index buffers (including the ones of the LOD levels)
+    std::map<Ogre::HardwareIndexBuffer*, HardwareIndexBufferSharedPtr> indexCopies;
 
+    std::vector<IndexData*>::iterator iterIndex, iterIndexEnd;
+    for (iterIndex = indexDatas.begin(), iterIndexEnd = indexDatas.end(); iterIndex != iterIndexEnd; ++iterIndex)
+    {
+        const HardwareIndexBufferSharedPtr source = (*iterIndex)->indexBuffer;
+        if (source.isNull() || !source->hasShadowBuffer())
+            continue;
+
+        HardwareIndexBufferSharedPtr& buffer = indexCopies[source.get()];
 
-        // Tangent
-        if (pTangentVertexElement)
+        if (buffer.isNull())
         {
-            bufferTangents->readData(offsetTangent, pTangentVertexElement->getSize(), &buffer);
+            buffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+                            source->getType(), source->getNumIndexes(),
+                            HardwareBuffer::HBU_STATIC_WRITE_ONLY, false);
+
+            buffer->writeData(0, source->getSizeInBytes(),
+                              source->lock(HardwareBuffer::HBL_READ_ONLY), true);
+            source->unlock();
+        }
 
-            Vector3 tangent = q * Vector3(buffer);
+        (*iterIndex)->indexBuffer = buffer;
+    }
 
-            buffer[0] = tangent.x;
-            buffer[1] = tangent.y;
-            buffer[2] = tangent.z;
+    // The buffers created by Ogre for this mesh later on don't need to be read either
+    m_mesh->setVertexBufferPolicy(HardwareBuffer::HBU_STATIC_WRITE_ONLY, false);
+    m_mesh->setIndexBufferPolicy(HardwareBuffer::HBU_STATIC_WRITE_ONLY, false);
+}
 
-            bufferTangents->writeData(offsetTangent, pTangentVertexElement->getSize(), &buffer);
+//-----------------------------------------------------------------------
 
-            offsetTangent += bufferTangents->getVertexSize();
-        }
+void MeshTransformer::transformPositions(const Ogre::Matrix4& transform, Real* pPositions,
+                                         unsigned int nbVertices, size_t stride)
+{
+    assert(transform.isAffine());
+    assert(pPositions || (nbVertices == 0));
 
+    transformPositionsKernel(reinterpret_cast<unsigned char*>(pPositions), nbVertices,
+                             (stride == 0 ? 3 * sizeof(Real) : stride), transform, 0);
+}
 
-        // Binormal
-        if (pBinormalVertexElement)
-        {
-            bufferBinormals->readData(offsetBinormal, pBinormalVertexElement->getSize(), &buffer);
+//-----------------------------------------------------------------------
 
-            Vector3 binormal = q * Vector3(buffer);
+void MeshTransformer::transformDirections(const Ogre::Matrix3& transform, Real* pDirections,
+                                          unsigned int nbVertices, size_t stride)
+{
+    assert(pDirections || (nbVertices == 0));
 
-            buffer[0] = binormal.x;
-            buffer[1] = binormal.y;
-            buffer[2] = binormal.z;
+    transformDirectionsKernel(reinterpret_cast<unsigned char*>(pDirections), nbVertices,
+                              (stride == 0 ? 3 * sizeof(Real) : stride), transform, true);
+}
 
-            bufferBinormals->writeData(offsetBinormal, pBinormalVertexElement->getSize(), &buffer);
+//-----------------------------------------------------------------------
 
-            offsetBinormal += bufferBinormals->getVertexSize();
-        }
-    }
+Ogre::Matrix3 MeshTransformer::getNormalMatrix(const Ogre::Matrix4& transform)
+{
+    Ogre::Matrix3 linear;
+    transform.extract3x3Matrix(linear);
+
+    Ogre::Matrix3 inverse;
+    if (!linear.Inverse(inverse))
+        return linear;
+
+    return inverse.Transpose();
 }
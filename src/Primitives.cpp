@@ -0,0 +1,863 @@
+/** @file   Primitives.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::Primitives'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/Primitives.h>
+#include <Athena-Graphics/MeshBuilder.h>
+
+// Ogre's includes
+#include <Ogre/OgreMeshManager.h>
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+    #define ATHENA_GRAPHICS_PRIMITIVES_SSE
+    #include <xmmintrin.h>
+#endif
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+using Ogre::MeshManager;
+using Ogre::MeshPtr;
+
+
+/************************************** CONSTANTS **************************************/
+
+static const double PI = 3.14159265358979323846;
+
+///< Names of the types of primitives, used in the names of the shared meshes
+static const char* TYPE_NAMES[] = { "Box", "UVSphere", "IcoSphere", "Capsule", "Cylinder",
+                                    "Cone", "Torus", "Grid" };
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// The vertices (position, normal and 2D texture coordinates) and indices of a
+/// primitive, before they are given to the mesh builder
+struct tGeometry
+{
+    std::vector<float>          positions;
+    std::vector<float>          normals;
+    std::vector<float>          texCoords;
+    std::vector<unsigned int>   indices;
+    std::vector<float>          circle;     ///< (cos, 0, -sin, 0) of the angles of the
+                                            ///  segments of the rings (see setCircle())
+};
+
+//-----------------------------------------------------------------------
+
+/// Sine and cosine of an angle. The values close to 0 are made exact, so the vertices
+/// located at the poles are identical.
+static void sinCos(double angle, float& s, float& c)
+{
+    s = (float) sin(angle);
+    c = (float) cos(angle);
+
+    if (fabsf(s) < 1e-6f)
+        s = 0.0f;
+
+    if (fabsf(c) < 1e-6f)
+        c = 0.0f;
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the angles of the segments of the rings and discs, once per primitive
+static void setCircle(tGeometry& geometry, unsigned int nbSegments)
+{
+    geometry.circle.resize((nbSegments + 1) * 4);
+
+    for (unsigned int i = 0; i <= nbSegments; ++i)
+    {
+        float s, c;
+        sinCos(2.0 * PI * i / nbSegments, s, c);
+
+        geometry.circle[i * 4]      = c;
+        geometry.circle[i * 4 + 1]  = 0.0f;
+        geometry.circle[i * 4 + 2]  = -s;
+        geometry.circle[i * 4 + 3]  = 0.0f;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Make room for some vertices, returns the index of the first one
+static unsigned int addVertices(tGeometry& geometry, unsigned int nbVertices)
+{
+    const unsigned int first = geometry.positions.size() / 3;
+
+    geometry.positions.resize((first + nbVertices) * 3);
+    geometry.normals.resize((first + nbVertices) * 3);
+    geometry.texCoords.resize((first + nbVertices) * 2);
+
+    return first;
+}
+
+//-----------------------------------------------------------------------
+
+static void addVertex(tGeometry& geometry, float x, float y, float z, float nx, float ny, float nz,
+                      float u, float v)
+{
+    geometry.positions.push_back(x);
+    geometry.positions.push_back(y);
+    geometry.positions.push_back(z);
+
+    geometry.normals.push_back(nx);
+    geometry.normals.push_back(ny);
+    geometry.normals.push_back(nz);
+
+    geometry.texCoords.push_back(u);
+    geometry.texCoords.push_back(v);
+}
+
+//-----------------------------------------------------------------------
+
+/// Add a triangle, unless two of its vertices are at the same position (at the poles
+/// of the spheres or at the apex of the cones)
+static void addTriangle(tGeometry& geometry, unsigned int i1, unsigned int i2, unsigned int i3)
+{
+    const float* p1 = &geometry.positions[i1 * 3];
+    const float* p2 = &geometry.positions[i2 * 3];
+    const float* p3 = &geometry.positions[i3 * 3];
+
+    if (((p1[0] == p2[0]) && (p1[1] == p2[1]) && (p1[2] == p2[2])) ||
+        ((p2[0] == p3[0]) && (p2[1] == p3[1]) && (p2[2] == p3[2])) ||
+        ((p3[0] == p1[0]) && (p3[1] == p1[1]) && (p3[2] == p1[2])))
+    {
+        return;
+    }
+
+    geometry.indices.push_back(i1);
+    geometry.indices.push_back(i2);
+    geometry.indices.push_back(i3);
+}
+
+//-----------------------------------------------------------------------
+
+/// Add the triangles of a surface made of (nbColumns + 1) x (nbRows + 1) vertices,
+/// stored row after row. The front face of the surface is the one whose normal is
+/// 'row direction x column direction'.
+static void addSurface(tGeometry& geometry, unsigned int first, unsigned int nbColumns,
+                       unsigned int nbRows)
+{
+    for (unsigned int j = 0; j < nbRows; ++j)
+    {
+        for (unsigned int i = 0; i < nbColumns; ++i)
+        {
+            const unsigned int a = first + j * (nbColumns + 1) + i;
+            const unsigned int b = a + 1;
+            const unsigned int c = a + nbColumns + 1;
+            const unsigned int d = c + 1;
+
+            addTriangle(geometry, a, c, b);
+            addTriangle(geometry, b, c, d);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Add a disc in the XZ plane, facing up or down
+static void addDisc(tGeometry& geometry, float y, float radius, unsigned int nbSegments, bool bUp)
+{
+    const float ny = (bUp ? 1.0f : -1.0f);
+
+    assert(geometry.circle.size() == (nbSegments + 1) * 4);
+
+    const unsigned int center = geometry.positions.size() / 3;
+    addVertex(geometry, 0.0f, y, 0.0f, 0.0f, ny, 0.0f, 0.5f, 0.5f);
+
+    for (unsigned int i = 0; i <= nbSegments; ++i)
+    {
+        const float c = geometry.circle[i * 4];
+        const float s = -geometry.circle[i * 4 + 2];
+
+        addVertex(geometry, radius * c, y, -radius * s, 0.0f, ny, 0.0f,
+                  0.5f + 0.5f * c, 0.5f - 0.5f * ny * s);
+    }
+
+    for (unsigned int i = 0; i < nbSegments; ++i)
+    {
+        if (bUp)
+            addTriangle(geometry, center, center + 1 + i, center + 2 + i);
+        else
+            addTriangle(geometry, center, center + 2 + i, center + 1 + i);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void buildBox(tGeometry& geometry, const Real* size, unsigned int nbSegments)
+{
+    // Normal and 'up' direction of each face
+    static const float FACES[6][6] = {
+        {  1.0f,  0.0f,  0.0f,      0.0f, 1.0f,  0.0f },
+        { -1.0f,  0.0f,  0.0f,      0.0f, 1.0f,  0.0f },
+        {  0.0f,  0.0f,  1.0f,      0.0f, 1.0f,  0.0f },
+        {  0.0f,  0.0f, -1.0f,      0.0f, 1.0f,  0.0f },
+        {  0.0f,  1.0f,  0.0f,      0.0f, 0.0f, -1.0f },
+        {  0.0f, -1.0f,  0.0f,      0.0f, 0.0f,  1.0f },
+    };
+
+    const float half[3] = { size[0] * 0.5f, size[1] * 0.5f, size[2] * 0.5f };
+
+    for (unsigned int f = 0; f < 6; ++f)
+    {
+        const float* n  = FACES[f];
+        const float* up = FACES[f] + 3;
+
+        // The rows go down, the columns right (as seen from the outside)
+        const float right[3] = { up[1] * n[2] - up[2] * n[1],
+                                 up[2] * n[0] - up[0] * n[2],
+                                 up[0] * n[1] - up[1] * n[0] };
+
+        const unsigned int first = geometry.positions.size() / 3;
+
+        for (unsigned int j = 0; j <= nbSegments; ++j)
+        {
+            const float t = float(j) / nbSegments;
+
+            for (unsigned int i = 0; i <= nbSegments; ++i)
+            {
+                const float s = float(i) / nbSegments;
+
+                float p[3];
+                for (unsigned int k = 0; k < 3; ++k)
+                    p[k] = (n[k] + right[k] * (2.0f * s - 1.0f) - up[k] * (2.0f * t - 1.0f)) * half[k];
+
+                addVertex(geometry, p[0], p[1], p[2], n[0], n[1], n[2], s, t);
+            }
+        }
+
+        addSurface(geometry, first, nbSegments, nbSegments);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Add a ring of vertices around the Y axis, defined by its radius, its height, the
+/// radial and vertical components of the normals and the V texture coordinate. The
+/// rings of a surface must be added from top to bottom.
+/// @remark setCircle() must have been called with the same number of segments
+static void addRing(tGeometry& geometry, float radius, float y, float nr, float ny, float v,
+                    unsigned int nbSegments)
+{
+    assert(geometry.circle.size() == (nbSegments + 1) * 4);
+
+    const unsigned int first = addVertices(geometry, nbSegments + 1);
+
+    const float* pCircle    = &geometry.circle[0];
+    float* pPositions       = &geometry.positions[first * 3];
+    float* pNormals         = &geometry.normals[first * 3];
+    float* pTexCoords       = &geometry.texCoords[first * 2];
+
+    // The position is radius * (cos, 0, -sin) + (0, y, 0), the normal
+    // nr * (cos, 0, -sin) + (0, ny, 0)
+#ifdef ATHENA_GRAPHICS_PRIMITIVES_SSE
+    const __m128 positionScale  = _mm_set1_ps(radius);
+    const __m128 positionOffset = _mm_setr_ps(0.0f, y, 0.0f, 0.0f);
+    const __m128 normalScale    = _mm_set1_ps(nr);
+    const __m128 normalOffset   = _mm_setr_ps(0.0f, ny, 0.0f, 0.0f);
+
+    for (unsigned int i = 0; i <= nbSegments; ++i, pCircle += 4, pPositions += 3, pNormals += 3)
+    {
+        const __m128 direction = _mm_loadu_ps(pCircle);
+
+        const __m128 position = _mm_add_ps(_mm_mul_ps(direction, positionScale), positionOffset);
+        const __m128 normal = _mm_add_ps(_mm_mul_ps(direction, normalScale), normalOffset);
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(pPositions), position);
+        _mm_store_ss(pPositions + 2, _mm_movehl_ps(position, position));
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(pNormals), normal);
+        _mm_store_ss(pNormals + 2, _mm_movehl_ps(normal, normal));
+    }
+#else
+    for (unsigned int i = 0; i <= nbSegments; ++i, pCircle += 4, pPositions += 3, pNormals += 3)
+    {
+        pPositions[0]   = radius * pCircle[0];
+        pPositions[1]   = y;
+        pPositions[2]   = radius * pCircle[2];
+
+        pNormals[0]     = nr * pCircle[0];
+        pNormals[1]     = ny;
+        pNormals[2]     = nr * pCircle[2];
+    }
+#endif
+
+    for (unsigned int i = 0; i <= nbSegments; ++i, pTexCoords += 2)
+    {
+        pTexCoords[0] = float(i) / nbSegments;
+        pTexCoords[1] = v;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void buildUVSphere(tGeometry& geometry, float radius, unsigned int nbRings,
+                          unsigned int nbSegments)
+{
+    setCircle(geometry, nbSegments);
+
+    const unsigned int first = geometry.positions.size() / 3;
+
+    for (unsigned int j = 0; j <= nbRings; ++j)
+    {
+        float s, c;
+        sinCos(PI * j / nbRings, s, c);
+
+        addRing(geometry, radius * s, radius * c, s, c, float(j) / nbRings, nbSegments);
+    }
+
+    addSurface(geometry, first, nbSegments, nbRings);
+}
+
+//-----------------------------------------------------------------------
+
+static void buildCapsule(tGeometry& geometry, float radius, float height, unsigned int nbRings,
+                         unsigned int nbSegments)
+{
+    setCircle(geometry, nbSegments);
+
+    const unsigned int first = geometry.positions.size() / 3;
+
+    // The texture coordinates follow the length of the profile
+    const float length = float(PI) * radius + height;
+
+    // Upper hemisphere, then lower one (the two rings at the equator delimit the
+    // cylindrical part)
+    for (unsigned int j = 0; j <= nbRings; ++j)
+    {
+        const double angle = 0.5 * PI * j / nbRings;
+
+        float s, c;
+        sinCos(angle, s, c);
+
+        addRing(geometry, radius * s, 0.5f * height + radius * c, s, c,
+                float(radius * angle) / length, nbSegments);
+    }
+
+    for (unsigned int j = 0; j <= nbRings; ++j)
+    {
+        const double angle = 0.5 * PI + 0.5 * PI * j / nbRings;
+
+        float s, c;
+        sinCos(angle, s, c);
+
+        addRing(geometry, radius * s, -0.5f * height + radius * c, s, c,
+                (float(radius * angle) + height) / length, nbSegments);
+    }
+
+    addSurface(geometry, first, nbSegments, 2 * nbRings + 1);
+}
+
+//-----------------------------------------------------------------------
+
+static void buildCylinder(tGeometry& geometry, float radius, float height, unsigned int nbSegments,
+                          unsigned int nbHeightSegments, bool bCapped)
+{
+    setCircle(geometry, nbSegments);
+
+    const unsigned int first = geometry.positions.size() / 3;
+
+    for (unsigned int j = 0; j <= nbHeightSegments; ++j)
+    {
+        const float t = float(j) / nbHeightSegments;
+        addRing(geometry, radius, height * (0.5f - t), 1.0f, 0.0f, t, nbSegments);
+    }
+
+    addSurface(geometry, first, nbSegments, nbHeightSegments);
+
+    if (bCapped)
+    {
+        addDisc(geometry, 0.5f * height, radius, nbSegments, true);
+        addDisc(geometry, -0.5f * height, radius, nbSegments, false);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void buildCone(tGeometry& geometry, float radius, float height, unsigned int nbSegments,
+                      unsigned int nbHeightSegments, bool bCapped)
+{
+    setCircle(geometry, nbSegments);
+
+    const unsigned int first = geometry.positions.size() / 3;
+
+    // The normals are perpendicular to the slope
+    const float length = sqrtf(height * height + radius * radius);
+    const float nr = (length > 0.0f ? height / length : 1.0f);
+    const float ny = (length > 0.0f ? radius / length : 0.0f);
+
+    for (unsigned int j = 0; j <= nbHeightSegments; ++j)
+    {
+        const float t = float(j) / nbHeightSegments;
+        addRing(geometry, radius * t, height * (0.5f - t), nr, ny, t, nbSegments);
+    }
+
+    addSurface(geometry, first, nbSegments, nbHeightSegments);
+
+    if (bCapped)
+        addDisc(geometry, -0.5f * height, radius, nbSegments, false);
+}
+
+//-----------------------------------------------------------------------
+
+static void buildTorus(tGeometry& geometry, float radius, float tubeRadius, unsigned int nbSegments,
+                       unsigned int nbTubeSegments)
+{
+    setCircle(geometry, nbSegments);
+
+    const unsigned int first = geometry.positions.size() / 3;
+
+    // Each ring of the tube is a ring around the Y axis (starting on the outside and
+    // going down, so the rows of the surface go down on the outside)
+    for (unsigned int j = 0; j <= nbTubeSegments; ++j)
+    {
+        float s, c;
+        sinCos(2.0 * PI * j / nbTubeSegments, s, c);
+
+        addRing(geometry, radius + tubeRadius * c, -tubeRadius * s, c, -s,
+                float(j) / nbTubeSegments, nbSegments);
+    }
+
+    addSurface(geometry, first, nbSegments, nbTubeSegments);
+}
+
+//-----------------------------------------------------------------------
+
+static void buildGrid(tGeometry& geometry, float width, float depth, unsigned int nbXSegments,
+                      unsigned int nbZSegments)
+{
+    const unsigned int first = addVertices(geometry, (nbXSegments + 1) * (nbZSegments + 1));
+
+    float* pPositions   = &geometry.positions[first * 3];
+    float* pNormals     = &geometry.normals[first * 3];
+    float* pTexCoords   = &geometry.texCoords[first * 2];
+
+    for (unsigned int j = 0; j <= nbZSegments; ++j)
+    {
+        const float t = float(j) / nbZSegments;
+
+        for (unsigned int i = 0; i <= nbXSegments; ++i, pPositions += 3, pNormals += 3, pTexCoords += 2)
+        {
+            const float s = float(i) / nbXSegments;
+
+            pPositions[0]   = width * (s - 0.5f);
+            pPositions[1]   = 0.0f;
+            pPositions[2]   = depth * (t - 0.5f);
+
+            pNormals[0]     = 0.0f;
+            pNormals[1]     = 1.0f;
+            pNormals[2]     = 0.0f;
+
+            pTexCoords[0]   = s;
+            pTexCoords[1]   = t;
+        }
+    }
+
+    addSurface(geometry, first, nbXSegments, nbZSegments);
+}
+
+//-----------------------------------------------------------------------
+
+/// Returns the index of the point in the middle of an edge of the ico sphere, creating
+/// it if necessary
+static unsigned int getMiddlePoint(std::vector<float>& points,
+                                   std::map<std::pair<unsigned int, unsigned int>, unsigned int>& middles,
+                                   unsigned int i1, unsigned int i2)
+{
+    const std::pair<unsigned int, unsigned int> key(std::min(i1, i2), std::max(i1, i2));
+
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator iter = middles.find(key);
+    if (iter != middles.end())
+        return iter->second;
+
+    float p[3] = { points[i1 * 3] + points[i2 * 3],
+                   points[i1 * 3 + 1] + points[i2 * 3 + 1],
+                   points[i1 * 3 + 2] + points[i2 * 3 + 2] };
+
+    const float length = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+    const unsigned int index = points.size() / 3;
+
+    points.push_back(p[0] / length);
+    points.push_back(p[1] / length);
+    points.push_back(p[2] / length);
+
+    middles[key] = index;
+
+    return index;
+}
+
+//-----------------------------------------------------------------------
+
+static void buildIcoSphere(tGeometry& geometry, float radius, unsigned int nbSubdivisions)
+{
+    // The icosahedron
+    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+    const float l = sqrtf(1.0f + t * t);
+    const float a = 1.0f / l;
+    const float b = t / l;
+
+    const float POINTS[12][3] = {
+        { -a,  b,  0 }, {  a,  b,  0 }, { -a, -b,  0 }, {  a, -b,  0 },
+        {  0, -a,  b }, {  0,  a,  b }, {  0, -a, -b }, {  0,  a, -b },
+        {  b,  0, -a }, {  b,  0,  a }, { -b,  0, -a }, { -b,  0,  a },
+    };
+
+    static const unsigned int TRIANGLES[20][3] = {
+        { 0, 11,  5 }, { 0,  5,  1 }, {  0,  1,  7 }, {  0,  7, 10 }, { 0, 10, 11 },
+        { 1,  5,  9 }, { 5, 11,  4 }, { 11, 10,  2 }, { 10,  7,  6 }, { 7,  1,  8 },
+        { 3,  9,  4 }, { 3,  4,  2 }, {  3,  2,  6 }, {  3,  6,  8 }, { 3,  8,  9 },
+        { 4,  9,  5 }, { 2,  4, 11 }, {  6,  2, 10 }, {  8,  6,  7 }, { 9,  8,  1 },
+    };
+
+    std::vector<float> points(&POINTS[0][0], &POINTS[0][0] + 12 * 3);
+    std::vector<unsigned int> triangles(&TRIANGLES[0][0], &TRIANGLES[0][0] + 20 * 3);
+
+    // Subdivide each triangle in 4
+    for (unsigned int i = 0; i < nbSubdivisions; ++i)
+    {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> middles;
+        std::vector<unsigned int> subdivided;
+        subdivided.reserve(triangles.size() * 4);
+
+        for (unsigned int j = 0; j < triangles.size(); j += 3)
+        {
+            const unsigned int v1 = triangles[j];
+            const unsigned int v2 = triangles[j + 1];
+            const unsigned int v3 = triangles[j + 2];
+
+            const unsigned int m12 = getMiddlePoint(points, middles, v1, v2);
+            const unsigned int m23 = getMiddlePoint(points, middles, v2, v3);
+            const unsigned int m31 = getMiddlePoint(points, middles, v3, v1);
+
+            const unsigned int newTriangles[12] = { v1, m12, m31, v2, m23, m12, v3, m31, m23, m12, m23, m31 };
+            subdivided.insert(subdivided.end(), newTriangles, newTriangles + 12);
+        }
+
+        triangles.swap(subdivided);
+    }
+
+    // Create the vertices, with a spherical mapping
+    const unsigned int first = geometry.positions.size() / 3;
+    const unsigned int nbPoints = points.size() / 3;
+
+    for (unsigned int i = 0; i < nbPoints; ++i)
+    {
+        const float* p = &points[i * 3];
+
+        float u = float(atan2(-p[2], p[0]) / (2.0 * PI));
+        if (u < 0.0f)
+            u += 1.0f;
+
+        const float v = float(acos(std::max(-1.0f, std::min(1.0f, p[1]))) / PI);
+
+        addVertex(geometry, p[0] * radius, p[1] * radius, p[2] * radius, p[0], p[1], p[2], u, v);
+    }
+
+    // The triangles crossing the seam of the mapping use copies of their vertices
+    // located at the beginning of the texture, shifted by 1
+    std::map<unsigned int, unsigned int> copies;
+
+    for (unsigned int i = 0; i < triangles.size(); i += 3)
+    {
+        unsigned int indices[3] = { first + triangles[i], first + triangles[i + 1], first + triangles[i + 2] };
+
+        const float u1 = geometry.texCoords[indices[0] * 2];
+        const float u2 = geometry.texCoords[indices[1] * 2];
+        const float u3 = geometry.texCoords[indices[2] * 2];
+
+        if (std::max(u1, std::max(u2, u3)) - std::min(u1, std::min(u2, u3)) > 0.5f)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                if (geometry.texCoords[indices[j] * 2] >= 0.5f)
+                    continue;
+
+                std::map<unsigned int, unsigned int>::iterator iter = copies.find(indices[j]);
+                if (iter == copies.end())
+                {
+                    const unsigned int index = indices[j];
+                    const unsigned int copy = geometry.positions.size() / 3;
+
+                    addVertex(geometry, geometry.positions[index * 3], geometry.positions[index * 3 + 1],
+                              geometry.positions[index * 3 + 2], geometry.normals[index * 3],
+                              geometry.normals[index * 3 + 1], geometry.normals[index * 3 + 2],
+                              geometry.texCoords[index * 2] + 1.0f, geometry.texCoords[index * 2 + 1]);
+
+                    iter = copies.insert(std::make_pair(index, copy)).first;
+                }
+
+                indices[j] = iter->second;
+            }
+        }
+
+        addTriangle(geometry, indices[0], indices[1], indices[2]);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Give the vertices and indices of a primitive to a mesh builder
+static void writeGeometry(MeshBuilder* pBuilder, tGeometry& geometry)
+{
+    if (geometry.indices.empty())
+        return;
+
+    // The indices are relative to the first vertex of the submesh
+    const unsigned int first = pBuilder->getNbVertices();
+
+    if (first > 0)
+    {
+        for (unsigned int i = 0; i < geometry.indices.size(); ++i)
+            geometry.indices[i] += first;
+    }
+
+    pBuilder->positions(&geometry.positions[0], geometry.positions.size() / 3);
+    pBuilder->normals(&geometry.normals[0]);
+    pBuilder->textureCoords(&geometry.texCoords[0], 2);
+    pBuilder->indices(&geometry.indices[0], geometry.indices.size());
+}
+
+
+/*************************************** METHODS ***************************************/
+
+void Primitives::addBox(MeshBuilder* pBuilder, const Vector3& size, unsigned int nbSegments)
+{
+    tParameters parameters = { TYPE_BOX, { size.x, size.y, size.z }, { nbSegments, 0 }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addUVSphere(MeshBuilder* pBuilder, Real radius, unsigned int nbRings,
+                             unsigned int nbSegments)
+{
+    tParameters parameters = { TYPE_UV_SPHERE, { radius, 0.0f, 0.0f }, { nbRings, nbSegments }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addIcoSphere(MeshBuilder* pBuilder, Real radius, unsigned int nbSubdivisions)
+{
+    tParameters parameters = { TYPE_ICO_SPHERE, { radius, 0.0f, 0.0f }, { nbSubdivisions, 0 }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addCapsule(MeshBuilder* pBuilder, Real radius, Real height, unsigned int nbRings,
+                            unsigned int nbSegments)
+{
+    tParameters parameters = { TYPE_CAPSULE, { radius, height, 0.0f }, { nbRings, nbSegments }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addCylinder(MeshBuilder* pBuilder, Real radius, Real height, unsigned int nbSegments,
+                             unsigned int nbHeightSegments, bool bCapped)
+{
+    tParameters parameters = { TYPE_CYLINDER, { radius, height, 0.0f }, { nbSegments, nbHeightSegments }, bCapped };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addCone(MeshBuilder* pBuilder, Real radius, Real height, unsigned int nbSegments,
+                         unsigned int nbHeightSegments, bool bCapped)
+{
+    tParameters parameters = { TYPE_CONE, { radius, height, 0.0f }, { nbSegments, nbHeightSegments }, bCapped };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addTorus(MeshBuilder* pBuilder, Real radius, Real tubeRadius, unsigned int nbSegments,
+                          unsigned int nbTubeSegments)
+{
+    tParameters parameters = { TYPE_TORUS, { radius, tubeRadius, 0.0f }, { nbSegments, nbTubeSegments }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addGrid(MeshBuilder* pBuilder, Real width, Real depth, unsigned int nbXSegments,
+                         unsigned int nbZSegments)
+{
+    tParameters parameters = { TYPE_GRID, { width, depth, 0.0f }, { nbXSegments, nbZSegments }, false };
+    addPrimitive(pBuilder, parameters);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getBox(const Vector3& size, unsigned int nbSegments,
+                           const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_BOX, { size.x, size.y, size.z }, { nbSegments, 0 }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getUVSphere(Real radius, unsigned int nbRings, unsigned int nbSegments,
+                                const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_UV_SPHERE, { radius, 0.0f, 0.0f }, { nbRings, nbSegments }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getIcoSphere(Real radius, unsigned int nbSubdivisions,
+                                 const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_ICO_SPHERE, { radius, 0.0f, 0.0f }, { nbSubdivisions, 0 }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getCapsule(Real radius, Real height, unsigned int nbRings, unsigned int nbSegments,
+                               const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_CAPSULE, { radius, height, 0.0f }, { nbRings, nbSegments }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getCylinder(Real radius, Real height, unsigned int nbSegments,
+                                unsigned int nbHeightSegments, bool bCapped,
+                                const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_CYLINDER, { radius, height, 0.0f }, { nbSegments, nbHeightSegments }, bCapped };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getCone(Real radius, Real height, unsigned int nbSegments,
+                            unsigned int nbHeightSegments, bool bCapped,
+                            const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_CONE, { radius, height, 0.0f }, { nbSegments, nbHeightSegments }, bCapped };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getTorus(Real radius, Real tubeRadius, unsigned int nbSegments,
+                             unsigned int nbTubeSegments, const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_TORUS, { radius, tubeRadius, 0.0f }, { nbSegments, nbTubeSegments }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getGrid(Real width, Real depth, unsigned int nbXSegments, unsigned int nbZSegments,
+                            const std::string& strResourceGroup)
+{
+    tParameters parameters = { TYPE_GRID, { width, depth, 0.0f }, { nbXSegments, nbZSegments }, false };
+    return getMesh(parameters, strResourceGroup);
+}
+
+//-----------------------------------------------------------------------
+
+MeshPtr Primitives::getMesh(const tParameters& parameters, const std::string& strResourceGroup)
+{
+    // The name of the mesh is built from the parameters. The values are written with
+    // enough digits to be read back exactly, so two different sizes never share a mesh.
+    std::ostringstream name;
+    name.precision(std::numeric_limits<Real>::digits10 + 3);
+
+    name << "Athena/Primitives/" << TYPE_NAMES[parameters.type] << "("
+         << parameters.values[0] << "," << parameters.values[1] << "," << parameters.values[2] << ","
+         << parameters.counts[0] << "," << parameters.counts[1]
+         << (parameters.bCapped ? ",capped)" : ")");
+
+    const string strName = name.str();
+
+    MeshPtr mesh = MeshManager::getSingleton().getByName(strName, strResourceGroup);
+    if (!mesh.isNull())
+        return mesh;
+
+    MeshBuilder builder(strName, strResourceGroup);
+
+    builder.begin("Primitive", "BaseWhite");
+    addPrimitive(&builder, parameters);
+    builder.end();
+
+    return builder.getMesh();
+}
+
+//-----------------------------------------------------------------------
+
+void Primitives::addPrimitive(MeshBuilder* pBuilder, const tParameters& parameters)
+{
+    assert(pBuilder);
+
+    const Real* values = parameters.values;
+    const unsigned int* counts = parameters.counts;
+
+    tGeometry geometry;
+
+    switch (parameters.type)
+    {
+        case TYPE_BOX:
+            assert(counts[0] > 0);
+            buildBox(geometry, values, counts[0]);
+            break;
+
+        case TYPE_UV_SPHERE:
+            assert((counts[0] > 1) && (counts[1] > 2));
+            buildUVSphere(geometry, values[0], counts[0], counts[1]);
+            break;
+
+        case TYPE_ICO_SPHERE:
+            buildIcoSphere(geometry, values[0], counts[0]);
+            break;
+
+        case TYPE_CAPSULE:
+            assert((counts[0] > 0) && (counts[1] > 2));
+            buildCapsule(geometry, values[0], values[1], counts[0], counts[1]);
+            break;
+
+        case TYPE_CYLINDER:
+            assert((counts[0] > 2) && (counts[1] > 0));
+            buildCylinder(geometry, values[0], values[1], counts[0], counts[1], parameters.bCapped);
+            break;
+
+        case TYPE_CONE:
+            assert((counts[0] > 2) && (counts[1] > 0));
+            buildCone(geometry, values[0], values[1], counts[0], counts[1], parameters.bCapped);
+            break;
+
+        case TYPE_TORUS:
+            assert((counts[0] > 2) && (counts[1] > 2));
+            buildTorus(geometry, values[0], values[1], counts[0], counts[1]);
+            break;
+
+        case TYPE_GRID:
+            assert((counts[0] > 0) && (counts[1] > 0));
+            buildGrid(geometry, values[0], values[1], counts[0], counts[1]);
+            break;
+    }
+
+    writeGeometry(pBuilder, geometry);
+}
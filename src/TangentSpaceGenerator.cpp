@@ -0,0 +1,336 @@
+/** @file   TangentSpaceGenerator.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::TangentSpaceGenerator'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/TangentSpaceGenerator.h>
+
+#include <math.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace std;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+static inline void subtract(const float* a, const float* b, float* result)
+{
+    result[0] = a[0] - b[0];
+    result[1] = a[1] - b[1];
+    result[2] = a[2] - b[2];
+}
+
+//-----------------------------------------------------------------------
+
+static inline void cross(const float* a, const float* b, float* result)
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+//-----------------------------------------------------------------------
+
+static inline float dot(const float* a, const float* b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//-----------------------------------------------------------------------
+
+/// Normalize a vector, returns its original length (a null vector is left unchanged)
+static inline float normalize(float* v)
+{
+    const float length = sqrtf(dot(v, v));
+
+    if (length > 1e-20f)
+    {
+        const float invLength = 1.0f / length;
+        v[0] *= invLength;
+        v[1] *= invLength;
+        v[2] *= invLength;
+    }
+
+    return length;
+}
+
+//-----------------------------------------------------------------------
+
+/// Compute the angles of a triangle at each of its corners
+static void cornerAngles(const float* p0, const float* p1, const float* p2, float* angles)
+{
+    const float* points[3] = { p0, p1, p2 };
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        float e1[3], e2[3];
+        subtract(points[(i + 1) % 3], points[i], e1);
+        subtract(points[(i + 2) % 3], points[i], e2);
+
+        if ((normalize(e1) <= 1e-20f) || (normalize(e2) <= 1e-20f))
+        {
+            angles[i] = 0.0f;
+            continue;
+        }
+
+        const float cosine = std::max(-1.0f, std::min(1.0f, dot(e1, e2)));
+        angles[i] = acosf(cosine);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/// Build the list of the corners (indices in the index list) using each vertex
+static void buildAdjacency(const unsigned int* pIndices, unsigned int nbIndices,
+                           unsigned int nbVertices, std::vector<unsigned int>& offsets,
+                           std::vector<unsigned int>& corners)
+{
+    offsets.assign(nbVertices + 1, 0);
+    corners.resize(nbIndices);
+
+    for (unsigned int i = 0; i < nbIndices; ++i)
+    {
+        assert(pIndices[i] < nbVertices);
+        ++offsets[pIndices[i] + 1];
+    }
+
+    for (unsigned int v = 0; v < nbVertices; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+    for (unsigned int i = 0; i < nbIndices; ++i)
+        corners[cursors[pIndices[i]]++] = i;
+}
+
+
+/*************************************** METHODS ***************************************/
+
+void TangentSpaceGenerator::computeNormals(const float* pPositions, unsigned int nbVertices,
+                                           const unsigned int* pIndices, unsigned int nbIndices,
+                                           tWeighting weighting, float* pNormals)
+{
+    assert(pPositions || (nbVertices == 0));
+    assert(pIndices || (nbIndices == 0));
+    assert(pNormals || (nbVertices == 0));
+    assert((nbIndices % 3 == 0) && "Only triangle lists are supported");
+
+    const int nbTriangles = (int) (nbIndices / 3);
+
+    // Compute the weighted normal of each corner of the triangles. Those are
+    // independent, so the triangles can be processed in parallel.
+    std::vector<float> cornerNormals(nbIndices * 3, 0.0f);
+
+#if ATHENA_GRAPHICS_THREADING
+    #pragma omp parallel for
+#endif
+    for (int t = 0; t < nbTriangles; ++t)
+    {
+        const float* p0 = &pPositions[pIndices[t * 3] * 3];
+        const float* p1 = &pPositions[pIndices[t * 3 + 1] * 3];
+        const float* p2 = &pPositions[pIndices[t * 3 + 2] * 3];
+
+        float e1[3], e2[3], normal[3];
+        subtract(p1, p0, e1);
+        subtract(p2, p0, e2);
+        cross(e1, e2, normal);
+
+        // The length of the cross product is twice the area of the triangle
+        float weights[3] = { 1.0f, 1.0f, 1.0f };
+
+        if (weighting == WEIGHT_ANGLE)
+        {
+            if (normalize(normal) <= 1e-20f)
+                continue;
+
+            cornerAngles(p0, p1, p2, weights);
+        }
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            float* pCorner = &cornerNormals[(t * 3 + i) * 3];
+            pCorner[0] = normal[0] * weights[i];
+            pCorner[1] = normal[1] * weights[i];
+            pCorner[2] = normal[2] * weights[i];
+        }
+    }
+
+
+    // Gather the corners of each vertex. Each vertex only writes its own normal, so
+    // they can be processed in parallel.
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> corners;
+    buildAdjacency(pIndices, nbIndices, nbVertices, offsets, corners);
+
+#if ATHENA_GRAPHICS_THREADING
+    #pragma omp parallel for
+#endif
+    for (int v = 0; v < (int) nbVertices; ++v)
+    {
+        float* pNormal = &pNormals[v * 3];
+        pNormal[0] = 0.0f;
+        pNormal[1] = 0.0f;
+        pNormal[2] = 0.0f;
+
+        for (unsigned int i = offsets[v]; i < offsets[v + 1]; ++i)
+        {
+            const float* pCorner = &cornerNormals[corners[i] * 3];
+            pNormal[0] += pCorner[0];
+            pNormal[1] += pCorner[1];
+            pNormal[2] += pCorner[2];
+        }
+
+        normalize(pNormal);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void TangentSpaceGenerator::computeTangents(const float* pPositions, const float* pNormals,
+                                            const float* pTexCoords, unsigned int nbVertices,
+                                            const unsigned int* pIndices, unsigned int nbIndices,
+                                            float* pTangents, float* pBinormals)
+{
+    assert(pPositions || (nbVertices == 0));
+    assert(pNormals || (nbVertices == 0));
+    assert(pTexCoords || (nbVertices == 0));
+    assert(pIndices || (nbIndices == 0));
+    assert(pTangents || (nbVertices == 0));
+    assert((nbIndices % 3 == 0) && "Only triangle lists are supported");
+
+    const int nbTriangles = (int) (nbIndices / 3);
+
+    // Compute the tangent and bitangent of each corner of the triangles, from the
+    // derivatives of the texture coordinates, weighted by the angle of the corner
+    std::vector<float> cornerTangents(nbIndices * 3, 0.0f);
+    std::vector<float> cornerBitangents(nbIndices * 3, 0.0f);
+
+#if ATHENA_GRAPHICS_THREADING
+    #pragma omp parallel for
+#endif
+    for (int t = 0; t < nbTriangles; ++t)
+    {
+        const unsigned int i0 = pIndices[t * 3];
+        const unsigned int i1 = pIndices[t * 3 + 1];
+        const unsigned int i2 = pIndices[t * 3 + 2];
+
+        const float* p0 = &pPositions[i0 * 3];
+        const float* p1 = &pPositions[i1 * 3];
+        const float* p2 = &pPositions[i2 * 3];
+
+        const float* uv0 = &pTexCoords[i0 * 2];
+        const float* uv1 = &pTexCoords[i1 * 2];
+        const float* uv2 = &pTexCoords[i2 * 2];
+
+        float e1[3], e2[3];
+        subtract(p1, p0, e1);
+        subtract(p2, p0, e2);
+
+        const float du1 = uv1[0] - uv0[0];
+        const float dv1 = uv1[1] - uv0[1];
+        const float du2 = uv2[0] - uv0[0];
+        const float dv2 = uv2[1] - uv0[1];
+
+        // Degenerated texture mapping: the triangle doesn't contribute
+        const float determinant = du1 * dv2 - du2 * dv1;
+        if (fabsf(determinant) <= 1e-20f)
+            continue;
+
+        const float r = 1.0f / determinant;
+
+        float tangent[3] = { (e1[0] * dv2 - e2[0] * dv1) * r,
+                             (e1[1] * dv2 - e2[1] * dv1) * r,
+                             (e1[2] * dv2 - e2[2] * dv1) * r };
+
+        float bitangent[3] = { (e2[0] * du1 - e1[0] * du2) * r,
+                               (e2[1] * du1 - e1[1] * du2) * r,
+                               (e2[2] * du1 - e1[2] * du2) * r };
+
+        normalize(tangent);
+        normalize(bitangent);
+
+        float angles[3];
+        cornerAngles(p0, p1, p2, angles);
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            float* pTangent = &cornerTangents[(t * 3 + i) * 3];
+            float* pBitangent = &cornerBitangents[(t * 3 + i) * 3];
+
+            pTangent[0] = tangent[0] * angles[i];
+            pTangent[1] = tangent[1] * angles[i];
+            pTangent[2] = tangent[2] * angles[i];
+
+            pBitangent[0] = bitangent[0] * angles[i];
+            pBitangent[1] = bitangent[1] * angles[i];
+            pBitangent[2] = bitangent[2] * angles[i];
+        }
+    }
+
+
+    // Gather the corners of each vertex, then orthonormalize the tangent space
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> corners;
+    buildAdjacency(pIndices, nbIndices, nbVertices, offsets, corners);
+
+#if ATHENA_GRAPHICS_THREADING
+    #pragma omp parallel for
+#endif
+    for (int v = 0; v < (int) nbVertices; ++v)
+    {
+        const float* pNormal = &pNormals[v * 3];
+        float* pTangent = &pTangents[v * 3];
+        float bitangent[3] = { 0.0f, 0.0f, 0.0f };
+
+        pTangent[0] = 0.0f;
+        pTangent[1] = 0.0f;
+        pTangent[2] = 0.0f;
+
+        for (unsigned int i = offsets[v]; i < offsets[v + 1]; ++i)
+        {
+            const float* pCornerTangent = &cornerTangents[corners[i] * 3];
+            const float* pCornerBitangent = &cornerBitangents[corners[i] * 3];
+
+            pTangent[0] += pCornerTangent[0];
+            pTangent[1] += pCornerTangent[1];
+            pTangent[2] += pCornerTangent[2];
+
+            bitangent[0] += pCornerBitangent[0];
+            bitangent[1] += pCornerBitangent[1];
+            bitangent[2] += pCornerBitangent[2];
+        }
+
+        // Gram-Schmidt orthogonalization
+        const float d = dot(pNormal, pTangent);
+        pTangent[0] -= pNormal[0] * d;
+        pTangent[1] -= pNormal[1] * d;
+        pTangent[2] -= pNormal[2] * d;
+
+        if (normalize(pTangent) <= 1e-20f)
+        {
+            // No usable texture mapping: pick any direction orthogonal to the normal
+            const float axis[3] = { 1.0f, 0.0f, 0.0f };
+            const float otherAxis[3] = { 0.0f, 1.0f, 0.0f };
+
+            cross(fabsf(pNormal[0]) < 0.9f ? axis : otherAxis, pNormal, pTangent);
+            normalize(pTangent);
+        }
+
+        if (pBinormals)
+        {
+            float* pBinormal = &pBinormals[v * 3];
+            cross(pNormal, pTangent, pBinormal);
+
+            // Handedness of the texture mapping
+            if (dot(pBinormal, bitangent) < 0.0f)
+            {
+                pBinormal[0] = -pBinormal[0];
+                pBinormal[1] = -pBinormal[1];
+                pBinormal[2] = -pBinormal[2];
+            }
+        }
+    }
+}
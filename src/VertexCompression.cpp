@@ -0,0 +1,235 @@
+/** @file   VertexCompression.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::VertexCompression'
+*/
+
+// Athena's includes
+#include <Athena-Graphics/VertexCompression.h>
+
+#include <math.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+using namespace std;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Largest value of a quantized 16-bit component
+static const float  SHORT_MAX   = 32767.0f;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Quantize a value in [-SHORT_MAX, SHORT_MAX]
+static short quantizeShort(float value)
+{
+    value = floorf(value + 0.5f);
+
+    if (value > SHORT_MAX)
+        return (short) SHORT_MAX;
+    else if (value < -SHORT_MAX)
+        return (short) -SHORT_MAX;
+
+    return (short) value;
+}
+
+//-----------------------------------------------------------------------
+
+/// Quantize a value in [-1, 1] on 8 bits
+static unsigned char quantizeByte(float value)
+{
+    value = floorf(value * 127.5f + 128.0f);
+
+    if (value > 255.0f)
+        return 255;
+    else if (value < 0.0f)
+        return 0;
+
+    return (unsigned char) value;
+}
+
+//-----------------------------------------------------------------------
+
+static float signNotZero(float value)
+{
+    return (value >= 0.0f ? 1.0f : -1.0f);
+}
+
+
+/*************************************** METHODS ***************************************/
+
+Ogre::VertexElementType VertexCompression::getElementType(tFormat format, unsigned short nbComponents)
+{
+    assert((nbComponents >= 1) && (nbComponents <= 4));
+
+    switch (format)
+    {
+    case FORMAT_SHORT:
+        return (nbComponents <= 2 ? Ogre::VET_SHORT2 : Ogre::VET_SHORT4);
+
+    case FORMAT_UBYTE:
+        return Ogre::VET_UBYTE4;
+
+    case FORMAT_OCTAHEDRAL:
+        assert((nbComponents == 3) && "The octahedral format only supports 3D unit vectors");
+        return Ogre::VET_SHORT2;
+
+    case FORMAT_FLOAT:
+    default:
+        return Ogre::VertexElementType(Ogre::VET_FLOAT1 + nbComponents - 1);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+bool VertexCompression::getVectorFormat(Ogre::VertexElementType type, tFormat& format)
+{
+    switch (type)
+    {
+    case Ogre::VET_FLOAT3:
+    case Ogre::VET_FLOAT4:
+        format = FORMAT_FLOAT;
+        return true;
+
+    case Ogre::VET_SHORT4:
+        format = FORMAT_SHORT;
+        return true;
+
+    case Ogre::VET_UBYTE4:
+        format = FORMAT_UBYTE;
+        return true;
+
+    case Ogre::VET_SHORT2:
+        format = FORMAT_OCTAHEDRAL;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+Real VertexCompression::computeScale(Real maxAbsValue)
+{
+    return (maxAbsValue > 0.0f ? maxAbsValue / SHORT_MAX : 1.0f / SHORT_MAX);
+}
+
+//-----------------------------------------------------------------------
+
+void VertexCompression::encode(tFormat format, const float* pValues, unsigned short nbComponents,
+                               Real scale, void* pDest)
+{
+    assert(pValues);
+    assert(pDest);
+
+    switch (format)
+    {
+    case FORMAT_SHORT:
+        {
+            short* pShorts = static_cast<short*>(pDest);
+            const unsigned short nbSlots = (nbComponents <= 2 ? 2 : 4);
+            const float invScale = 1.0f / scale;
+
+            for (unsigned short i = 0; i < nbSlots; ++i)
+                pShorts[i] = (i < nbComponents ? quantizeShort(pValues[i] * invScale) : 0);
+        }
+        break;
+
+    case FORMAT_UBYTE:
+        {
+            unsigned char* pBytes = static_cast<unsigned char*>(pDest);
+
+            for (unsigned short i = 0; i < 4; ++i)
+                pBytes[i] = (i < nbComponents ? quantizeByte(pValues[i]) : 128);
+        }
+        break;
+
+    case FORMAT_OCTAHEDRAL:
+        {
+            // Project the unit vector on the octahedron, then fold the lower hemisphere
+            const float l1 = fabsf(pValues[0]) + fabsf(pValues[1]) + fabsf(pValues[2]);
+            float x = (l1 > 0.0f ? pValues[0] / l1 : 0.0f);
+            float y = (l1 > 0.0f ? pValues[1] / l1 : 0.0f);
+
+            if (pValues[2] < 0.0f)
+            {
+                const float tmp = (1.0f - fabsf(y)) * signNotZero(x);
+                y = (1.0f - fabsf(x)) * signNotZero(y);
+                x = tmp;
+            }
+
+            short* pShorts = static_cast<short*>(pDest);
+            pShorts[0] = quantizeShort(x * SHORT_MAX);
+            pShorts[1] = quantizeShort(y * SHORT_MAX);
+        }
+        break;
+
+    case FORMAT_FLOAT:
+    default:
+        memcpy(pDest, pValues, nbComponents * sizeof(float));
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void VertexCompression::decode(tFormat format, const void* pSource, unsigned short nbComponents,
+                               Real scale, float* pValues)
+{
+    assert(pSource);
+    assert(pValues);
+
+    switch (format)
+    {
+    case FORMAT_SHORT:
+        {
+            const short* pShorts = static_cast<const short*>(pSource);
+
+            for (unsigned short i = 0; i < nbComponents; ++i)
+                pValues[i] = pShorts[i] * scale;
+        }
+        break;
+
+    case FORMAT_UBYTE:
+        {
+            const unsigned char* pBytes = static_cast<const unsigned char*>(pSource);
+
+            for (unsigned short i = 0; i < nbComponents; ++i)
+                pValues[i] = pBytes[i] / 127.5f - 1.0f;
+        }
+        break;
+
+    case FORMAT_OCTAHEDRAL:
+        {
+            const short* pShorts = static_cast<const short*>(pSource);
+
+            float x = pShorts[0] / SHORT_MAX;
+            float y = pShorts[1] / SHORT_MAX;
+            const float z = 1.0f - fabsf(x) - fabsf(y);
+
+            if (z < 0.0f)
+            {
+                const float tmp = (1.0f - fabsf(y)) * signNotZero(x);
+                y = (1.0f - fabsf(x)) * signNotZero(y);
+                x = tmp;
+            }
+
+            const float length = sqrtf(x * x + y * y + z * z);
+
+            pValues[0] = x / length;
+            pValues[1] = y / length;
+            pValues[2] = z / length;
+        }
+        break;
+
+    case FORMAT_FLOAT:
+    default:
+        memcpy(pValues, pSource, nbComponents * sizeof(float));
+        break;
+    }
+}
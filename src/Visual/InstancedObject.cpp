@@ -0,0 +1,245 @@
+/** @file   InstancedObject.cpp
+    @author Philip Abbet
+
+    Implementation of the class 'Athena::Graphics::Visual::InstancedObject'
+*/
+
+#include <Athena-Graphics/Visual/InstancedObject.h>
+#include <Athena-Core/Log/LogManager.h>
+#include <Ogre/OgreMeshManager.h>
+#include <Ogre/OgreSceneManager.h>
+
+
+using namespace Athena;
+using namespace Athena::Graphics;
+using namespace Athena::Graphics::Visual;
+using namespace Athena::Entities;
+using namespace Athena::Utils;
+using namespace Athena::Log;
+using namespace std;
+
+using Ogre::Exception;
+using Ogre::MeshManager;
+using Ogre::MeshPtr;
+
+
+/************************************** CONSTANTS **************************************/
+
+/// Context used for logging
+static const char* __CONTEXT__  = "Visual/InstancedObject";
+
+///< Name of the type of component
+const std::string InstancedObject::TYPE = "Athena/Visual/InstancedObject";
+
+
+/***************************** CONSTRUCTION / DESTRUCTION ******************************/
+
+InstancedObject::InstancedObject(const std::string& strName, ComponentsList* pList)
+: EntityComponent(strName, pList), m_pInstancedMesh(0)
+{
+}
+
+//-----------------------------------------------------------------------
+
+InstancedObject::~InstancedObject()
+{
+    assert(getSceneManager());
+    assert(m_pSceneNode);
+
+    if (m_pInstancedMesh)
+        destroyInstancedMesh();
+}
+
+//-----------------------------------------------------------------------
+
+InstancedObject* InstancedObject::create(const std::string& strName, ComponentsList* pList)
+{
+    return new InstancedObject(strName, pList);
+}
+
+//-----------------------------------------------------------------------
+
+InstancedObject* InstancedObject::cast(Component* pComponent)
+{
+    return dynamic_cast<InstancedObject*>(pComponent);
+}
+
+
+/*************************************** METHODS ***************************************/
+
+bool InstancedObject::loadMesh(const std::string& strMeshName, const std::string& strGroupName)
+{
+    // Assertions
+    assert(!m_pInstancedMesh);
+    assert(!strMeshName.empty());
+    assert(getSceneManager());
+    assert(m_pSceneNode);
+
+    try
+    {
+        // Retrieve the mesh
+        MeshPtr mesh = MeshManager::getSingletonPtr()->getByName(strMeshName);
+        if (mesh.isNull())
+        {
+            mesh = MeshManager::getSingletonPtr()->load(strMeshName, strGroupName);
+            if (mesh.isNull())
+            {
+                ATHENA_LOG_ERROR("Failed to load the mesh '" + strMeshName + "' on the entity '" +
+                                 m_id.strName + "', reason: file not found");
+                return false;
+            }
+        }
+
+        if (!mesh->isLoaded())
+            mesh->load();
+
+        // Create the instanced mesh and attach it to the scene node
+        m_pInstancedMesh = new InstancedMesh(m_id.strEntity + ".Visual[" + m_id.strName + "].InstancedMesh", mesh);
+        m_pInstancedMesh->_notifyManager(getSceneManager());
+
+        if (m_pInstancedMesh->getMaxNbInstances() == 0)
+        {
+            ATHENA_LOG_ERROR("Failed to load the mesh '" + strMeshName + "' on the entity '" +
+                             m_id.strName + "', reason: the mesh doesn't have any instance buffer");
+            delete m_pInstancedMesh;
+            m_pInstancedMesh = 0;
+            return false;
+        }
+
+        attachObject(m_pInstancedMesh);
+    }
+    catch (Exception& ex)
+    {
+        ATHENA_LOG_ERROR("Failed to load the mesh '" + strMeshName + "' on the entity '" +
+                         m_id.strName + "', reason: " + ex.getFullDescription());
+
+        delete m_pInstancedMesh;
+        m_pInstancedMesh = 0;
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedObject::setNbInstances(unsigned int nbInstances)
+{
+    // Assertions
+    assert(m_pInstancedMesh);
+
+    m_pInstancedMesh->setNbInstances(nbInstances);
+}
+
+//-----------------------------------------------------------------------
+
+unsigned int InstancedObject::getNbInstances() const
+{
+    return (m_pInstancedMesh ? m_pInstancedMesh->getNbInstances() : 0);
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedObject::setInstanceData(unsigned short usSource, unsigned int start,
+                                      unsigned int nbElements, const void* pData)
+{
+    // Assertions
+    assert(m_pInstancedMesh);
+
+    m_pInstancedMesh->setInstanceData(usSource, start, nbElements, pData);
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedObject::setInstancesBounds(const Math::AxisAlignedBox& box)
+{
+    // Assertions
+    assert(m_pInstancedMesh);
+
+    m_pInstancedMesh->setBoundingBox(box);
+}
+
+//-----------------------------------------------------------------------
+
+void InstancedObject::destroyInstancedMesh()
+{
+    // Assertions
+    assert(m_pInstancedMesh);
+    assert(m_pInstancedMesh->getParentNode() == m_pSceneNode);
+
+    m_pSceneNode->detachObject(m_pInstancedMesh);
+    delete m_pInstancedMesh;
+    m_pInstancedMesh = 0;
+}
+
+
+/***************************** MANAGEMENT OF THE PROPERTIES ****************************/
+
+Utils::PropertiesList* InstancedObject::getProperties() const
+{
+    // Call the base class implementation
+    PropertiesList* pProperties = EntityComponent::getProperties();
+
+    // Create the category belonging to this type
+    pProperties->selectCategory(TYPE, false);
+
+    if (m_pInstancedMesh)
+    {
+        // Mesh
+        pProperties->set("mesh", new Variant(m_pInstancedMesh->getMesh()->getName()));
+
+        // Number of instances
+        pProperties->set("nbInstances", new Variant(m_pInstancedMesh->getNbInstances()));
+    }
+
+    // Returns the list
+    return pProperties;
+}
+
+//-----------------------------------------------------------------------
+
+bool InstancedObject::setProperty(const std::string& strCategory, const std::string& strName,
+                                  Utils::Variant* pValue)
+{
+    assert(!strCategory.empty());
+    assert(!strName.empty());
+    assert(pValue);
+
+    if (strCategory == TYPE)
+        return InstancedObject::setProperty(strName, pValue);
+
+    return EntityComponent::setProperty(strCategory, strName, pValue);
+}
+
+//-----------------------------------------------------------------------
+
+bool InstancedObject::setProperty(const std::string& strName, Utils::Variant* pValue)
+{
+    // Assertions
+    assert(!strName.empty());
+    assert(pValue);
+
+    // Declarations
+    bool bUsed = true;
+
+    // Mesh
+    if (strName == "mesh")
+    {
+        loadMesh(pValue->toString());
+    }
+    else if (m_pInstancedMesh)
+    {
+        // Number of instances (their data isn't serialized)
+        if (strName == "nbInstances")
+            m_pInstancedMesh->setNbInstances(pValue->toUInt());
+    }
+    else
+    {
+        bUsed = false;
+    }
+
+    // Destroy the value
+    delete pValue;
+
+    return bUsed;
+}
@@ -5,11 +5,15 @@
 */
 
 #include <Athena-Graphics/Visual/Object.h>
+#include <Athena-Graphics/Visual/World.h>
 #include <Athena-Core/Log/LogManager.h>
 #include <Ogre/OgreEntity.h>
 #include <Ogre/OgreSubEntity.h>
 #include <Ogre/OgreMeshManager.h>
+#include <Ogre/OgreSubMesh.h>
 #include <Ogre/OgreSceneManager.h>
+#include <Ogre/OgreHardwareBufferManager.h>
+#include <Ogre/OgreRoot.h>
 
 
 using namespace Athena;
@@ -22,9 +26,15 @@ using namespace std;
 
 using Ogre::Entity;
 using Ogre::Exception;
+using Ogre::HardwareBuffer;
+using Ogre::HardwareBufferManager;
+using Ogre::HardwareIndexBuffer;
+using Ogre::HardwareIndexBufferSharedPtr;
+using Ogre::IndexData;
 using Ogre::MeshManager;
 using Ogre::MeshPtr;
 using Ogre::SubEntity;
+using Ogre::SubMesh;
 
 
 /************************************** CONSTANTS **************************************/
@@ -39,7 +49,8 @@ const std::string Object::TYPE  = "Athena/Visual/Object";
 /***************************** CONSTRUCTION / DESTRUCTION ******************************/
 
 Object::Object(const std::string& strName, ComponentsList* pList)
-: EntityComponent(strName, pList), m_pEntity(0)
+: EntityComponent(strName, pList), m_pEntity(0), m_pCullingCamera(0), m_cullingFrame(0),
+  m_bStatic(false), m_bBatched(false)
 {
 }
 
@@ -50,14 +61,14 @@ Object::~Object()
     assert(getSceneManager());
     assert(m_pSceneNode);
 
+    if (m_bStatic && getWorld())
+        getWorld()->_removeStaticObject(this);
+
     if (m_pEntity)
-    {
-        assert(m_pEntity->getParentNode() == m_pSceneNode);
+        destroyEntity();
 
-        m_pSceneNode->detachObject(m_pEntity);
-        getSceneManager()->destroyEntity(m_pEntity);
-        m_pEntity = 0;
-    }
+    if (!m_clusteredMesh.isNull())
+        destroyClusteredMesh();
 }
 
 //-----------------------------------------------------------------------
@@ -114,6 +125,356 @@ bool Object::loadMesh(const std::string& strMeshName, const std::string& strGrou
     return true;
 }
 
+//-----------------------------------------------------------------------
+
+bool Object::enableClusterCulling(const MeshClusters& clusters)
+{
+    // Assertions
+    assert(m_pEntity);
+    assert(!isClusterCullingEnabled());
+    assert(clusters.getNbSubMeshes() == m_pEntity->getMesh()->getNumSubMeshes());
+
+    MeshPtr mesh = m_pEntity->getMesh();
+    const std::string strClusteredMeshName = m_pEntity->getName() + ".ClusteredMesh";
+
+    std::vector<IndexData*> culledIndexData;
+    std::vector<IndexData*> allIndexData;
+
+    try
+    {
+        // Create a copy of the mesh, sharing the vertex buffers and the index buffers of
+        // the submeshes that aren't clustered
+        MeshPtr clusteredMesh = MeshManager::getSingletonPtr()->createManual(strClusteredMeshName,
+                                                                             mesh->getGroup());
+
+        if (mesh->sharedVertexData)
+        {
+            clusteredMesh->sharedVertexData = mesh->sharedVertexData->clone(false);
+            clusteredMesh->sharedBlendIndexToBoneIndexMap = mesh->sharedBlendIndexToBoneIndexMap;
+        }
+
+        culledIndexData.resize(mesh->getNumSubMeshes(), 0);
+        allIndexData.resize(mesh->getNumSubMeshes(), 0);
+
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            SubMesh* pSource = mesh->getSubMesh(i);
+            SubMesh* pSubMesh = clusteredMesh->createSubMesh();
+            const MeshClusters::tSubMeshClusters& subMeshClusters = clusters.getSubMesh(i);
+
+            pSubMesh->useSharedVertices         = pSource->useSharedVertices;
+            pSubMesh->operationType             = pSource->operationType;
+            pSubMesh->blendIndexToBoneIndexMap  = pSource->blendIndexToBoneIndexMap;
+            pSubMesh->setMaterialName(pSource->getMaterialName());
+
+            if (!pSource->useSharedVertices)
+                pSubMesh->vertexData = pSource->vertexData->clone(false);
+
+            delete pSubMesh->indexData;
+
+            if (subMeshClusters.clusters.empty())
+            {
+                pSubMesh->indexData = pSource->indexData->clone(false);
+                continue;
+            }
+
+            // The clustered submeshes get a dynamic index buffer, rewritten when the
+            // visible clusters change
+            pSubMesh->indexData = new IndexData();
+            pSubMesh->indexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+                                                    pSource->indexData->indexBuffer->getType(),
+                                                    subMeshClusters.indices.size(),
+                                                    HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY_DISCARDABLE);
+
+            // The shadow cameras render all the clusters, from the static index buffer
+            // of the source
+            culledIndexData[i]  = pSubMesh->indexData;
+            allIndexData[i]     = pSource->indexData->clone(false);
+        }
+
+        if (mesh->hasSkeleton())
+            clusteredMesh->setSkeletonName(mesh->getSkeletonName());
+
+        clusteredMesh->_setBounds(mesh->getBounds(), false);
+        clusteredMesh->_setBoundingSphereRadius(mesh->getBoundingSphereRadius());
+        clusteredMesh->load();
+
+        m_originalMesh      = mesh;
+        m_clusteredMesh     = clusteredMesh;
+        m_clusters          = clusters;
+        m_pCullingCamera    = 0;
+
+        m_culledIndexData.swap(culledIndexData);
+        m_allIndexData.swap(allIndexData);
+
+        // No cluster is considered visible yet, so the index buffers are filled during
+        // the first rendering
+        m_clustersVisibility.clear();
+        m_clustersVisibility.resize(clusters.getNbSubMeshes());
+
+        for (unsigned int i = 0; i < clusters.getNbSubMeshes(); ++i)
+        {
+            m_clustersVisibility[i].resize(clusters.getSubMesh(i).clusters.size(), 0);
+            if (!m_clustersVisibility[i].empty())
+                clusteredMesh->getSubMesh(i)->indexData->indexCount = 0;
+        }
+
+        replaceEntity(clusteredMesh->getName());
+        m_pEntity->setListener(this);
+    }
+    catch (Exception& ex)
+    {
+        ATHENA_LOG_ERROR("Failed to enable the culling of the clusters of the mesh '" + mesh->getName() +
+                         "' on the entity '" + m_id.strName + "', reason: " + ex.getFullDescription());
+
+        if (m_clusteredMesh.isNull())
+        {
+            MeshManager::getSingletonPtr()->remove(strClusteredMeshName);
+
+            for (unsigned int i = 0; i < allIndexData.size(); ++i)
+                delete allIndexData[i];
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+void Object::disableClusterCulling()
+{
+    if (!isClusterCullingEnabled())
+        return;
+
+    replaceEntity(m_originalMesh->getName());
+
+    destroyClusteredMesh();
+
+    m_originalMesh.setNull();
+    m_clusters.clear();
+    m_clustersVisibility.clear();
+}
+
+//-----------------------------------------------------------------------
+
+void Object::setStatic(bool bStatic)
+{
+    // Assertions
+    assert(getWorld());
+
+    if (bStatic == m_bStatic)
+        return;
+
+    m_bStatic = bStatic;
+
+    if (m_bStatic)
+        getWorld()->_addStaticObject(this);
+    else
+        getWorld()->_removeStaticObject(this);
+}
+
+//-----------------------------------------------------------------------
+
+void Object::_setBatched(bool bBatched)
+{
+    // Assertions
+    assert(m_pEntity);
+    assert(m_bStatic || !bBatched);
+
+    if (bBatched == m_bBatched)
+        return;
+
+    m_bBatched = bBatched;
+
+    // The entity of a batched object isn't rendered, nor even culled
+    if (m_bBatched)
+        m_pSceneNode->detachObject(m_pEntity);
+    else
+        attachObject(m_pEntity);
+}
+
+//-----------------------------------------------------------------------
+
+void Object::cullClusters(const Ogre::Camera* pCamera)
+{
+    // Assertions
+    assert(m_pEntity);
+    assert(isClusterCullingEnabled());
+
+    const Ogre::Matrix4& transform = m_pEntity->_getParentNodeFullTransform();
+
+    std::vector<unsigned char> visibility;
+
+    for (unsigned int i = 0; i < m_clusters.getNbSubMeshes(); ++i)
+    {
+        const MeshClusters::tSubMeshClusters& subMesh = m_clusters.getSubMesh(i);
+        if (subMesh.clusters.empty())
+            continue;
+
+        MeshClusters::cull(subMesh.clusters, pCamera, transform, visibility);
+
+        // Only rewrite the index buffer when the visible clusters changed
+        if (visibility == m_clustersVisibility[i])
+            continue;
+
+        m_clustersVisibility[i].swap(visibility);
+
+        IndexData* pIndexData = m_culledIndexData[i];
+        HardwareIndexBufferSharedPtr buffer = pIndexData->indexBuffer;
+
+        const bool b32Bits = (buffer->getType() == HardwareIndexBuffer::IT_32BIT);
+        unsigned int nbIndices = 0;
+
+        unsigned char* pDest = static_cast<unsigned char*>(buffer->lock(HardwareBuffer::HBL_DISCARD));
+
+        for (unsigned int j = 0; j < subMesh.clusters.size(); ++j)
+        {
+            if (!m_clustersVisibility[i][j])
+                continue;
+
+            const MeshClusters::tCluster& cluster = subMesh.clusters[j];
+            const unsigned int* pSource = &subMesh.indices[cluster.indexStart];
+
+            if (b32Bits)
+            {
+                memcpy(pDest + nbIndices * sizeof(unsigned int), pSource,
+                       cluster.nbIndices * sizeof(unsigned int));
+            }
+            else
+            {
+                unsigned short* pIndices = reinterpret_cast<unsigned short*>(pDest) + nbIndices;
+                for (unsigned int k = 0; k < cluster.nbIndices; ++k)
+                    pIndices[k] = (unsigned short) pSource[k];
+            }
+
+            nbIndices += cluster.nbIndices;
+        }
+
+        buffer->unlock();
+
+        pIndexData->indexStart = 0;
+        pIndexData->indexCount = nbIndices;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void Object::renderAllClusters(bool bAll)
+{
+    // Assertions
+    assert(isClusterCullingEnabled());
+
+    for (unsigned int i = 0; i < m_culledIndexData.size(); ++i)
+    {
+        if (m_culledIndexData[i])
+            m_clusteredMesh->getSubMesh(i)->indexData = (bAll ? m_allIndexData[i] : m_culledIndexData[i]);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void Object::destroyClusteredMesh()
+{
+    // Assertions
+    assert(isClusterCullingEnabled());
+
+    // The submeshes must own their dynamic index data when destroyed
+    renderAllClusters(false);
+
+    MeshManager::getSingletonPtr()->remove(m_clusteredMesh->getHandle());
+    m_clusteredMesh.setNull();
+
+    for (unsigned int i = 0; i < m_allIndexData.size(); ++i)
+        delete m_allIndexData[i];
+
+    m_allIndexData.clear();
+    m_culledIndexData.clear();
+    m_pCullingCamera = 0;
+}
+
+//-----------------------------------------------------------------------
+
+void Object::replaceEntity(const std::string& strMeshName)
+{
+    // Assertions
+    assert(m_pEntity);
+
+    // Save the state of the subentities
+    std::vector<std::pair<std::string, bool> > subEntities;
+    for (unsigned int i = 0; i < m_pEntity->getNumSubEntities(); ++i)
+    {
+        SubEntity* pSubEntity = m_pEntity->getSubEntity(i);
+        subEntities.push_back(std::make_pair(pSubEntity->getMaterialName(), pSubEntity->isVisible()));
+    }
+
+    const std::string strName = m_pEntity->getName();
+
+    destroyEntity();
+
+    m_pEntity = getSceneManager()->createEntity(strName, strMeshName);
+    attachObject(m_pEntity);
+
+    if (m_bBatched)
+        m_pSceneNode->detachObject(m_pEntity);
+
+    // Restore the state of the subentities
+    for (unsigned int i = 0; i < std::min((unsigned int) subEntities.size(), m_pEntity->getNumSubEntities()); ++i)
+    {
+        SubEntity* pSubEntity = m_pEntity->getSubEntity(i);
+        pSubEntity->setMaterialName(subEntities[i].first);
+        pSubEntity->setVisible(subEntities[i].second);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void Object::destroyEntity()
+{
+    // Assertions
+    assert(m_pEntity);
+    assert(!m_pEntity->getParentNode() || (m_pEntity->getParentNode() == m_pSceneNode));
+
+    m_pEntity->setListener(0);
+
+    if (m_pEntity->getParentNode())
+        m_pSceneNode->detachObject(m_pEntity);
+
+    getSceneManager()->destroyEntity(m_pEntity);
+    m_pEntity = 0;
+}
+
+
+/********************* IMPLEMENTATION OF Ogre::MovableObject::Listener *****************/
+
+bool Object::objectRendering(const Ogre::MovableObject* pObject, const Ogre::Camera* pCamera)
+{
+    assert(pObject == m_pEntity);
+
+    // A shadow can be cast by a cluster invisible from the camera: the shadow cameras
+    // render all of them, without touching the culled index buffers
+    const bool bShadows = (getSceneManager()->_getCurrentRenderStage() == Ogre::SceneManager::IRS_RENDER_TO_TEXTURE);
+
+    renderAllClusters(bShadows);
+
+    if (bShadows)
+        return true;
+
+    // The clusters are only culled once per camera and frame (the listener is called
+    // for each render target, pass and compositor using the camera)
+    const unsigned long frame = Ogre::Root::getSingleton().getNextFrameNumber();
+    if ((pCamera == m_pCullingCamera) && (frame == m_cullingFrame))
+        return true;
+
+    m_pCullingCamera    = pCamera;
+    m_cullingFrame      = frame;
+
+    cullClusters(pCamera);
+
+    return true;
+}
+
 
 /***************************** MANAGEMENT OF THE PROPERTIES ****************************/
 
@@ -125,10 +486,14 @@ Utils::PropertiesList* Object::getProperties() const
     // Create the category belonging to this type
     pProperties->selectCategory(TYPE, false);
 
+    // Static
+    pProperties->set("static", new Variant(m_bStatic));
+
     if (m_pEntity)
     {
         // Mesh
-        pProperties->set("mesh", new Variant(m_pEntity->getMesh()->getName()));
+        pProperties->set("mesh", new Variant(isClusterCullingEnabled() ? m_originalMesh->getName() :
+                                                                        m_pEntity->getMesh()->getName()));
 
         // Subentities
         for (unsigned int i = 0; i < m_pEntity->getNumSubEntities(); ++i)
@@ -178,6 +543,13 @@ bool Object::setProperty(const std::string& strName, Utils::Variant* pValue)
     {
         loadMesh(pValue->toString());
     }
+
+    // Static
+    else if (strName == "static")
+    {
+        setStatic(pValue->toBool());
+    }
+
     else if (m_pEntity)
     {
         // Sub-entities
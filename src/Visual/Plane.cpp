@@ -6,6 +6,9 @@
 
 #include <Athena-Graphics/Visual/Plane.h>
 #include <Athena-Graphics/Conversions.h>
+#include <Athena-Graphics/DynamicMesh.h>
+#include <Athena-Graphics/MeshBounds.h>
+#include <Athena-Graphics/MeshBuilder.h>
 #include <Athena-Core/Log/LogManager.h>
 #include <Ogre/OgreEntity.h>
 #include <Ogre/OgreSubEntity.h>
@@ -24,9 +27,9 @@ using namespace std;
 using Athena::Math::Vector3;
 using Ogre::Entity;
 using Ogre::Exception;
+using Ogre::HardwareBuffer;
 using Ogre::MeshManager;
 using Ogre::MeshPtr;
-using Ogre::ResourceGroupManager;
 
 
 /************************************** CONSTANTS **************************************/
@@ -38,13 +41,68 @@ static const char*  __CONTEXT__ = "Visual/Plane";
 const std::string   Plane::TYPE = "Athena/Visual/Plane";
 
 
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Compute the vertices of a plane, the same way than Ogre::MeshManager::createPlane()
+static void computeVertices(const Vector3& normalVector, Math::Real distance, Math::Real width,
+                            Math::Real height, int xSegments, int ySegments, Math::Real uTile,
+                            Math::Real vTile, const Vector3& upVector, std::vector<float>& positions,
+                            std::vector<float>& normals, std::vector<float>& texCoords)
+{
+    // The up vector is orthogonalised against the normal, so the axes are orthonormal
+    // even if the up vector isn't in the plane
+    const Ogre::Vector3 zAxis = toOgre(normalVector).normalisedCopy();
+    Ogre::Vector3 xAxis = toOgre(upVector).crossProduct(zAxis);
+
+    assert(!xAxis.isZeroLength() && "The up vector of the plane is parallel to its normal");
+
+    xAxis.normalise();
+
+    const Ogre::Vector3 yAxis = zAxis.crossProduct(xAxis);
+    const Ogre::Vector3 translation = toOgre(normalVector) * distance;
+
+    const unsigned int nbVertices = (xSegments + 1) * (ySegments + 1);
+
+    positions.resize(nbVertices * 3);
+    normals.resize(nbVertices * 3);
+    texCoords.resize(nbVertices * 2);
+
+    const Math::Real xSpace = width / xSegments;
+    const Math::Real ySpace = height / ySegments;
+    const Math::Real xTex   = uTile / xSegments;
+    const Math::Real yTex   = vTile / ySegments;
+
+    unsigned int index = 0;
+    for (int y = 0; y <= ySegments; ++y)
+    {
+        for (int x = 0; x <= xSegments; ++x, ++index)
+        {
+            const Ogre::Vector3 position = xAxis * (x * xSpace - width * 0.5f) +
+                                           yAxis * (y * ySpace - height * 0.5f) + translation;
+
+            positions[index * 3]        = position.x;
+            positions[index * 3 + 1]    = position.y;
+            positions[index * 3 + 2]    = position.z;
+
+            normals[index * 3]          = zAxis.x;
+            normals[index * 3 + 1]      = zAxis.y;
+            normals[index * 3 + 2]      = zAxis.z;
+
+            texCoords[index * 2]        = x * xTex;
+            texCoords[index * 2 + 1]    = 1.0f - y * yTex;
+        }
+    }
+}
+
+
 /***************************** CONSTRUCTION / DESTRUCTION ******************************/
 
 Plane::Plane(const std::string& strName, ComponentsList* pList)
 : EntityComponent(strName, pList), m_pEntity(0), m_strMaterial(""),
   m_normalVector(Vector3::ZERO), m_distance(0.0f), m_width(0.0f), m_height(0.0f), m_xSegments(1),
   m_ySegments(1), m_bNormals(true), m_iNbTexCoordSet(1), m_uTile(1.0f), m_vTile(1.0f),
-  m_upVector(Vector3::UNIT_Y)
+  m_upVector(Vector3::UNIT_Y), m_pDynamicMesh(0), m_meshXSegments(0), m_meshYSegments(0),
+  m_bMeshNormals(false), m_iMeshNbTexCoordSet(0)
 {
 }
 
@@ -58,11 +116,7 @@ Plane::~Plane()
     if (m_pEntity)
     {
         assert(m_pEntity->getParentNode() == m_pSceneNode);
-
-        m_pSceneNode->detachObject(m_pEntity);
-        getSceneManager()->destroyEntity(m_pEntity);
-        m_pEntity = 0;
-        MeshManager::getSingleton().remove(m_id.strEntity + ".Visual[" + m_id.strName + "].Mesh");
+        destroyPlane();
     }
 }
 
@@ -120,29 +174,79 @@ bool Plane::createPlane()
 
     try
     {
-        // Destroy the previous plane (if any)
-        if (m_pEntity)
-        {
-            m_pSceneNode->detachObject(m_pEntity);
-            getSceneManager()->destroyEntity(m_pEntity);
-            m_pEntity = 0;
-            MeshManager::getSingleton().remove(m_id.strEntity + ".Visual[" + m_id.strName + "].Mesh");
-        }
-
         // Check that we have enough informations about the plane
         if (m_strMaterial.empty() || m_normalVector.isZeroLength() || (m_distance < 0.0f) ||
-            (m_width <= 0.0f) || (m_height <= 0.0f))
+            (m_width <= 0.0f) || (m_height <= 0.0f) || (m_xSegments <= 0) || (m_ySegments <= 0))
+        {
+            destroyPlane();
             return false;
+        }
+
+        // Only update the vertices if the tesselation didn't change
+        if (m_pEntity && (m_xSegments == m_meshXSegments) && (m_ySegments == m_meshYSegments) &&
+            (m_bNormals == m_bMeshNormals) && (m_iNbTexCoordSet == m_iMeshNbTexCoordSet))
+        {
+            updatePlane();
+            m_pEntity->setMaterialName(m_strMaterial);
+            return true;
+        }
+
+        // Destroy the previous plane (if any)
+        destroyPlane();
 
         string strPrefix = m_id.strEntity + ".Visual[" + m_id.strName + "]";
 
-        // Create the plane
-        MeshPtr mesh = MeshManager::getSingleton().createPlane(strPrefix + ".Mesh",
-                                                               ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
-                                                               Ogre::Plane(toOgre(m_normalVector), m_distance), m_width, m_height,
-                                                               m_xSegments, m_ySegments, m_bNormals, m_iNbTexCoordSet,
-                                                               m_uTile, m_vTile, toOgre(m_upVector));
-        m_pEntity = getSceneManager()->createEntity(strPrefix + ".Entity", strPrefix + ".Mesh");
+        // Create the plane, with a static vertex buffer (shadowed, so it can be made
+        // dynamic if its vertices are updated later)
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+
+        computeVertices(m_normalVector, m_distance, m_width, m_height, m_xSegments, m_ySegments,
+                        m_uTile, m_vTile, m_upVector, positions, normals, texCoords);
+
+        MeshBuilder builder(strPrefix + ".Mesh");
+
+        builder.begin("Plane", m_strMaterial);
+        builder.declareVertexBuffer(0, HardwareBuffer::HBU_STATIC_WRITE_ONLY, true);
+        builder.declarePosition();
+
+        if (m_bNormals)
+            builder.declareNormal();
+
+        for (int i = 0; i < m_iNbTexCoordSet; ++i)
+            builder.declareTextureCoordinates(0, 2);
+
+        builder.positions(&positions[0], positions.size() / 3);
+
+        if (m_bNormals)
+            builder.normals(&normals[0]);
+
+        for (int i = 0; i < m_iNbTexCoordSet; ++i)
+            builder.textureCoords(&texCoords[0], 2);
+
+        for (int y = 0; y < m_ySegments; ++y)
+        {
+            for (int x = 0; x < m_xSegments; ++x)
+            {
+                const unsigned int v = y * (m_xSegments + 1) + x;
+
+                builder.triangle(v + m_xSegments + 1, v, v + m_xSegments + 2);
+                builder.triangle(v + m_xSegments + 2, v, v + 1);
+            }
+        }
+
+        builder.end();
+
+        // Retrieving the mesh builds it (and saves it in the cache, if any)
+        MeshPtr mesh = builder.getMesh();
+
+        m_meshXSegments         = m_xSegments;
+        m_meshYSegments         = m_ySegments;
+        m_bMeshNormals          = m_bNormals;
+        m_iMeshNbTexCoordSet    = m_iNbTexCoordSet;
+
+        m_pEntity = getSceneManager()->createEntity(strPrefix + ".Entity", mesh->getName());
 
         m_pEntity->setCastShadows(false);
         m_pEntity->setMaterialName(m_strMaterial);
@@ -159,6 +263,62 @@ bool Plane::createPlane()
     return true;
 }
 
+//-----------------------------------------------------------------------
+
+void Plane::updatePlane()
+{
+    // Assertions
+    assert(m_pEntity);
+
+    // The vertex buffer is only replaced by a dynamic one the first time the plane
+    // is updated
+    if (!m_pDynamicMesh)
+        m_pDynamicMesh = new DynamicMesh(m_pEntity->getMesh());
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+
+    computeVertices(m_normalVector, m_distance, m_width, m_height, m_xSegments, m_ySegments,
+                    m_uTile, m_vTile, m_upVector, positions, normals, texCoords);
+
+    const unsigned int nbVertices = positions.size() / 3;
+
+    m_pDynamicMesh->setValues(0, Ogre::VES_POSITION, 0, nbVertices, &positions[0]);
+
+    if (m_bNormals)
+        m_pDynamicMesh->setValues(0, Ogre::VES_NORMAL, 0, nbVertices, &normals[0]);
+
+    for (int i = 0; i < m_iNbTexCoordSet; ++i)
+        m_pDynamicMesh->setValues(0, Ogre::VES_TEXTURE_COORDINATES, 0, nbVertices, &texCoords[0], i);
+
+    m_pDynamicMesh->update();
+
+    // Update the bounds of the mesh
+    const MeshBounds::tBounds bounds = MeshBounds::compute(&positions[0], nbVertices);
+
+    MeshPtr mesh = m_pDynamicMesh->getMesh();
+    mesh->_setBounds(toOgre(bounds.aabb));
+    mesh->_setBoundingSphereRadius(MeshBounds::getRadiusFromOrigin(bounds));
+}
+
+//-----------------------------------------------------------------------
+
+void Plane::destroyPlane()
+{
+    if (!m_pEntity)
+        return;
+
+    m_pSceneNode->detachObject(m_pEntity);
+    getSceneManager()->destroyEntity(m_pEntity);
+    m_pEntity = 0;
+
+    delete m_pDynamicMesh;
+    m_pDynamicMesh = 0;
+
+    MeshManager::getSingleton().remove(m_id.strEntity + ".Visual[" + m_id.strName + "].Mesh");
+}
+
 
 /***************************** MANAGEMENT OF THE PROPERTIES ****************************/
 
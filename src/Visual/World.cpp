@@ -5,11 +5,23 @@
 */
 
 #include <Athena-Graphics/Visual/World.h>
+#include <Athena-Graphics/Visual/Object.h>
+#include <Athena-Graphics/GraphicTools.h>
+#include <Athena-Graphics/MeshBuilder.h>
+#include <Athena-Graphics/MeshTransformer.h>
 #include <Athena-Graphics/Conversions.h>
 #include <Athena-Entities/Scene.h>
 #include <Athena-Core/Log/LogManager.h>
 #include <Ogre/OgreRoot.h>
 #include <Ogre/OgreSceneManager.h>
+#include <Ogre/OgreMeshManager.h>
+#include <Ogre/OgreSubMesh.h>
+#include <Ogre/OgreSubEntity.h>
+#include <Ogre/OgreStringConverter.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
 
 
 using namespace Athena;
@@ -22,6 +34,18 @@ using namespace Athena::Math;
 using namespace Athena::Log;
 using namespace std;
 
+using Ogre::Entity;
+using Ogre::HardwareBuffer;
+using Ogre::HardwareVertexBufferSharedPtr;
+using Ogre::IndexData;
+using Ogre::MeshManager;
+using Ogre::MeshPtr;
+using Ogre::StringConverter;
+using Ogre::SubEntity;
+using Ogre::SubMesh;
+using Ogre::VertexData;
+using Ogre::VertexElement;
+
 
 /************************************** CONSTANTS **************************************/
 
@@ -35,10 +59,276 @@ const std::string World::DEFAULT_NAME   = "VisualWorld";
 const std::string   World::TYPE         = "Athena/Visual/World";
 
 
+/********************************** STATIC ATTRIBUTES **********************************/
+
+/// Used to give unique names to the static batches
+static unsigned int nbStaticBatchesCreated = 0;
+
+
+/********************************** STATIC FUNCTIONS ***********************************/
+
+/// Geometry of a visible submesh of a static object, in world space
+struct tBatchPart
+{
+    std::string                     strKey;             ///< Material and vertex format
+    std::string                     strMaterial;
+    unsigned int                    nbVertices;
+    std::vector<Real>               positions;
+    std::vector<Real>               normals;
+    std::vector<Real>               diffuseColors;
+    std::vector<Real>               specularColors;
+    std::vector<std::vector<Real> > textureCoords;
+    std::vector<unsigned short>     textureCoordsDims;
+    std::vector<Real>               binormals;
+    std::vector<Real>               tangents;
+    std::vector<unsigned int>       indices;
+};
+
+//-----------------------------------------------------------------------
+
+/// Read an attribute of the vertices, as floats (colours as red, green, blue and
+/// alpha). Returns 'false' if the attribute exists but can't be read.
+static bool readElement(VertexData* pVertexData, Ogre::VertexElementSemantic semantic,
+                        unsigned short usIndex, std::vector<Real>& values,
+                        unsigned short& nbComponents)
+{
+    values.clear();
+    nbComponents = 0;
+
+    const VertexElement* pElement = pVertexData->vertexDeclaration->findElementBySemantic(semantic, usIndex);
+    if (!pElement)
+        return true;
+
+    HardwareVertexBufferSharedPtr buffer = pVertexData->vertexBufferBinding->getBuffer(pElement->getSource());
+    if (!GraphicTools::isReadable(buffer.get()))
+        return false;
+
+    Ogre::VertexElementType type = pElement->getType();
+    if (type == Ogre::VET_COLOUR)
+        type = VertexElement::getBestColourVertexElementType();
+
+    const bool bColour = (type == Ogre::VET_COLOUR_ARGB) || (type == Ogre::VET_COLOUR_ABGR);
+    if (!bColour && (VertexElement::getBaseType(type) != Ogre::VET_FLOAT1))
+        return false;
+
+    nbComponents = (bColour ? 4 : VertexElement::getTypeCount(type));
+    values.resize(pVertexData->vertexCount * nbComponents);
+
+    const size_t vertexSize = buffer->getVertexSize();
+    const unsigned char* pSource = static_cast<const unsigned char*>(
+            buffer->lock(pVertexData->vertexStart * vertexSize, pVertexData->vertexCount * vertexSize,
+                         HardwareBuffer::HBL_READ_ONLY)) + pElement->getOffset();
+
+    Real* pDest = &values[0];
+    for (unsigned int i = 0; i < pVertexData->vertexCount; ++i, pSource += vertexSize, pDest += nbComponents)
+    {
+        if (bColour)
+        {
+            Ogre::uint32 colour;
+            memcpy(&colour, pSource, sizeof(Ogre::uint32));
+            VertexElement::convertColourValue(type, Ogre::VET_COLOUR_ARGB, &colour);
+
+            Ogre::ColourValue value;
+            value.setAsARGB(colour);
+
+            pDest[0] = value.r;
+            pDest[1] = value.g;
+            pDest[2] = value.b;
+            pDest[3] = value.a;
+        }
+        else
+        {
+            const float* pValues = reinterpret_cast<const float*>(pSource);
+            for (unsigned short j = 0; j < nbComponents; ++j)
+                pDest[j] = pValues[j];
+        }
+    }
+
+    buffer->unlock();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+/// Read the indices of a submesh (relative to its first vertex). Returns 'false' if
+/// they can't be read.
+static bool readIndices(const IndexData* pIndexData, unsigned int nbVertices,
+                        std::vector<unsigned int>& indices)
+{
+    indices.clear();
+
+    // Not indexed: the vertices are used in order
+    if (!pIndexData || pIndexData->indexBuffer.isNull())
+    {
+        indices.resize(nbVertices);
+        for (unsigned int i = 0; i < nbVertices; ++i)
+            indices[i] = i;
+
+        return true;
+    }
+
+    if (!GraphicTools::isReadable(pIndexData->indexBuffer.get()))
+        return false;
+
+    GraphicTools::readIndices(pIndexData, indices);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+/// Retrieve the geometry of the visible submeshes of a static object, in world space.
+/// Returns 'false' (with the reason) if the object can't be batched.
+static bool extractBatchParts(Object* pObject, std::vector<tBatchPart>& parts, std::string& strReason)
+{
+    MeshPtr mesh = pObject->getMesh();
+    Entity* pEntity = pObject->getOgreEntity();
+
+    if (mesh->hasSkeleton())
+    {
+        strReason = "the mesh has a skeleton";
+        return false;
+    }
+
+    if (mesh->hasVertexAnimation())
+    {
+        strReason = "the mesh has some vertex animations";
+        return false;
+    }
+
+    const Ogre::Matrix4& transform = pObject->getSceneNode()->_getFullTransform();
+    const Ogre::Matrix3 normalMatrix = MeshTransformer::getNormalMatrix(transform);
+
+    Ogre::Matrix3 linear;
+    transform.extract3x3Matrix(linear);
+
+    // A mirroring transformation reverses the winding of the triangles
+    const bool bMirrored = (linear.Determinant() < 0.0f);
+
+    for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+    {
+        SubMesh* pSubMesh = mesh->getSubMesh(i);
+        SubEntity* pSubEntity = pEntity->getSubEntity(i);
+
+        if (!pSubEntity->isVisible())
+            continue;
+
+        VertexData* pVertexData = (pSubMesh->useSharedVertices ? mesh->sharedVertexData : pSubMesh->vertexData);
+        if (!pVertexData || (pVertexData->vertexCount == 0))
+            continue;
+
+        const std::string strSubMesh = "the submesh #" + StringConverter::toString(i);
+
+        if (pSubMesh->operationType != Ogre::RenderOperation::OT_TRIANGLE_LIST)
+        {
+            strReason = strSubMesh + " isn't a triangle list";
+            return false;
+        }
+
+        tBatchPart part;
+        part.strMaterial    = pSubEntity->getMaterialName();
+        part.nbVertices     = pVertexData->vertexCount;
+
+        unsigned short nbComponents;
+        bool bSupported = readElement(pVertexData, Ogre::VES_POSITION, 0, part.positions, nbComponents) &&
+                          (nbComponents == 3);
+
+        bSupported = bSupported &&
+                     readElement(pVertexData, Ogre::VES_NORMAL, 0, part.normals, nbComponents) &&
+                     (part.normals.empty() || (nbComponents == 3));
+
+        bSupported = bSupported &&
+                     readElement(pVertexData, Ogre::VES_DIFFUSE, 0, part.diffuseColors, nbComponents) &&
+                     (part.diffuseColors.empty() || (nbComponents == 4));
+
+        bSupported = bSupported &&
+                     readElement(pVertexData, Ogre::VES_SPECULAR, 0, part.specularColors, nbComponents) &&
+                     (part.specularColors.empty() || (nbComponents == 4));
+
+        bSupported = bSupported &&
+                     readElement(pVertexData, Ogre::VES_BINORMAL, 0, part.binormals, nbComponents) &&
+                     (part.binormals.empty() || (nbComponents == 3));
+
+        bSupported = bSupported &&
+                     readElement(pVertexData, Ogre::VES_TANGENT, 0, part.tangents, nbComponents) &&
+                     (part.tangents.empty() || (nbComponents == 3));
+
+        for (unsigned short usIndex = 0; bSupported; ++usIndex)
+        {
+            if (!pVertexData->vertexDeclaration->findElementBySemantic(Ogre::VES_TEXTURE_COORDINATES, usIndex))
+                break;
+
+            part.textureCoords.push_back(std::vector<Real>());
+
+            bSupported = readElement(pVertexData, Ogre::VES_TEXTURE_COORDINATES, usIndex,
+                                     part.textureCoords.back(), nbComponents) &&
+                         (nbComponents <= 3);
+
+            part.textureCoordsDims.push_back(nbComponents);
+        }
+
+        if (!bSupported || part.positions.empty())
+        {
+            strReason = "the vertices of " + strSubMesh + " can't be read, or have an unsupported format";
+            return false;
+        }
+
+        if (!readIndices(pSubMesh->indexData, part.nbVertices, part.indices))
+        {
+            strReason = "the indices of " + strSubMesh + " can't be read";
+            return false;
+        }
+
+        // Transform the vertices in world space
+        MeshTransformer::transformPositions(transform, &part.positions[0], part.nbVertices);
+
+        if (!part.normals.empty())
+            MeshTransformer::transformDirections(normalMatrix, &part.normals[0], part.nbVertices);
+
+        if (!part.binormals.empty())
+            MeshTransformer::transformDirections(linear, &part.binormals[0], part.nbVertices);
+
+        if (!part.tangents.empty())
+            MeshTransformer::transformDirections(linear, &part.tangents[0], part.nbVertices);
+
+        // It also changes the handedness of the tangent space: the binormals must be
+        // flipped to stay consistent with the normals and the tangents
+        if (bMirrored)
+        {
+            for (size_t j = 0; j + 2 < part.indices.size(); j += 3)
+                std::swap(part.indices[j + 1], part.indices[j + 2]);
+
+            for (size_t j = 0; j < part.binormals.size(); ++j)
+                part.binormals[j] = -part.binormals[j];
+        }
+
+        // The parts with the same key can be merged in the same submesh
+        std::ostringstream key;
+        key << part.strMaterial << '|'
+            << (part.normals.empty() ? "" : "N")
+            << (part.diffuseColors.empty() ? "" : "D")
+            << (part.specularColors.empty() ? "" : "S")
+            << (part.binormals.empty() ? "" : "B")
+            << (part.tangents.empty() ? "" : "T");
+
+        for (unsigned int j = 0; j < part.textureCoordsDims.size(); ++j)
+            key << 'U' << part.textureCoordsDims[j];
+
+        part.strKey = key.str();
+
+        parts.push_back(part);
+    }
+
+    return true;
+}
+
+
 /***************************** CONSTRUCTION / DESTRUCTION ******************************/
 
 World::World(const std::string& strName, ComponentsList* pList)
-: VisualComponent(DEFAULT_NAME, pList), m_pSceneManager(0)
+: VisualComponent(DEFAULT_NAME, pList), m_pSceneManager(0),
+  m_staticChunkSize(100.0f, 100.0f, 100.0f), m_pStaticBatchesNode(0)
 {
     // Assertions
     assert(m_pList);
@@ -58,6 +348,9 @@ World::~World()
     assert(m_pList);
     assert(m_pList->getScene());
 
+    if (m_pSceneManager)
+        clearStaticBatches();
+
     Ogre::Root::getSingletonPtr()->destroySceneManager(m_pSceneManager);
 
     m_pList->getScene()->_resetMainComponent(COMP_VISUAL);
@@ -130,6 +423,432 @@ const Math::Color World::getAmbientLight() const
 }
 
 
+/*********************************** STATIC BATCHING **********************************/
+
+void World::setStaticChunkSize(const Math::Vector3& size)
+{
+    assert((size.x > 0.0f) && (size.y > 0.0f) && (size.z > 0.0f));
+
+    m_staticChunkSize = size;
+}
+
+//-----------------------------------------------------------------------
+
+void World::buildStaticBatches()
+{
+    batchStaticObjects(0);
+}
+
+//-----------------------------------------------------------------------
+
+void World::unbatchRegion(const Math::AxisAlignedBox& region)
+{
+    const Ogre::AxisAlignedBox box = toOgre(region);
+
+    tStaticChunksList::iterator iter = m_staticChunks.begin();
+    while (iter != m_staticChunks.end())
+    {
+        // The batches can extend beyond their chunk (the objects are assigned by
+        // their center)
+        bool bIntersects = getChunkBox(iter->first).intersects(box);
+
+        std::vector<Entity*>::iterator iterBatch, iterBatchEnd;
+        for (iterBatch = iter->second.batches.begin(), iterBatchEnd = iter->second.batches.end();
+             !bIntersects && (iterBatch != iterBatchEnd); ++iterBatch)
+        {
+            bIntersects = (*iterBatch)->getWorldBoundingBox(true).intersects(box);
+        }
+
+        if (bIntersects)
+            unbatchStaticChunk(iter++);
+        else
+            ++iter;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void World::rebatchRegion(const Math::AxisAlignedBox& region)
+{
+    unbatchRegion(region);
+
+    const Ogre::AxisAlignedBox box = toOgre(region);
+    batchStaticObjects(&box);
+}
+
+//-----------------------------------------------------------------------
+
+void World::clearStaticBatches()
+{
+    while (!m_staticChunks.empty())
+        unbatchStaticChunk(m_staticChunks.begin());
+
+    m_unbatchableObjects.clear();
+}
+
+//-----------------------------------------------------------------------
+
+unsigned int World::getNbStaticBatches() const
+{
+    unsigned int nbBatches = 0;
+
+    tStaticChunksList::const_iterator iter, iterEnd;
+    for (iter = m_staticChunks.begin(), iterEnd = m_staticChunks.end(); iter != iterEnd; ++iter)
+        nbBatches += iter->second.batches.size();
+
+    return nbBatches;
+}
+
+//-----------------------------------------------------------------------
+
+void World::_addStaticObject(Object* pObject)
+{
+    assert(pObject);
+    assert(std::find(m_staticObjects.begin(), m_staticObjects.end(), pObject) == m_staticObjects.end());
+
+    m_staticObjects.push_back(pObject);
+}
+
+//-----------------------------------------------------------------------
+
+void World::_removeStaticObject(Object* pObject)
+{
+    assert(pObject);
+
+    std::map<Object*, tChunkCoords>::iterator iterChunk = m_staticObjectsChunks.find(pObject);
+    if (iterChunk != m_staticObjectsChunks.end())
+        removeFromStaticChunk(m_staticChunks.find(iterChunk->second), pObject);
+
+    m_unbatchableObjects.erase(pObject);
+
+    std::vector<Object*>::iterator iter = std::find(m_staticObjects.begin(), m_staticObjects.end(), pObject);
+    if (iter != m_staticObjects.end())
+        m_staticObjects.erase(iter);
+}
+
+//-----------------------------------------------------------------------
+
+void World::batchStaticObjects(const Ogre::AxisAlignedBox* pRegion)
+{
+    // Assertions
+    assert(m_pSceneManager);
+
+    if (!m_pStaticBatchesNode)
+        m_pStaticBatchesNode = m_pSceneManager->getRootSceneNode()->createChildSceneNode(m_id.strName + ".StaticBatches");
+
+    // The chunks that lost some objects are rebuilt too
+    std::set<tChunkCoords> modifiedChunks;
+    modifiedChunks.swap(m_dirtyChunks);
+
+    // Assign the objects that aren't batched yet to their chunk
+
+    std::vector<Object*>::iterator iter, iterEnd;
+    for (iter = m_staticObjects.begin(), iterEnd = m_staticObjects.end(); iter != iterEnd; ++iter)
+    {
+        Object* pObject = *iter;
+
+        // The hidden or disabled objects aren't rendered, so they aren't batched
+        if (pObject->isBatched() || !pObject->getOgreEntity() || !pObject->isVisible() ||
+            !pObject->getSceneNode()->isInSceneGraph())
+        {
+            continue;
+        }
+
+        // The objects that failed to be batched were already reported
+        if (m_unbatchableObjects.find(pObject) != m_unbatchableObjects.end())
+            continue;
+
+        Ogre::AxisAlignedBox box = pObject->getMesh()->getBounds();
+        box.transformAffine(pObject->getSceneNode()->_getFullTransform());
+
+        if (box.isNull() || (pRegion && !pRegion->intersects(box.getCenter())))
+            continue;
+
+        tChunkCoords coords = getChunkCoords(box.getCenter());
+        m_staticChunks[coords].objects.push_back(pObject);
+        m_staticObjectsChunks[pObject] = coords;
+        modifiedChunks.insert(coords);
+    }
+
+    // Rebuild the modified chunks
+    std::set<tChunkCoords>::iterator iterCoords, iterCoordsEnd;
+    for (iterCoords = modifiedChunks.begin(), iterCoordsEnd = modifiedChunks.end();
+         iterCoords != iterCoordsEnd; ++iterCoords)
+    {
+        tStaticChunksList::iterator iterChunk = m_staticChunks.find(*iterCoords);
+        if (iterChunk == m_staticChunks.end())
+            continue;
+
+        buildStaticChunk(iterChunk->second);
+
+        if (iterChunk->second.objects.empty())
+            m_staticChunks.erase(iterChunk);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void World::buildStaticChunk(tStaticChunk& chunk)
+{
+    // Assertions
+    assert(m_pSceneManager);
+    assert(m_pStaticBatchesNode);
+
+    // Destroy the previous batches of the chunk
+    destroyStaticBatches(chunk);
+
+    // Retrieve the geometry of the objects, in world space. The ones that can't be
+    // batched are removed from the chunk, and keep their own entity.
+    std::vector<tBatchPart> parts;
+    std::vector<bool> castShadows;
+
+    std::vector<Object*>::iterator iter = chunk.objects.begin();
+    while (iter != chunk.objects.end())
+    {
+        Object* pObject = *iter;
+        const size_t nbParts = parts.size();
+        std::string strReason;
+
+        if (!extractBatchParts(pObject, parts, strReason))
+        {
+            ATHENA_LOG_ERROR("Failed to batch the static object '" + pObject->getID().toString() +
+                             "', reason: " + strReason);
+
+            parts.resize(nbParts);
+            pObject->_setBatched(false);
+            m_unbatchableObjects.insert(pObject);
+            m_staticObjectsChunks.erase(pObject);
+            iter = chunk.objects.erase(iter);
+            continue;
+        }
+
+        castShadows.resize(parts.size(), pObject->mustCastShadows());
+        ++iter;
+    }
+
+    // One batch for the objects casting shadows, one for the others. Each batch has one
+    // submesh per material and vertex format.
+    bool bSucceeded = true;
+
+    for (unsigned int i = 0; (i < 2) && bSucceeded; ++i)
+    {
+        std::map<std::string, std::vector<const tBatchPart*> > groups;
+        for (unsigned int j = 0; j < parts.size(); ++j)
+        {
+            if (castShadows[j] == (i == 1))
+                groups[parts[j].strKey].push_back(&parts[j]);
+        }
+
+        if (groups.empty())
+            continue;
+
+        const std::string strName = m_id.strName + ".StaticBatch" + StringConverter::toString(++nbStaticBatchesCreated);
+
+        try
+        {
+            MeshBuilder builder(strName + ".Mesh");
+            builder.setOptimizations(MeshBuilder::OPTIMIZE_VERTEX_CACHE);
+
+            std::map<std::string, std::vector<const tBatchPart*> >::iterator iterGroup, iterGroupEnd;
+            unsigned int subMesh = 0;
+
+            for (iterGroup = groups.begin(), iterGroupEnd = groups.end(); iterGroup != iterGroupEnd; ++iterGroup, ++subMesh)
+            {
+                const tBatchPart* pFirst = iterGroup->second.front();
+
+                builder.begin(StringConverter::toString(subMesh), pFirst->strMaterial);
+
+                builder.declarePosition();
+
+                if (!pFirst->normals.empty())
+                    builder.declareNormal();
+
+                if (!pFirst->diffuseColors.empty())
+                    builder.declareDiffuseColor();
+
+                if (!pFirst->specularColors.empty())
+                    builder.declareSpecularColor();
+
+                for (unsigned int k = 0; k < pFirst->textureCoordsDims.size(); ++k)
+                    builder.declareTextureCoordinates(0, pFirst->textureCoordsDims[k]);
+
+                if (!pFirst->binormals.empty())
+                    builder.declareBinormal();
+
+                if (!pFirst->tangents.empty())
+                    builder.declareTangent();
+
+                std::vector<const tBatchPart*>::iterator iterPart, iterPartEnd;
+                for (iterPart = iterGroup->second.begin(), iterPartEnd = iterGroup->second.end();
+                     iterPart != iterPartEnd; ++iterPart)
+                {
+                    const tBatchPart* pPart = *iterPart;
+                    const unsigned int firstVertex = builder.getNbVertices();
+
+                    builder.positions(&pPart->positions[0], pPart->nbVertices);
+
+                    if (!pPart->normals.empty())
+                        builder.normals(&pPart->normals[0]);
+
+                    if (!pPart->diffuseColors.empty())
+                        builder.diffuseColors(&pPart->diffuseColors[0]);
+
+                    if (!pPart->specularColors.empty())
+                        builder.specularColors(&pPart->specularColors[0]);
+
+                    for (unsigned int k = 0; k < pPart->textureCoords.size(); ++k)
+                        builder.textureCoords(&pPart->textureCoords[k][0], pPart->textureCoordsDims[k]);
+
+                    if (!pPart->binormals.empty())
+                        builder.binormals(&pPart->binormals[0]);
+
+                    if (!pPart->tangents.empty())
+                        builder.tangents(&pPart->tangents[0]);
+
+                    if (pPart->indices.empty())
+                        continue;
+
+                    std::vector<unsigned int> indices(pPart->indices);
+                    for (unsigned int k = 0; k < indices.size(); ++k)
+                        indices[k] += firstVertex;
+
+                    builder.indices(&indices[0], (unsigned int) indices.size());
+                }
+
+                builder.end();
+            }
+
+            MeshPtr mesh = builder.getMesh();
+
+            Entity* pBatch = m_pSceneManager->createEntity(strName, mesh->getName());
+            pBatch->setCastShadows(i == 1);
+            m_pStaticBatchesNode->attachObject(pBatch);
+
+            chunk.batches.push_back(pBatch);
+        }
+        catch (Ogre::Exception& ex)
+        {
+            ATHENA_LOG_ERROR("Failed to build the static batch '" + strName + "', reason: " +
+                             ex.getFullDescription());
+
+            if (!MeshManager::getSingletonPtr()->getByName(strName + ".Mesh").isNull())
+                MeshManager::getSingletonPtr()->remove(strName + ".Mesh");
+
+            bSucceeded = false;
+        }
+    }
+
+    // If a batch can't be built, the objects of the chunk keep their own entity
+    if (!bSucceeded)
+    {
+        destroyStaticBatches(chunk);
+
+        for (iter = chunk.objects.begin(); iter != chunk.objects.end(); ++iter)
+        {
+            (*iter)->_setBatched(false);
+            m_staticObjectsChunks.erase(*iter);
+        }
+
+        chunk.objects.clear();
+        return;
+    }
+
+    for (iter = chunk.objects.begin(); iter != chunk.objects.end(); ++iter)
+        (*iter)->_setBatched(true);
+}
+
+//-----------------------------------------------------------------------
+
+void World::unbatchStaticChunk(tStaticChunksList::iterator iter)
+{
+    // Assertions
+    assert(m_pSceneManager);
+
+    tStaticChunk& chunk = iter->second;
+
+    destroyStaticBatches(chunk);
+
+    std::vector<Object*>::iterator iterObject, iterObjectEnd;
+    for (iterObject = chunk.objects.begin(), iterObjectEnd = chunk.objects.end(); iterObject != iterObjectEnd; ++iterObject)
+    {
+        (*iterObject)->_setBatched(false);
+        m_staticObjectsChunks.erase(*iterObject);
+    }
+
+    m_dirtyChunks.erase(iter->first);
+    m_staticChunks.erase(iter);
+}
+
+//-----------------------------------------------------------------------
+
+void World::removeFromStaticChunk(tStaticChunksList::iterator iter, Object* pObject)
+{
+    assert(iter != m_staticChunks.end());
+
+    tStaticChunk& chunk = iter->second;
+
+    std::vector<Object*>::iterator iterObject = std::find(chunk.objects.begin(), chunk.objects.end(), pObject);
+    assert(iterObject != chunk.objects.end());
+
+    chunk.objects.erase(iterObject);
+    m_staticObjectsChunks.erase(pObject);
+    pObject->_setBatched(false);
+
+    // The other objects of the chunk stay batched: the chunk is only rebuilt by the
+    // next batching, so destroying many objects doesn't rebuild it each time
+    if (chunk.objects.empty())
+    {
+        destroyStaticBatches(chunk);
+        m_dirtyChunks.erase(iter->first);
+        m_staticChunks.erase(iter);
+    }
+    else
+    {
+        m_dirtyChunks.insert(iter->first);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void World::destroyStaticBatches(tStaticChunk& chunk)
+{
+    // Assertions
+    assert(m_pSceneManager);
+
+    std::vector<Entity*>::iterator iter, iterEnd;
+    for (iter = chunk.batches.begin(), iterEnd = chunk.batches.end(); iter != iterEnd; ++iter)
+    {
+        MeshPtr mesh = (*iter)->getMesh();
+        m_pSceneManager->destroyEntity(*iter);
+        MeshManager::getSingletonPtr()->remove(mesh->getHandle());
+    }
+
+    chunk.batches.clear();
+}
+
+//-----------------------------------------------------------------------
+
+World::tChunkCoords World::getChunkCoords(const Ogre::Vector3& position) const
+{
+    tChunkCoords coords;
+    coords.x = (int) floor(position.x / m_staticChunkSize.x);
+    coords.y = (int) floor(position.y / m_staticChunkSize.y);
+    coords.z = (int) floor(position.z / m_staticChunkSize.z);
+
+    return coords;
+}
+
+//-----------------------------------------------------------------------
+
+Ogre::AxisAlignedBox World::getChunkBox(const tChunkCoords& coords) const
+{
+    const Ogre::Vector3 size = toOgre(m_staticChunkSize);
+    const Ogre::Vector3 minimum(coords.x * size.x, coords.y * size.y, coords.z * size.z);
+
+    return Ogre::AxisAlignedBox(minimum, minimum + size);
+}
+
+
 /***************************** MANAGEMENT OF THE PROPERTIES ****************************/
 
 Utils::PropertiesList* World::getProperties() const
@@ -149,6 +868,9 @@ Utils::PropertiesList* World::getProperties() const
         pProperties->set("ambientlight", new Variant(getAmbientLight()));
     }
 
+    // Size of the chunks of the static batches
+    pProperties->set("staticChunkSize", new Variant(m_staticChunkSize));
+
     // Returns the list
     return pProperties;
 }
@@ -197,6 +919,12 @@ bool World::setProperty(const std::string& strName, Utils::Variant* pValue)
             bUsed = false;
     }
 
+    // Size of the chunks of the static batches
+    else if (strName == "staticChunkSize")
+    {
+        setStaticChunkSize(pValue->toVector3());
+    }
+
     else
     {
         bUsed = false;
@@ -0,0 +1,7 @@
+#include <UnitTest++.h>
+
+
+int main(int argc, char** argv)
+{
+    return UnitTest::RunAllTests();
+}
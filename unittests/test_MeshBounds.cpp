@@ -0,0 +1,118 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshBounds.h>
+#include <algorithm>
+#include <vector>
+
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+
+
+/// Generate some vertices scattered in [-10, 10]^3 (not a multiple of 4, so the
+/// vectorized loops have a remainder to process)
+static void buildCloud(unsigned int nbVertices, std::vector<float>& positions)
+{
+    unsigned int seed = 12345;
+
+    positions.resize(nbVertices * 3);
+
+    for (unsigned int i = 0; i < positions.size(); ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        positions[i] = (float) (seed >> 8) / (float) (1 << 24) * 20.0f - 10.0f;
+    }
+}
+
+
+SUITE(MeshBoundsTests)
+{
+    TEST(BoxOfNoVertexIsNull)
+    {
+        CHECK(MeshBounds::computeAABB(0, 0).isNull());
+    }
+
+
+    TEST(BoxContainsTheVertices)
+    {
+        std::vector<float> positions;
+        buildCloud(37, positions);
+
+        const AxisAlignedBox aabb = MeshBounds::computeAABB(&positions[0], 37);
+
+        float minimum[3] = { positions[0], positions[1], positions[2] };
+        float maximum[3] = { positions[0], positions[1], positions[2] };
+
+        for (unsigned int i = 1; i < 37; ++i)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                minimum[j] = std::min(minimum[j], positions[i * 3 + j]);
+                maximum[j] = std::max(maximum[j], positions[i * 3 + j]);
+            }
+        }
+
+        CHECK_EQUAL(minimum[0], aabb.getMinimum().x);
+        CHECK_EQUAL(minimum[1], aabb.getMinimum().y);
+        CHECK_EQUAL(minimum[2], aabb.getMinimum().z);
+        CHECK_EQUAL(maximum[0], aabb.getMaximum().x);
+        CHECK_EQUAL(maximum[1], aabb.getMaximum().y);
+        CHECK_EQUAL(maximum[2], aabb.getMaximum().z);
+    }
+
+
+    TEST(BoxOfInterleavedVertices)
+    {
+        // Positions followed by normals: the normals must be skipped
+        const float vertices[] = {
+            -1.0f, 2.0f, 0.5f,      100.0f, 100.0f, 100.0f,
+            3.0f, -4.0f, 1.5f,      -100.0f, -100.0f, -100.0f,
+            0.0f, 0.0f, -2.0f,      100.0f, -100.0f, 100.0f,
+        };
+
+        const AxisAlignedBox aabb = MeshBounds::computeAABB(vertices, 3, 6 * sizeof(float));
+
+        CHECK_EQUAL(-1.0f, aabb.getMinimum().x);
+        CHECK_EQUAL(-4.0f, aabb.getMinimum().y);
+        CHECK_EQUAL(-2.0f, aabb.getMinimum().z);
+        CHECK_EQUAL(3.0f, aabb.getMaximum().x);
+        CHECK_EQUAL(2.0f, aabb.getMaximum().y);
+        CHECK_EQUAL(1.5f, aabb.getMaximum().z);
+    }
+
+
+    TEST(SphereContainsTheVertices)
+    {
+        std::vector<float> positions;
+        buildCloud(101, positions);
+
+        const MeshBounds::tBounds bounds = MeshBounds::compute(&positions[0], 101);
+
+        for (unsigned int i = 0; i < 101; ++i)
+        {
+            const Vector3 position(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+            CHECK((position - bounds.sphere.getCenter()).length() <= bounds.sphere.getRadius() + 1e-4f);
+        }
+
+        // Never larger than the sphere enclosing the box
+        CHECK(bounds.sphere.getRadius() <=
+              (bounds.aabb.getMaximum() - bounds.aabb.getMinimum()).length() * 0.5f + 1e-4f);
+    }
+
+
+    TEST(RadiusFromTheOrigin)
+    {
+        // A cube of side 2 centered on (10, 0, 0)
+        const float positions[] = {
+            9.0f, -1.0f, -1.0f,     11.0f, -1.0f, -1.0f,    9.0f, 1.0f, -1.0f,      11.0f, 1.0f, -1.0f,
+            9.0f, -1.0f, 1.0f,      11.0f, -1.0f, 1.0f,     9.0f, 1.0f, 1.0f,       11.0f, 1.0f, 1.0f,
+        };
+
+        const MeshBounds::tBounds bounds = MeshBounds::compute(positions, 8);
+        const Real radius = MeshBounds::getRadiusFromOrigin(bounds);
+
+        // Contains the farthest corner, no larger than the farthest corner of the box
+        const Real farthest = Vector3(11.0f, 1.0f, 1.0f).length();
+
+        CHECK(radius >= farthest - 1e-4f);
+        CHECK(radius <= farthest + 1e-4f);
+    }
+}
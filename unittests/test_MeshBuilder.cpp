@@ -0,0 +1,140 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshBuilder.h>
+
+using namespace Athena::Graphics;
+
+
+// The deferred builders process the submeshes in end() without any Ogre manager, the
+// mesh is only created by commit() (never called here)
+
+SUITE(MeshBuilderTests)
+{
+    TEST(WeldingOfIdenticalVertices)
+    {
+        // A quad made of two triangles, with its diagonal duplicated
+        const float positions[] = {
+            0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,
+            1.0f, 0.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f, 0.0f,
+        };
+
+        const unsigned int indices[] = { 0, 1, 2, 3, 4, 5 };
+
+        MeshBuilder builder("WeldingOfIdenticalVertices", "General", true);
+        builder.setWelding(true);
+
+        builder.begin("quad", "BaseWhite");
+        builder.positions(positions, 6);
+        builder.indices(indices, 6);
+        builder.end();
+
+        CHECK_EQUAL(6, builder.getStatistics().nbVerticesBeforeWelding);
+        CHECK_EQUAL(4, builder.getStatistics().nbVertices);
+        CHECK_EQUAL(6, builder.getStatistics().nbIndices);
+    }
+
+
+    TEST(WeldingWithEpsilon)
+    {
+        const float positions[] = {
+            0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,       0.0f, 1.0f, 0.0f,
+            1.0f, 0.0f, 0.0f,   1.0f, 1.0f, 0.0f,       0.0f, 1.0004f, 0.0f,
+            0.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,       -1.0f, 0.0f, 0.0f,
+        };
+
+        const unsigned int indices[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        MeshBuilder builder("WeldingWithEpsilon", "General", true);
+        builder.setWelding(true, 0.001f);
+
+        builder.begin("quad", "BaseWhite");
+        builder.positions(positions, 9);
+        builder.indices(indices, 9);
+        builder.end();
+
+        CHECK_EQUAL(9, builder.getStatistics().nbVerticesBeforeWelding);
+        CHECK_EQUAL(5, builder.getStatistics().nbVertices);
+    }
+
+
+    TEST(WeldingAcrossTheBoundaryOfACell)
+    {
+        // The values differ by less than epsilon, but would round to different keys
+        const float positions[] = {
+            0.0999f, 0.0f, 0.0f,    1.0f, 0.1004f, 0.0f,    0.0f, 1.0f, 0.0f,
+            0.1001f, 0.0f, 0.0f,    1.0f, 0.1006f, 0.0f,    0.0f, 1.0f, 0.0f,
+            0.1030f, 0.0f, 0.0f,    1.0f, 0.1004f, 0.0f,    0.0f, 1.0f, 0.0f,
+        };
+
+        const unsigned int indices[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        MeshBuilder builder("WeldingAcrossTheBoundaryOfACell", "General", true);
+        builder.setWelding(true, 0.001f);
+
+        builder.begin("triangles", "BaseWhite");
+        builder.positions(positions, 9);
+        builder.indices(indices, 9);
+        builder.end();
+
+        // Only the vertex at 0.1030 is further than epsilon from the others
+        CHECK_EQUAL(9, builder.getStatistics().nbVerticesBeforeWelding);
+        CHECK_EQUAL(4, builder.getStatistics().nbVertices);
+    }
+
+
+    TEST(WeldingKeepsDifferentAttributes)
+    {
+        // Same positions, but different normals: nothing to weld
+        const float positions[] = {
+            0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, 0.0f,
+        };
+
+        const float normals[] = {
+            0.0f, 0.0f, 1.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, 1.0f,
+            0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f, -1.0f,
+        };
+
+        const unsigned int indices[] = { 0, 1, 2, 3, 4, 5 };
+
+        MeshBuilder builder("WeldingKeepsDifferentAttributes", "General", true);
+        builder.setWelding(true);
+
+        builder.begin("twoSided", "BaseWhite");
+        builder.positions(positions, 6);
+        builder.normals(normals);
+        builder.indices(indices, 6);
+        builder.end();
+
+        CHECK_EQUAL(6, builder.getStatistics().nbVertices);
+    }
+
+
+    TEST(BulkAndPerVertexIngestionsAreEquivalent)
+    {
+        const float positions[] = {
+            0.0f, 0.0f, 0.0f,   1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 1.0f, 0.0f,
+        };
+
+        const unsigned int indices[] = { 0, 1, 2, 1, 3, 2 };
+
+        MeshBuilder bulk("BulkIngestion", "General", true);
+        bulk.begin("quad", "BaseWhite");
+        bulk.positions(positions, 4);
+        bulk.indices(indices, 6);
+        bulk.end();
+
+        MeshBuilder perVertex("PerVertexIngestion", "General", true);
+        perVertex.begin("quad", "BaseWhite");
+
+        for (unsigned int i = 0; i < 4; ++i)
+            perVertex.position(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+
+        for (unsigned int i = 0; i < 6; ++i)
+            perVertex.index(indices[i]);
+
+        perVertex.end();
+
+        CHECK_EQUAL(perVertex.getStatistics().nbVertices, bulk.getStatistics().nbVertices);
+        CHECK_EQUAL(perVertex.getStatistics().nbIndices, bulk.getStatistics().nbIndices);
+    }
+}
@@ -0,0 +1,93 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshCache.h>
+#include <string>
+#include <vector>
+
+using namespace Athena::Graphics;
+
+
+SUITE(MeshCacheTests)
+{
+    TEST(HashOfNoData)
+    {
+        MeshCache::Hasher hasher;
+        CHECK(hasher.getHash() == 14695981039346656037ULL);
+    }
+
+
+    TEST(HashOfKnownData)
+    {
+        // Reference values of the 64-bit FNV-1a hash
+        MeshCache::Hasher hasher;
+
+        hasher.add("a", 1);
+        CHECK(hasher.getHash() == 0xaf63dc4c8601ec8cULL);
+
+        hasher.reset();
+        hasher.add("foobar", 6);
+        CHECK(hasher.getHash() == 0x85944171f73967e8ULL);
+    }
+
+
+    TEST(ResetRestartsTheHash)
+    {
+        MeshCache::Hasher hasher;
+        hasher.add("foobar", 6);
+        hasher.reset();
+
+        CHECK(hasher.getHash() == MeshCache::Hasher().getHash());
+    }
+
+
+    TEST(IncrementalHash)
+    {
+        MeshCache::Hasher incremental;
+        incremental.add("foo", 3);
+        incremental.add("bar", 3);
+
+        MeshCache::Hasher oneShot;
+        oneShot.add("foobar", 6);
+
+        CHECK(incremental.getHash() == oneShot.getHash());
+    }
+
+
+    TEST(StringsIncludeTheirLength)
+    {
+        MeshCache::Hasher first;
+        first.add(std::string("ab"));
+        first.add(std::string("c"));
+
+        MeshCache::Hasher second;
+        second.add(std::string("a"));
+        second.add(std::string("bc"));
+
+        CHECK(first.getHash() != second.getHash());
+    }
+
+
+    TEST(ArraysIncludeTheirSize)
+    {
+        std::vector<unsigned int> values(2, 0);
+
+        MeshCache::Hasher first;
+        first.add(values);
+        first.add(std::vector<unsigned int>());
+
+        MeshCache::Hasher second;
+        second.add(std::vector<unsigned int>(1, 0));
+        second.add(std::vector<unsigned int>(1, 0));
+
+        CHECK(first.getHash() != second.getHash());
+    }
+
+
+    TEST(Paths)
+    {
+        const MeshCache::tHash hash = 0x0123456789abcdefULL;
+
+        CHECK_EQUAL(std::string("0123456789abcdef"), MeshCache::getPath("", hash));
+        CHECK_EQUAL(std::string("cache/0123456789abcdef"), MeshCache::getPath("cache", hash));
+        CHECK_EQUAL(std::string("cache/0123456789abcdef"), MeshCache::getPath("cache/", hash));
+    }
+}
@@ -0,0 +1,141 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshClusters.h>
+#include <algorithm>
+#include <vector>
+
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+
+
+/// Build a flat grid of (size x size) quads, facing +Z
+static void buildPlane(unsigned int size, std::vector<float>& positions,
+                       std::vector<unsigned int>& indices)
+{
+    const unsigned int nbVerticesPerRow = size + 1;
+
+    for (unsigned int y = 0; y < nbVerticesPerRow; ++y)
+    {
+        for (unsigned int x = 0; x < nbVerticesPerRow; ++x)
+        {
+            positions.push_back((float) x);
+            positions.push_back((float) y);
+            positions.push_back(0.0f);
+        }
+    }
+
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            const unsigned int v = y * nbVerticesPerRow + x;
+
+            indices.push_back(v);
+            indices.push_back(v + 1);
+            indices.push_back(v + nbVerticesPerRow);
+
+            indices.push_back(v + 1);
+            indices.push_back(v + nbVerticesPerRow + 1);
+            indices.push_back(v + nbVerticesPerRow);
+        }
+    }
+}
+
+
+SUITE(MeshClustersTests)
+{
+    TEST(ClustersCoverTheTriangles)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildPlane(16, positions, indices);
+
+        std::vector<unsigned int> reference = indices;
+
+        MeshClusters::tClustersList clusters;
+        MeshClusters::build(&positions[0], positions.size() / 3, &indices[0], indices.size(),
+                            64, clusters);
+
+        CHECK(clusters.size() >= 512 / 64);
+
+        // The clusters are contiguous, and not larger than the limit
+        unsigned int indexStart = 0;
+
+        for (unsigned int i = 0; i < clusters.size(); ++i)
+        {
+            CHECK_EQUAL(indexStart, clusters[i].indexStart);
+            CHECK(clusters[i].nbIndices > 0);
+            CHECK(clusters[i].nbIndices <= 64 * 3);
+
+            indexStart += clusters[i].nbIndices;
+        }
+
+        CHECK_EQUAL(reference.size(), indexStart);
+
+        // The indices are only reordered, by triangle
+        std::vector<unsigned int> sortedReference, sortedIndices;
+
+        for (unsigned int i = 0; i < indices.size(); i += 3)
+        {
+            sortedReference.push_back(reference[i] * 1000000 + reference[i + 1] * 1000 + reference[i + 2]);
+            sortedIndices.push_back(indices[i] * 1000000 + indices[i + 1] * 1000 + indices[i + 2]);
+        }
+
+        std::sort(sortedReference.begin(), sortedReference.end());
+        std::sort(sortedIndices.begin(), sortedIndices.end());
+
+        CHECK(sortedReference == sortedIndices);
+    }
+
+
+    TEST(BoundsContainTheVertices)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildPlane(8, positions, indices);
+
+        MeshClusters::tClustersList clusters;
+        MeshClusters::build(&positions[0], positions.size() / 3, &indices[0], indices.size(),
+                            16, clusters);
+
+        for (unsigned int i = 0; i < clusters.size(); ++i)
+        {
+            const MeshClusters::tCluster& cluster = clusters[i];
+            const Vector3& min = cluster.aabb.getMinimum();
+            const Vector3& max = cluster.aabb.getMaximum();
+
+            for (unsigned int j = cluster.indexStart; j < cluster.indexStart + cluster.nbIndices; ++j)
+            {
+                const float* p = &positions[indices[j] * 3];
+
+                CHECK((p[0] >= min.x) && (p[0] <= max.x));
+                CHECK((p[1] >= min.y) && (p[1] <= max.y));
+                CHECK((p[2] >= min.z) && (p[2] <= max.z));
+
+                const Vector3 position(p[0], p[1], p[2]);
+                CHECK((position - cluster.sphere.getCenter()).length() <=
+                      cluster.sphere.getRadius() + 1e-4f);
+            }
+        }
+    }
+
+
+    TEST(FlatClustersAreBackFacingFromBehind)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildPlane(8, positions, indices);
+
+        MeshClusters::tClustersList clusters;
+        MeshClusters::build(&positions[0], positions.size() / 3, &indices[0], indices.size(),
+                            16, clusters);
+
+        for (unsigned int i = 0; i < clusters.size(); ++i)
+        {
+            CHECK_CLOSE(1.0f, clusters[i].coneAxis.z, 1e-4f);
+            CHECK(clusters[i].coneCutoff < 1.0f);
+
+            CHECK(MeshClusters::isBackFacing(clusters[i], Vector3(4.0f, 4.0f, -100.0f)));
+            CHECK(!MeshClusters::isBackFacing(clusters[i], Vector3(4.0f, 4.0f, 100.0f)));
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshOptimizer.h>
+#include <algorithm>
+#include <vector>
+
+using namespace Athena::Graphics;
+
+
+/// Build a grid of (size x size) quads, with the triangles in a shuffled order
+static void buildGrid(unsigned int size, std::vector<float>& positions,
+                      std::vector<unsigned int>& indices)
+{
+    const unsigned int nbVerticesPerRow = size + 1;
+
+    positions.clear();
+    indices.clear();
+
+    for (unsigned int y = 0; y < nbVerticesPerRow; ++y)
+    {
+        for (unsigned int x = 0; x < nbVerticesPerRow; ++x)
+        {
+            positions.push_back((float) x);
+            positions.push_back((float) y);
+            positions.push_back(0.0f);
+        }
+    }
+
+    std::vector<unsigned int> triangles;
+
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            const unsigned int v = y * nbVerticesPerRow + x;
+
+            triangles.push_back(v);
+            triangles.push_back(v + 1);
+            triangles.push_back(v + nbVerticesPerRow);
+
+            triangles.push_back(v + 1);
+            triangles.push_back(v + nbVerticesPerRow + 1);
+            triangles.push_back(v + nbVerticesPerRow);
+        }
+    }
+
+    // Deterministic shuffle of the triangles
+    const unsigned int nbTriangles = triangles.size() / 3;
+    unsigned int seed = 12345;
+
+    std::vector<unsigned int> order(nbTriangles);
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+        order[t] = t;
+
+    for (unsigned int t = nbTriangles - 1; t > 0; --t)
+    {
+        seed = seed * 1103515245 + 12345;
+        std::swap(order[t], order[(seed >> 8) % (t + 1)]);
+    }
+
+    for (unsigned int t = 0; t < nbTriangles; ++t)
+        indices.insert(indices.end(), &triangles[order[t] * 3], &triangles[order[t] * 3] + 3);
+}
+
+//-----------------------------------------------------------------------
+
+/// Returns the triangles as a sorted list, each one starting with its smallest index (to
+/// compare two triangle lists regardless of their order)
+static std::vector<unsigned int> sortedTriangles(const std::vector<unsigned int>& indices)
+{
+    std::vector<unsigned long long> keys;
+
+    for (unsigned int i = 0; i < indices.size(); i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+        // Rotate, keeping the winding
+        while ((a > b) || (a > c))
+        {
+            const unsigned int tmp = a;
+            a = b;
+            b = c;
+            c = tmp;
+        }
+
+        keys.push_back(((unsigned long long) a << 42) | ((unsigned long long) b << 21) | c);
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<unsigned int> result;
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        result.push_back((unsigned int) (keys[i] >> 42));
+        result.push_back((unsigned int) ((keys[i] >> 21) & 0x1FFFFF));
+        result.push_back((unsigned int) (keys[i] & 0x1FFFFF));
+    }
+
+    return result;
+}
+
+
+SUITE(MeshOptimizerTests)
+{
+    TEST(AnalyzeSingleTriangle)
+    {
+        const unsigned int indices[3] = { 0, 1, 2 };
+
+        MeshOptimizer::tCacheStatistics statistics = MeshOptimizer::analyzeVertexCache(indices, 3, 3);
+
+        CHECK_EQUAL(1, statistics.nbTriangles);
+        CHECK_EQUAL(3, statistics.nbVertices);
+        CHECK_EQUAL(3, statistics.nbTransformedVertices);
+        CHECK_CLOSE(3.0f, statistics.acmr, 1e-6f);
+        CHECK_CLOSE(1.0f, statistics.atvr, 1e-6f);
+    }
+
+
+    TEST(VertexCacheKeepsTheTriangles)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildGrid(32, positions, indices);
+
+        const unsigned int nbVertices = positions.size() / 3;
+        const std::vector<unsigned int> reference = sortedTriangles(indices);
+
+        MeshOptimizer::tCacheStatistics before = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), nbVertices);
+
+        MeshOptimizer::optimizeVertexCache(&indices[0], indices.size(), nbVertices);
+
+        MeshOptimizer::tCacheStatistics after = MeshOptimizer::analyzeVertexCache(&indices[0], indices.size(), nbVertices);
+
+        CHECK(reference == sortedTriangles(indices));
+        CHECK(after.acmr < before.acmr);
+        CHECK(after.acmr < 1.0f);
+    }
+
+
+    TEST(OverdrawKeepsTheTriangles)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildGrid(16, positions, indices);
+
+        const unsigned int nbVertices = positions.size() / 3;
+        const std::vector<unsigned int> reference = sortedTriangles(indices);
+
+        MeshOptimizer::optimizeOverdraw(&indices[0], indices.size(), &positions[0], nbVertices);
+
+        CHECK(reference == sortedTriangles(indices));
+    }
+
+
+    TEST(VertexFetchOrdersByFirstUse)
+    {
+        unsigned int indices[6] = { 4, 2, 0, 2, 4, 3 };
+        std::vector<unsigned int> order;
+
+        MeshOptimizer::optimizeVertexFetch(indices, 6, 6, order);
+
+        const unsigned int expectedIndices[6] = { 0, 1, 2, 1, 0, 3 };
+        const unsigned int expectedOrder[6] = { 4, 2, 0, 3, 1, 5 };
+
+        CHECK_ARRAY_EQUAL(expectedIndices, indices, 6);
+        CHECK_EQUAL(6, order.size());
+        CHECK_ARRAY_EQUAL(expectedOrder, &order[0], 6);
+    }
+}
@@ -0,0 +1,98 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshSimplifier.h>
+#include <vector>
+
+using namespace Athena::Graphics;
+
+
+/// Build a flat grid of (size x size) quads, facing +Z
+static void buildPlane(unsigned int size, std::vector<float>& positions,
+                       std::vector<float>& normals, std::vector<unsigned int>& indices)
+{
+    const unsigned int nbVerticesPerRow = size + 1;
+
+    for (unsigned int y = 0; y < nbVerticesPerRow; ++y)
+    {
+        for (unsigned int x = 0; x < nbVerticesPerRow; ++x)
+        {
+            positions.push_back((float) x);
+            positions.push_back((float) y);
+            positions.push_back(0.0f);
+
+            normals.push_back(0.0f);
+            normals.push_back(0.0f);
+            normals.push_back(1.0f);
+        }
+    }
+
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            const unsigned int v = y * nbVerticesPerRow + x;
+
+            indices.push_back(v);
+            indices.push_back(v + 1);
+            indices.push_back(v + nbVerticesPerRow);
+
+            indices.push_back(v + 1);
+            indices.push_back(v + nbVerticesPerRow + 1);
+            indices.push_back(v + nbVerticesPerRow);
+        }
+    }
+}
+
+
+SUITE(MeshSimplifierTests)
+{
+    TEST(PlaneIsSimplified)
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<unsigned int> indices;
+        buildPlane(16, positions, normals, indices);
+
+        const unsigned int nbVertices = positions.size() / 3;
+        const unsigned int nbIndices = indices.size();
+
+        MeshSimplifier::simplify(&positions[0], &normals[0], 0, nbVertices, indices, nbIndices / 4);
+
+        CHECK(indices.size() < nbIndices);
+        CHECK_EQUAL(0, indices.size() % 3);
+
+        for (unsigned int i = 0; i < indices.size(); i += 3)
+        {
+            CHECK(indices[i] < nbVertices);
+            CHECK(indices[i + 1] < nbVertices);
+            CHECK(indices[i + 2] < nbVertices);
+
+            CHECK(indices[i] != indices[i + 1]);
+            CHECK(indices[i] != indices[i + 2]);
+            CHECK(indices[i + 1] != indices[i + 2]);
+
+            // The remaining triangles still face +Z
+            const float* p0 = &positions[indices[i] * 3];
+            const float* p1 = &positions[indices[i + 1] * 3];
+            const float* p2 = &positions[indices[i + 2] * 3];
+
+            const float z = (p1[0] - p0[0]) * (p2[1] - p0[1]) - (p1[1] - p0[1]) * (p2[0] - p0[0]);
+            CHECK(z > 0.0f);
+        }
+    }
+
+
+    TEST(TargetAboveTheCurrentSizeDoesNothing)
+    {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<unsigned int> indices;
+        buildPlane(4, positions, normals, indices);
+
+        const std::vector<unsigned int> reference = indices;
+
+        MeshSimplifier::simplify(&positions[0], &normals[0], 0, positions.size() / 3, indices,
+                                 indices.size());
+
+        CHECK(reference == indices);
+    }
+}
@@ -0,0 +1,136 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/MeshTransformer.h>
+#include <Ogre/OgreMatrix3.h>
+#include <Ogre/OgreQuaternion.h>
+#include <vector>
+
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+
+
+/// Returns a transformation made of a non-uniform scale, a rotation and a translation
+static Ogre::Matrix4 getTransform()
+{
+    Ogre::Matrix4 transform;
+    transform.makeTransform(Ogre::Vector3(1.0f, -2.0f, 3.0f), Ogre::Vector3(2.0f, 0.5f, 1.0f),
+                            Ogre::Quaternion(Ogre::Degree(30.0f), Ogre::Vector3::UNIT_Z));
+    return transform;
+}
+
+
+SUITE(MeshTransformerTests)
+{
+    TEST(TransformPositions)
+    {
+        // Not a multiple of 4, so the vectorized loop has a remainder to process
+        const unsigned int nbVertices = 7;
+
+        std::vector<Real> positions(nbVertices * 3);
+        for (unsigned int i = 0; i < positions.size(); ++i)
+            positions[i] = (Real) i - 10.0f;
+
+        const std::vector<Real> original(positions);
+        const Ogre::Matrix4 transform = getTransform();
+
+        MeshTransformer::transformPositions(transform, &positions[0], nbVertices);
+
+        for (unsigned int i = 0; i < nbVertices; ++i)
+        {
+            const Ogre::Vector3 expected = transform.transformAffine(
+                            Ogre::Vector3(original[i * 3], original[i * 3 + 1], original[i * 3 + 2]));
+
+            CHECK_CLOSE(expected.x, positions[i * 3], 1e-4f);
+            CHECK_CLOSE(expected.y, positions[i * 3 + 1], 1e-4f);
+            CHECK_CLOSE(expected.z, positions[i * 3 + 2], 1e-4f);
+        }
+    }
+
+
+    TEST(TransformInterleavedPositions)
+    {
+        // Positions followed by normals: the normals must be left untouched
+        Real vertices[] = {
+            1.0f, 0.0f, 0.0f,   0.0f, 0.0f, 1.0f,
+            0.0f, 1.0f, 0.0f,   0.0f, 0.0f, 1.0f,
+        };
+
+        Ogre::Matrix4 translation = Ogre::Matrix4::IDENTITY;
+        translation.setTrans(Ogre::Vector3(5.0f, 6.0f, 7.0f));
+
+        MeshTransformer::transformPositions(translation, vertices, 2, 6 * sizeof(Real));
+
+        CHECK_CLOSE(6.0f, vertices[0], 1e-6f);
+        CHECK_CLOSE(6.0f, vertices[1], 1e-6f);
+        CHECK_CLOSE(7.0f, vertices[2], 1e-6f);
+        CHECK_CLOSE(5.0f, vertices[6], 1e-6f);
+        CHECK_CLOSE(7.0f, vertices[7], 1e-6f);
+        CHECK_CLOSE(7.0f, vertices[8], 1e-6f);
+
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            CHECK_EQUAL(0.0f, vertices[i * 6 + 3]);
+            CHECK_EQUAL(0.0f, vertices[i * 6 + 4]);
+            CHECK_EQUAL(1.0f, vertices[i * 6 + 5]);
+        }
+    }
+
+
+    TEST(TransformDirectionsNormalisesThem)
+    {
+        const Ogre::Matrix3 scale(3.0f, 0.0f, 0.0f,
+                                  0.0f, 3.0f, 0.0f,
+                                  0.0f, 0.0f, 3.0f);
+
+        Real directions[] = {
+            1.0f, 0.0f, 0.0f,   0.0f, 0.6f, 0.8f,   0.0f, 0.0f, -1.0f,
+            0.6f, 0.0f, 0.8f,   0.0f, 1.0f, 0.0f,
+        };
+
+        const Real expected[] = {
+            1.0f, 0.0f, 0.0f,   0.0f, 0.6f, 0.8f,   0.0f, 0.0f, -1.0f,
+            0.6f, 0.0f, 0.8f,   0.0f, 1.0f, 0.0f,
+        };
+
+        MeshTransformer::transformDirections(scale, directions, 5);
+
+        for (unsigned int i = 0; i < 15; ++i)
+            CHECK_CLOSE(expected[i], directions[i], 1e-5f);
+    }
+
+
+    TEST(NormalsStayPerpendicularToTheSurface)
+    {
+        const Ogre::Matrix4 transform = getTransform();
+
+        Ogre::Matrix3 linear;
+        transform.extract3x3Matrix(linear);
+
+        // A normal and a tangent of the same surface
+        Real normal[]  = { 0.6f, 0.8f, 0.0f };
+        Real tangent[] = { 0.8f, -0.6f, 0.0f };
+
+        MeshTransformer::transformDirections(MeshTransformer::getNormalMatrix(transform), normal, 1);
+        MeshTransformer::transformDirections(linear, tangent, 1);
+
+        const Ogre::Vector3 n(normal[0], normal[1], normal[2]);
+        const Ogre::Vector3 t(tangent[0], tangent[1], tangent[2]);
+
+        CHECK_CLOSE(1.0f, n.length(), 1e-5f);
+        CHECK_CLOSE(0.0f, n.dotProduct(t), 1e-5f);
+    }
+
+
+    TEST(NormalMatrixOfASingularTransformation)
+    {
+        // Flattened along Z: the linear part is returned as is
+        Ogre::Matrix4 transform = Ogre::Matrix4::IDENTITY;
+        transform.setScale(Ogre::Vector3(1.0f, 2.0f, 0.0f));
+
+        const Ogre::Matrix3 normalMatrix = MeshTransformer::getNormalMatrix(transform);
+
+        Ogre::Matrix3 linear;
+        transform.extract3x3Matrix(linear);
+
+        CHECK(normalMatrix == linear);
+    }
+}
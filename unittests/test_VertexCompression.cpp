@@ -0,0 +1,116 @@
+#include <UnitTest++.h>
+#include <Athena-Graphics/VertexCompression.h>
+#include <math.h>
+
+using namespace Athena::Graphics;
+using namespace Athena::Math;
+
+
+SUITE(VertexCompressionTests)
+{
+    TEST(ElementTypes)
+    {
+        CHECK_EQUAL(Ogre::VET_FLOAT3, VertexCompression::getElementType(VertexCompression::FORMAT_FLOAT, 3));
+        CHECK_EQUAL(Ogre::VET_SHORT2, VertexCompression::getElementType(VertexCompression::FORMAT_SHORT, 2));
+        CHECK_EQUAL(Ogre::VET_SHORT4, VertexCompression::getElementType(VertexCompression::FORMAT_SHORT, 3));
+        CHECK_EQUAL(Ogre::VET_UBYTE4, VertexCompression::getElementType(VertexCompression::FORMAT_UBYTE, 3));
+        CHECK_EQUAL(Ogre::VET_SHORT2, VertexCompression::getElementType(VertexCompression::FORMAT_OCTAHEDRAL, 3));
+    }
+
+
+    TEST(VectorFormats)
+    {
+        VertexCompression::tFormat format;
+
+        CHECK(VertexCompression::getVectorFormat(Ogre::VET_FLOAT3, format));
+        CHECK_EQUAL(VertexCompression::FORMAT_FLOAT, format);
+
+        CHECK(VertexCompression::getVectorFormat(Ogre::VET_SHORT4, format));
+        CHECK_EQUAL(VertexCompression::FORMAT_SHORT, format);
+
+        CHECK(VertexCompression::getVectorFormat(Ogre::VET_SHORT2, format));
+        CHECK_EQUAL(VertexCompression::FORMAT_OCTAHEDRAL, format);
+
+        CHECK(VertexCompression::getVectorFormat(Ogre::VET_UBYTE4, format));
+        CHECK_EQUAL(VertexCompression::FORMAT_UBYTE, format);
+
+        CHECK(!VertexCompression::getVectorFormat(Ogre::VET_FLOAT2, format));
+    }
+
+
+    TEST(ShortRoundTrip)
+    {
+        const float values[3] = { 12.5f, -100.0f, 0.001f };
+        const Real scale = VertexCompression::computeScale(100.0f);
+
+        short stored[4];
+        float decoded[3];
+
+        VertexCompression::encode(VertexCompression::FORMAT_SHORT, values, 3, scale, stored);
+        VertexCompression::decode(VertexCompression::FORMAT_SHORT, stored, 3, scale, decoded);
+
+        CHECK_EQUAL(0, stored[3]);
+
+        for (unsigned int i = 0; i < 3; ++i)
+            CHECK_CLOSE(values[i], decoded[i], scale * 0.5f + 1e-6f);
+    }
+
+
+    TEST(ShortClamping)
+    {
+        const float values[2] = { 200.0f, -200.0f };
+        const Real scale = VertexCompression::computeScale(100.0f);
+
+        short stored[2];
+
+        VertexCompression::encode(VertexCompression::FORMAT_SHORT, values, 2, scale, stored);
+
+        CHECK_EQUAL(32767, stored[0]);
+        CHECK_EQUAL(-32767, stored[1]);
+    }
+
+
+    TEST(UByteRoundTrip)
+    {
+        const float values[4] = { -1.0f, 0.0f, 0.5f, 1.0f };
+
+        unsigned char stored[4];
+        float decoded[4];
+
+        VertexCompression::encode(VertexCompression::FORMAT_UBYTE, values, 4, 1.0f, stored);
+        VertexCompression::decode(VertexCompression::FORMAT_UBYTE, stored, 4, 1.0f, decoded);
+
+        for (unsigned int i = 0; i < 4; ++i)
+            CHECK_CLOSE(values[i], decoded[i], 1.0f / 127.5f);
+    }
+
+
+    TEST(OctahedralRoundTrip)
+    {
+        const float directions[][3] = {
+            { 0.0f, 0.0f, 1.0f },
+            { 0.0f, 0.0f, -1.0f },
+            { 1.0f, 0.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f },
+            { 0.57735f, 0.57735f, 0.57735f },
+            { -0.57735f, 0.57735f, -0.57735f },
+            { 0.26726f, -0.53452f, -0.80178f },
+        };
+
+        for (unsigned int n = 0; n < sizeof(directions) / sizeof(directions[0]); ++n)
+        {
+            short stored[2];
+            float decoded[3];
+
+            VertexCompression::encode(VertexCompression::FORMAT_OCTAHEDRAL, directions[n], 3, 1.0f, stored);
+            VertexCompression::decode(VertexCompression::FORMAT_OCTAHEDRAL, stored, 3, 1.0f, decoded);
+
+            const float length = sqrtf(decoded[0] * decoded[0] + decoded[1] * decoded[1] +
+                                       decoded[2] * decoded[2]);
+            CHECK_CLOSE(1.0f, length, 1e-5f);
+
+            for (unsigned int i = 0; i < 3; ++i)
+                CHECK_CLOSE(directions[n][i], decoded[i], 1e-3f);
+        }
+    }
+}